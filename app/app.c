@@ -4,7 +4,7 @@
  *
  * Responsibilities:
  *  - Look at CommandLine.mode and choose which feature to run:
- *      * MODE_SCAN    → port scanner
+ *      * MODE_SCAN    → port scanner (or ping sweep with --subnet)
  *      * MODE_TRACE   → traceroute
  *      * MODE_MONITOR → interface monitor
  *  - Call the corresponding module (scanner/tracer/monitor)
@@ -18,16 +18,79 @@
 #include "app.h"
 #include "../cli/cli.h"
 #include "../scanner/scanner.h"
+#include "../scanner/sweep.h"
 #include "../tracer/tracer.h"
+#include "../tracer/pmtu.h"
+#include "../tracer/topo.h"
+#include "../tracer/asn.h"
 #include "../monitor/monitor.h"
+#include "../monitor/rollup.h"
+#include "../monitor/tsdb.h"
+#include "../monitor/exporter.h"
 #include "../fmt/fmt.h"
 #include "../model/model.h"
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>   // isatty()
 
 #define DEFAULT_MONITOR_SAMPLES 10 //how many samples to collect in monitor mode
 
+/**
+ * Load the --asn table, if one was given
+ * @param cmd Pointer to CommandLine
+ * @param table AsnTable to fill (left empty when --asn is not set)
+ * @return 0 on success (or nothing to load), -1 if the table cannot be loaded
+ */
+static int load_asn(const CommandLine *cmd, AsnTable *table){
+
+    memset(table, 0, sizeof(*table));
+
+    if(cmd->asn_file[0] == '\0'){
+        return 0;
+    }
+
+    return asn_load(cmd->asn_file, table);
+}
+
+/**
+ * Run ICMP ping sweep of a subnet (scan --subnet)
+ * @param cmd Pointer to CommandLine
+ * @return 0 on success, non-zero error code on failure
+ */
+static int run_sweep(const CommandLine *cmd){
+
+    //Initialize empty SweepTable
+    SweepTable table = {0};
+    AsnTable asn;
+
+    // Load the AS table first: a bad file should fail before any probing
+    if(load_asn(cmd, &asn) != 0){
+        return 1;
+    }
+
+    int sweep_result = sweep_run(cmd, &table);
+
+    if(sweep_result != 0){
+
+        fprintf(stderr, "Ping sweep failed (code %d).\n", sweep_result);
+        asn_free(&asn);
+        return sweep_result;
+    }
+
+    if(cmd->asn_file[0] != '\0'){
+        asn_annotate_sweep(&asn, &table);
+    }
+    asn_free(&asn);
+
+    fmt_sweep_table(&table, cmd->json, cmd->csv);
+
+    sweeptable_free(&table);
+
+    return 0;
+}
+
 /**
  * Run port scanner feature
  * @param cmd Pointer to CommandLine
@@ -35,17 +98,32 @@
  */
 static int run_scan(const CommandLine *cmd){
 
+    if(cmd->subnet[0] != '\0'){
+        return run_sweep(cmd);
+    }
+
     //Initialize empty ScanTable
     ScanTable table = {0};
+    AsnTable asn;
+
+    if(load_asn(cmd, &asn) != 0){
+        return 1;
+    }
 
     int scan_result = scanner_run(cmd, &table);
 
     if(scan_result != 0){
 
         fprintf(stderr, "Scan failed (code %d).\n", scan_result);
+        asn_free(&asn);
         return scan_result;
     }
 
+    if(cmd->asn_file[0] != '\0'){
+        asn_annotate_scan(&asn, cmd->target, &table);
+    }
+    asn_free(&asn);
+
     fmt_scan_table(&table, cmd->json, cmd->csv);
 
     scantable_free(&table);   // <- if scanner allocates rows, this is where you free
@@ -53,6 +131,96 @@ static int run_scan(const CommandLine *cmd){
     return 0;
 }
 
+/**
+ * Snapshot callback for continuous trace: hands each round to fmt.c
+ * @param stats Current path statistics
+ * @param ctx Pointer to the CommandLine (output format flags)
+ */
+static void on_trace_snapshot(const PathStats *stats, void *ctx){
+
+    const CommandLine *cmd = (const CommandLine *)ctx;
+
+    // Redraw the table in place only when a human is watching
+    bool refresh = !cmd->json && !cmd->csv && isatty(STDOUT_FILENO);
+
+    fmt_path_stats(stats, cmd->json, cmd->csv, refresh);
+}
+
+/**
+ * Run continuous (MTR-style) traceroute feature
+ * @param cmd Pointer to CommandLine
+ * @return 0 on success, non-zero error code on failure
+ */
+static int run_trace_continuous(const CommandLine *cmd){
+
+    //Initialize empty PathStats
+    PathStats stats = {0};
+
+    int trace_result = tracer_continuous(cmd, &stats, on_trace_snapshot, (void *)cmd);
+
+    pathstats_free(&stats);
+
+    if(trace_result != 0){
+
+        fprintf(stderr, "Traceroute failed (code %d).\n", trace_result);
+        return trace_result;
+    }
+
+    return 0;
+}
+
+/**
+ * Run path MTU discovery (traceroute --pmtu)
+ * @param cmd Pointer to CommandLine
+ * @return 0 on success, non-zero error code on failure
+ */
+static int run_trace_pmtu(const CommandLine *cmd){
+
+    //Initialize empty PmtuTable
+    PmtuTable table = {0};
+
+    int pmtu_result = tracer_pmtu(cmd, &table);
+
+    if(pmtu_result != 0){
+
+        fprintf(stderr, "Path MTU discovery failed (code %d).\n", pmtu_result);
+        pmtutable_free(&table);
+        return pmtu_result;
+    }
+
+    fmt_pmtu_table(&table, cmd->json, cmd->csv);
+
+    pmtutable_free(&table);
+
+    return 0;
+}
+
+/**
+ * Run traceroute to many targets and print the merged topology (traceroute --graph)
+ * @param cmd Pointer to CommandLine
+ * @return 0 on success, non-zero error code on failure
+ */
+static int run_trace_graph(const CommandLine *cmd){
+
+    //Initialize empty TopoGraph
+    TopoGraph graph = {0};
+
+    int graph_result = tracer_graph(cmd, &graph);
+
+    if(graph_result != 0){
+
+        fprintf(stderr, "Topology trace failed (code %d).\n", graph_result);
+        topo_free(&graph);
+        return graph_result;
+    }
+
+    fmt_topo_graph(&graph, cmd->json, cmd->csv, cmd->dot);
+
+    topo_free(&graph);
+
+    return 0;
+}
+
 /**
  * Run traceroute feature
  * @param cmd Pointer to CommandLine
@@ -60,17 +228,40 @@ static int run_scan(const CommandLine *cmd){
  */
 static int run_trace(const CommandLine *cmd){
 
+    if(cmd->continuous){
+        return run_trace_continuous(cmd);
+    }
+
+    if(cmd->pmtu){
+        return run_trace_pmtu(cmd);
+    }
+
+    if(cmd->graph){
+        return run_trace_graph(cmd);
+    }
+
     //Initialize empty TraceRoute
     TraceRoute route = {0};
+    AsnTable asn;
+
+    if(load_asn(cmd, &asn) != 0){
+        return 1;
+    }
 
-    int trace_result = tracer_run(cmd, &route);
+    int trace_result = cmd->enumerate ? tracer_enumerate(cmd, &route) : tracer_run(cmd, &route);
 
     if(trace_result != 0){
 
         fprintf(stderr, "Traceroute failed (code %d).\n", trace_result);
+        asn_free(&asn);
         return trace_result;
     }
 
+    if(cmd->asn_file[0] != '\0'){
+        asn_annotate_route(&asn, &route);
+    }
+    asn_free(&asn);
+
     fmt_traceroute(&route, cmd->json, cmd->csv);
 
     traceroute_free(&route);  // <- if tracer allocates rows, this is where you free
@@ -78,6 +269,172 @@ static int run_trace(const CommandLine *cmd){
     return 0;
 }
 
+/**
+ * Where run_monitor sends each sample as it is taken
+ * - cmd: Output format, and whether to stream
+ * - rollup: History tiers to fold samples into (NULL without --rollup)
+ * - record: Time-series file samples are appended to (NULL without --record)
+ * - record_failed: An append to the file failed; later samples are not written
+ * - exporter: Metrics endpoint whose snapshot each sample refreshes (NULL without --serve)
+ */
+typedef struct{
+    const CommandLine *cmd;
+    Rollup *rollup;
+    TsdbWriter *record;
+    bool record_failed;
+    Exporter *exporter;
+}MonitorSink;
+
+/**
+ * Handle a monitor sample as soon as it is taken (--stream, --rollup, --record, --serve)
+ * @param sample Pointer to the new IfaceStats
+ * @param ctx Pointer to the MonitorSink
+ */
+static void on_monitor_sample(const IfaceStats *sample, void *ctx){
+
+    MonitorSink *sink = ctx;
+
+    if(sink->cmd->stream){
+        fmt_monitor_stream_sample(sample, sink->cmd->json, sink->cmd->csv);
+    }
+
+    if(sink->rollup != NULL){
+        rollup_add(sink->rollup, sample);
+    }
+
+    if(sink->record != NULL && !sink->record_failed){
+        if(tsdb_append(sink->record, sample) < 0){
+            sink->record_failed = true;
+        }
+    }
+
+    if(sink->exporter != NULL){
+        exporter_update(sink->exporter, sample);
+    }
+}
+
+/**
+ * Forget an interface that disappeared during the run (--serve)
+ * @param iface Interface name
+ * @param ctx Pointer to the MonitorSink
+ */
+static void on_monitor_gone(const char *iface, void *ctx){
+
+    MonitorSink *sink = ctx;
+
+    if(sink->exporter != NULL){
+        exporter_remove(sink->exporter, iface);
+    }
+}
+
+/**
+ * Serve pending metrics requests between monitor ticks (--serve)
+ * @param ctx Pointer to the MonitorSink
+ */
+static void on_monitor_poll(void *ctx){
+
+    MonitorSink *sink = ctx;
+
+    exporter_poll(sink->exporter);
+}
+
+/**
+ * Open the --serve metrics endpoint and say where it listens
+ * @param exporter Pointer to the Exporter to open
+ * @param cmd Pointer to CommandLine (serve_host, serve_port)
+ * @return 0 on success, -1 if the address cannot be used
+ */
+static int open_exporter(Exporter *exporter, const CommandLine *cmd){
+
+    //IPv6 literals are printed back in brackets
+    const char *host = (cmd->serve_host[0] != '\0') ? cmd->serve_host : "*";
+    bool v6 = (strchr(host, ':') != NULL);
+
+    if(exporter_open(exporter, cmd->serve_host, cmd->serve_port) < 0){
+        fprintf(stderr, "Error: cannot serve metrics on %s%s%s:%d: %s\n",
+                v6 ? "[" : "", host, v6 ? "]" : "", cmd->serve_port, strerror(errno));
+        return -1;
+    }
+
+    fprintf(stderr, "Serving metrics at http://%s%s%s:%d/metrics\n", v6 ? "[" : "", host, v6 ? "]" : "", cmd->serve_port);
+    return 0;
+}
+
+/**
+ * Print a message for a time-series file that cannot be opened or read
+ * @param path File path
+ */
+static void tsdb_error(const char *path){
+
+    if(errno == EINVAL){
+        fprintf(stderr, "Error: '%s' is not a wirefish time-series file (or is corrupt)\n", path);
+    }
+    else{
+        fprintf(stderr, "Error: cannot use '%s': %s\n", path, strerror(errno));
+    }
+}
+
+/**
+ * Print the samples stored in a --record file (--replay)
+ * @param cmd Pointer to CommandLine
+ * @return 0 on success, -1 if the file cannot be read
+ */
+static int run_replay(const CommandLine *cmd){
+
+    TsdbReader reader;
+    MonitorSeries series = {0};
+
+    if(tsdb_reader_open(&reader, cmd->replay_file) < 0){
+        tsdb_error(cmd->replay_file);
+        return -1;
+    }
+
+    //Only the blocks overlapping --from/--to are decoded
+    if(tsdb_scan(&reader, cmd->from_ms, cmd->to_ms, &series) < 0){
+        tsdb_error(cmd->replay_file);
+        monitorseries_free(&series);
+        tsdb_reader_close(&reader);
+        return -1;
+    }
+    tsdb_reader_close(&reader);
+
+    //The file keeps counters and rates; window statistics follow this run's --window/--alpha
+    if(monitorseries_restat(&series, (size_t)cmd->window, cmd->alpha) < 0){
+        fprintf(stderr, "Error: cannot allocate rolling windows\n");
+        monitorseries_free(&series);
+        return -1;
+    }
+
+    if(cmd->group){
+        monitorseries_group(&series);
+    }
+
+    fmt_monitor_series(&series, cmd->json, cmd->csv);
+
+    monitorseries_free(&series);
+    return 0;
+}
+
+/**
+ * Print the --rollup history of the whole run, from the finest tier that covers it
+ * @param rollup Pointer to the filled Rollup
+ * @param cmd Pointer to CommandLine (output format)
+ * @return 0 on success, -1 if the answer cannot be allocated
+ */
+static int print_rollup(const Rollup *rollup, const CommandLine *cmd){
+
+    RollupView view;
+
+    if(rollup_query(rollup, rollup->first_ms, rollup->last_ms, &view) < 0){
+        fprintf(stderr, "Error: cannot allocate rollup output\n");
+        return -1;
+    }
+
+    fmt_monitor_rollup(&view, cmd->json, cmd->csv);
+    rollupview_free(&view);
+    return 0;
+}
+
 /**
  * Run interface monitor feature
  * @param cmd Pointer to CommandLine
@@ -85,32 +442,171 @@ static int run_trace(const CommandLine *cmd){
  */
 static int run_monitor(const CommandLine *cmd){
 
+    if(cmd->replay_file[0] != '\0'){
+        return run_replay(cmd);
+    }
+
     // If user passed --iface, use it; otherwise let monitor_run auto-detect
     const char *iface = (cmd->iface[0] != '\0') ? cmd->iface : NULL;
 
-    int interval_ms = cmd->interval_ms;  // from CLI defaults / --interval
+    long interval_us = cmd->interval_us;  // from CLI defaults / --interval
     int samples = DEFAULT_MONITOR_SAMPLES;
 
-    // Approximate duration (in seconds) for N samples at given interval
-    // duration_sec ≈ samples * interval_ms / 1000
-    int duration_sec = (samples * interval_ms + 999) / 1000;  // round up
+    // Run for exactly N sampling intervals unless --duration says otherwise (0 = until Ctrl+C)
+    long long duration_us = (long long)samples * interval_us;
+    if(cmd->duration_sec >= 0){
+        duration_us = (long long)cmd->duration_sec * 1000000LL;
+    }
+    else if(cmd->serve_port > 0){
+        duration_us = 0;  //An exporter keeps serving until stopped
+    }
 
     // Output model
     MonitorSeries series = {0};
 
-    int monitor_result = monitor_run(iface, interval_ms, duration_sec, &series);
+    MonitorOptions opt = {
+        .iface = iface,
+        .interval_us = interval_us,
+        .duration_us = duration_us,
+        .backend = IFSTATS_AUTO,
+        .window = (size_t)cmd->window,
+        .alpha = cmd->alpha,
+        .keep = MONITOR_KEEP_ALL,
+        .on_sample = NULL,
+        .on_gone = NULL,
+        .poll_fd = -1,
+        .on_poll = NULL,
+        .ctx = NULL
+    };
+
+    //--rollup folds samples into fixed-size history tiers instead of keeping them
+    Rollup rollup;
+    MonitorSink sink = { .cmd = cmd, .rollup = NULL, .record = NULL, .record_failed = false, .exporter = NULL };
+
+    if(cmd->rollup_tiers > 0){
+
+        RollupTier tiers[ROLLUP_MAX_TIERS];
+        for(int t = 0; t < cmd->rollup_tiers; t++){
+            tiers[t].width_ms = cmd->rollup_width_ms[t];
+            tiers[t].cap = (size_t)cmd->rollup_buckets[t];
+        }
+
+        if(rollup_init(&rollup, tiers, (size_t)cmd->rollup_tiers) < 0){
+            fprintf(stderr, "Error: invalid rollup tiers\n");
+            return -1;
+        }
+
+        sink.rollup = &rollup;
+        opt.keep = 0;
+        opt.on_sample = on_monitor_sample;
+        opt.ctx = &sink;
+    }
+
+    //--record appends every sample to a compressed time-series file as it is taken
+    TsdbWriter record;
+
+    if(cmd->record_file[0] != '\0'){
+
+        if(tsdb_writer_open(&record, cmd->record_file) < 0){
+            tsdb_error(cmd->record_file);
+            if(sink.rollup != NULL){
+                rollup_free(&rollup);
+            }
+            return -1;
+        }
+
+        sink.record = &record;
+        opt.on_sample = on_monitor_sample;
+        opt.ctx = &sink;
+    }
+
+    //--serve answers scrapes from the latest samples, between ticks on this thread
+    Exporter exporter;
+
+    if(cmd->serve_port > 0){
+
+        if(open_exporter(&exporter, cmd) < 0){
+            if(sink.record != NULL){
+                tsdb_writer_close(&record);
+            }
+            if(sink.rollup != NULL){
+                rollup_free(&rollup);
+            }
+            return -1;
+        }
+
+        sink.exporter = &exporter;
+        opt.on_sample = on_monitor_sample;
+        opt.on_gone = on_monitor_gone;
+        opt.poll_fd = exporter.ep;
+        opt.on_poll = on_monitor_poll;
+        opt.ctx = &sink;
+    }
+
+    //Streaming prints every sample as it comes and keeps none: constant memory for any run time
+    if(cmd->stream){
+        opt.keep = 0;
+        opt.on_sample = on_monitor_sample;
+        opt.ctx = &sink;
+        fmt_monitor_stream_begin(cmd->json, cmd->csv);
+    }
+    else if(cmd->keep > 0){
+        opt.keep = (size_t)cmd->keep;
+    }
+    else if(sink.exporter != NULL){
+        opt.keep = 0;  //Scrapes read the snapshot; the run keeps no samples unless --keep asks
+    }
+
+    //CLI counter source choice maps one to one onto the monitor's backends
+    if(cmd->stats == STATS_NETLINK){
+        opt.backend = IFSTATS_NETLINK;
+    }
+    else if(cmd->stats == STATS_PROCFS){
+        opt.backend = IFSTATS_PROCFS;
+    }
+
+    int monitor_result = monitor_run(&opt, &series);
+
+    if(sink.exporter != NULL){
+        exporter_close(&exporter);
+    }
+
+    //Close the file even after a failed run: blocks already written stay readable
+    if(sink.record != NULL && (tsdb_writer_close(&record) < 0 || sink.record_failed)){
+        fprintf(stderr, "Error: cannot write '%s': %s\n", cmd->record_file, strerror(errno));
+        monitor_result = -1;
+    }
 
     if(monitor_result != 0){
         fprintf(stderr, "Error: monitor mode failed\n");
         monitorseries_free(&series);
+        if(sink.rollup != NULL){
+            rollup_free(&rollup);
+        }
         return -1;
     }
 
-    // Now display via fmt.c (table/CSV/JSON)
-    fmt_monitor_series(&series, cmd->json, cmd->csv);
+    //Samples come interleaved by time; --group lists each interface's run together
+    if(cmd->group){
+        monitorseries_group(&series);
+    }
+
+    // Now display via fmt.c (table/CSV/JSON); streamed samples are already out
+    if(cmd->stream){
+        fmt_monitor_stream_end(&series, cmd->json, cmd->csv);
+    }
+    else if(opt.keep != 0){
+        fmt_monitor_series(&series, cmd->json, cmd->csv);
+    }
+
+    int result = 0;
+    if(sink.rollup != NULL){
+        result = print_rollup(&rollup, cmd);
+        rollup_free(&rollup);
+    }
 
     monitorseries_free(&series);
-    return 0;
+    return result;
 }
 
 
@@ -0,0 +1,1294 @@
+/*bench.c - Micro-benchmarks for wirefish hot paths.
+ * Summary: Stand-alone benchmark driver (not part of the wirefish binary).
+ *
+ * Usage:
+ *   ./wirefish-bench probe [target] [rounds] [probes]
+ *       Probe engine throughput: rounds of parallel ICMP probes to a target
+ *       (default 127.0.0.1, 2000 rounds of 64). Reports packets per second
+ *       of wall time and per second of CPU time (= per busy core).
+ *   ./wirefish-bench build [payload|verify]
+ *       Echo probe construction: full icmp_build_echo() versus a prebuilt
+ *       template with incremental checksum updates (default payload 56 bytes).
+ *       "verify": checks instead that templates patched to every sequence number
+ *       (and, for Paris templates, several flows) carry the checksum a full
+ *       recompute gives, for several payload sizes (exit status 1 on mismatch).
+ *   ./wirefish-bench checksum [verify]
+ *       Checks every checksum variant against the reference for all lengths
+ *       0-2048 at every alignment 0-63 (exit status 1 on mismatch), then
+ *       reports GB/s per variant for several buffer sizes ("verify": check only).
+ *   ./wirefish-bench asn <table> [out]
+ *       Prefix -> AS trie: load time of a text dump (or mapped compiled file),
+ *       trie size, lookups checked against a linear longest-prefix scan, then
+ *       nanoseconds per lookup for random addresses. Writes the compiled table to 'out'.
+ *   ./wirefish-bench procnet [samples] [iface]
+ *       Monitor sampling cost: the old fopen/fgets/sscanf read of /proc/net/dev,
+ *       the persistent pread() reader and the netlink stats dump, in
+ *       microseconds per sample (default 20000 samples of "lo"); all must
+ *       report the same counters.
+ *   ./wirefish-bench ring [window] [samples]
+ *       Rolling statistics: mean/stddev/min/max of the O(1) window checked against
+ *       a full recomputation, then nanoseconds per sample for the O(1) window
+ *       versus summing the whole window every sample (default window 10000,
+ *       1000000 samples).
+ *   ./wirefish-bench counters
+ *       Counter wrap/reset classification: feeds steps back from near 2^32 (and
+ *       others) against idle, empty and 10 Mbit/s rolling windows and checks each
+ *       is called a wrap or a reset as expected (exit status 1 otherwise).
+ *   ./wirefish-bench tick [interval_us] [ticks] [work_us]
+ *       Sampling clock: sleep-then-work (the old monitor loop) versus the
+ *       absolute-deadline timerfd ticker, with work_us of busy work per tick
+ *       (default 500 us interval, 2000 ticks, 100 us work). Reports the mean
+ *       period, period jitter, total drift from ticks * interval, and missed ticks.
+ *   ./wirefish-bench tsdb [samples] [file]
+ *       Monitor time-series file: appends synthetic 100 ms samples of one bursty
+ *       interface (default 864000 = one day) to 'file' (default /tmp/wirefish-bench.wfts),
+ *       checks that a full scan returns them unchanged, then reports bytes per sample
+ *       (versus the JSON output), append cost, and full versus one-minute range scans.
+ *   ./wirefish-bench scrape [ifaces] [scrapes]
+ *       Metrics endpoint (--serve): fills the snapshot with 'ifaces' interfaces
+ *       (default 64), then times whole HTTP scrapes over loopback, from connect()
+ *       to the last byte of the response, with a fresh sample before every scrape
+ *       (re-render) and without one (cached body). Default 5000 scrapes each.
+ *
+ * Notes:
+ *  - Needs the same privileges as --trace (ping socket or root)
+ *  - Use loopback or a veth pair so the wire is not the bottleneck
+ *
+ * Author: Shan Truong - 400576105 - truons8
+ * Date: December 3, 2025
+ * Coures: 2XC3
+ */
+
+#define _GNU_SOURCE
+#include "../tracer/probe.h"
+#include "../tracer/icmp.h"
+#include "../tracer/checksum.h"
+#include "../tracer/asn.h"
+#include "../monitor/procnet.h"
+#include "../monitor/nlstats.h"
+#include "../monitor/ringbuf.h"
+#include "../monitor/counter.h"
+#include "../monitor/tsdb.h"
+#include "../monitor/exporter.h"
+#include "../timeutil/timeutil.h"
+#include "../net/net.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <math.h>
+#include <netinet/ip_icmp.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define BENCH_PROBE_TARGET "127.0.0.1"
+#define BENCH_PROBE_ROUNDS 2000
+#define BENCH_PROBE_COUNT 64
+#define BENCH_PROBE_TIMEOUT_MS 200
+#define BENCH_BUILD_PAYLOAD 56
+#define BENCH_BUILD_ITERS 10000000
+#define BENCH_BUILD_MAX 1472
+#define BENCH_BUILD_FLOWS 6             // flows checked per Paris payload size
+#define BENCH_CSUM_VERIFY_LEN 2048
+#define BENCH_CSUM_VERIFY_ALIGN 64
+#define BENCH_CSUM_BYTES (1ULL << 30)   // bytes checksummed per variant and size
+#define BENCH_ASN_VERIFY 2000           // lookups checked against a linear scan
+#define BENCH_ASN_LOOKUPS 20000000      // timed lookups
+#define BENCH_ASN_KEYS 4096             // distinct random addresses (power of two)
+#define BENCH_PROCNET_SAMPLES 20000
+#define BENCH_PROCNET_IFACE "lo"
+#define BENCH_RING_WINDOW 10000
+#define BENCH_RING_SAMPLES 1000000
+#define BENCH_RING_CHECKS 1000          // samples compared against a full recomputation
+#define BENCH_COUNTER_RATE 1e7         // bit/s in the busy window of the counter cases
+#define BENCH_TICK_INTERVAL_US 500
+#define BENCH_TICK_COUNT 2000
+#define BENCH_TICK_WORK_US 100
+#define BENCH_TSDB_SAMPLES 864000       // one day at 100 ms
+#define BENCH_TSDB_FILE "/tmp/wirefish-bench.wfts"
+#define BENCH_TSDB_INTERVAL_MS 100
+#define BENCH_SCRAPE_IFACES 64
+#define BENCH_SCRAPE_COUNT 5000
+
+/**
+ * Read a clock in seconds.
+ * @param clock CLOCK_MONOTONIC (wall) or CLOCK_PROCESS_CPUTIME_ID (CPU)
+ * @return Seconds as a double
+ */
+static double bench_seconds(clockid_t clock){
+
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * Probe engine throughput: send/receive rounds and count answered probes.
+ * @param target Destination host
+ * @param rounds Number of rounds
+ * @param count Probes per round (all with a TTL that reaches the target)
+ * @return 0 on success, 1 on error
+ */
+static int bench_probe(const char *target, int rounds, int count){
+
+    struct sockaddr_storage dst;
+    socklen_t dst_len;
+
+    if(net_resolve(target, &dst, &dst_len) != 0){
+        fprintf(stderr, "Error: Failed to resolve target '%s'\n", target);
+        return 1;
+    }
+
+    ProbeEngine eng;
+    if(probe_engine_open(&eng, PROBE_ICMP, 0, &dst, dst_len) != 0){
+        return 1;
+    }
+
+    Probe *probes = calloc((size_t)count, sizeof(Probe));
+    if(probes == NULL){
+        probe_engine_close(&eng);
+        return 1;
+    }
+
+    unsigned long sent = 0;
+    unsigned long answered = 0;
+
+    double wall0 = bench_seconds(CLOCK_MONOTONIC);
+    double cpu0 = bench_seconds(CLOCK_PROCESS_CPUTIME_ID);
+
+    for(int r = 0; r < rounds; r++){
+
+        for(int i = 0; i < count; i++){
+            probes[i].ttl = 64;
+        }
+
+        if(probe_engine_round(&eng, probes, (size_t)count, BENCH_PROBE_TIMEOUT_MS) != 0){
+            break;
+        }
+
+        sent += (unsigned long)count;
+        for(int i = 0; i < count; i++){
+            answered += probes[i].answered;
+        }
+    }
+
+    double wall = bench_seconds(CLOCK_MONOTONIC) - wall0;
+    double cpu = bench_seconds(CLOCK_PROCESS_CPUTIME_ID) - cpu0;
+
+    //Each probe is one packet out and one back
+    double packets = (double)(sent + answered);
+
+    printf("probe: target=%s socket=%s batch=%d rounds=%d probes/round=%d\n",
+           target, eng.dgram ? "dgram" : "raw", PROBE_BATCH, rounds, count);
+    printf("  sent=%lu answered=%lu wall=%.3fs cpu=%.3fs\n", sent, answered, wall, cpu);
+    printf("  %.0f pkt/s wall, %.0f pkt/s per core\n",
+           wall > 0 ? packets / wall : 0.0, cpu > 0 ? packets / cpu : 0.0);
+
+    free(probes);
+    probe_engine_close(&eng);
+    return 0;
+}
+
+/**
+ * Echo build cost: full build versus template mutation.
+ * @param payload_len Payload bytes per probe
+ * @return 0 on success, 1 on error
+ */
+static int bench_build(size_t payload_len){
+
+    static unsigned char payload[BENCH_BUILD_MAX];
+    static unsigned char pkt[sizeof(struct icmphdr) + BENCH_BUILD_MAX];
+    size_t len = 0;
+
+    memset(payload, 0xA5, sizeof(payload));
+
+    //Full build: header + payload copy + checksum over everything
+    double t0 = bench_seconds(CLOCK_MONOTONIC);
+    unsigned sink = 0;
+    for(unsigned i = 0; i < BENCH_BUILD_ITERS; i++){
+        icmp_build_echo(0x1234, (uint16_t)i, payload, payload_len, pkt, &len);
+        sink += pkt[2];
+    }
+    double full = bench_seconds(CLOCK_MONOTONIC) - t0;
+
+    //Template: built once, then only seq + checksum are patched
+    IcmpTemplate t;
+    if(icmp_template_init(&t, pkt, sizeof(pkt), 0x1234, payload, payload_len, false) != 0){
+        return 1;
+    }
+
+    t0 = bench_seconds(CLOCK_MONOTONIC);
+    for(unsigned i = 0; i < BENCH_BUILD_ITERS; i++){
+        icmp_template_set_seq(&t, (uint16_t)i);
+        sink += pkt[2];
+    }
+    double tmpl = bench_seconds(CLOCK_MONOTONIC) - t0;
+
+    printf("build: payload=%zu iterations=%d (sink %u)\n", payload_len, BENCH_BUILD_ITERS, sink & 1);
+    printf("  icmp_build_echo      %6.1f ns/probe\n", full * 1e9 / BENCH_BUILD_ITERS);
+    printf("  icmp_template_set_seq %5.1f ns/probe\n", tmpl * 1e9 / BENCH_BUILD_ITERS);
+    return 0;
+}
+
+/**
+ * Template checksums: every sequence number (and several flows for Paris
+ * templates) patched in incrementally, checked against a full recompute.
+ * Plain templates must match icmp_build_echo() byte for byte; Paris templates
+ * must keep the flow in the checksum field and still sum to a valid checksum.
+ * @return 0 if every packet matched, 1 otherwise
+ */
+static int bench_build_verify(void){
+
+    static const size_t sizes[] = {0, 1, 2, 7, 56, 1471, BENCH_BUILD_MAX};
+    static const uint16_t flows[BENCH_BUILD_FLOWS] = {0, 1, 0x00FF, 0x1234, 0xFFFE, 0xFFFF};
+    static unsigned char payload[BENCH_BUILD_MAX];
+    static unsigned char pkt[sizeof(struct icmphdr) + ICMP_FLOW_PAYLOAD_LEN + BENCH_BUILD_MAX];
+    static unsigned char ref[sizeof(struct icmphdr) + ICMP_FLOW_PAYLOAD_LEN + BENCH_BUILD_MAX];
+    size_t nsizes = sizeof(sizes) / sizeof(sizes[0]);
+    unsigned long long checked = 0;
+
+    //Pseudo-random payload (xorshift) so the sums carry in every position
+    uint32_t x = 0x9E3779B9u;
+    for(size_t i = 0; i < sizeof(payload); i++){
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        payload[i] = (unsigned char)x;
+    }
+
+    for(size_t z = 0; z < nsizes; z++){
+        size_t len = 0;
+        IcmpTemplate t;
+
+        //Plain: the patched template is exactly what a full build produces
+        if(icmp_template_init(&t, pkt, sizeof(pkt), 0xBEEF, payload, sizes[z], false) != 0){
+            return 1;
+        }
+        for(uint32_t seq = 0; seq <= 0xFFFF; seq++){
+            icmp_template_set_seq(&t, (uint16_t)seq);
+            icmp_build_echo(0xBEEF, (uint16_t)seq, payload, sizes[z], ref, &len);
+            checked++;
+
+            if(len != t.len || memcmp(pkt, ref, len) != 0){
+                fprintf(stderr, "Error: payload %zu seq %u: patched checksum %04x, full recompute %04x\n",
+                        sizes[z], seq, ((struct icmphdr *)pkt)->checksum, ((struct icmphdr *)ref)->checksum);
+                return 1;
+            }
+        }
+
+        //Paris: flow stays in the checksum field, and the packet still verifies
+        for(int f = 0; f < BENCH_BUILD_FLOWS; f++){
+            if(icmp_template_init(&t, pkt, sizeof(pkt), 0xBEEF, payload, sizes[z], true) != 0){
+                return 1;
+            }
+            icmp_template_set_flow(&t, flows[f]);
+
+            for(uint32_t seq = 0; seq <= 0xFFFF; seq++){
+                icmp_template_set_seq(&t, (uint16_t)seq);
+                checked++;
+
+                const struct icmphdr *hdr = (const struct icmphdr *)pkt;
+                bool bad = ntohs(hdr->checksum) != flows[f] || icmp_checksum(pkt, t.len) != 0;
+
+                //Without a payload the packet must equal icmp_build_echo_flow()'s
+                if(!bad && sizes[z] == 0){
+                    icmp_build_echo_flow(0xBEEF, (uint16_t)seq, flows[f], ref, &len);
+                    bad = len != t.len || memcmp(pkt, ref, len) != 0;
+                }
+
+                if(bad){
+                    fprintf(stderr, "Error: Paris payload %zu flow %04x seq %u: checksum field %04x, packet sum %04x\n",
+                            sizes[z], flows[f], seq, ntohs(hdr->checksum), icmp_checksum(pkt, t.len));
+                    return 1;
+                }
+            }
+        }
+    }
+
+    printf("build: %llu template packets, checksums match a full recompute\n", checked);
+    return 0;
+}
+
+/**
+ * Checksum variants: correctness against checksum_ref, then throughput.
+ * @param verify_only true to skip the throughput part
+ * @return 0 if every variant matched, 1 otherwise
+ */
+static int bench_checksum(bool verify_only){
+
+    static const size_t sizes[] = {64, 1500, 9000, 65536, 1 << 20};
+    size_t buf_len = (1 << 20) + BENCH_CSUM_VERIFY_ALIGN;
+
+    unsigned char *buf = malloc(buf_len);
+    if(buf == NULL){
+        return 1;
+    }
+
+    //Deterministic pseudo-random bytes (xorshift) so carries happen everywhere
+    uint32_t x = 2463534242U;
+    for(size_t i = 0; i < buf_len; i++){
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        buf[i] = (unsigned char)x;
+    }
+
+    ChecksumImpl impls[CHECKSUM_MAX_IMPLS];
+    size_t nimpls = checksum_impls(impls, CHECKSUM_MAX_IMPLS);
+
+    //Every length (odd ones included) at every misalignment
+    unsigned long mismatches = 0;
+    for(size_t align = 0; align < BENCH_CSUM_VERIFY_ALIGN; align++){
+        for(size_t len = 0; len <= BENCH_CSUM_VERIFY_LEN; len++){
+            uint16_t want = checksum_ref(buf + align, len);
+            for(size_t k = 1; k < nimpls; k++){
+                if(impls[k].fn(buf + align, len) != want){
+                    if(mismatches++ < 5){
+                        fprintf(stderr, "mismatch: %s len=%zu align=%zu\n", impls[k].name, len, align);
+                    }
+                }
+            }
+        }
+    }
+
+    //All-ones data: the largest possible carries
+    memset(buf, 0xFF, buf_len);
+    for(size_t k = 1; k < nimpls; k++){
+        if(impls[k].fn(buf + 1, buf_len - 1) != checksum_ref(buf + 1, buf_len - 1)){
+            fprintf(stderr, "mismatch: %s all-ones len=%zu\n", impls[k].name, buf_len - 1);
+            mismatches++;
+        }
+    }
+
+    if(mismatches > 0){
+        printf("checksum: %lu mismatches\n", mismatches);
+        free(buf);
+        return 1;
+    }
+
+    printf("checksum: all variants match (lengths 0-%d, alignments 0-%d), dispatch=%s\n",
+           BENCH_CSUM_VERIFY_LEN, BENCH_CSUM_VERIFY_ALIGN - 1, checksum_fast_name());
+
+    if(verify_only){
+        free(buf);
+        return 0;
+    }
+
+    //Throughput: roughly the same number of bytes for every size
+    unsigned sink = 0;
+    for(size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++){
+
+        size_t len = sizes[s];
+        unsigned long iters = (unsigned long)(BENCH_CSUM_BYTES / len);
+
+        printf("  %8zu B:", len);
+        for(size_t k = 0; k < nimpls; k++){
+
+            double t0 = bench_seconds(CLOCK_MONOTONIC);
+            for(unsigned long i = 0; i < iters; i++){
+                sink += impls[k].fn(buf, len);
+            }
+            double t = bench_seconds(CLOCK_MONOTONIC) - t0;
+
+            printf("  %s %6.2f GB/s", impls[k].name, t > 0 ? (double)iters * (double)len / t / 1e9 : 0.0);
+        }
+        printf("\n");
+    }
+
+    printf("  (sink %u)\n", sink & 1);
+    free(buf);
+    return 0;
+}
+
+/**
+ * Next value of a xorshift32 generator (cheap, deterministic addresses).
+ * @param state Generator state (non-zero)
+ * @return Next pseudo-random value
+ */
+static uint32_t bench_xorshift(uint32_t *state){
+
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+/**
+ * Longest-prefix match by scanning every route (reference for asn_lookup).
+ * @param t Table
+ * @param addr Address (host order)
+ * @return Matching route or NULL
+ */
+static const AsnEntry *bench_asn_linear(const AsnTable *t, uint32_t addr){
+
+    const AsnEntry *best = NULL;
+
+    for(size_t i = 0; i < t->nentries; i++){
+
+        const AsnEntry *e = &t->entries[i];
+        uint32_t mask = e->len == 0 ? 0 : 0xFFFFFFFFu << (32 - e->len);
+
+        // Later duplicates win, like the trie build
+        if((addr & mask) == e->prefix && (best == NULL || e->len >= best->len)){
+            best = e;
+        }
+    }
+
+    return best;
+}
+
+/**
+ * Prefix -> AS trie: build/map time, size, correctness and lookup speed.
+ * @param path Text dump or compiled table
+ * @param out Where to write the compiled table (NULL = don't)
+ * @return 0 on success, 1 on error or mismatch
+ */
+static int bench_asn(const char *path, const char *out){
+
+    AsnTable t;
+
+    double t0 = bench_seconds(CLOCK_MONOTONIC);
+
+    if(asn_load(path, &t) != 0){
+        return 1;
+    }
+
+    double load = bench_seconds(CLOCK_MONOTONIC) - t0;
+    size_t bytes = t.nnodes * sizeof(AsnNode) + t.nleaves * sizeof(uint32_t) + t.nentries * sizeof(AsnEntry);
+
+    printf("%s %zu routes in %.3f s: %zu nodes, %zu leaves, %.1f MB\n", t.map ? "mapped" : "built",
+           t.nentries, load, t.nnodes, t.nleaves, bytes / 1e6);
+
+    // Half the keys inside known routes, half anywhere
+    uint32_t keys[BENCH_ASN_KEYS];
+    uint32_t rng = 2463534242u;
+
+    for(size_t i = 0; i < BENCH_ASN_KEYS; i++){
+
+        uint32_t r = bench_xorshift(&rng);
+
+        if(i % 2 == 0){
+            const AsnEntry *e = &t.entries[r % t.nentries];
+            uint32_t host = e->len == 32 ? 0 : bench_xorshift(&rng) & (0xFFFFFFFFu >> e->len);
+            keys[i] = e->prefix | host;
+        }
+        else{
+            keys[i] = r;
+        }
+    }
+
+    int bad = 0;
+
+    for(int i = 0; i < BENCH_ASN_VERIFY; i++){
+
+        uint32_t k = keys[i % BENCH_ASN_KEYS];
+        const AsnEntry *want = bench_asn_linear(&t, k);
+        const AsnEntry *got = asn_lookup(&t, k);
+
+        bool same = (want == NULL && got == NULL) ||
+                    (want != NULL && got != NULL && want->prefix == got->prefix && want->len == got->len && want->asn == got->asn);
+
+        if(!same){
+            bad++;
+        }
+    }
+
+    printf("verify: %d lookups, %d mismatches\n", BENCH_ASN_VERIFY, bad);
+
+    // Sum the AS numbers so the compiler can't drop the lookups
+    unsigned long long sum = 0;
+    t0 = bench_seconds(CLOCK_MONOTONIC);
+
+    for(long i = 0; i < BENCH_ASN_LOOKUPS; i++){
+
+        const AsnEntry *e = asn_lookup(&t, keys[i & (BENCH_ASN_KEYS - 1)]);
+
+        if(e != NULL){
+            sum += e->asn;
+        }
+    }
+
+    double secs = bench_seconds(CLOCK_MONOTONIC) - t0;
+
+    printf("lookup: %.1f ns (checksum %llu)\n", secs * 1e9 / BENCH_ASN_LOOKUPS, sum);
+
+    int rc = bad == 0 ? 0 : 1;
+
+    if(out != NULL){
+
+        if(asn_save(&t, out) != 0){
+            rc = 1;
+        }
+        else{
+            printf("wrote %s\n", out);
+        }
+    }
+
+    asn_free(&t);
+    return rc;
+}
+
+/**
+ * The monitor's original sampler: fopen, skip two headers, sscanf every line, fclose.
+ * @param iface Interface to find
+ * @param rx RX bytes
+ * @param tx TX bytes
+ * @return 0 if found, -1 otherwise
+ */
+static int bench_procnet_legacy(const char *iface, unsigned long long *rx, unsigned long long *tx){
+
+    FILE *fp = fopen(PROC_NET_DEV, "r");
+    if(fp == NULL){
+        return -1;
+    }
+
+    char line[256];
+    int found = -1;
+
+    if(fgets(line, sizeof(line), fp) == NULL || fgets(line, sizeof(line), fp) == NULL){
+        fclose(fp);
+        return -1;
+    }
+
+    while(fgets(line, sizeof(line), fp)){
+
+        char name[64];
+        unsigned long long r, t, dummy;
+
+        int n = sscanf(line, " %63[^:]: %llu %llu %llu %llu %llu %llu %llu %llu %llu",
+                       name, &r, &dummy, &dummy, &dummy, &dummy, &dummy, &dummy, &dummy, &t);
+
+        if(n >= 10 && strcmp(name, iface) == 0){
+            *rx = r;
+            *tx = t;
+            found = 0;
+            break;
+        }
+    }
+
+    fclose(fp);
+    return found;
+}
+
+/**
+ * Monitor sampling: old /proc/net/dev reader, persistent pread() reader, netlink dump.
+ * @param samples Samples per reader
+ * @param iface Interface both readers look up
+ * @return 0 on success, 1 on error or if the readers disagree
+ */
+static int bench_procnet(int samples, const char *iface){
+
+    unsigned long long rx = 0, tx = 0;
+
+    double t0 = bench_seconds(CLOCK_MONOTONIC);
+    for(int i = 0; i < samples; i++){
+        if(bench_procnet_legacy(iface, &rx, &tx) != 0){
+            fprintf(stderr, "Error: interface '%s' not found in %s\n", iface, PROC_NET_DEV);
+            return 1;
+        }
+    }
+    double legacy = bench_seconds(CLOCK_MONOTONIC) - t0;
+
+    ProcNetDev pnd;
+    if(procnet_open(&pnd) != 0){
+        return 1;
+    }
+
+    const IfCounters *c = NULL;
+    int nifs = 0;
+
+    t0 = bench_seconds(CLOCK_MONOTONIC);
+    for(int i = 0; i < samples; i++){
+        nifs = procnet_sample(&pnd);
+        c = procnet_find(&pnd, iface);
+    }
+    double fast = bench_seconds(CLOCK_MONOTONIC) - t0;
+
+    //Sanity: both readers see the same interface (counters only move forward)
+    int rc = 0;
+    if(c == NULL || c->rx_bytes < rx || c->tx_bytes < tx){
+        fprintf(stderr, "Error: readers disagree on '%s'\n", iface);
+        rc = 1;
+    }
+
+    printf("procnet: %d samples of '%s' (%d interfaces listed)\n", samples, iface, nifs);
+    printf("  fopen+sscanf  %7.2f us/sample\n", legacy * 1e6 / samples);
+    printf("  pread+scan    %7.2f us/sample\n", fast * 1e6 / samples);
+
+    //Netlink: same counters from binary RTM_GETSTATS dumps (RTM_GETLINK on the first sample)
+    NlStats nl;
+    if(nlstats_open(&nl) != 0){
+        printf("  netlink       unavailable\n");
+        procnet_close(&pnd);
+        return rc;
+    }
+
+    t0 = bench_seconds(CLOCK_MONOTONIC);
+    for(int i = 0; i < samples; i++){
+        nifs = nlstats_sample(&nl);
+    }
+    double dump = bench_seconds(CLOCK_MONOTONIC) - t0;
+
+    const IfCounters *nc = NULL;
+    for(int i = 0; i < nifs; i++){
+        if(strcmp(nl.ifs[i].name, iface) == 0){
+            nc = &nl.ifs[i];
+        }
+    }
+
+    if(nifs < 0 || nc == NULL || nc->rx_bytes < c->rx_bytes || nc->tx_bytes < c->tx_bytes){
+        fprintf(stderr, "Error: netlink disagrees on '%s'\n", iface);
+        rc = 1;
+    }
+
+    printf("  netlink dump  %7.2f us/sample\n", dump * 1e6 / samples);
+
+    nlstats_close(&nl);
+    procnet_close(&pnd);
+    return rc;
+}
+
+/**
+ * Rolling statistics: O(1) window versus recomputing over the whole window.
+ * @param window Window length in samples
+ * @param samples Samples pushed
+ * @return 0 on success, 1 on error or if the statistics disagree
+ */
+static int bench_ring(size_t window, int samples){
+
+    RingBuf rb;
+    if(ring_init(&rb, window, 0.3) != 0){
+        fprintf(stderr, "Error: cannot allocate a window of %zu samples\n", window);
+        return 1;
+    }
+
+    //Rates in bps with a large offset: the case where an uncompensated running sum drifts
+    double *values = malloc((size_t)samples * sizeof(double));
+    if(values == NULL){
+        ring_free(&rb);
+        return 1;
+    }
+
+    uint32_t rng = 0x2545F491u;
+    for(int i = 0; i < samples; i++){
+        values[i] = 1e9 + (bench_xorshift(&rng) % 1000000) * 0.37;
+    }
+
+    //Correctness: compare with a full pass over the window at spread-out points
+    int rc = 0;
+    int step = samples / BENCH_RING_CHECKS > 0 ? samples / BENCH_RING_CHECKS : 1;
+
+    for(int i = 0; i < samples; i++){
+        ring_push(&rb, values[i]);
+
+        if(i % step != step - 1 && i != samples - 1){
+            continue;
+        }
+
+        size_t n = (size_t)(i + 1) < window ? (size_t)(i + 1) : window;
+        double sum = 0.0, lo = values[i], hi = values[i];
+        for(size_t k = 0; k < n; k++){
+            double v = values[i - k];
+            sum += v;
+            lo = v < lo ? v : lo;
+            hi = v > hi ? v : hi;
+        }
+
+        double mean = sum / n, var = 0.0;
+        for(size_t k = 0; k < n; k++){
+            var += (values[i - k] - mean) * (values[i - k] - mean);
+        }
+        double sd = sqrt(var / n);
+
+        //Mean to 1e-12 relative; stddev is a difference of squares so allow 1e-3 of the spread
+        if(fabs(ring_mean(&rb) - mean) > 1e-12 * mean || ring_min(&rb) != lo || ring_max(&rb) != hi ||
+           fabs(ring_stddev(&rb) - sd) > 1e-3 * sd + 1e-6 * mean){
+            fprintf(stderr, "Error: window disagrees after %d samples (mean %.6f/%.6f sd %.3f/%.3f)\n",
+                    i + 1, ring_mean(&rb), mean, ring_stddev(&rb), sd);
+            rc = 1;
+            break;
+        }
+    }
+
+    printf("ring: window %zu, %d samples, statistics %s\n", window, samples, rc == 0 ? "match" : "DIFFER");
+
+    //Speed: push + every statistic per sample, as the monitor does
+    ring_free(&rb);
+    ring_init(&rb, window, 0.3);
+
+    volatile double sink = 0.0;
+    double t0 = bench_seconds(CLOCK_MONOTONIC);
+    for(int i = 0; i < samples; i++){
+        ring_push(&rb, values[i]);
+        sink += ring_mean(&rb) + ring_stddev(&rb) + ring_min(&rb) + ring_max(&rb) + ring_ewma(&rb);
+    }
+    double fast = bench_seconds(CLOCK_MONOTONIC) - t0;
+
+    //Old monitor behaviour: sum the whole window every sample (mean only)
+    int naive_samples = samples;
+    if((double)samples * window > 2e9){
+        naive_samples = (int)(2e9 / window);    //keep the O(window) run to a few seconds
+    }
+
+    t0 = bench_seconds(CLOCK_MONOTONIC);
+    for(int i = 0; i < naive_samples; i++){
+        size_t n = (size_t)(i + 1) < window ? (size_t)(i + 1) : window;
+        double sum = 0.0;
+        for(size_t k = 0; k < n; k++){
+            sum += values[i - k];
+        }
+        sink += sum / n;
+    }
+    double naive = bench_seconds(CLOCK_MONOTONIC) - t0;
+
+    printf("  O(1) window    %9.1f ns/sample (mean, stddev, min, max, ewma)\n", fast * 1e9 / samples);
+    printf("  full re-sum    %9.1f ns/sample (mean only)\n", naive * 1e9 / naive_samples);
+
+    (void)sink;
+    free(values);
+    ring_free(&rb);
+    return rc;
+}
+
+/**
+ * One counter classification case.
+ * window: 0 = empty window, 1 = idle (all 0 bit/s), 2 = busy (about BENCH_COUNTER_RATE)
+ */
+typedef struct{
+    const char *name;
+    unsigned long long prev, curr;
+    double dt_sec;
+    int window;
+    CounterStep want;
+    unsigned long long want_delta;
+} BenchCounterCase;
+
+/**
+ * Counter classification: steps back that are wraps and steps back that are resets.
+ * @return 0 if every case is classified as expected, 1 otherwise
+ */
+static int bench_counters(void){
+
+    const unsigned long long top = COUNTER32_MAX + 1;
+    const BenchCounterCase cases[] = {
+        {"growth",                             1000, 5000, 1.0, 2, COUNTER_OK, 4000},
+        {"wrap at 10 Mbit/s",                  top - 4096, 1000000, 1.0, 2, COUNTER_WRAPPED, 1004096},
+        {"wrap across a 60 s gap",             top - 4096, 60000000, 60.0, 2, COUNTER_WRAPPED, 60004096},
+        {"reset to 0 from under 2^32",         top - 4096, 0, 1.0, 1, COUNTER_RESET, 0},
+        {"reset from under 2^32, busy",        top - 4096, 300000000, 1.0, 2, COUNTER_RESET, 0},
+        {"reset from under 2^32, no window",   top - 4096, 1000, 1.0, 0, COUNTER_RESET, 0},
+        {"reset from 3e9 to 0",                3000000000ULL, 0, 1.0, 2, COUNTER_RESET, 0},
+        {"64-bit counter going back",          5000000000ULL, 1000, 1.0, 2, COUNTER_RESET, 0},
+    };
+    const char *step_names[] = {"ok", "wrap", "reset"};
+    size_t ncases = sizeof(cases) / sizeof(cases[0]);
+
+    RingBuf rates[3];
+    for(int w = 0; w < 3; w++){
+        if(ring_init(&rates[w], 60, 0.3) != 0){
+            for(int k = 0; k < w; k++){
+                ring_free(&rates[k]);
+            }
+            return 1;
+        }
+    }
+    for(int i = 0; i < 60; i++){
+        ring_push(&rates[1], 0.0);
+        ring_push(&rates[2], BENCH_COUNTER_RATE * (0.8 + 0.2 * (i % 5) / 4.0));
+    }
+
+    int rc = 0;
+    for(size_t i = 0; i < ncases; i++){
+        const BenchCounterCase *c = &cases[i];
+        unsigned long long delta;
+        CounterStep got = counter_step(c->prev, c->curr, &rates[c->window], c->dt_sec, &delta);
+
+        if(got != c->want || delta != c->want_delta){
+            fprintf(stderr, "Error: %s: %llu -> %llu is %s (delta %llu), expected %s (delta %llu)\n",
+                    c->name, c->prev, c->curr, step_names[got], delta, step_names[c->want], c->want_delta);
+            rc = 1;
+        }
+    }
+
+    printf("counters: %zu cases, %s\n", ncases, rc == 0 ? "all classified as expected" : "MISCLASSIFIED");
+
+    for(int w = 0; w < 3; w++){
+        ring_free(&rates[w]);
+    }
+    return rc;
+}
+
+/**
+ * Busy-waits for a number of microseconds (stands in for reading and storing a sample).
+ * @param us Microseconds to spin
+ */
+static void bench_spin_us(long us){
+    long long until = ns_mono() + us * 1000LL;
+    while(ns_mono() < until){
+    }
+}
+
+/**
+ * Prints one row of the tick benchmark.
+ * @param name Row label
+ * @param stamps Monotonic time of each tick (count + 1 entries, [0] = start)
+ * @param count Ticks taken
+ * @param interval_us Requested period
+ * @param missed Ticks skipped (timerfd only)
+ */
+static void bench_tick_report(const char *name, const long long *stamps, int count, long interval_us, unsigned long long missed){
+
+    double sum = 0.0, sumsq = 0.0;
+    for(int i = 1; i <= count; i++){
+        double p = (stamps[i] - stamps[i - 1]) / 1000.0;
+        sum += p;
+        sumsq += p * p;
+    }
+
+    double mean = sum / count;
+    double var = sumsq / count - mean * mean;
+    double drift = (stamps[count] - stamps[0]) / 1000.0 - (double)interval_us * (count + (double)missed);
+
+    printf("  %-14s period %9.2f us  jitter %7.2f us  drift %+11.1f us  missed %llu\n",
+           name, mean, var > 0.0 ? sqrt(var) : 0.0, drift, missed);
+}
+
+/**
+ * Sampling clock: relative sleeps versus absolute timerfd deadlines.
+ * @param interval_us Requested period
+ * @param count Ticks to take
+ * @param work_us Busy work after each tick
+ * @return 0 on success, 1 on error
+ */
+static int bench_tick(long interval_us, int count, long work_us){
+
+    long long *stamps = malloc(((size_t)count + 1) * sizeof(long long));
+    if(stamps == NULL){
+        return 1;
+    }
+
+    printf("tick: %d ticks of %ld us, %ld us of work per tick\n", count, interval_us, work_us);
+
+    //Old loop: sleep a full interval after the work, so every period is interval + work + wakeup
+    struct timespec req = { interval_us / 1000000, (interval_us % 1000000) * 1000 };
+    stamps[0] = ns_mono();
+    for(int i = 1; i <= count; i++){
+        nanosleep(&req, NULL);
+        stamps[i] = ns_mono();
+        bench_spin_us(work_us);
+    }
+    bench_tick_report("sleep+work", stamps, count, interval_us, 0);
+
+    //Ticker: deadlines at start + k * interval whatever the work costs
+    Ticker t;
+    if(ticker_start(&t, interval_us * 1000LL) != 0){
+        perror("timerfd");
+        free(stamps);
+        return 1;
+    }
+
+    stamps[0] = ns_mono();
+    for(int i = 1; i <= count; i++){
+        if(ticker_wait(&t) <= 0){
+            break;
+        }
+        stamps[i] = ns_mono();
+        bench_spin_us(work_us);
+    }
+    bench_tick_report("timerfd", stamps, count, interval_us, t.missed);
+
+    ticker_stop(&t);
+    free(stamps);
+    return 0;
+}
+
+/**
+ * Bytes one sample takes in the monitor's JSON output (same fields and precision as fmt.c).
+ * @param s Sample
+ * @return Length of its JSON object plus the separating comma
+ */
+static int bench_tsdb_json_len(const IfaceStats *s){
+
+    char buf[1024];
+
+    return 1 + snprintf(buf, sizeof(buf),
+        "{\"iface\":\"%s\",\"ts_ms\":%lld,\"rx_bytes\":%llu,\"tx_bytes\":%llu,\"rx_bps\":%.2f,\"tx_bps\":%.2f,"
+        "\"rx_avg_bps\":%.2f,\"tx_avg_bps\":%.2f,\"rx_packets\":%llu,\"tx_packets\":%llu,\"rx_errors\":%llu,"
+        "\"tx_errors\":%llu,\"rx_dropped\":%llu,\"tx_dropped\":%llu,\"multicast\":%llu,\"rx_ewma_bps\":%.2f,"
+        "\"tx_ewma_bps\":%.2f,\"rx_min_bps\":%.2f,\"rx_max_bps\":%.2f,\"tx_min_bps\":%.2f,\"tx_max_bps\":%.2f,"
+        "\"rx_stddev_bps\":%.2f,\"tx_stddev_bps\":%.2f}",
+        s->iface, s->ts_ms, s->rx_bytes, s->tx_bytes, s->rx_rate_bps, s->tx_rate_bps,
+        s->rx_rate_bps, s->tx_rate_bps, s->rx_packets, s->tx_packets, s->rx_errors,
+        s->tx_errors, s->rx_dropped, s->tx_dropped, s->multicast, s->rx_rate_bps,
+        s->tx_rate_bps, s->rx_rate_bps, s->rx_rate_bps, s->tx_rate_bps, s->tx_rate_bps, 0.0, 0.0);
+}
+
+/**
+ * Monitor time-series file: size, append cost and scan cost.
+ * @param samples Samples to store
+ * @param path File to create (overwritten)
+ * @return 0 on success, 1 on error or if the file does not return the samples
+ */
+static int bench_tsdb(int samples, const char *path){
+
+    IfaceStats *in = calloc((size_t)samples, sizeof(IfaceStats));
+    if(in == NULL){
+        return 1;
+    }
+
+    //A link that idles, then carries bursts of varying size; stamps jitter by a millisecond now and then
+    uint32_t rng = 0x9E3779B9u;
+    unsigned long long rx = 123456789ULL, tx = 987654321ULL, rxp = 100000, txp = 200000;
+    long long ts = 1767225600000LL;
+    double json_bytes = 0.0;
+
+    for(int i = 0; i < samples; i++){
+        IfaceStats *s = &in[i];
+        bool busy = (i / 600) % 3 == 0;
+        unsigned long long drx = busy ? 1500ULL * (bench_xorshift(&rng) % 800) : (bench_xorshift(&rng) % 8 == 0 ? 60 : 0);
+        unsigned long long dtx = busy ? 1500ULL * (bench_xorshift(&rng) % 100) : 0;
+
+        rx += drx;
+        tx += dtx;
+        rxp += drx / 1500 + (drx % 1500 ? 1 : 0);
+        txp += dtx / 1500;
+        ts += BENCH_TSDB_INTERVAL_MS + (bench_xorshift(&rng) % 50 == 0 ? 1 : 0);
+
+        strcpy(s->iface, "eth0");
+        s->ts_ms = ts;
+        s->rx_bytes = rx;
+        s->tx_bytes = tx;
+        s->rx_packets = rxp;
+        s->tx_packets = txp;
+        s->rx_rate_bps = drx * 8.0 / (BENCH_TSDB_INTERVAL_MS / 1000.0);
+        s->tx_rate_bps = dtx * 8.0 / (BENCH_TSDB_INTERVAL_MS / 1000.0);
+        json_bytes += bench_tsdb_json_len(s);
+    }
+
+    //Append
+    remove(path);
+    TsdbWriter w;
+    if(tsdb_writer_open(&w, path) < 0){
+        perror("Error: cannot create time-series file");
+        free(in);
+        return 1;
+    }
+
+    double t0 = bench_seconds(CLOCK_MONOTONIC);
+    for(int i = 0; i < samples; i++){
+        if(tsdb_append(&w, &in[i]) < 0){
+            perror("Error: append failed");
+            tsdb_writer_close(&w);
+            free(in);
+            return 1;
+        }
+    }
+    size_t nblocks = w.nblocks + (w.nrec > 0 ? 1 : 0);
+    if(tsdb_writer_close(&w) < 0){
+        perror("Error: cannot finish time-series file");
+        free(in);
+        return 1;
+    }
+    double append = bench_seconds(CLOCK_MONOTONIC) - t0;
+
+    //Full scan: must give back every stored field unchanged
+    TsdbReader r;
+    MonitorSeries out;
+    if(tsdb_reader_open(&r, path) < 0){
+        perror("Error: cannot open time-series file");
+        free(in);
+        return 1;
+    }
+
+    t0 = bench_seconds(CLOCK_MONOTONIC);
+    int got = tsdb_scan(&r, 0, in[samples - 1].ts_ms, &out);
+    double full = bench_seconds(CLOCK_MONOTONIC) - t0;
+
+    int rc = (got == samples) ? 0 : 1;
+    for(int i = 0; rc == 0 && i < samples; i++){
+        const IfaceStats *a = &in[i], *b = &out.samples[i];
+        if(strcmp(a->iface, b->iface) != 0 || a->ts_ms != b->ts_ms || a->rx_bytes != b->rx_bytes ||
+           a->tx_bytes != b->tx_bytes || a->rx_packets != b->rx_packets || a->tx_packets != b->tx_packets ||
+           a->rx_rate_bps != b->rx_rate_bps || a->tx_rate_bps != b->tx_rate_bps){
+            fprintf(stderr, "Error: sample %d differs after the round trip\n", i);
+            rc = 1;
+        }
+    }
+    free(out.samples);
+
+    //Range scan: one minute from the middle of the run
+    long long from = in[samples / 2].ts_ms;
+    t0 = bench_seconds(CLOCK_MONOTONIC);
+    int minute = tsdb_scan(&r, from, from + 60000, &out);
+    double range = bench_seconds(CLOCK_MONOTONIC) - t0;
+    free(out.samples);
+
+    double bytes = (double)r.size;
+    tsdb_reader_close(&r);
+
+    printf("tsdb: %d samples in %zu blocks, round trip %s\n", samples, nblocks, rc == 0 ? "matches" : "DIFFERS");
+    printf("  file          %9.2f bytes/sample (%.1f MB)\n", bytes / samples, bytes / 1e6);
+    printf("  JSON output   %9.2f bytes/sample (%.1f MB)\n", json_bytes / samples, json_bytes / 1e6);
+    printf("  append        %9.1f ns/sample\n", append * 1e9 / samples);
+    printf("  full scan     %9.1f ns/sample (%.1f ms)\n", full * 1e9 / samples, full * 1e3);
+    printf("  1 min range   %9.1f us (%d samples)\n", range * 1e6, minute);
+
+    free(in);
+    return rc;
+}
+
+/**
+ * One scrape of the exporter from a loopback client, serving it on this thread.
+ * @param e Open exporter
+ * @param addr Its listening address
+ * @param buf Buffer for the response
+ * @param len Size of buf
+ * @return Bytes of response received, or -1 on error
+ */
+static long bench_scrape_once(Exporter *e, const struct sockaddr_in *addr, char *buf, size_t len){
+
+    static const char req[] = "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if(fd < 0){
+        return -1;
+    }
+
+    //connect() completes from the listen backlog; the request waits in the socket
+    if(connect(fd, (const struct sockaddr *)addr, sizeof(*addr)) < 0 ||
+       send(fd, req, sizeof(req) - 1, 0) != (ssize_t)(sizeof(req) - 1)){
+        close(fd);
+        return -1;
+    }
+
+    long got = 0;
+    for(;;){
+        exporter_poll(e);
+
+        ssize_t r = recv(fd, buf + got, len - (size_t)got, MSG_DONTWAIT);
+        if(r == 0){
+            break;   //Response complete: the server closed the connection
+        }
+        if(r > 0){
+            got += r;
+            if((size_t)got == len){
+                break;
+            }
+        }
+    }
+
+    close(fd);
+    return got;
+}
+
+/**
+ * Metrics endpoint: cost of a scrape with and without re-rendering.
+ * @param ifaces Interfaces in the snapshot
+ * @param scrapes Scrapes timed per case
+ * @return 0 on success, 1 on error
+ */
+static int bench_scrape(int ifaces, int scrapes){
+
+    Exporter e;
+    if(exporter_open(&e, "127.0.0.1", 0) < 0){
+        perror("Error: cannot open the metrics endpoint");
+        return 1;
+    }
+
+    struct sockaddr_in addr;
+    socklen_t alen = sizeof(addr);
+    if(getsockname(e.listen_fd, (struct sockaddr *)&addr, &alen) < 0){
+        perror("Error: getsockname");
+        exporter_close(&e);
+        return 1;
+    }
+
+    IfaceStats *s = calloc((size_t)ifaces, sizeof(IfaceStats));
+    size_t len = 1 << 22;
+    char *buf = malloc(len);
+    if(s == NULL || buf == NULL){
+        free(s);
+        free(buf);
+        exporter_close(&e);
+        return 1;
+    }
+    for(int i = 0; i < ifaces; i++){
+        snprintf(s[i].iface, sizeof(s[i].iface), "veth%05d", i);
+        s[i].rx_bytes = 1000000ULL * (unsigned)i;
+        s[i].ts_ms = 1767225600000LL;
+        exporter_update(&e, &s[i]);
+    }
+
+    int rc = 0;
+    long bytes = 0;
+    double t_fresh = 0.0, t_cached = 0.0;
+
+    for(int pass = 0; pass < 2 && rc == 0; pass++){
+        double t0 = bench_seconds(CLOCK_MONOTONIC);
+        for(int k = 0; k < scrapes; k++){
+
+            //Pass 0: a new sample arrives before each scrape, so the body is rendered again
+            if(pass == 0){
+                s[k % ifaces].rx_bytes += 1500;
+                s[k % ifaces].rx_rate_bps = k * 8.0;
+                exporter_update(&e, &s[k % ifaces]);
+            }
+
+            bytes = bench_scrape_once(&e, &addr, buf, len);
+            if(bytes <= 0 || strncmp(buf, "HTTP/1.1 200 OK", 15) != 0){
+                fprintf(stderr, "Error: scrape %d failed\n", k);
+                rc = 1;
+                break;
+            }
+        }
+        double t = bench_seconds(CLOCK_MONOTONIC) - t0;
+        if(pass == 0){
+            t_fresh = t;
+        }
+        else{
+            t_cached = t;
+        }
+    }
+
+    if(rc == 0){
+        printf("scrape: %d interfaces, %ld byte response\n", ifaces, bytes);
+        printf("  after a new sample  %8.1f us/scrape\n", t_fresh * 1e6 / scrapes);
+        printf("  cached body         %8.1f us/scrape\n", t_cached * 1e6 / scrapes);
+    }
+
+    free(s);
+    free(buf);
+    exporter_close(&e);
+    return rc;
+}
+
+int main(int argc, char *argv[]){
+
+    if(argc < 2){
+        fprintf(stderr, "Usage: %s probe [target] [rounds] [probes]\n", argv[0]);
+        fprintf(stderr, "       %s build [payload|verify]\n", argv[0]);
+        fprintf(stderr, "       %s checksum [verify]\n", argv[0]);
+        fprintf(stderr, "       %s asn <table> [out]\n", argv[0]);
+        fprintf(stderr, "       %s procnet [samples] [iface]\n", argv[0]);
+        fprintf(stderr, "       %s ring [window] [samples]\n", argv[0]);
+        fprintf(stderr, "       %s counters\n", argv[0]);
+        fprintf(stderr, "       %s tick [interval_us] [ticks] [work_us]\n", argv[0]);
+        fprintf(stderr, "       %s tsdb [samples] [file]\n", argv[0]);
+        fprintf(stderr, "       %s scrape [ifaces] [scrapes]\n", argv[0]);
+        return 1;
+    }
+
+    if(strcmp(argv[1], "probe") == 0){
+        const char *target = (argc > 2) ? argv[2] : BENCH_PROBE_TARGET;
+        int rounds = (argc > 3) ? atoi(argv[3]) : BENCH_PROBE_ROUNDS;
+        int count = (argc > 4) ? atoi(argv[4]) : BENCH_PROBE_COUNT;
+
+        if(rounds <= 0 || count <= 0 || count > 65535){
+            fprintf(stderr, "Error: rounds and probes must be positive (probes <= 65535)\n");
+            return 1;
+        }
+
+        return bench_probe(target, rounds, count);
+    }
+
+    if(strcmp(argv[1], "build") == 0){
+        if(argc > 2 && strcmp(argv[2], "verify") == 0){
+            return bench_build_verify();
+        }
+
+        int payload = (argc > 2) ? atoi(argv[2]) : BENCH_BUILD_PAYLOAD;
+
+        if(payload < 0 || payload > BENCH_BUILD_MAX){
+            fprintf(stderr, "Error: payload must be 0-%d bytes\n", BENCH_BUILD_MAX);
+            return 1;
+        }
+
+        return bench_build((size_t)payload);
+    }
+
+    if(strcmp(argv[1], "checksum") == 0){
+        return bench_checksum(argc > 2 && strcmp(argv[2], "verify") == 0);
+    }
+
+    if(strcmp(argv[1], "asn") == 0){
+
+        if(argc < 3){
+            fprintf(stderr, "Error: asn needs a prefix table\n");
+            return 1;
+        }
+
+        return bench_asn(argv[2], argc > 3 ? argv[3] : NULL);
+    }
+
+    if(strcmp(argv[1], "procnet") == 0){
+        int samples = (argc > 2) ? atoi(argv[2]) : BENCH_PROCNET_SAMPLES;
+
+        if(samples <= 0){
+            fprintf(stderr, "Error: samples must be positive\n");
+            return 1;
+        }
+
+        return bench_procnet(samples, argc > 3 ? argv[3] : BENCH_PROCNET_IFACE);
+    }
+
+    if(strcmp(argv[1], "ring") == 0){
+        int window = (argc > 2) ? atoi(argv[2]) : BENCH_RING_WINDOW;
+        int samples = (argc > 3) ? atoi(argv[3]) : BENCH_RING_SAMPLES;
+
+        if(window <= 0 || samples <= 0){
+            fprintf(stderr, "Error: window and samples must be positive\n");
+            return 1;
+        }
+
+        return bench_ring((size_t)window, samples);
+    }
+
+    if(strcmp(argv[1], "counters") == 0){
+        return bench_counters();
+    }
+
+    if(strcmp(argv[1], "tick") == 0){
+        long interval_us = (argc > 2) ? atol(argv[2]) : BENCH_TICK_INTERVAL_US;
+        int count = (argc > 3) ? atoi(argv[3]) : BENCH_TICK_COUNT;
+        long work_us = (argc > 4) ? atol(argv[4]) : BENCH_TICK_WORK_US;
+
+        if(interval_us <= 0 || count <= 0 || work_us < 0){
+            fprintf(stderr, "Error: interval and ticks must be positive, work non-negative\n");
+            return 1;
+        }
+
+        return bench_tick(interval_us, count, work_us);
+    }
+
+    if(strcmp(argv[1], "tsdb") == 0){
+        int samples = (argc > 2) ? atoi(argv[2]) : BENCH_TSDB_SAMPLES;
+
+        if(samples <= 0){
+            fprintf(stderr, "Error: samples must be positive\n");
+            return 1;
+        }
+
+        return bench_tsdb(samples, argc > 3 ? argv[3] : BENCH_TSDB_FILE);
+    }
+
+    if(strcmp(argv[1], "scrape") == 0){
+        int ifaces = (argc > 2) ? atoi(argv[2]) : BENCH_SCRAPE_IFACES;
+        int scrapes = (argc > 3) ? atoi(argv[3]) : BENCH_SCRAPE_COUNT;
+
+        if(ifaces <= 0 || scrapes <= 0){
+            fprintf(stderr, "Error: ifaces and scrapes must be positive\n");
+            return 1;
+        }
+
+        return bench_scrape(ifaces, scrapes);
+    }
+
+    fprintf(stderr, "Error: Unknown benchmark '%s'\n", argv[1]);
+    return 1;
+}
@@ -12,6 +12,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 
 #include "cli.h"
 
@@ -81,6 +82,184 @@ static void parse_range(const char *str, int *from, int *to) {
     }
 }
 
+/*
+ * Function: parse_count
+ *
+ * Parses a non-negative whole number for options like --cycles
+ *
+ * Parameters:
+ *   flag - The option name (used in error messages)
+ *   str  - The input string
+ *
+ * Returns:
+ *   The parsed value (exits on invalid input)
+ */
+static int parse_count(const char *flag, const char *str) {
+
+    char *endptr;
+    long value = strtol(str, &endptr, 10);
+
+    // Check if conversion failed or there were trailing characters
+    if (endptr == str || *endptr != '\0') {
+        fprintf(stderr, "Error: Invalid %s value '%s' (must be a number)\n", flag, str);
+        exit(EXIT_FAILURE);
+    }
+
+    // Counts cannot be negative
+    if (value < 0 || value > 1000000000L) {
+        fprintf(stderr, "Error: %s must be between 0 and 1000000000\n", flag);
+        exit(EXIT_FAILURE);
+    }
+
+    return (int)value;
+}
+
+/*
+ * Function: parse_epoch_ms
+ *
+ * Parses a Unix time in milliseconds for --from / --to (the ts_ms of monitor output)
+ *
+ * Parameters:
+ *   flag - The option name (used in error messages)
+ *   str  - The input string
+ *
+ * Returns:
+ *   The parsed value (exits on invalid input)
+ */
+static long long parse_epoch_ms(const char *flag, const char *str) {
+
+    char *endptr;
+    long long value = strtoll(str, &endptr, 10);
+
+    if (endptr == str || *endptr != '\0' || value < 0 || value == LLONG_MAX) {
+        fprintf(stderr, "Error: Invalid %s value '%s' (must be a Unix time in milliseconds)\n", flag, str);
+        exit(EXIT_FAILURE);
+    }
+
+    return value;
+}
+
+/*
+ * Function: parse_rollup
+ *
+ * Parses a --rollup tier list like "1s:300,1m:1440,1h:168": each tier is a
+ * bucket width (ms, s, m or h) and the number of buckets it keeps
+ *
+ * Parameters:
+ *   str - The input string
+ *   out - CommandLine whose rollup_* fields are filled in
+ *
+ * Returns:
+ *   Nothing (exits on invalid input)
+ */
+static void parse_rollup(const char *str, CommandLine *out) {
+
+    const char *p = str;
+    out->rollup_tiers = 0;
+
+    while (*p) {
+        if (out->rollup_tiers == MAX_ROLLUP_TIERS) {
+            fprintf(stderr, "Error: --rollup allows at most %d tiers\n", MAX_ROLLUP_TIERS);
+            exit(EXIT_FAILURE);
+        }
+
+        // Width: a number followed by its unit
+        char *endptr;
+        long width = strtol(p, &endptr, 10);
+        long long unit_ms = 0;
+
+        if (strncmp(endptr, "ms", 2) == 0) {
+            unit_ms = 1;
+            endptr += 2;
+        } else if (*endptr == 's') {
+            unit_ms = 1000;
+            endptr++;
+        } else if (*endptr == 'm') {
+            unit_ms = 60 * 1000;
+            endptr++;
+        } else if (*endptr == 'h') {
+            unit_ms = 60 * 60 * 1000;
+            endptr++;
+        }
+
+        // Then ":" and the number of buckets
+        long buckets = 0;
+        if (endptr != p && unit_ms > 0 && *endptr == ':') {
+            const char *count = endptr + 1;
+            buckets = strtol(count, &endptr, 10);
+            if (endptr == count) {
+                buckets = 0;
+            }
+        }
+
+        if (width <= 0 || width > 1000000 || unit_ms == 0 || buckets < 1 || buckets > MAX_ROLLUP_BUCKETS ||
+            (*endptr != ',' && *endptr != '\0')) {
+            fprintf(stderr, "Error: Invalid --rollup tiers '%s' (expected <width><ms|s|m|h>:<buckets>,... e.g. 1s:300,1m:1440)\n", str);
+            exit(EXIT_FAILURE);
+        }
+
+        int t = out->rollup_tiers;
+        out->rollup_width_ms[t] = width * unit_ms;
+        out->rollup_buckets[t] = (int)buckets;
+
+        // Coarser tiers must come after finer ones
+        if (t > 0 && out->rollup_width_ms[t] <= out->rollup_width_ms[t - 1]) {
+            fprintf(stderr, "Error: --rollup tier widths must increase (finest first)\n");
+            exit(EXIT_FAILURE);
+        }
+        out->rollup_tiers++;
+
+        p = (*endptr == ',') ? endptr + 1 : endptr;
+    }
+
+    if (out->rollup_tiers == 0) {
+        fprintf(stderr, "Error: --rollup requires at least one tier (e.g. 1s:300,1m:1440,1h:168)\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/*
+ * Function: parse_serve
+ *
+ * Parses a --serve address like ":9100", "127.0.0.1:9100" or "[::1]:9100"
+ *
+ * Parameters:
+ *   str - The input string
+ *   out - CommandLine whose serve_host and serve_port are filled in
+ *
+ * Returns:
+ *   Nothing (exits on invalid input)
+ */
+static void parse_serve(const char *str, CommandLine *out) {
+
+    // The port follows the last ':' (IPv6 hosts are bracketed)
+    const char *colon = strrchr(str, ':');
+    char *endptr = NULL;
+    long port = 0;
+
+    if (colon != NULL) {
+        port = strtol(colon + 1, &endptr, 10);
+    }
+
+    const char *host = str;
+    size_t host_len = (colon != NULL) ? (size_t)(colon - str) : 0;
+    if (host_len >= 2 && host[0] == '[' && host[host_len - 1] == ']') {
+        host++;
+        host_len -= 2;
+    }
+
+    if (colon == NULL || endptr == colon + 1 || *endptr != '\0' || port < MIN_PORT || port > MAX_PORT ||
+        host_len >= sizeof(out->serve_host) || memchr(host, '[', host_len) != NULL ||
+        (memchr(host, ':', host_len) != NULL && host == str)) {
+        fprintf(stderr, "Error: Invalid --serve address '%s' (expected [host]:port, e.g. :9100 or 127.0.0.1:9100)\n", str);
+        exit(EXIT_FAILURE);
+    }
+
+    memcpy(out->serve_host, host, host_len);
+    out->serve_host[host_len] = '\0';
+    out->serve_port = (int)port;
+}
+
 /*
  * Function: cli_parse
  * 
@@ -98,16 +277,51 @@ int cli_parse(int argc, char *argv[], CommandLine *out) {
     // Initializing the struct with default values
     out->json = false;
     out->csv = false;
+    out->dot = false;
     out->mode = MODE_NONE;
     
     out->target[0] = '\0';  
+    out->subnet[0] = '\0';
     out->iface[0] = '\0';
+    out->asn_file[0] = '\0';
     
     out->ports_from = DEFAULT_PORTS_FROM;
     out->ports_to = DEFAULT_PORTS_TO;
+    out->count = DEFAULT_PING_COUNT;
+    out->rate = DEFAULT_SWEEP_RATE;
     out->ttl_start = DEFAULT_TTL_START;
     out->ttl_max = DEFAULT_TTL_MAX;
+    out->queries = DEFAULT_QUERIES;
     out->interval_ms = DEFAULT_INTERVAL_MS;
+    out->interval_us = DEFAULT_INTERVAL_MS * 1000L;
+    out->continuous = false;
+    out->cycles = DEFAULT_CYCLES;
+    out->paris = false;
+    out->enumerate = false;
+    out->flows = DEFAULT_FLOWS;
+    out->proto = PROTO_ICMP;
+    out->port = 0;
+    out->pmtu = false;
+    out->graph = false;
+    out->hop_cache = true;
+    out->stats = STATS_AUTO;
+    out->group = false;
+    out->window = DEFAULT_WINDOW;
+    out->alpha = DEFAULT_ALPHA;
+    out->duration_sec = -1;
+    out->stream = false;
+    out->keep = 0;
+    out->rollup_tiers = 0;
+    out->record_file[0] = '\0';
+    out->replay_file[0] = '\0';
+    out->serve_host[0] = '\0';
+    out->serve_port = 0;
+    out->from_ms = 0;
+    out->to_ms = LLONG_MAX;
+
+    // Remember whether --interval was given so trace mode can pick its own default
+    bool interval_given = false;
+    bool window_given = false, alpha_given = false;   // monitor-only statistics settings
     
     // Checking for help flag
     for (int i = 1; i < argc; i++) {
@@ -151,6 +365,10 @@ int cli_parse(int argc, char *argv[], CommandLine *out) {
         else if (strcmp(argv[i], "--csv") == 0) {
             out->csv = true;
         }
+
+        else if (strcmp(argv[i], "--dot") == 0) {
+            out->dot = true;
+        }
         
         
         else if (strcmp(argv[i], "--target") == 0) {
@@ -170,6 +388,53 @@ int cli_parse(int argc, char *argv[], CommandLine *out) {
             out->target[sizeof(out->target) - 1] = '\0';  
         }
 
+        else if (strcmp(argv[i], "--subnet") == 0) {
+            // Making sure there's a next argument for the CIDR block
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: --subnet requires a CIDR block (ex, 192.168.1.0/24)\n");
+                exit(EXIT_FAILURE);
+            }
+
+            // Copy the value (the sweep itself checks the format)
+            i++;
+            strncpy(out->subnet, argv[i], sizeof(out->subnet) - 1);
+
+            // Making sure there's a null terminator
+            out->subnet[sizeof(out->subnet) - 1] = '\0';
+        }
+
+        else if (strcmp(argv[i], "--count") == 0) {
+            // Making sure there's a next argument
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: --count requires a number of Echo Requests per host\n");
+                exit(EXIT_FAILURE);
+            }
+
+            i++;
+            out->count = parse_count("--count", argv[i]);
+
+            if (out->count < 1 || out->count > MAX_PING_COUNT) {
+                fprintf(stderr, "Error: --count must be in range 1-%d\n", MAX_PING_COUNT);
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        else if (strcmp(argv[i], "--rate") == 0) {
+            // Making sure there's a next argument
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: --rate requires a number of Echo Requests per second\n");
+                exit(EXIT_FAILURE);
+            }
+
+            i++;
+            out->rate = parse_count("--rate", argv[i]);
+
+            if (out->rate < 1 || out->rate > MAX_SWEEP_RATE) {
+                fprintf(stderr, "Error: --rate must be in range 1-%d\n", MAX_SWEEP_RATE);
+                exit(EXIT_FAILURE);
+            }
+        }
+
         else if (strcmp(argv[i], "--ports") == 0) {
             // Making sure there's a next argument
             if (i + 1 >= argc) {
@@ -216,24 +481,283 @@ int cli_parse(int argc, char *argv[], CommandLine *out) {
                 exit(EXIT_FAILURE);
             }
             
-            // Convert to integer using strtol for proper validation
+            // Milliseconds, with a fraction for sub-millisecond monitor sampling (0.25 = 250 us)
             i++;
             char *endptr;
-            long interval_long = strtol(argv[i], &endptr, 10);
+            double interval_ms = strtod(argv[i], &endptr);
             
             // Check if conversion failed 
-            if (endptr == argv[i] || *endptr != '\0') {
+            if (endptr == argv[i] || *endptr != '\0' || interval_ms != interval_ms) {
                 fprintf(stderr, "Error: Invalid interval value '%s' (must be a number)\n", argv[i]);
                 exit(EXIT_FAILURE);
             }
             
-            out->interval_ms = (int)interval_long;
-            
-            // Must be positive 
-            if (out->interval_ms <= 0) {
+            // Must be positive (and at least 1 us once rounded)
+            if (interval_ms < 0.0005) {
                 fprintf(stderr, "Error: Interval must be positive\n");
                 exit(EXIT_FAILURE);
             }
+
+            if (interval_ms > MAX_INTERVAL_MS) {
+                fprintf(stderr, "Error: Interval must be at most %d ms\n", MAX_INTERVAL_MS);
+                exit(EXIT_FAILURE);
+            }
+
+            out->interval_us = (long)(interval_ms * 1000.0 + 0.5);
+            out->interval_ms = (int)(out->interval_us / 1000);
+            interval_given = true;
+        }
+
+        else if (strcmp(argv[i], "--continuous") == 0) {
+            out->continuous = true;
+        }
+
+        else if (strcmp(argv[i], "--cycles") == 0) {
+            // Making sure there's a next argument
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: --cycles requires a number of rounds\n");
+                exit(EXIT_FAILURE);
+            }
+
+            i++;
+            out->cycles = parse_count("--cycles", argv[i]);
+        }
+
+        else if (strcmp(argv[i], "--queries") == 0) {
+            // Making sure there's a next argument
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: --queries requires a number of probes per TTL\n");
+                exit(EXIT_FAILURE);
+            }
+
+            i++;
+            out->queries = parse_count("--queries", argv[i]);
+        }
+
+        else if (strcmp(argv[i], "--paris") == 0) {
+            out->paris = true;
+        }
+
+        else if (strcmp(argv[i], "--enumerate") == 0) {
+            out->enumerate = true;
+        }
+
+        else if (strcmp(argv[i], "--pmtu") == 0) {
+            out->pmtu = true;
+        }
+
+        else if (strcmp(argv[i], "--graph") == 0) {
+            out->graph = true;
+        }
+
+        else if (strcmp(argv[i], "--no-hop-cache") == 0) {
+            out->hop_cache = false;
+        }
+
+        else if (strcmp(argv[i], "--group") == 0) {
+            out->group = true;
+        }
+
+        else if (strcmp(argv[i], "--window") == 0) {
+            // Making sure there's a next argument
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: --window requires a number of samples\n");
+                exit(EXIT_FAILURE);
+            }
+
+            i++;
+            out->window = parse_count("--window", argv[i]);
+            window_given = true;
+
+            if (out->window < 1 || out->window > MAX_WINDOW) {
+                fprintf(stderr, "Error: --window must be in range 1-%d\n", MAX_WINDOW);
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        else if (strcmp(argv[i], "--alpha") == 0) {
+            // Making sure there's a next argument
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: --alpha requires an EWMA weight (0 < alpha <= 1)\n");
+                exit(EXIT_FAILURE);
+            }
+
+            i++;
+            char *endptr;
+            out->alpha = strtod(argv[i], &endptr);
+            alpha_given = true;
+
+            // Rejects trailing characters, NaN and anything outside (0, 1]
+            if (endptr == argv[i] || *endptr != '\0' || !(out->alpha > 0.0 && out->alpha <= 1.0)) {
+                fprintf(stderr, "Error: Invalid --alpha value '%s' (must be > 0 and <= 1)\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        else if (strcmp(argv[i], "--duration") == 0) {
+            // Making sure there's a next argument
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: --duration requires a number of seconds\n");
+                exit(EXIT_FAILURE);
+            }
+
+            i++;
+            out->duration_sec = parse_count("--duration", argv[i]);
+        }
+
+        else if (strcmp(argv[i], "--stream") == 0) {
+            out->stream = true;
+        }
+
+        else if (strcmp(argv[i], "--keep") == 0) {
+            // Making sure there's a next argument
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: --keep requires a number of samples\n");
+                exit(EXIT_FAILURE);
+            }
+
+            i++;
+            out->keep = parse_count("--keep", argv[i]);
+
+            if (out->keep < 1 || out->keep > MAX_KEEP) {
+                fprintf(stderr, "Error: --keep must be in range 1-%d\n", MAX_KEEP);
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        else if (strcmp(argv[i], "--rollup") == 0) {
+            // Making sure there's a next argument
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: --rollup requires a tier list (e.g. 1s:300,1m:1440,1h:168)\n");
+                exit(EXIT_FAILURE);
+            }
+
+            i++;
+            parse_rollup(argv[i], out);
+        }
+
+        else if (strcmp(argv[i], "--record") == 0 || strcmp(argv[i], "--replay") == 0) {
+            bool record = (strcmp(argv[i], "--record") == 0);
+
+            // Making sure there's a next argument
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: %s requires a file path\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+
+            i++;
+            char *file = record ? out->record_file : out->replay_file;
+            strncpy(file, argv[i], sizeof(out->record_file) - 1);
+            file[sizeof(out->record_file) - 1] = '\0';
+        }
+
+        else if (strcmp(argv[i], "--serve") == 0) {
+
+            // Making sure there's a next argument
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: --serve requires an address (e.g. :9100)\n");
+                exit(EXIT_FAILURE);
+            }
+
+            i++;
+            parse_serve(argv[i], out);
+        }
+
+        else if (strcmp(argv[i], "--from") == 0 || strcmp(argv[i], "--to") == 0) {
+            bool from = (strcmp(argv[i], "--from") == 0);
+
+            // Making sure there's a next argument
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: %s requires a Unix time in milliseconds\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+
+            i++;
+            if (from) {
+                out->from_ms = parse_epoch_ms("--from", argv[i]);
+            } else {
+                out->to_ms = parse_epoch_ms("--to", argv[i]);
+            }
+        }
+
+        else if (strcmp(argv[i], "--asn") == 0) {
+            // Making sure there's a next argument
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: --asn requires a prefix-to-AS table file\n");
+                exit(EXIT_FAILURE);
+            }
+
+            i++;
+            if (strlen(argv[i]) >= sizeof(out->asn_file)) {
+                fprintf(stderr, "Error: --asn file name too long\n");
+                exit(EXIT_FAILURE);
+            }
+            strcpy(out->asn_file, argv[i]);
+        }
+
+        else if (strcmp(argv[i], "--flows") == 0) {
+            // Making sure there's a next argument
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: --flows requires a probe budget per TTL\n");
+                exit(EXIT_FAILURE);
+            }
+
+            i++;
+            out->flows = parse_count("--flows", argv[i]);
+        }
+
+        else if (strcmp(argv[i], "--proto") == 0) {
+            // Making sure there's a next argument
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: --proto requires a probe type (icmp, udp or tcp)\n");
+                exit(EXIT_FAILURE);
+            }
+
+            i++;
+            if (strcmp(argv[i], "icmp") == 0) {
+                out->proto = PROTO_ICMP;
+            } else if (strcmp(argv[i], "udp") == 0) {
+                out->proto = PROTO_UDP;
+            } else if (strcmp(argv[i], "tcp") == 0) {
+                out->proto = PROTO_TCP;
+            } else {
+                fprintf(stderr, "Error: Invalid --proto value '%s' (must be icmp, udp or tcp)\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        else if (strcmp(argv[i], "--stats") == 0) {
+            // Making sure there's a next argument
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: --stats requires a counter source (netlink or procfs)\n");
+                exit(EXIT_FAILURE);
+            }
+
+            i++;
+            if (strcmp(argv[i], "netlink") == 0) {
+                out->stats = STATS_NETLINK;
+            } else if (strcmp(argv[i], "procfs") == 0) {
+                out->stats = STATS_PROCFS;
+            } else {
+                fprintf(stderr, "Error: Invalid --stats value '%s' (must be netlink or procfs)\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        else if (strcmp(argv[i], "--port") == 0) {
+            // Making sure there's a next argument
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: --port requires a port number\n");
+                exit(EXIT_FAILURE);
+            }
+
+            i++;
+            out->port = parse_count("--port", argv[i]);
+
+            if (out->port < MIN_PORT || out->port > MAX_PORT) {
+                fprintf(stderr, "Error: --port must be in range %d-%d\n", MIN_PORT, MAX_PORT);
+                exit(EXIT_FAILURE);
+            }
         }
         
         else {
@@ -251,9 +775,20 @@ int cli_parse(int argc, char *argv[], CommandLine *out) {
         exit(EXIT_FAILURE);
     }
     
+    // A scan is either a port scan of --target or a ping sweep of --subnet
+    if (out->mode == MODE_SCAN && out->target[0] != '\0' && out->subnet[0] != '\0') {
+        fprintf(stderr, "Error: Cannot use both --target and --subnet\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (out->subnet[0] != '\0' && out->mode != MODE_SCAN) {
+        fprintf(stderr, "Error: --subnet is only valid with --scan\n");
+        exit(EXIT_FAILURE);
+    }
+
     // Check that --scan and --trace have a target
     if ((out->mode == MODE_SCAN || out->mode == MODE_TRACE) && 
-        out->target[0] == '\0') {
+        out->target[0] == '\0' && out->subnet[0] == '\0') {
         fprintf(stderr, "Error: --target required for %s mode\n", out->mode == MODE_SCAN ? "scan" : "trace");
         exit(EXIT_FAILURE);
     }
@@ -263,8 +798,25 @@ int cli_parse(int argc, char *argv[], CommandLine *out) {
         fprintf(stderr, "Error: Cannot use both --json and --csv\n");
         exit(EXIT_FAILURE);
     }
+
+    // DOT is a graph format: only the topology graph has one
+    if (out->dot && (out->json || out->csv)) {
+        fprintf(stderr, "Error: Cannot combine --dot with --json or --csv\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (out->dot && !(out->mode == MODE_TRACE && out->graph)) {
+        fprintf(stderr, "Error: --dot is only valid with --trace --graph\n");
+        exit(EXIT_FAILURE);
+    }
     
 
+    // AS annotation applies to hop listings, sweep hosts and scan targets
+    if (out->asn_file[0] != '\0' && out->mode == MODE_MONITOR) {
+        fprintf(stderr, "Error: --asn is only valid with --scan or --trace\n");
+        exit(EXIT_FAILURE);
+    }
+
     // Check that options make sense for the selected mode
     
     // SCAN mode: validate port range was specified correctly
@@ -281,11 +833,156 @@ int cli_parse(int argc, char *argv[], CommandLine *out) {
             fprintf(stderr, "Error: TTL values must be in range %d-%d\n", MIN_TTL, MAX_TTL);
             exit(EXIT_FAILURE);
         }
+
+        // Enumeration sends a burst of flows per TTL; it has no continuous form
+        if (out->enumerate && out->continuous) {
+            fprintf(stderr, "Error: Cannot combine --enumerate with --continuous\n");
+            exit(EXIT_FAILURE);
+        }
+
+        if (out->queries < 1 || out->queries > MAX_QUERIES) {
+            fprintf(stderr, "Error: --queries must be in range 1-%d\n", MAX_QUERIES);
+            exit(EXIT_FAILURE);
+        }
+
+        // Continuous, enumeration and PMTU modes pace their own probes
+        if (out->queries > 1 && (out->continuous || out->enumerate || out->pmtu)) {
+            fprintf(stderr, "Error: --queries cannot be combined with --continuous, --enumerate or --pmtu\n");
+            exit(EXIT_FAILURE);
+        }
+
+        if (out->flows < 1 || out->flows > MAX_FLOWS) {
+            fprintf(stderr, "Error: --flows must be in range 1-%d\n", MAX_FLOWS);
+            exit(EXIT_FAILURE);
+        }
+
+        // Paris/enumeration steer the flow through the ICMP checksum; TCP probes keep
+        // one 5-tuple anyway and UDP probes change it on purpose
+        if ((out->paris || out->enumerate) && out->proto != PROTO_ICMP) {
+            fprintf(stderr, "Error: --paris and --enumerate require --proto icmp\n");
+            exit(EXIT_FAILURE);
+        }
+
+        // PMTU discovery sends its own DF Echo probes, one size at a time
+        if (out->pmtu && (out->continuous || out->enumerate || out->paris || out->proto != PROTO_ICMP)) {
+            fprintf(stderr, "Error: --pmtu cannot be combined with --continuous, --enumerate, --paris or --proto\n");
+            exit(EXIT_FAILURE);
+        }
+
+        // The topology graph merges ordinary traces, one per target
+        if (out->graph && (out->continuous || out->enumerate || out->pmtu)) {
+            fprintf(stderr, "Error: --graph cannot be combined with --continuous, --enumerate or --pmtu\n");
+            exit(EXIT_FAILURE);
+        }
+
+        // Continuous, PMTU and graph output have no per-hop AS columns
+        if (out->asn_file[0] != '\0' && (out->continuous || out->pmtu || out->graph)) {
+            fprintf(stderr, "Error: --asn cannot be combined with --continuous, --pmtu or --graph\n");
+            exit(EXIT_FAILURE);
+        }
+
+        // Only PMTU discovery and the topology graph take several targets
+        if (!out->pmtu && !out->graph && (strchr(out->target, ',') != NULL || out->target[0] == '@')) {
+            fprintf(stderr, "Error: Multiple targets require --pmtu or --graph\n");
+            exit(EXIT_FAILURE);
+        }
+
+        if (out->port != 0 && out->proto == PROTO_ICMP) {
+            fprintf(stderr, "Error: --port requires --proto udp or --proto tcp\n");
+            exit(EXIT_FAILURE);
+        }
+
+        if (out->port == 0) {
+            out->port = (out->proto == PROTO_TCP) ? DEFAULT_TCP_PORT : DEFAULT_UDP_PORT;
+        }
+
+        // Continuous mode paces rounds once a second unless told otherwise
+        if (out->continuous && !interval_given) {
+            out->interval_ms = DEFAULT_TRACE_INTERVAL_MS;
+            out->interval_us = DEFAULT_TRACE_INTERVAL_MS * 1000L;
+        }
+
+        // Rounds are paced in whole milliseconds
+        if (out->interval_us % 1000 != 0) {
+            fprintf(stderr, "Error: Fractional --interval is only valid with --monitor\n");
+            exit(EXIT_FAILURE);
+        }
     }
     
+    if (out->stats != STATS_AUTO && out->mode != MODE_MONITOR) {
+        fprintf(stderr, "Error: --stats is only valid with --monitor\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (out->group && out->mode != MODE_MONITOR) {
+        fprintf(stderr, "Error: --group is only valid with --monitor\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if ((window_given || alpha_given) && out->mode != MODE_MONITOR) {
+        fprintf(stderr, "Error: --window and --alpha are only valid with --monitor\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if ((out->duration_sec >= 0 || out->stream || out->keep > 0) && out->mode != MODE_MONITOR) {
+        fprintf(stderr, "Error: --duration, --stream and --keep are only valid with --monitor\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (out->rollup_tiers > 0 && out->mode != MODE_MONITOR) {
+        fprintf(stderr, "Error: --rollup is only valid with --monitor\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if ((out->record_file[0] != '\0' || out->replay_file[0] != '\0') && out->mode != MODE_MONITOR) {
+        fprintf(stderr, "Error: --record and --replay are only valid with --monitor\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (out->serve_port > 0 && out->mode != MODE_MONITOR) {
+        fprintf(stderr, "Error: --serve is only valid with --monitor\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if ((out->from_ms != 0 || out->to_ms != LLONG_MAX) && out->replay_file[0] == '\0') {
+        fprintf(stderr, "Error: --from and --to are only valid with --replay\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (out->from_ms > out->to_ms) {
+        fprintf(stderr, "Error: --from must not be after --to\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // A replay prints a stored run: nothing is sampled, so sampling options make no sense
+    if (out->replay_file[0] != '\0' &&
+        (out->iface[0] != '\0' || interval_given || out->stats != STATS_AUTO || out->duration_sec >= 0 ||
+         out->stream || out->keep > 0 || out->rollup_tiers > 0 || out->record_file[0] != '\0' ||
+         out->serve_port > 0)) {
+        fprintf(stderr, "Error: --replay only combines with --from, --to, --window, --alpha, --group and output options\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // The rollup history replaces the raw sample list at the end of the run
+    if (out->rollup_tiers > 0 && (out->keep > 0 || out->group)) {
+        fprintf(stderr, "Error: --rollup cannot be combined with --keep or --group\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Streamed samples are printed and dropped: there is nothing left to keep or regroup
+    if (out->stream && out->keep > 0) {
+        fprintf(stderr, "Error: --keep cannot be combined with --stream\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (out->stream && out->group) {
+        fprintf(stderr, "Error: --group cannot be combined with --stream\n");
+        exit(EXIT_FAILURE);
+    }
+
     // MONITOR mode: validate interval 
     if (out->mode == MODE_MONITOR) {
-        if (out->interval_ms <= 0) {
+        if (out->interval_us <= 0) {
             fprintf(stderr, "Error: Interval must be positive\n");
             exit(EXIT_FAILURE);
         }
@@ -307,33 +1004,82 @@ void cli_print_help() {
     printf("WireFish - Network reconnaissance and monitoring tool\n\n");
     
     printf("Modes (choose one):\n");
-    printf("  --scan              TCP port scanning\n");
-    printf("  --trace             ICMP traceroute\n");
+    printf("  --scan              TCP port scanning, or ICMP ping sweep with --subnet\n");
+    printf("  --trace             Traceroute (ICMP, UDP or TCP probes)\n");
     printf("  --monitor           Network interface monitoring\n\n");
     
     printf("Scan Options:\n");
     printf("  --target <host>     Target hostname or IP (required)\n");
-    printf("  --ports <from-to>   Port range (default: %d-%d)\n\n", DEFAULT_PORTS_FROM, DEFAULT_PORTS_TO);
+    printf("  --ports <from-to>   Port range (default: %d-%d)\n", DEFAULT_PORTS_FROM, DEFAULT_PORTS_TO);
+    printf("  --subnet <cidr>     Ping sweep a block instead (ex, 10.0.0.0/24; up to a /16)\n");
+    printf("  --count <n>         Echo Requests per host (default: %d)\n", DEFAULT_PING_COUNT);
+    printf("  --rate <pps>        Echo Requests per second (default: %d)\n\n", DEFAULT_SWEEP_RATE);
     
     printf("Trace Options:\n");
     printf("  --target <host>     Target hostname or IP (required)\n");
-    printf("  --ttl <start-max>   TTL range (default: %d-%d)\n\n", DEFAULT_TTL_START, DEFAULT_TTL_MAX);
+    printf("  --ttl <start-max>   TTL range (default: %d-%d)\n", DEFAULT_TTL_START, DEFAULT_TTL_MAX);
+    printf("  --queries <n>       Probes per TTL, sent together (default: %d, max %d)\n", DEFAULT_QUERIES, MAX_QUERIES);
+    printf("  --proto <type>      Probe type: icmp, udp or tcp (default: icmp)\n");
+    printf("  --port <n>          UDP base port (default: %d) or TCP port (default: %d)\n", DEFAULT_UDP_PORT, DEFAULT_TCP_PORT);
+    printf("  --continuous        Keep probing every hop (MTR-style loss/RTT/jitter stats)\n");
+    printf("  --cycles <n>        Rounds in continuous mode (default: %d = until Ctrl+C)\n", DEFAULT_CYCLES);
+    printf("  --interval <ms>     Time between continuous rounds (default: %d)\n", DEFAULT_TRACE_INTERVAL_MS);
+    printf("  --paris             Flow-stable probes (same ECMP path for every TTL)\n");
+    printf("  --enumerate         Vary the flow to list every load-balanced next hop\n");
+    printf("  --flows <n>         Probe budget per TTL for --enumerate (default: %d)\n", DEFAULT_FLOWS);
+    printf("  --pmtu              Find the path MTU instead (--target may list hosts: a,b,c)\n");
+    printf("  --graph             Merge the paths to many targets into one topology graph\n");
+    printf("                      (--target a,b,c or @file with one host per line)\n");
+    printf("  --no-hop-cache      Probe every TTL of every target, even hops shared by earlier traces\n");
+    printf("  --asn <file>        Tag each hop with its origin AS (also for --scan)\n");
+    printf("                      (CSV prefix/len,asn or pfx2as dump; or a table prebuilt by wirefish-bench asn)\n\n");
     
     printf("Monitor Options:\n");
-    printf("  --iface <name>      Network interface (default: auto-detect)\n");
-    printf("  --interval <ms>     Sample interval in milliseconds (default: %d)\n\n", DEFAULT_INTERVAL_MS);
+    printf("  --iface <name>      Network interface (default: auto-detect); \"all\" or globs\n");
+    printf("                      such as eth*,bond0 watch every match from one sample\n");
+    printf("  --interval <ms>     Sample interval in milliseconds, fractions allowed (default: %d)\n", DEFAULT_INTERVAL_MS);
+    printf("  --stats <source>    Counter source: netlink or procfs (default: netlink, else procfs)\n");
+    printf("  --group             List samples interface by interface instead of interleaved\n");
+    printf("  --window <n>        Samples in the rolling mean/min/max/stddev window (default: %d)\n", DEFAULT_WINDOW);
+    printf("  --alpha <a>         EWMA weight of each new sample, 0 < a <= 1 (default: %.1f)\n", DEFAULT_ALPHA);
+    printf("  --duration <s>      Run time in seconds, 0 = until Ctrl+C (default: 10 intervals)\n");
+    printf("  --stream            Print each sample as it is taken (JSON: one object per line)\n");
+    printf("  --keep <n>          Report only the last n samples, held in a fixed ring\n");
+    printf("  --rollup <tiers>    Report min/max/avg/last history instead of samples, e.g.\n");
+    printf("                      1s:300,1m:1440,1h:168 (bucket width:buckets kept, finest first)\n");
+    printf("  --record <file>     Also append every sample to a compact time-series file\n");
+    printf("  --replay <file>     Print the samples stored in a --record file instead of sampling\n");
+    printf("  --from <ms>         With --replay: first Unix time (ms) to print\n");
+    printf("  --to <ms>           With --replay: last Unix time (ms) to print\n");
+    printf("  --serve <addr>      Serve Prometheus metrics at http://<addr>/metrics, e.g. :9100\n");
+    printf("                      (runs until Ctrl+C unless --duration is given)\n\n");
     
     printf("Output Options:\n");
     printf("  --json              Output in JSON format\n");
-    printf("  --csv               Output in CSV format\n\n");
+    printf("  --csv               Output in CSV format\n");
+    printf("  --dot               Output in Graphviz DOT format (--graph only)\n\n");
     
     printf("Other:\n");
     printf("  --help              Show this help message\n\n");
     
     printf("Examples:\n");
     printf("  wirefish --scan --target google.com --ports 80-443\n");
+    printf("  wirefish --scan --subnet 192.168.1.0/24 --count 5\n");
     printf("  wirefish --trace --target 8.8.8.8 --json\n");
+    printf("  wirefish --trace --target 8.8.8.8 --asn routeviews-pfx2as.txt\n");
+    printf("  wirefish --trace --target 8.8.8.8 --queries 3\n");
+    printf("  wirefish --trace --target 8.8.8.8 --continuous --cycles 60\n");
+    printf("  wirefish --trace --target 8.8.8.8 --enumerate --flows 32\n");
+    printf("  wirefish --trace --target example.com --proto tcp --port 443\n");
+    printf("  wirefish --trace --pmtu --target 10.0.0.1,example.com\n");
+    printf("  wirefish --trace --graph --target @hosts.txt --dot | dot -Tsvg > paths.svg\n");
     printf("  wirefish --monitor --iface eth0 --interval 500\n");
+    printf("  wirefish --monitor --iface 'eth*,bond*' --group\n");
+    printf("  wirefish --monitor --iface all --duration 0 --stream --json\n");
+    printf("  wirefish --monitor --iface eth0 --duration 0 --rollup 1s:300,1m:1440,1h:168\n");
+    printf("  wirefish --monitor --iface all --duration 0 --stream --record eth.wfts\n");
+    printf("  wirefish --monitor --replay eth.wfts --from 1767225600000 --csv\n");
+    printf("  wirefish --monitor --iface all --serve :9100\n");
 }
 
 
@@ -24,6 +24,25 @@
 #define DEFAULT_TTL_START 1
 #define DEFAULT_TTL_MAX 30
 #define DEFAULT_INTERVAL_MS 100
+#define MAX_INTERVAL_MS 86400000         // --interval upper bound (one day)
+#define DEFAULT_TRACE_INTERVAL_MS 1000   // round interval for --trace --continuous
+#define DEFAULT_CYCLES 0                 // 0 = run until Ctrl+C
+#define DEFAULT_FLOWS 64                 // probe budget per TTL for --enumerate
+#define MAX_FLOWS 1024
+#define DEFAULT_QUERIES 1                // probes per TTL for --trace
+#define MAX_QUERIES 10                   // must not exceed HOP_MAX_QUERIES (model.h)
+#define DEFAULT_UDP_PORT 33434           // first destination port of --proto udp probes
+#define DEFAULT_TCP_PORT 80              // destination port of --proto tcp probes
+#define DEFAULT_PING_COUNT 3             // Echo Requests per host for --scan --subnet
+#define MAX_PING_COUNT 100
+#define DEFAULT_SWEEP_RATE 20000         // Echo Requests per second for --scan --subnet
+#define MAX_SWEEP_RATE 1000000
+#define DEFAULT_WINDOW 10                // rolling window (samples) for --monitor statistics
+#define MAX_WINDOW 1000000
+#define DEFAULT_ALPHA 0.3                // EWMA weight of each new monitor sample
+#define MAX_KEEP 1000000                 // --keep upper bound (samples held for the final report)
+#define MAX_ROLLUP_TIERS 4               // must not exceed ROLLUP_MAX_TIERS (rollup.h)
+#define MAX_ROLLUP_BUCKETS 1000000       // buckets per --rollup tier
 
 #define MIN_PORT 1
 #define MAX_PORT 65535
@@ -32,13 +51,58 @@
 
 typedef struct{
     bool json, csv;
+    bool dot;          // Graphviz output (--graph only)
 
     char target[256];
-    char iface[64];
+    char subnet[64];   // --scan --subnet: CIDR block to ping sweep instead of a port scan
+    char iface[256];   // --monitor: interface name, "all", or comma list of globs (eth*,bond0)
+    char asn_file[256]; // --asn: prefix-to-AS table (text dump or prebuilt binary), "" = off
+    char record_file[256]; // --monitor --record: time-series file samples are appended to, "" = off
+    char replay_file[256]; // --monitor --replay: time-series file to print instead of sampling, "" = off
+    char serve_host[64];   // --monitor --serve: metrics listen address, "" = every address
 
     int ports_from, ports_to;
+    int count;         // Echo Requests per host (ping sweep)
+    int rate;          // Echo Requests per second (ping sweep)
     int ttl_start, ttl_max;
+    int queries;       // probes per TTL, all in flight at once
     int interval_ms;
+    long interval_us;  // --interval in microseconds (monitor may use fractions of a ms)
+
+    bool continuous;   // --trace --continuous (MTR-style)
+    int cycles;        // probe rounds in continuous mode (0 = forever)
+
+    bool paris;        // keep the ECMP flow identifier constant
+    bool enumerate;    // vary the flow to find every load-balanced next hop
+    int flows;         // probe budget per TTL when enumerating
+
+    enum{
+        PROTO_ICMP=0,
+        PROTO_UDP,
+        PROTO_TCP
+    }proto;            // traceroute probe type
+    int port;          // UDP base port / TCP destination port (0 = protocol default)
+
+    bool pmtu;         // path MTU discovery instead of a hop listing (target may be a comma list)
+    bool graph;        // merge the traces of many targets into one topology graph
+    bool hop_cache;    // copy near-side hops shared with earlier traces instead of probing them
+
+    enum{
+        STATS_AUTO=0,
+        STATS_NETLINK,
+        STATS_PROCFS
+    }stats;            // monitor counter source (auto = netlink, else /proc/net/dev)
+    bool group;        // monitor output ordered by interface instead of by sample time
+    int window;        // monitor rolling window length in samples
+    double alpha;      // monitor EWMA weight, 0 < alpha <= 1
+    int duration_sec;  // monitor run time in seconds (0 = until Ctrl+C, -1 = default sample count)
+    bool stream;       // print each monitor sample as it is taken instead of at the end
+    int keep;          // monitor samples held for the final report (0 = all)
+    int rollup_tiers;  // --rollup: number of history tiers (0 = off), finest first
+    long long rollup_width_ms[MAX_ROLLUP_TIERS];  // bucket width of each tier
+    int rollup_buckets[MAX_ROLLUP_TIERS];         // buckets kept by each tier
+    long long from_ms, to_ms;  // --replay time range (Unix epoch ms, inclusive)
+    int serve_port;    // --serve: Prometheus metrics port (0 = off)
 
     enum{
         MODE_NONE=0,
@@ -7,7 +7,7 @@
  *  - Keep schemas stable for tooling integration
  * 
  * Responsibilities:
- * - Render ScanTable, TraceRoute, MonitorSeries in consistent schema
+ * - Render ScanTable, SweepTable, TraceRoute, PathStats, PmtuTable, MonitorSeries in consistent schema
  * - Avoid business logic; pure presentation
  * 
  * Author: Shan Truong - 400576105 - truons8
@@ -21,6 +21,7 @@
 #include <stdbool.h>
 #include <netinet/ip_icmp.h>  // ICMP_ECHOREPLY, ICMP_TIME_EXCEEDED
 #include <string.h>
+#include <time.h>     // localtime_r(), strftime() for rollup bucket times
 
 /**
  * Helper to convert PortState enum to string.
@@ -46,6 +47,88 @@ static const char *port_state_str(int state){
     }
 }
 
+/**
+ * Helper to print an AS number as "AS64500", or "-" if no route matched.
+ * @param buf Output buffer
+ * @param len Size of output buffer
+ * @param asn AS number (0 if unknown)
+ * @return void
+ */
+static void format_asn(char *buf, size_t len, unsigned int asn){
+
+    if(asn == 0){
+        snprintf(buf, len, "-");
+    }
+    else{
+        snprintf(buf, len, "AS%u", asn);
+    }
+}
+
+/**
+ * Helper to print the "asn" and "prefix" JSON members (null if no route matched).
+ * @param asn AS number (0 if unknown)
+ * @param prefix Matched prefix ("" if unknown)
+ * @return void
+ */
+static void print_json_asn(unsigned int asn, const char *prefix){
+
+    if(asn == 0){
+        printf("\"asn\":null,\"prefix\":null");
+    }
+    else{
+        printf("\"asn\":%u,\"prefix\":\"%s\"", asn, prefix);
+    }
+}
+
+/**
+ * Helper to print the asn,prefix CSV fields (empty if no route matched).
+ * @param asn AS number (0 if unknown)
+ * @param prefix Matched prefix ("" if unknown)
+ * @return void
+ */
+static void print_csv_asn(unsigned int asn, const char *prefix){
+
+    if(asn == 0){
+        printf(",,");
+    }
+    else{
+        printf(",%u,%s", asn, prefix);
+    }
+}
+
+/**
+ * Helper to list the per-query results of a hop, e.g. "0.071 0.065 *".
+ * @param buf Output buffer
+ * @param len Size of output buffer
+ * @param h Hop (h->queries probes)
+ * @param sep Separator between queries
+ * @param ips true to list responders instead of RTTs
+ * @return void
+ */
+static void format_queries(char *buf, size_t len, const Hop *h, char sep, bool ips){
+
+    size_t off = 0;
+    buf[0] = '\0';
+
+    for(int q = 0; q < h->queries && off + 1 < len; q++){
+
+        if(q > 0){
+            buf[off++] = sep;
+            buf[off] = '\0';
+        }
+
+        if(ips){
+            off += (size_t)snprintf(buf + off, len - off, "%s", h->query_ip[q]);
+        }
+        else if(h->query_rtt_us[q] < 0){
+            off += (size_t)snprintf(buf + off, len - off, "*");
+        }
+        else{
+            off += (size_t)snprintf(buf + off, len - off, "%.3f", h->query_rtt_us[q] / 1000.0);
+        }
+    }
+}
+
 /**
  * Format ScanTable in table format.
  * @param scan_table Pointer to ScanTable
@@ -53,6 +136,14 @@ static const char *port_state_str(int state){
  */
 static void fmt_scan_table_table(const ScanTable *scan_table){
 
+    // Who owns the target (--asn)
+    if(scan_table->has_asn){
+
+        char asn_buf[16];
+        format_asn(asn_buf, sizeof(asn_buf), scan_table->asn);
+        printf("Target %s  %s  %s\n\n", scan_table->ip, asn_buf, scan_table->prefix[0] ? scan_table->prefix : "-");
+    }
+
     printf("PORT  STATE      LATENCY(ms)\n");
     printf("----  ---------  ----------\n");
 
@@ -80,7 +171,7 @@ static void fmt_scan_table_table(const ScanTable *scan_table){
  */
 static void fmt_scan_table_csv(const ScanTable *scan_table){
 
-    printf("port,state,latency_ms\n");
+    printf("port,state,latency_ms%s\n", scan_table->has_asn ? ",asn,prefix" : "");
 
     for(size_t i = 0; i < scan_table->len; i++){
 
@@ -89,13 +180,17 @@ static void fmt_scan_table_csv(const ScanTable *scan_table){
         printf("%d,%s,", row->port, port_state_str(row->state));
 
         if(row->latency_ms >= 0){
-            printf("%d\n", row->latency_ms);
+            printf("%d", row->latency_ms);
         } 
-        
-        else{
-            // no latency measured → leave blank field
-            printf("\n");
+
+        // no latency measured → leave blank field
+
+        // Target's AS repeated on every row (--asn)
+        if(scan_table->has_asn){
+            print_csv_asn(scan_table->asn, scan_table->prefix);
         }
+
+        printf("\n");
     }
 }
 
@@ -106,7 +201,16 @@ static void fmt_scan_table_csv(const ScanTable *scan_table){
  */
 static void fmt_scan_table_json(const ScanTable *scan_table){
 
-    printf("{\"type\":\"scan\",\"results\":[");
+    printf("{\"type\":\"scan\",");
+
+    // Who owns the target (--asn)
+    if(scan_table->has_asn){
+        printf("\"ip\":\"%s\",", scan_table->ip);
+        print_json_asn(scan_table->asn, scan_table->prefix);
+        printf(",");
+    }
+
+    printf("\"results\":[");
     
     for(size_t i = 0; i < scan_table->len; i++){
 
@@ -152,6 +256,123 @@ void fmt_scan_table(const struct ScanTable *table, bool json, bool csv){
     }
 }
 
+/**
+ * Format SweepTable in table format.
+ * @param table Pointer to SweepTable
+ * @return void
+ */
+static void fmt_sweep_table_table(const SweepTable *table){
+
+    printf("IP               SENT  RECV  LOSS%%   MIN(ms)  AVG(ms)  MAX(ms)  MDEV(ms)%s\n", table->has_asn ? "  AS        PREFIX" : "");
+    printf("---------------- ----  ----  ------  -------  -------  -------  --------%s\n", table->has_asn ? "  --------  ------------------" : "");
+
+    for(size_t i = 0; i < table->len; i++){
+
+        const HostPing *h = &table->rows[i];
+
+        double loss = 100.0 * (double)(h->sent - h->received) / (double)h->sent;
+
+        printf("%-16s %-4lu  %-4lu  %5.1f%%  %-7.3f  %-7.3f  %-7.3f  %-8.3f",
+               h->ip, h->sent, h->received, loss,
+               h->min_us / 1000.0, h->avg_us / 1000.0, h->max_us / 1000.0, h->mdev_us / 1000.0);
+
+        if(table->has_asn){
+
+            char asn_buf[16];
+            format_asn(asn_buf, sizeof(asn_buf), h->asn);
+            printf("  %-8s  %s", asn_buf, h->prefix[0] ? h->prefix : "-");
+        }
+
+        printf("\n");
+    }
+
+    printf("\n%zu of %lu hosts up in %s (%d requests per host)\n",
+           table->len, table->hosts, table->subnet, table->count);
+}
+
+/**
+ * Format SweepTable in CSV format.
+ * @param table Pointer to SweepTable
+ * @return void
+ */
+static void fmt_sweep_table_csv(const SweepTable *table){
+
+    printf("ip,sent,received,loss_pct,min_ms,avg_ms,max_ms,mdev_ms%s\n", table->has_asn ? ",asn,prefix" : "");
+
+    for(size_t i = 0; i < table->len; i++){
+
+        const HostPing *h = &table->rows[i];
+
+        printf("%s,%lu,%lu,%.1f,%.3f,%.3f,%.3f,%.3f",
+               h->ip, h->sent, h->received,
+               100.0 * (double)(h->sent - h->received) / (double)h->sent,
+               h->min_us / 1000.0, h->avg_us / 1000.0, h->max_us / 1000.0, h->mdev_us / 1000.0);
+
+        if(table->has_asn){
+            print_csv_asn(h->asn, h->prefix);
+        }
+
+        printf("\n");
+    }
+}
+
+/**
+ * Format SweepTable in JSON format.
+ * @param table Pointer to SweepTable
+ * @return void
+ */
+static void fmt_sweep_table_json(const SweepTable *table){
+
+    printf("{\"type\":\"sweep\",\"subnet\":\"%s\",\"hosts\":%lu,\"hosts_up\":%zu,\"count\":%d,\"results\":[",
+           table->subnet, table->hosts, table->len, table->count);
+
+    for(size_t i = 0; i < table->len; i++){
+
+        const HostPing *h = &table->rows[i];
+
+        if(i > 0){
+            printf(",");
+        }
+
+        printf("{\"ip\":\"%s\",\"sent\":%lu,\"received\":%lu,\"loss_pct\":%.1f,"
+               "\"min_ms\":%.3f,\"avg_ms\":%.3f,\"max_ms\":%.3f,\"mdev_ms\":%.3f",
+               h->ip, h->sent, h->received,
+               100.0 * (double)(h->sent - h->received) / (double)h->sent,
+               h->min_us / 1000.0, h->avg_us / 1000.0, h->max_us / 1000.0, h->mdev_us / 1000.0);
+
+        if(table->has_asn){
+            printf(",");
+            print_json_asn(h->asn, h->prefix);
+        }
+
+        printf("}");
+    }
+
+    printf("]}\n");
+}
+
+/**
+ * Format SweepTable in specified format.
+ * @param table Pointer to SweepTable
+ * @param json If true, output in JSON format
+ * @param csv If true, output in CSV format
+ * @return void
+ */
+void fmt_sweep_table(const struct SweepTable *table, bool json, bool csv){
+
+    if(json){
+        fmt_sweep_table_json(table);
+    }
+
+    else if(csv){
+        fmt_sweep_table_csv(table);
+    }
+
+    else{
+        fmt_sweep_table_table(table);
+    }
+}
+
 /**
  * Format TraceRoute in CSV format.
  * @param route Pointer to TraceRoute
@@ -159,30 +380,47 @@ void fmt_scan_table(const struct ScanTable *table, bool json, bool csv){
  */
 static void fmt_traceroute_csv(const TraceRoute *route){
 
-    printf("hop,ip,host,rtt_ms,timeout\n");
+    printf("hop,ip,host,rtt_ms,timeout%s%s\n", route->has_asn ? ",asn,prefix" : "", route->queries > 1 ? ",rtts_ms,responders" : "");
+
+    // rtt_ms keeps its name but now carries microsecond precision (e.g. 0.042)
 
     for(size_t i = 0; i < route->len; i++){
 
         const Hop *current_hop = &route->rows[i];
 
         //Note: For safety, we could quote host if it might contain commas, but for now assume it doesn't. Ask team if needed.
-        if(current_hop->rtt_ms >= 0 && !current_hop->timeout){
-            printf("%d,%s,%s,%d,%s\n",
+        if(current_hop->rtt_us >= 0 && !current_hop->timeout){
+            printf("%d,%s,%s,%.3f,%s",
                    current_hop->hop,
                    current_hop->ip,
                    current_hop->host,
-                   current_hop->rtt_ms,
+                   current_hop->rtt_us / 1000.0,
                    current_hop->timeout ? "true" : "false");
         } 
         
         else{
             // timeout or unknown RTT (Round Trip Time)
-            printf("%d,%s,%s,-,%s\n",
+            printf("%d,%s,%s,-,%s",
                    current_hop->hop,
                    current_hop->ip,
                    current_hop->host,
                    current_hop->timeout ? "true" : "false");
         }
+
+        if(route->has_asn){
+            print_csv_asn(current_hop->asn, current_hop->prefix);
+        }
+
+        // Every probe of the TTL, ';'-separated (empty for cached hops)
+        if(route->queries > 1){
+
+            char rtts[128], ips[192];
+            format_queries(rtts, sizeof(rtts), current_hop, ';', false);
+            format_queries(ips, sizeof(ips), current_hop, ';', true);
+            printf(",%s,%s", rtts, ips);
+        }
+
+        printf("\n");
     }
 }
 
@@ -206,13 +444,48 @@ static void fmt_traceroute_json(const TraceRoute *route){
         printf("{\"hop\":%d,\"ip\":\"%s\",\"host\":\"%s\",",
                current_hop->hop, current_hop->ip, current_hop->host);
 
-        if(current_hop->timeout || current_hop->rtt_ms < 0){
-            printf("\"rtt_ms\":null,\"timeout\":true}");
+        // Paris/enumeration runs say which flow reached this hop
+        if(current_hop->flow >= 0){
+            printf("\"flow\":%d,", current_hop->flow);
+        }
+
+        if(route->has_asn){
+            print_json_asn(current_hop->asn, current_hop->prefix);
+            printf(",");
+        }
+
+        // Every probe of the TTL (--queries), each with its own responder
+        if(route->queries > 1 && current_hop->queries > 0){
+
+            printf("\"probes\":[");
+
+            for(int q = 0; q < current_hop->queries; q++){
+
+                if(current_hop->query_rtt_us[q] < 0){
+                    printf("%s{\"ip\":null,\"rtt_ms\":null}", q > 0 ? "," : "");
+                }
+                else{
+                    printf("%s{\"ip\":\"%s\",\"rtt_ms\":%.3f}", q > 0 ? "," : "",
+                           current_hop->query_ip[q], current_hop->query_rtt_us[q] / 1000.0);
+                }
+            }
+
+            printf("],");
+        }
+
+        // Copied from the hop cache: known router, nothing measured
+        if(current_hop->cached){
+            printf("\"rtt_ms\":null,\"rtt_us\":null,\"timeout\":false,\"cached\":true}");
+        }
+
+        else if(current_hop->timeout || current_hop->rtt_us < 0){
+            printf("\"rtt_ms\":null,\"rtt_us\":null,\"timeout\":true}");
         } 
         
         else{
-            printf("\"rtt_ms\":%d,\"timeout\":%s}",
-                   current_hop->rtt_ms,
+            printf("\"rtt_ms\":%.3f,\"rtt_us\":%ld,\"timeout\":%s}",
+                   current_hop->rtt_us / 1000.0,
+                   current_hop->rtt_us,
                    current_hop->timeout ? "true" : "false");
         }
     }
@@ -261,8 +534,15 @@ static void print_host_column(const char *host){
  */
 static void fmt_traceroute_table(const TraceRoute *route){
 
-    printf("HOP  IP               HOST                       RTT(ms)  STATUS      \n");
-    printf("---  ---------------- -------------------------- -------  ------------\n");
+    // One RTT per query side by side (--queries)
+    int rtt_w = route->queries > 1 ? route->queries * 8 - 1 : 7;
+
+    char dashes[HOP_MAX_QUERIES * 8];
+    memset(dashes, '-', (size_t)rtt_w);
+    dashes[rtt_w] = '\0';
+
+    printf("HOP  IP               HOST                       %-*s  STATUS      %s\n", rtt_w, "RTT(ms)", route->has_asn ? "  AS        PREFIX" : "");
+    printf("---  ---------------- -------------------------- %s  ------------%s\n", dashes, route->has_asn ? "  --------  ------------------" : "");
 
     // Iterate over each hop
     for(size_t i = 0; i < route->len; i++){
@@ -275,7 +555,10 @@ static void fmt_traceroute_table(const TraceRoute *route){
         if(h->timeout){
             strcpy(status, "TIMEOUT");
         }
-        else if(h->icmp_type == ICMP_ECHOREPLY){
+        else if(h->cached){
+            strcpy(status, "CACHED");
+        }
+        else if(h->reached || h->icmp_type == ICMP_ECHOREPLY){
             strcpy(status, "DEST");
         }
         else if(h->icmp_type == ICMP_TIME_EXCEEDED){
@@ -285,20 +568,73 @@ static void fmt_traceroute_table(const TraceRoute *route){
             strcpy(status, "OTHER");
         }
 
-        char rtt_buf[8];
+        char rtt_buf[128];
+
+        if(h->queries > 1){
+
+            // "0.071   0.065   *": every query in a fixed-width slot
+            size_t off = 0;
+            for(int q = 0; q < h->queries; q++){
 
-        if(h->timeout || h->rtt_ms < 0){
+                char one[16];
+                if(h->query_rtt_us[q] < 0){
+                    strcpy(one, "*");
+                }
+                else{
+                    snprintf(one, sizeof(one), "%.3f", h->query_rtt_us[q] / 1000.0);
+                }
+                off += (size_t)snprintf(rtt_buf + off, sizeof(rtt_buf) - off, q + 1 < h->queries ? "%-7s " : "%s", one);
+            }
+        }
+        else if(h->timeout || h->rtt_us < 0){
             strcpy(rtt_buf, "-");
         }
         else{
 
-            //snprintf is used to hold the rtt_ms in string format
-            snprintf(rtt_buf, sizeof(rtt_buf), "%d", h->rtt_ms);
+            //snprintf is used to hold the RTT in string format (ms with microsecond precision)
+            snprintf(rtt_buf, sizeof(rtt_buf), "%.3f", h->rtt_us / 1000.0);
         }
 
         printf("%-3d  %-16s ", h->hop, h->ip);
         print_host_column(h->host);
-        printf(" %-7s  %-12s\n", rtt_buf, status);
+        printf(" %-*s  %-12s", rtt_w, rtt_buf, status);
+
+        if(route->has_asn){
+
+            char asn_buf[16];
+            format_asn(asn_buf, sizeof(asn_buf), h->asn);
+            printf("  %-8s  %s", asn_buf, h->prefix[0] ? h->prefix : "-");
+        }
+
+        printf("\n");
+
+        // Other routers that answered some of this TTL's probes, one line each
+        for(int q = 0; q < h->queries; q++){
+
+            const char *ip = h->query_ip[q];
+            bool first = true;
+
+            if(strcmp(ip, "*") == 0 || strcmp(ip, h->ip) == 0){
+                continue;
+            }
+
+            for(int k = 0; k < q; k++){
+                if(strcmp(h->query_ip[k], ip) == 0){
+                    first = false;
+                }
+            }
+
+            if(first){
+
+                printf("     %-16s answered queries", ip);
+                for(int k = q; k < h->queries; k++){
+                    if(strcmp(h->query_ip[k], ip) == 0){
+                        printf(" %d", k + 1);
+                    }
+                }
+                printf("\n");
+            }
+        }
     }
 }
 
@@ -326,106 +662,958 @@ void fmt_traceroute(const struct TraceRoute *route, bool json, bool csv){
 }
 
 /**
- * Format MonitorSeries in CSV format.
- * @param series Pointer to MonitorSeries
+ * Helper to print an RTT in ms with microsecond precision, or "-" if unknown.
+ * @param buf Output buffer
+ * @param len Size of output buffer
+ * @param rtt_us RTT in microseconds (-1 if unknown)
  * @return void
  */
-static void fmt_monitor_series_csv(const MonitorSeries *series){
+static void format_rtt(char *buf, size_t len, double rtt_us){
 
-    printf("iface,rx_bytes,tx_bytes,rx_bps,tx_bps,rx_avg_bps,tx_avg_bps\n");
+    if(rtt_us < 0){
+        snprintf(buf, len, "-");
+    }
+    else{
+        snprintf(buf, len, "%.3f", rtt_us / 1000.0);
+    }
+}
 
-    for(size_t i = 0; i < series->len; i++){
-        
-        const IfaceStats *sample = &series->samples[i];
+/**
+ * Helper to compute loss percentage of a hop.
+ * @param sent Probes sent
+ * @param received Replies received
+ * @return Loss in percent (0 if nothing sent)
+ */
+static double loss_pct(unsigned long sent, unsigned long received){
 
-        printf("%s,%llu,%llu,%.2f,%.2f,%.2f,%.2f\n",
-               sample->iface,
-               sample->rx_bytes,
-               sample->tx_bytes,
-               sample->rx_rate_bps,
-               sample->tx_rate_bps,
-               sample->rx_avg_bps,
-               sample->tx_avg_bps);
+    if(sent == 0){
+        return 0.0;
     }
+
+    return 100.0 * (double)(sent - received) / (double)sent;
 }
 
 /**
- * Format MonitorSeries in JSON format.
- * @param series Pointer to MonitorSeries
+ * Format PathStats in table format.
+ * @param stats Pointer to PathStats
  * @return void
  */
-static void fmt_monitor_series_json(const MonitorSeries *series){
+static void fmt_path_stats_table(const PathStats *stats){
 
-    printf("{\"type\":\"monitor\",\"samples\":[");
-    
-    for(size_t i = 0; i < series->len; i++){
+    printf("HOP  IP               HOST                       LOSS%%   SNT    LAST     AVG      BEST     WRST     JTTR\n");
+    printf("---  ---------------- -------------------------- ------  -----  -------  -------  -------  -------  -------\n");
 
-        const IfaceStats *sample = &series->samples[i];
+    for(size_t i = 0; i < stats->len; i++){
 
-        if(i > 0){
-            printf(",");
-        }
+        const HopStats *hs = &stats->hops[i];
+
+        char last[16], avg[16], best[16], worst[16], jitter[16];
 
-        printf("{\"iface\":\"%s\",\"rx_bytes\":%llu,\"tx_bytes\":%llu,"
-               "\"rx_bps\":%.2f,\"tx_bps\":%.2f,"
-               "\"rx_avg_bps\":%.2f,\"tx_avg_bps\":%.2f}",
-               sample->iface,
-               sample->rx_bytes,
-               sample->tx_bytes,
-               sample->rx_rate_bps,
-               sample->tx_rate_bps,
-               sample->rx_avg_bps,
-               sample->tx_avg_bps);
+        format_rtt(last, sizeof(last), (double)hs->last_us);
+        format_rtt(avg, sizeof(avg), hs->received ? hs->avg_us : -1.0);
+        format_rtt(best, sizeof(best), (double)hs->best_us);
+        format_rtt(worst, sizeof(worst), (double)hs->worst_us);
+        format_rtt(jitter, sizeof(jitter), hs->received > 1 ? hs->jitter_us : -1.0);
+
+        printf("%-3d  %-16s ", hs->hop, hs->ip);
+        print_host_column(hs->host);
+        printf(" %5.1f%%  %-5lu  %-7s  %-7s  %-7s  %-7s  %-7s\n",
+               loss_pct(hs->sent, hs->received), hs->sent,
+               last, avg, best, worst, jitter);
     }
 
-    printf("]}\n");
+    printf("cycles: %lu\n", stats->cycles);
 }
 
 /**
- * Format MonitorSeries in table format.
- * @param series Pointer to MonitorSeries
+ * Format PathStats in CSV format. The header is printed with the first
+ * snapshot only so periodic snapshots form one continuous CSV stream.
+ * @param stats Pointer to PathStats
  * @return void
  */
-static void fmt_monitor_series_table(const MonitorSeries *series){
+static void fmt_path_stats_csv(const PathStats *stats){
+
+    if(stats->cycles <= 1){
+        printf("cycle,hop,ip,host,loss_pct,sent,received,last_ms,avg_ms,best_ms,worst_ms,jitter_ms,recent_loss_pct\n");
+    }
 
-    printf("IFACE  RX_BYTES   TX_BYTES   RX_BPS      TX_BPS      RX_AVG_BPS   TX_AVG_BPS\n");
-    printf("-----  --------   --------   ----------  ----------  -----------  -----------\n");
+    for(size_t i = 0; i < stats->len; i++){
 
-    for(size_t i = 0; i < series->len; i++){
+        const HopStats *hs = &stats->hops[i];
 
-        const IfaceStats *sample = &series->samples[i];
+        char last[16], avg[16], best[16], worst[16], jitter[16];
 
-        printf("%-5s  %-8llu  %-8llu  %-10.2f  %-10.2f  %-11.2f  %-11.2f\n",
-               sample->iface,
-               sample->rx_bytes,
-               sample->tx_bytes,
-               sample->rx_rate_bps,
-               sample->tx_rate_bps,
-               sample->rx_avg_bps,
-               sample->tx_avg_bps);
+        format_rtt(last, sizeof(last), (double)hs->last_us);
+        format_rtt(avg, sizeof(avg), hs->received ? hs->avg_us : -1.0);
+        format_rtt(best, sizeof(best), (double)hs->best_us);
+        format_rtt(worst, sizeof(worst), (double)hs->worst_us);
+        format_rtt(jitter, sizeof(jitter), hs->received > 1 ? hs->jitter_us : -1.0);
+
+        printf("%lu,%d,%s,%s,%.1f,%lu,%lu,%s,%s,%s,%s,%s,%.1f\n",
+               stats->cycles, hs->hop, hs->ip, hs->host,
+               loss_pct(hs->sent, hs->received), hs->sent, hs->received,
+               last, avg, best, worst, jitter,
+               loss_pct(hs->hist_len, hs->hist_len - hs->hist_lost));
     }
 }
 
 /**
- * Format MonitorSeries in specified format.
- * @param series Pointer to MonitorSeries
+ * Helper to print an RTT as a JSON number in ms, or null if unknown.
+ * @param rtt_us RTT in microseconds (-1 if unknown)
+ * @return void
+ */
+static void print_json_rtt(double rtt_us){
+
+    if(rtt_us < 0){
+        printf("null");
+    }
+    else{
+        printf("%.3f", rtt_us / 1000.0);
+    }
+}
+
+/**
+ * Format PathStats in JSON format (one object per line per snapshot).
+ * @param stats Pointer to PathStats
+ * @return void
+ */
+static void fmt_path_stats_json(const PathStats *stats){
+
+    printf("{\"type\":\"trace_stats\",\"cycle\":%lu,\"hops\":[", stats->cycles);
+
+    for(size_t i = 0; i < stats->len; i++){
+
+        const HopStats *hs = &stats->hops[i];
+
+        if(i > 0){
+            printf(",");
+        }
+
+        printf("{\"hop\":%d,\"ip\":\"%s\",\"host\":\"%s\",\"loss_pct\":%.1f,\"sent\":%lu,\"received\":%lu,",
+               hs->hop, hs->ip, hs->host,
+               loss_pct(hs->sent, hs->received), hs->sent, hs->received);
+
+        printf("\"last_ms\":");
+        print_json_rtt((double)hs->last_us);
+        printf(",\"avg_ms\":");
+        print_json_rtt(hs->received ? hs->avg_us : -1.0);
+        printf(",\"best_ms\":");
+        print_json_rtt((double)hs->best_us);
+        printf(",\"worst_ms\":");
+        print_json_rtt((double)hs->worst_us);
+        printf(",\"jitter_ms\":");
+        print_json_rtt(hs->received > 1 ? hs->jitter_us : -1.0);
+
+        printf(",\"recent_loss_pct\":%.1f}", loss_pct(hs->hist_len, hs->hist_len - hs->hist_lost));
+    }
+
+    printf("]}\n");
+}
+
+/**
+ * Format a PathStats snapshot in specified format.
+ * @param stats Pointer to PathStats
  * @param json If true, output in JSON format
  * @param csv If true, output in CSV format
+ * @param refresh If true (table only), redraw in place instead of appending
  * @return void
  */
-void fmt_monitor_series(const struct MonitorSeries *series, bool json, bool csv){
+void fmt_path_stats(const struct PathStats *stats, bool json, bool csv, bool refresh){
+
+    if(json){
+        fmt_path_stats_json(stats);
+    }
+
+    else if(csv){
+        fmt_path_stats_csv(stats);
+    }
 
-    if (json){
-        fmt_monitor_series_json(series);
-    } 
-    
-    else if (csv){
-        fmt_monitor_series_csv(series);
-    } 
-    
     else{
-        fmt_monitor_series_table(series);
+
+        // ANSI: cursor home + clear screen, so the table updates in place
+        if(refresh){
+            printf("\033[H\033[2J");
+        }
+
+        fmt_path_stats_table(stats);
     }
+
+    // Snapshots are consumed live, don't let them sit in the stdio buffer
+    fflush(stdout);
 }
 
+/**
+ * Format PmtuTable in table format.
+ * @param table Pointer to PmtuTable
+ * @return void
+ */
+static void fmt_pmtu_table_table(const PmtuTable *table){
+
+    printf("TARGET                     IP               PMTU   PROBES  RTT(ms)  NOTE\n");
+    printf("-------------------------- ---------------- -----  ------  -------  ----------------------------\n");
+
+    for(size_t i = 0; i < table->len; i++){
+
+        const PmtuResult *r = &table->rows[i];
 
+        char mtu_buf[16];
+        char rtt_buf[16];
+        char note[96];
+
+        if(r->mtu < 0){
+            strcpy(mtu_buf, "-");
+        }
+        else{
+            snprintf(mtu_buf, sizeof(mtu_buf), "%d", r->mtu);
+        }
+
+        format_rtt(rtt_buf, sizeof(rtt_buf), (double)r->rtt_us);
+
+        // Most useful first: unreachable, then the router that limits the path
+        if(r->mtu < 0){
+            strcpy(note, "NO REPLY");
+        }
+        else if(r->hint_from[0] != '\0'){
+            snprintf(note, sizeof(note), "%s%s says %d", r->blackhole ? "BLACKHOLE, " : "", r->hint_from, r->hint_mtu);
+        }
+        else if(r->blackhole){
+            strcpy(note, "BLACKHOLE (no frag-needed)");
+        }
+        else{
+            note[0] = '\0';
+        }
+
+        print_host_column(r->target);
+        printf(" %-16s %-5s  %-6d  %-7s  %s\n", r->ip, mtu_buf, r->probes, rtt_buf, note);
+    }
+}
+
+/**
+ * Format PmtuTable in CSV format.
+ * @param table Pointer to PmtuTable
+ * @return void
+ */
+static void fmt_pmtu_table_csv(const PmtuTable *table){
+
+    printf("target,ip,pmtu,hint_mtu,hint_from,probes,rtt_ms,blackhole\n");
+
+    for(size_t i = 0; i < table->len; i++){
+
+        const PmtuResult *r = &table->rows[i];
+
+        // Unknown values stay as empty fields
+        printf("%s,%s,", r->target, r->ip);
+
+        if(r->mtu >= 0){
+            printf("%d", r->mtu);
+        }
+
+        printf(",");
+
+        if(r->hint_mtu > 0){
+            printf("%d", r->hint_mtu);
+        }
+
+        printf(",%s,%d,", r->hint_from, r->probes);
+
+        if(r->rtt_us >= 0){
+            printf("%.3f", r->rtt_us / 1000.0);
+        }
+
+        printf(",%s\n", r->blackhole ? "true" : "false");
+    }
+}
+
+/**
+ * Format PmtuTable in JSON format.
+ * @param table Pointer to PmtuTable
+ * @return void
+ */
+static void fmt_pmtu_table_json(const PmtuTable *table){
+
+    printf("{\"type\":\"pmtu\",\"targets\":[");
+
+    for(size_t i = 0; i < table->len; i++){
+
+        const PmtuResult *r = &table->rows[i];
+
+        if(i > 0){
+            printf(",");
+        }
+
+        printf("{\"target\":\"%s\",\"ip\":\"%s\",", r->target, r->ip);
+
+        if(r->mtu >= 0){
+            printf("\"pmtu\":%d,", r->mtu);
+        }
+        else{
+            printf("\"pmtu\":null,");
+        }
+
+        if(r->hint_from[0] != '\0'){
+            printf("\"hint_mtu\":%d,\"hint_from\":\"%s\",", r->hint_mtu, r->hint_from);
+        }
+        else{
+            printf("\"hint_mtu\":null,\"hint_from\":null,");
+        }
+
+        printf("\"probes\":%d,\"rtt_ms\":", r->probes);
+        print_json_rtt((double)r->rtt_us);
+        printf(",\"blackhole\":%s}", r->blackhole ? "true" : "false");
+    }
+
+    printf("]}\n");
+}
+
+/**
+ * Format PmtuTable in specified format.
+ * @param table Pointer to PmtuTable
+ * @param json If true, output in JSON format
+ * @param csv If true, output in CSV format
+ * @return void
+ */
+void fmt_pmtu_table(const struct PmtuTable *table, bool json, bool csv){
+
+    if(json){
+        fmt_pmtu_table_json(table);
+    }
+
+    else if(csv){
+        fmt_pmtu_table_csv(table);
+    }
+
+    else{
+        fmt_pmtu_table_table(table);
+    }
+}
+
+/**
+ * Average RTT of a topology edge, or -1 if no hop along it had an RTT.
+ * @param e Pointer to TopoEdge
+ * @return Average in microseconds
+ */
+static double topo_edge_avg(const TopoEdge *e){
+    return e->samples > 0 ? e->sum_us / (double)e->samples : -1.0;
+}
+
+/**
+ * Format TopoGraph as a text edge list.
+ * @param graph Pointer to TopoGraph
+ * @return void
+ */
+static void fmt_topo_graph_table(const TopoGraph *graph){
+
+    printf("%lu traces, %zu nodes, %zu links", graph->ntraces, graph->nnodes, graph->nedges);
+
+    // Hops the shared-prefix cache saved from being probed again
+    if(graph->cached > 0){
+        printf(", %lu hops from cache", graph->cached);
+    }
+
+    printf("\n\n");
+    printf("FROM             TO               GAP  TRACES  MIN(ms)  AVG(ms)  MAX(ms)  HOST\n");
+    printf("---------------- ---------------- ---  ------  -------  -------  -------  ----------------------------\n");
+
+    for(size_t i = 0; i < graph->nedges; i++){
+
+        const TopoEdge *e = &graph->edges[i];
+        const TopoNode *to = &graph->nodes[e->to];
+
+        char min_buf[16];
+        char avg_buf[16];
+        char max_buf[16];
+
+        format_rtt(min_buf, sizeof(min_buf), (double)e->min_us);
+        format_rtt(avg_buf, sizeof(avg_buf), topo_edge_avg(e));
+        format_rtt(max_buf, sizeof(max_buf), (double)e->max_us);
+
+        printf("%-16s %-16s %-3d  %-6lu  %-7s  %-7s  %-7s  %s%s\n", graph->nodes[e->from].ip, to->ip, e->gap, e->traces,
+               min_buf, avg_buf, max_buf, to->host, to->target ? " (target)" : "");
+    }
+}
+
+/**
+ * Format TopoGraph in CSV format (one row per link).
+ * @param graph Pointer to TopoGraph
+ * @return void
+ */
+static void fmt_topo_graph_csv(const TopoGraph *graph){
+
+    printf("from_ip,to_ip,to_host,gap,traces,min_ms,avg_ms,max_ms\n");
+
+    for(size_t i = 0; i < graph->nedges; i++){
+
+        const TopoEdge *e = &graph->edges[i];
+
+        printf("%s,%s,%s,%d,%lu,", graph->nodes[e->from].ip, graph->nodes[e->to].ip, graph->nodes[e->to].host, e->gap, e->traces);
+
+        // Unknown RTTs stay as empty fields
+        if(e->min_us >= 0){
+            printf("%.3f,%.3f,%.3f\n", e->min_us / 1000.0, topo_edge_avg(e) / 1000.0, e->max_us / 1000.0);
+        }
+        else{
+            printf(",,\n");
+        }
+    }
+}
+
+/**
+ * Format TopoGraph in JSON format: node list with adjacency, then edge list.
+ * @param graph Pointer to TopoGraph
+ * @return void
+ */
+static void fmt_topo_graph_json(const TopoGraph *graph){
+
+    printf("{\"type\":\"topology\",\"traces\":%lu,\"cached_hops\":%lu,\"nodes\":[", graph->ntraces, graph->cached);
+
+    for(size_t i = 0; i < graph->nnodes; i++){
+
+        const TopoNode *n = &graph->nodes[i];
+
+        if(i > 0){
+            printf(",");
+        }
+
+        printf("{\"id\":%zu,\"ip\":\"%s\",\"host\":\"%s\",\"ttl\":%d,\"traces\":%lu,\"source\":%s,\"target\":%s,\"next\":[",
+               i, n->ip, n->host, n->min_ttl, n->traces, i == 0 ? "true" : "false", n->target ? "true" : "false");
+
+        for(long e = n->first_out; e >= 0; e = graph->edges[e].next_out){
+            printf("%zu%s", graph->edges[e].to, graph->edges[e].next_out >= 0 ? "," : "");
+        }
+
+        printf("]}");
+    }
+
+    printf("],\"edges\":[");
+
+    for(size_t i = 0; i < graph->nedges; i++){
+
+        const TopoEdge *e = &graph->edges[i];
+
+        if(i > 0){
+            printf(",");
+        }
+
+        printf("{\"from\":%zu,\"to\":%zu,\"gap\":%d,\"traces\":%lu,\"min_ms\":", e->from, e->to, e->gap, e->traces);
+        print_json_rtt((double)e->min_us);
+        printf(",\"avg_ms\":");
+        print_json_rtt(topo_edge_avg(e));
+        printf(",\"max_ms\":");
+        print_json_rtt((double)e->max_us);
+        printf("}");
+    }
+
+    printf("]}\n");
+}
+
+/**
+ * Format TopoGraph in Graphviz DOT format.
+ * @param graph Pointer to TopoGraph
+ * @return void
+ */
+static void fmt_topo_graph_dot(const TopoGraph *graph){
+
+    printf("digraph wirefish {\n");
+    printf("  rankdir=LR;\n");
+    printf("  node [shape=box, fontname=\"monospace\"];\n");
+
+    for(size_t i = 0; i < graph->nnodes; i++){
+
+        const TopoNode *n = &graph->nodes[i];
+
+        // Show the name too when reverse DNS found one
+        if(strcmp(n->host, n->ip) != 0){
+            printf("  n%zu [label=\"%s\\n%s\"", i, n->host, n->ip);
+        }
+        else{
+            printf("  n%zu [label=\"%s\"", i, n->ip);
+        }
+
+        if(i == 0){
+            printf(", shape=ellipse");
+        }
+        else if(n->target){
+            printf(", shape=doubleoctagon");
+        }
+
+        printf("];\n");
+    }
+
+    for(size_t i = 0; i < graph->nedges; i++){
+
+        const TopoEdge *e = &graph->edges[i];
+        char avg_buf[16];
+
+        format_rtt(avg_buf, sizeof(avg_buf), topo_edge_avg(e));
+
+        printf("  n%zu -> n%zu [label=\"%s ms x%lu\"", e->from, e->to, avg_buf, e->traces);
+
+        // Silent hops in between: dashed
+        if(e->gap > 1){
+            printf(", style=dashed");
+        }
+
+        printf("];\n");
+    }
+
+    printf("}\n");
+}
+
+/**
+ * Format TopoGraph in specified format.
+ * @param graph Pointer to TopoGraph
+ * @param json If true, output in JSON format
+ * @param csv If true, output in CSV format
+ * @param dot If true, output in Graphviz DOT format
+ * @return void
+ */
+void fmt_topo_graph(const struct TopoGraph *graph, bool json, bool csv, bool dot){
+
+    if(dot){
+        fmt_topo_graph_dot(graph);
+    }
+
+    else if(json){
+        fmt_topo_graph_json(graph);
+    }
+
+    else if(csv){
+        fmt_topo_graph_csv(graph);
+    }
+
+    else{
+        fmt_topo_graph_table(graph);
+    }
+}
+
+//Column lists of the monitor formats, shared by the batch and streaming output
+#define MONITOR_CSV_HEADER "iface,rx_bytes,tx_bytes,rx_bps,tx_bps,rx_avg_bps,tx_avg_bps," \
+    "rx_packets,tx_packets,rx_errors,tx_errors,rx_dropped,tx_dropped,multicast," \
+    "rx_ewma_bps,tx_ewma_bps,rx_min_bps,rx_max_bps,tx_min_bps,tx_max_bps,rx_stddev_bps,tx_stddev_bps,ts_ms\n"
+#define MONITOR_TABLE_HEADER "%-*s  RX_BYTES   TX_BYTES   RX_BPS      TX_BPS      RX_AVG_BPS   TX_AVG_BPS   RX_PKTS     TX_PKTS     ERRS    DROPS\n"
+#define MONITOR_TABLE_RULE "%.*s  --------   --------   ----------  ----------  -----------  -----------  ----------  ----------  ------  ------\n"
+
+/**
+ * Print one IfaceStats as a CSV row.
+ * @param sample Pointer to IfaceStats
+ * @return void
+ */
+static void fmt_monitor_sample_csv(const IfaceStats *sample){
+
+    printf("%s,%llu,%llu,%.2f,%.2f,%.2f,%.2f,%llu,%llu,%llu,%llu,%llu,%llu,%llu,"
+           "%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%lld\n",
+           sample->iface,
+           sample->rx_bytes,
+           sample->tx_bytes,
+           sample->rx_rate_bps,
+           sample->tx_rate_bps,
+           sample->rx_avg_bps,
+           sample->tx_avg_bps,
+           sample->rx_packets,
+           sample->tx_packets,
+           sample->rx_errors,
+           sample->tx_errors,
+           sample->rx_dropped,
+           sample->tx_dropped,
+           sample->multicast,
+           sample->rx_ewma_bps,
+           sample->tx_ewma_bps,
+           sample->rx_min_bps,
+           sample->rx_max_bps,
+           sample->tx_min_bps,
+           sample->tx_max_bps,
+           sample->rx_stddev_bps,
+           sample->tx_stddev_bps,
+           sample->ts_ms);
+}
+
+/**
+ * Print one IfaceStats as a JSON object (no trailing newline).
+ * @param sample Pointer to IfaceStats
+ * @return void
+ */
+static void fmt_monitor_sample_json(const IfaceStats *sample){
+
+    printf("{\"iface\":\"%s\",\"ts_ms\":%lld,\"rx_bytes\":%llu,\"tx_bytes\":%llu,"
+           "\"rx_bps\":%.2f,\"tx_bps\":%.2f,"
+           "\"rx_avg_bps\":%.2f,\"tx_avg_bps\":%.2f,"
+           "\"rx_packets\":%llu,\"tx_packets\":%llu,"
+           "\"rx_errors\":%llu,\"tx_errors\":%llu,"
+           "\"rx_dropped\":%llu,\"tx_dropped\":%llu,\"multicast\":%llu,"
+           "\"rx_ewma_bps\":%.2f,\"tx_ewma_bps\":%.2f,"
+           "\"rx_min_bps\":%.2f,\"rx_max_bps\":%.2f,"
+           "\"tx_min_bps\":%.2f,\"tx_max_bps\":%.2f,"
+           "\"rx_stddev_bps\":%.2f,\"tx_stddev_bps\":%.2f}",
+           sample->iface,
+           sample->ts_ms,
+           sample->rx_bytes,
+           sample->tx_bytes,
+           sample->rx_rate_bps,
+           sample->tx_rate_bps,
+           sample->rx_avg_bps,
+           sample->tx_avg_bps,
+           sample->rx_packets,
+           sample->tx_packets,
+           sample->rx_errors,
+           sample->tx_errors,
+           sample->rx_dropped,
+           sample->tx_dropped,
+           sample->multicast,
+           sample->rx_ewma_bps,
+           sample->tx_ewma_bps,
+           sample->rx_min_bps,
+           sample->rx_max_bps,
+           sample->tx_min_bps,
+           sample->tx_max_bps,
+           sample->rx_stddev_bps,
+           sample->tx_stddev_bps);
+}
+
+/**
+ * Print one IfaceStats as a table row.
+ * @param sample Pointer to IfaceStats
+ * @param width Width of the IFACE column
+ * @return void
+ */
+static void fmt_monitor_sample_table(const IfaceStats *sample, int width){
+
+    // Errors and drops summed over both directions (the CSV/JSON keep them apart)
+    printf("%-*s  %-8llu  %-8llu  %-10.2f  %-10.2f  %-11.2f  %-11.2f  %-10llu  %-10llu  %-6llu  %-6llu\n",
+           width, sample->iface,
+           sample->rx_bytes,
+           sample->tx_bytes,
+           sample->rx_rate_bps,
+           sample->tx_rate_bps,
+           sample->rx_avg_bps,
+           sample->tx_avg_bps,
+           sample->rx_packets,
+           sample->tx_packets,
+           sample->rx_errors + sample->tx_errors,
+           sample->rx_dropped + sample->tx_dropped);
+}
+
+/**
+ * Report sampling overruns and counter resets/wraps after a monitor run.
+ * Tables get the notes inline; CSV gets them on stderr to keep the CSV clean.
+ * @param series Pointer to MonitorSeries (ticks and counter events)
+ * @param csv If true, the output is CSV
+ * @return void
+ */
+static void fmt_monitor_run_notes(const MonitorSeries *series, bool csv){
+
+    FILE *out = csv ? stderr : stdout;
+
+    //Deadlines skipped because sampling overran the interval
+    if(series->missed_ticks > 0){
+        if(csv){
+            fprintf(out, "Warning: missed %llu of %llu sampling ticks\n",
+                    series->missed_ticks, series->ticks);
+        }
+        else{
+            fprintf(out, "Missed %llu of %llu sampling ticks (interval too short for the load)\n",
+                    series->missed_ticks, series->ticks);
+        }
+    }
+
+    //Counters that went back or wrapped: samples skipped or rates corrected
+    if(series->counter_resets > 0 || series->counter_wraps > 0){
+        fprintf(out, "%sCounter resets: %llu (interfaces re-baselined), 32-bit wraps corrected: %llu\n",
+                csv ? "Note: " : "", series->counter_resets, series->counter_wraps);
+    }
+}
+
+/**
+ * Format MonitorSeries in CSV format.
+ * @param series Pointer to MonitorSeries
+ * @return void
+ */
+static void fmt_monitor_series_csv(const MonitorSeries *series){
+
+    printf(MONITOR_CSV_HEADER);
+
+    for(size_t i = 0; i < series->len; i++){
+        fmt_monitor_sample_csv(&series->samples[i]);
+    }
+
+    //Keep the CSV itself clean: report overruns and counter events on stderr
+    fmt_monitor_run_notes(series, true);
+}
+
+/**
+ * Format MonitorSeries in JSON format.
+ * @param series Pointer to MonitorSeries
+ * @return void
+ */
+static void fmt_monitor_series_json(const MonitorSeries *series){
+
+    printf("{\"type\":\"monitor\",\"samples\":[");
+    
+    for(size_t i = 0; i < series->len; i++){
+
+        if(i > 0){
+            printf(",");
+        }
+
+        fmt_monitor_sample_json(&series->samples[i]);
+    }
+
+    printf("],\"ticks\":%llu,\"missed_ticks\":%llu,\"counter_resets\":%llu,\"counter_wraps\":%llu}\n",
+           series->ticks, series->missed_ticks, series->counter_resets, series->counter_wraps);
+}
+
+/**
+ * Format MonitorSeries in table format.
+ * @param series Pointer to MonitorSeries
+ * @return void
+ */
+static void fmt_monitor_series_table(const MonitorSeries *series){
+
+    //IFACE column widens to the longest name when several interfaces are listed
+    int width = 5;
+    for(size_t i = 0; i < series->len; i++){
+        int len = (int)strlen(series->samples[i].iface);
+        if(len > width){
+            width = len;
+        }
+    }
+
+    printf(MONITOR_TABLE_HEADER, width, "IFACE");
+    printf(MONITOR_TABLE_RULE, width, "----------------------------------------------------------------");
+
+    for(size_t i = 0; i < series->len; i++){
+        fmt_monitor_sample_table(&series->samples[i], width);
+    }
+
+    fmt_monitor_run_notes(series, false);
+}
+
+/**
+ * Start streaming monitor output: prints the CSV or table header.
+ * JSON streams are newline-delimited and need no header.
+ * @param json If true, output in JSON format
+ * @param csv If true, output in CSV format
+ * @return void
+ */
+void fmt_monitor_stream_begin(bool json, bool csv){
+
+    if(json){
+        return;
+    }
+
+    if(csv){
+        printf(MONITOR_CSV_HEADER);
+    }
+    else{
+        //Rows are printed before all names are known: size IFACE for the longest possible name
+        printf(MONITOR_TABLE_HEADER, IFACE_NAME_MAX - 1, "IFACE");
+        printf(MONITOR_TABLE_RULE, IFACE_NAME_MAX - 1, "----------------------------------------------------------------");
+    }
+
+    fflush(stdout);
+}
+
+/**
+ * Print one monitor sample as soon as it is taken.
+ * JSON output is one object per line (NDJSON).
+ * @param sample Pointer to IfaceStats
+ * @param json If true, output in JSON format
+ * @param csv If true, output in CSV format
+ * @return void
+ */
+void fmt_monitor_stream_sample(const struct IfaceStats *sample, bool json, bool csv){
+
+    if(json){
+        fmt_monitor_sample_json(sample);
+        printf("\n");
+    }
+    else if(csv){
+        fmt_monitor_sample_csv(sample);
+    }
+    else{
+        fmt_monitor_sample_table(sample, IFACE_NAME_MAX - 1);
+    }
+
+    //Readers of a pipe see each sample now, not when the buffer fills
+    fflush(stdout);
+}
+
+/**
+ * End streaming monitor output: reports the tick counts and counter events.
+ * @param series Pointer to MonitorSeries (only the ticks and counter events are used)
+ * @param json If true, output in JSON format
+ * @param csv If true, output in CSV format
+ * @return void
+ */
+void fmt_monitor_stream_end(const struct MonitorSeries *series, bool json, bool csv){
+
+    if(json){
+        printf("{\"type\":\"monitor_end\",\"ticks\":%llu,\"missed_ticks\":%llu,\"counter_resets\":%llu,\"counter_wraps\":%llu}\n",
+               series->ticks, series->missed_ticks, series->counter_resets, series->counter_wraps);
+    }
+    else{
+        fmt_monitor_run_notes(series, csv);
+    }
+
+    fflush(stdout);
+}
+
+/**
+ * Format MonitorSeries in specified format.
+ * @param series Pointer to MonitorSeries
+ * @param json If true, output in JSON format
+ * @param csv If true, output in CSV format
+ * @return void
+ */
+void fmt_monitor_series(const struct MonitorSeries *series, bool json, bool csv){
+
+    if (json){
+        fmt_monitor_series_json(series);
+    } 
+    
+    else if (csv){
+        fmt_monitor_series_csv(series);
+    } 
+    
+    else{
+        fmt_monitor_series_table(series);
+    }
+}
+
+/**
+ * Average of a rollup bucket's rates.
+ * @param sum Sum of the rates
+ * @param samples Samples in the bucket
+ * @return Mean rate, 0 for an empty bucket
+ */
+static double rollup_avg(double sum, unsigned long samples){
+
+    return samples ? sum / (double)samples : 0.0;
+}
+
+/**
+ * Format RollupView in CSV format.
+ * @param view Pointer to RollupView
+ * @return void
+ */
+static void fmt_monitor_rollup_csv(const RollupView *view){
+
+    printf("iface,width_ms,start_ms,samples,rx_min_bps,rx_avg_bps,rx_max_bps,rx_last_bps,"
+           "tx_min_bps,tx_avg_bps,tx_max_bps,tx_last_bps\n");
+
+    for(size_t i = 0; i < view->len; i++){
+
+        const RollupRow *row = &view->rows[i];
+        const RollupBucket *b = &row->bucket;
+
+        printf("%s,%lld,%lld,%lu,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f\n",
+               row->iface,
+               view->width_ms,
+               b->start_ms,
+               b->samples,
+               b->rx_min_bps,
+               rollup_avg(b->rx_sum_bps, b->samples),
+               b->rx_max_bps,
+               b->rx_last_bps,
+               b->tx_min_bps,
+               rollup_avg(b->tx_sum_bps, b->samples),
+               b->tx_max_bps,
+               b->tx_last_bps);
+    }
+}
+
+/**
+ * Format RollupView in JSON format.
+ * @param view Pointer to RollupView
+ * @return void
+ */
+static void fmt_monitor_rollup_json(const RollupView *view){
+
+    printf("{\"type\":\"monitor_rollup\",\"width_ms\":%lld,\"buckets\":[", view->width_ms);
+
+    for(size_t i = 0; i < view->len; i++){
+
+        const RollupRow *row = &view->rows[i];
+        const RollupBucket *b = &row->bucket;
+
+        if(i > 0){
+            printf(",");
+        }
+
+        printf("{\"iface\":\"%s\",\"start_ms\":%lld,\"samples\":%lu,"
+               "\"rx_min_bps\":%.2f,\"rx_avg_bps\":%.2f,\"rx_max_bps\":%.2f,\"rx_last_bps\":%.2f,"
+               "\"tx_min_bps\":%.2f,\"tx_avg_bps\":%.2f,\"tx_max_bps\":%.2f,\"tx_last_bps\":%.2f}",
+               row->iface,
+               b->start_ms,
+               b->samples,
+               b->rx_min_bps,
+               rollup_avg(b->rx_sum_bps, b->samples),
+               b->rx_max_bps,
+               b->rx_last_bps,
+               b->tx_min_bps,
+               rollup_avg(b->tx_sum_bps, b->samples),
+               b->tx_max_bps,
+               b->tx_last_bps);
+    }
+
+    printf("]}\n");
+}
+
+/**
+ * Format RollupView in table format.
+ * @param view Pointer to RollupView
+ * @return void
+ */
+static void fmt_monitor_rollup_table(const RollupView *view){
+
+    printf("History in %lld ms buckets\n", view->width_ms);
+    printf("%-15s  START         SAMPLES   RX_MIN_BPS    RX_AVG_BPS    RX_MAX_BPS    TX_MIN_BPS    TX_AVG_BPS    TX_MAX_BPS\n", "IFACE");
+    printf("%-15s  ------------  --------  ------------  ------------  ------------  ------------  ------------  ------------\n", "---------------");
+
+    for(size_t i = 0; i < view->len; i++){
+
+        const RollupRow *row = &view->rows[i];
+        const RollupBucket *b = &row->bucket;
+
+        //Local wall-clock start of the bucket, to the millisecond
+        char start[16] = "?";
+        time_t sec = (time_t)(b->start_ms / 1000);
+        struct tm tm;
+        if(localtime_r(&sec, &tm) != NULL){
+            size_t n = strftime(start, sizeof(start), "%H:%M:%S", &tm);
+            snprintf(start + n, sizeof(start) - n, ".%03lld", b->start_ms % 1000);
+        }
+
+        printf("%-15s  %-12s  %-8lu  %-12.2f  %-12.2f  %-12.2f  %-12.2f  %-12.2f  %-12.2f\n",
+               row->iface,
+               start,
+               b->samples,
+               b->rx_min_bps,
+               rollup_avg(b->rx_sum_bps, b->samples),
+               b->rx_max_bps,
+               b->tx_min_bps,
+               rollup_avg(b->tx_sum_bps, b->samples),
+               b->tx_max_bps);
+    }
+}
+
+/**
+ * Format a monitor rollup query in specified format.
+ * @param view Pointer to RollupView
+ * @param json If true, output in JSON format
+ * @param csv If true, output in CSV format
+ * @return void
+ */
+void fmt_monitor_rollup(const struct RollupView *view, bool json, bool csv){
+
+    if(json){
+        fmt_monitor_rollup_json(view);
+    }
+
+    else if(csv){
+        fmt_monitor_rollup_csv(view);
+    }
+
+    else{
+        fmt_monitor_rollup_table(view);
+    }
+}
@@ -8,8 +8,16 @@
  *
  * Public API:
  *  - void fmt_scan_table(const ScanTable *t, bool json, bool csv);
+ *  - void fmt_sweep_table(const SweepTable *t, bool json, bool csv);
  *  - void fmt_traceroute(const TraceRoute *t, bool json, bool csv);
  *  - void fmt_monitor_series(const MonitorSeries *s, bool json, bool csv);
+ *  - void fmt_monitor_stream_begin(bool json, bool csv);
+ *  - void fmt_monitor_stream_sample(const IfaceStats *s, bool json, bool csv);
+ *  - void fmt_monitor_stream_end(const MonitorSeries *s, bool json, bool csv);
+ *  - void fmt_monitor_rollup(const RollupView *v, bool json, bool csv);
+ *  - void fmt_path_stats(const PathStats *s, bool json, bool csv, bool refresh);
+ *  - void fmt_pmtu_table(const PmtuTable *t, bool json, bool csv);
+ *  - void fmt_topo_graph(const TopoGraph *g, bool json, bool csv, bool dot);
  * 
  * Author: Shan Truong - 400576105 - truons8
  * Date: December 3, 2025
@@ -23,11 +31,25 @@
 
 //Forward declarations
 struct ScanTable;
+struct SweepTable;
 struct TraceRoute;
 struct MonitorSeries;
+struct IfaceStats;
+struct RollupView;
+struct PathStats;
+struct PmtuTable;
+struct TopoGraph;
 
 void fmt_scan_table(const struct ScanTable *table, bool json, bool csv);
+void fmt_sweep_table(const struct SweepTable *table, bool json, bool csv);
 void fmt_traceroute(const struct TraceRoute *route, bool json, bool csv);
 void fmt_monitor_series(const struct MonitorSeries *series, bool json, bool csv);
+void fmt_monitor_stream_begin(bool json, bool csv);
+void fmt_monitor_stream_sample(const struct IfaceStats *sample, bool json, bool csv);
+void fmt_monitor_stream_end(const struct MonitorSeries *series, bool json, bool csv);
+void fmt_monitor_rollup(const struct RollupView *view, bool json, bool csv);
+void fmt_path_stats(const struct PathStats *stats, bool json, bool csv, bool refresh);
+void fmt_pmtu_table(const struct PmtuTable *table, bool json, bool csv);
+void fmt_topo_graph(const struct TopoGraph *graph, bool json, bool csv, bool dot);
 
 #endif /* FMT_H */
\ No newline at end of file
@@ -8,7 +8,10 @@
  *
  * Contains:
  *  - typedefs mirrored from scanner.h (ScanResult, ScanTable)
- *  - typedefs mirrored from tracer.h  (Hop, TraceRoute)
+ *  - typedefs mirrored from sweep.h   (HostPing, SweepTable)
+ *  - typedefs mirrored from tracer.h  (Hop, TraceRoute, HopStats, PathStats)
+ *  - typedefs mirrored from topo.h    (TopoNode, TopoEdge, TopoGraph)
+ *  - typedefs mirrored from pmtu.h    (PmtuResult, PmtuTable)
  *  - typedefs mirrored from monitor.h (IfaceStats, MonitorSeries)
  *
  * Note:
@@ -45,28 +48,91 @@ typedef struct ScanResult{
  * - rows: Dynamically allocated array of ScanResult
  * - len: Number of valid entries in rows
  * - cap: Allocated capacity of rows
+ * - has_asn: true if ip/asn/prefix describe the target (--asn)
+ * - ip, asn, prefix: Target address, origin AS (0 = no route) and matched prefix
  */
 typedef struct ScanTable{
     ScanResult *rows;
     size_t len, cap;
+    bool has_asn;
+    char ip[64];
+    unsigned int asn;
+    char prefix[20];
 } ScanTable;
 
+/**
+ * Data model for the ping statistics of one host in a subnet sweep.
+ * - ip: Host address as string
+ * - sent, received: Echo Requests sent / Echo Replies received (loss = sent - received)
+ * - min_us, max_us: Smallest / largest RTT in microseconds (-1 if no reply)
+ * - avg_us: Mean RTT in microseconds
+ * - mdev_us: Standard deviation of the RTT in microseconds (like ping's mdev)
+ * - asn, prefix: Origin AS (0 = no route) and matched prefix (with --asn)
+ */
+typedef struct HostPing{
+    char ip[64];
+    unsigned long sent, received;
+    long min_us, max_us;
+    double avg_us;
+    double mdev_us;
+    unsigned int asn;
+    char prefix[20];
+} HostPing;
+
+/**
+ * Data model for a subnet ping sweep.
+ * - rows: Dynamically allocated array of HostPing, one per host that replied
+ * - len: Number of valid entries in rows
+ * - cap: Allocated capacity of rows
+ * - subnet: Swept CIDR block as given
+ * - hosts: Number of addresses probed
+ * - count: Echo Requests sent per host
+ * - has_asn: true if the rows carry AS annotations (--asn)
+ */
+typedef struct SweepTable{
+    HostPing *rows;
+    size_t len, cap;
+    char subnet[64];
+    unsigned long hosts;
+    int count;
+    bool has_asn;
+} SweepTable;
+
+// Most probes per TTL a trace can send (--queries)
+#define HOP_MAX_QUERIES 10
+
 /**
  * Data model for a single traceroute hop.
  * - hop: Hop number (TTL)
  * - host: Resolved hostname (or "?" if unknown)
  * - ip: IP address as string
- * - rtt_ms: Round-trip time in milliseconds (-1 if timeout)
- * - timeout: true if the hop timed out
+ * - rtt_us: Round-trip time in microseconds (-1 if timeout); with several queries,
+ *   the RTT of the query that answered from ip
+ * - timeout: true if the hop timed out (no query answered)
  * - icmp_type: ICMP type received (e.g., ICMP_ECHOREPLY, ICMP_TIME_EXCEEDED)
+ * - flow: Paris flow identifier that reached this hop (-1 if not flow-controlled)
+ * - reached: true if this hop is the destination (Echo Reply, Port Unreachable, SYN-ACK/RST)
+ * - cached: true if copied from the hop cache instead of probed (rtt_us is -1)
+ * - asn, prefix: Origin AS (0 = no route) and matched prefix (with --asn)
+ * - queries: Probes sent to this TTL (0 if cached)
+ * - query_rtt_us, query_ip: Per-probe RTT (-1 if lost) and responder ("*" if lost);
+ *   different routers can answer different probes of one TTL
  */
 typedef struct Hop{
     int hop;
     char host[256];
     char ip[64];
-    int rtt_ms;
+    long rtt_us;
     bool timeout;
     int  icmp_type;  // 0 = ECHO_REPLY, 11 = TIME_EXCEEDED, etc.
+    int  flow;
+    bool reached;
+    bool cached;
+    unsigned int asn;
+    char prefix[20];
+    int  queries;
+    long query_rtt_us[HOP_MAX_QUERIES];
+    char query_ip[HOP_MAX_QUERIES][16];
 } Hop;
 
 /**
@@ -74,24 +140,197 @@ typedef struct Hop{
  * - rows: Dynamically allocated array of Hop
  * - len: Number of valid entries in rows
  * - cap: Allocated capacity of rows
+ * - has_asn: true if the hops carry AS annotations (--asn)
+ * - queries: Probes sent per TTL (--queries)
  */
 typedef struct TraceRoute{
     Hop *rows;
     size_t len, cap;
+    bool has_asn;
+    int queries;
 } TraceRoute;
 
+/**
+ * Data model for one router (or target) in a merged topology graph.
+ * - addr: IPv4 address (network order), the key nodes are interned by
+ * - ip, host: Address string and resolved name (from the first trace that saw it)
+ * - min_ttl: Smallest TTL it was seen at (0 for the local source)
+ * - traces: Number of traces that went through it
+ * - target: true if some trace ended here
+ * - first_out: Index of its first outgoing edge (-1 if none), chained by TopoEdge.next_out
+ */
+typedef struct TopoNode{
+    unsigned int addr;
+    char ip[64];
+    char host[256];
+    int min_ttl;
+    unsigned long traces;
+    bool target;
+    long first_out;
+} TopoNode;
+
+/**
+ * Data model for one directed link between consecutive responding hops.
+ * - from, to: Node indices
+ * - gap: TTL distance (1 = adjacent; more if silent hops sat in between)
+ * - traces: Number of traces that used this link
+ * - samples: Traces that measured an RTT for the 'to' hop (cached hops don't)
+ * - min_us, max_us, sum_us: RTT statistics of the 'to' hop seen along this link
+ * - next_out: Next outgoing edge of 'from' (-1 = last)
+ */
+typedef struct TopoEdge{
+    size_t from, to;
+    int gap;
+    unsigned long traces;
+    unsigned long samples;
+    long min_us, max_us;
+    double sum_us;
+    long next_out;
+} TopoEdge;
+
+/**
+ * Data model for a topology graph merged from many traces.
+ * Memory grows with unique routers and links, not with traces x hops.
+ * - nodes, nnodes, node_cap: Node table (node 0 is the local source)
+ * - edges, nedges, edge_cap: Edge table
+ * - node_index, node_slots: Open-addressing hash of address -> node index + 1 (0 = empty)
+ * - edge_index, edge_slots: Open-addressing hash of (from, to) -> edge index + 1
+ * - ntraces: Number of traces merged
+ * - cached: Hops taken from the hop cache instead of probed
+ */
+typedef struct TopoGraph{
+    TopoNode *nodes;
+    size_t nnodes, node_cap;
+    TopoEdge *edges;
+    size_t nedges, edge_cap;
+    size_t *node_index;
+    size_t node_slots;
+    size_t *edge_index;
+    size_t edge_slots;
+    unsigned long ntraces;
+    unsigned long cached;
+} TopoGraph;
+
+// Number of recent probe results kept per hop in continuous trace mode
+#define HOP_HISTORY_LEN 64
+
+/**
+ * Data model for running statistics of one hop in continuous trace mode.
+ * Every field is updated in O(1) per probe; memory is fixed per hop.
+ * - hop: Hop number (TTL)
+ * - host, ip: Most recent responder at this TTL
+ * - sent, received: Probe counters (loss = sent - received)
+ * - last_us, best_us, worst_us: RTTs in microseconds (-1 until first reply)
+ * - avg_us: Running mean RTT in microseconds
+ * - jitter_us: Smoothed |RTT delta| between consecutive replies (RFC 3550)
+ * - history: Ring of the last HOP_HISTORY_LEN results (-1 = lost)
+ * - hist_head, hist_len: Ring write position and fill level
+ * - hist_lost: Number of losses currently inside the ring
+ */
+typedef struct HopStats{
+    int hop;
+    char host[256];
+    char ip[64];
+    unsigned long sent, received;
+    long last_us, best_us, worst_us;
+    double avg_us;
+    double jitter_us;
+    long history[HOP_HISTORY_LEN];
+    size_t hist_head, hist_len, hist_lost;
+} HopStats;
+
+/**
+ * Data model for a continuously monitored path.
+ * - hops: Array of HopStats, one per TTL (allocated once)
+ * - len: Number of hops currently on the path (up to the destination)
+ * - cap: Allocated capacity of hops
+ * - cycles: Number of completed probe rounds
+ */
+typedef struct PathStats{
+    HopStats *hops;
+    size_t len, cap;
+    unsigned long cycles;
+} PathStats;
+
+/**
+ * Data model for the path MTU towards one target.
+ * - target: Target as given on the command line
+ * - ip: Resolved IP address as string
+ * - mtu: Largest packet (IP bytes, DF set) that got an Echo Reply (-1 if none did)
+ * - hint_mtu: Last next-hop MTU reported by a Fragmentation Needed error (0 if none)
+ * - hint_from: Router that reported hint_mtu ("" if none)
+ * - probes: Probes sent to find mtu
+ * - rtt_us: RTT of the reply that confirmed mtu in microseconds (-1 if none)
+ * - blackhole: A larger probe vanished without a Fragmentation Needed error
+ */
+typedef struct PmtuResult{
+    char target[256];
+    char ip[64];
+    int mtu;
+    int hint_mtu;
+    char hint_from[64];
+    int probes;
+    long rtt_us;
+    bool blackhole;
+} PmtuResult;
+
+/**
+ * Data model for path MTU results, one row per target.
+ * - rows: Dynamically allocated array of PmtuResult
+ * - len: Number of valid entries in rows
+ * - cap: Allocated capacity of rows
+ */
+typedef struct PmtuTable{
+    PmtuResult *rows;
+    size_t len, cap;
+} PmtuTable;
+
+/* Interface name buffer: IFNAMSIZ, the kernel allows at most 15 characters */
+#define IFACE_NAME_MAX 16
+
+/**
+ * Data model for the raw counters of one interface, as read from a stats
+ * source (/proc/net/dev or netlink). Counters are read as 64-bit totals,
+ * but some drivers keep 32-bit ones that wrap at 2^32.
+ * - name: Interface name
+ * - ifindex: Kernel interface index (0 = unknown; /proc/net/dev has none)
+ * - rx_*, tx_*: Bytes, packets, errors and drops per direction
+ * - rx_multicast: Multicast packets received
+ */
+typedef struct IfCounters{
+    char name[IFACE_NAME_MAX];
+    int ifindex;
+    unsigned long long rx_bytes, rx_packets, rx_errors, rx_dropped, rx_multicast;
+    unsigned long long tx_bytes, tx_packets, tx_errors, tx_dropped;
+} IfCounters;
+
 /**
  * Data model for interface statistics sample.
  * - iface: Interface name
  * - rx_bytes: Total received bytes
  * - tx_bytes: Total transmitted bytes
  * - rx_rate_bps: Receive rate in bits per second
+ * - rx_packets, tx_packets: Total packets
+ * - rx_errors, tx_errors, rx_dropped, tx_dropped: Total errors and drops
+ * - multicast: Total multicast packets received
+ * - rx_avg_bps, tx_avg_bps: Mean rate over the rolling window
+ * - rx_ewma_bps, tx_ewma_bps: Exponentially weighted moving average rate
+ * - rx/tx_min_bps, rx/tx_max_bps, rx/tx_stddev_bps: Rate extremes and spread over the window
+ * - ts_ms: Wall-clock time the counters were read (Unix epoch, milliseconds)
  */
 typedef struct IfaceStats{
-    char iface[64];
+    char iface[IFACE_NAME_MAX];
     unsigned long long rx_bytes, tx_bytes;
     double rx_rate_bps, tx_rate_bps;
     double rx_avg_bps, tx_avg_bps;
+    double rx_ewma_bps, tx_ewma_bps;
+    double rx_min_bps, rx_max_bps, tx_min_bps, tx_max_bps;
+    double rx_stddev_bps, tx_stddev_bps;
+    long long ts_ms;
+    unsigned long long rx_packets, tx_packets;
+    unsigned long long rx_errors, tx_errors;
+    unsigned long long rx_dropped, tx_dropped;
+    unsigned long long multicast;
 } IfaceStats;
 
 /**
@@ -99,10 +338,56 @@ typedef struct IfaceStats{
  * - samples: Dynamically allocated array of IfaceStats
  * - len: Number of valid entries in samples
  * - cap: Allocated capacity of samples
+ * - ticks: Sampling deadlines that passed during the run
+ * - missed_ticks: Deadlines skipped because a sample was still being taken
+ * - counter_resets: Times an interface's counters went back (driver reset,
+ *   or the interface was re-created), so it was re-baselined with no sample
+ * - counter_wraps: Times a 32-bit counter wrapped past 2^32 and the rate was corrected
  */
 typedef struct MonitorSeries{
     IfaceStats *samples;
     size_t len, cap;
+    unsigned long long ticks, missed_ticks;
+    unsigned long long counter_resets, counter_wraps;
 } MonitorSeries;
 
+/**
+ * Data model for one rollup bucket: the rates of one interface
+ * aggregated over a fixed span of wall-clock time.
+ * - start_ms: Start of the span (Unix epoch, milliseconds, aligned to the tier width)
+ * - samples: Raw samples folded into the bucket
+ * - rx/tx_min_bps, rx/tx_max_bps: Rate extremes within the span
+ * - rx/tx_sum_bps: Sum of the rates (average = sum / samples)
+ * - rx/tx_last_bps: Rate of the latest sample in the span
+ */
+typedef struct RollupBucket{
+    long long start_ms;
+    unsigned long samples;
+    double rx_min_bps, rx_max_bps, rx_sum_bps, rx_last_bps;
+    double tx_min_bps, tx_max_bps, tx_sum_bps, tx_last_bps;
+} RollupBucket;
+
+/**
+ * Data model for one row of a rollup query.
+ * - iface: Interface name
+ * - bucket: Aggregated rates
+ */
+typedef struct RollupRow{
+    char iface[IFACE_NAME_MAX];
+    RollupBucket bucket;
+} RollupRow;
+
+/**
+ * Data model for the answer to a rollup query, taken from one tier.
+ * - width_ms: Bucket width of the tier the rows come from
+ * - rows: Dynamically allocated array of RollupRow, interface by interface, oldest first
+ * - len: Number of valid entries in rows
+ * - cap: Allocated capacity of rows
+ */
+typedef struct RollupView{
+    long long width_ms;
+    RollupRow *rows;
+    size_t len, cap;
+} RollupView;
+
 #endif /* MODEL_H */
\ No newline at end of file
@@ -0,0 +1,51 @@
+/*
+ * File: counter.c
+ * Purpose: Implements the wrap/reset classification of interface counters.
+ *
+ * A 32-bit counter that wraps and a counter that is reset (driver reset,
+ * interface re-created) both go back, and the value alone cannot tell
+ * them apart: a reset from 3e9 to 0 looks like a wrap that moved 1.3 GB.
+ * The interface's recent rates can. A wrap is accepted only when the rate
+ * it implies is at most COUNTER_WRAP_BURST times the busiest rate in the
+ * rolling window; with an empty window there is nothing to compare with,
+ * so the step is a reset.
+ *
+ * AUTHOR: Youssef Elshafei
+ * DATE:   2025-12-03
+ */
+
+#include "counter.h"
+
+/*
+ * Works out how far a counter moved since the previous sample.
+ * Parameters:
+ *   prev, curr – counter at the previous and at this sample
+ *   rates      – rolling window of this counter's rates in bit/s
+ *   dt_sec     – seconds between the two samples
+ *   delta      – set to the increase (0 after a reset)
+ * Returns:
+ *   COUNTER_OK, COUNTER_WRAPPED (delta counts across the wrap) or COUNTER_RESET.
+ *
+ * A counter that went back from a value that fits in 32 bits is taken as
+ * a 32-bit wrap if the wrapped increase is below COUNTER32_WRAP_MAX and
+ * plausible for the window (see above); any other step back is a reset.
+ */
+CounterStep counter_step(unsigned long long prev, unsigned long long curr,
+                         const RingBuf *rates, double dt_sec, unsigned long long *delta) {
+    if (curr >= prev) {
+        *delta = curr - prev;
+        return COUNTER_OK;
+    }
+
+    if (prev <= COUNTER32_MAX && rates->len > 0 && dt_sec > 0) {
+        unsigned long long wrapped = (COUNTER32_MAX - prev) + curr + 1;
+        double rate = (wrapped * 8.0) / dt_sec;
+        if (wrapped < COUNTER32_WRAP_MAX && rate <= COUNTER_WRAP_BURST * ring_max(rates)) {
+            *delta = wrapped;
+            return COUNTER_WRAPPED;
+        }
+    }
+
+    *delta = 0;
+    return COUNTER_RESET;
+}
@@ -0,0 +1,54 @@
+/*
+ * File: counter.h
+ * Summary: Classifies how an interface byte counter moved between two samples.
+ *
+ * Responsibilities:
+ *  - Tell normal growth from a 32-bit counter wrapping and from a reset
+ *  - Give the increase across a wrap, so no sample is lost to it
+ *
+ * Data & Types:
+ *  - typedef enum CounterStep { COUNTER_OK, COUNTER_WRAPPED, COUNTER_RESET }
+ *
+ * Public API:
+ *  - CounterStep counter_step(unsigned long long prev, unsigned long long curr,
+ *                             const RingBuf *rates, double dt_sec, unsigned long long *delta);
+ *
+ * Notes:
+ *  - A step back can only be judged against recent traffic: a wrap is accepted
+ *    only if the rate it implies fits the interface's rolling window
+ *  - Ambiguous steps are resets; a reset costs one sample, a false wrap a bogus rate
+ *
+ * AUTHOR: Youssef Elshafei
+ * DATE:   2025-12-03
+ */
+#ifndef COUNTER_H
+#define COUNTER_H
+
+#include "ringbuf.h"
+
+/* Largest value of a 32-bit counter */
+#define COUNTER32_MAX 0xFFFFFFFFULL
+
+/* Most a wrapped 32-bit counter is taken to have moved in one sample;
+ * a bigger backwards step is a reset */
+#define COUNTER32_WRAP_MAX (1ULL << 31)
+
+/* How far above the busiest rate in the window a wrap's rate may be */
+#define COUNTER_WRAP_BURST 4.0
+
+/*
+ * How a counter moved since the previous sample.
+ * COUNTER_OK:       it grew (or stood still)
+ * COUNTER_WRAPPED:  a 32-bit counter passed 2^32 and started again from 0
+ * COUNTER_RESET:    it went back: the increase since the last sample is unknown
+ */
+typedef enum CounterStep {
+    COUNTER_OK,
+    COUNTER_WRAPPED,
+    COUNTER_RESET
+} CounterStep;
+
+CounterStep counter_step(unsigned long long prev, unsigned long long curr,
+                         const RingBuf *rates, double dt_sec, unsigned long long *delta);
+
+#endif /* COUNTER_H */
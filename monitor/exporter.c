@@ -0,0 +1,678 @@
+/*
+ * File: exporter.c
+ * Purpose: Implements the monitor's Prometheus metrics endpoint.
+ *
+ * The monitor hands every sample to exporter_update(), which only copies
+ * it into the snapshot. A scrape renders the snapshot (at most once per
+ * batch of new samples) into a buffer that keeps its size from scrape to
+ * scrape, then copies it into the connection's own reused buffer, so a
+ * slow client never holds up the next render. All sockets are
+ * non-blocking and driven from one epoll set.
+ *
+ * AUTHOR: Youssef Elshafei
+ * DATE:   2025-12-03
+ */
+
+#define _GNU_SOURCE   // accept4()
+
+#include "exporter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <errno.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+
+/* epoll tag of the listening socket (connections use their slot number) */
+#define EXPORTER_LISTEN EXPORTER_MAX_CONNS
+
+/* Room for the status line and headers of a response */
+#define EXPORTER_HEAD_MAX 256
+
+/* Room for one sample line: metric name, escaped label and value */
+#define EXPORTER_LINE_MAX 256
+
+/* Content type of the text exposition format */
+#define EXPORTER_CONTENT_TYPE "text/plain; version=0.0.4; charset=utf-8"
+
+/*
+ * One exported metric family.
+ * name:     metric name
+ * help:     HELP text
+ * counter:  unsigned long long counter field (false: double gauge field)
+ * off:      offset of the field in IfaceStats
+ */
+typedef struct {
+    const char *name;
+    const char *help;
+    bool counter;
+    size_t off;
+} ExporterMetric;
+
+static const ExporterMetric exporter_metrics[] = {
+    { "wirefish_receive_bytes_total", "Bytes received.", true, offsetof(IfaceStats, rx_bytes) },
+    { "wirefish_transmit_bytes_total", "Bytes transmitted.", true, offsetof(IfaceStats, tx_bytes) },
+    { "wirefish_receive_packets_total", "Packets received.", true, offsetof(IfaceStats, rx_packets) },
+    { "wirefish_transmit_packets_total", "Packets transmitted.", true, offsetof(IfaceStats, tx_packets) },
+    { "wirefish_receive_errors_total", "Receive errors.", true, offsetof(IfaceStats, rx_errors) },
+    { "wirefish_transmit_errors_total", "Transmit errors.", true, offsetof(IfaceStats, tx_errors) },
+    { "wirefish_receive_dropped_total", "Received packets dropped.", true, offsetof(IfaceStats, rx_dropped) },
+    { "wirefish_transmit_dropped_total", "Transmitted packets dropped.", true, offsetof(IfaceStats, tx_dropped) },
+    { "wirefish_receive_multicast_total", "Multicast packets received.", true, offsetof(IfaceStats, multicast) },
+    { "wirefish_receive_bits_per_second", "Receive rate over the last sampling interval.", false, offsetof(IfaceStats, rx_rate_bps) },
+    { "wirefish_transmit_bits_per_second", "Transmit rate over the last sampling interval.", false, offsetof(IfaceStats, tx_rate_bps) },
+    { "wirefish_receive_avg_bits_per_second", "Mean receive rate over the rolling window.", false, offsetof(IfaceStats, rx_avg_bps) },
+    { "wirefish_transmit_avg_bits_per_second", "Mean transmit rate over the rolling window.", false, offsetof(IfaceStats, tx_avg_bps) },
+    { "wirefish_receive_ewma_bits_per_second", "Exponentially weighted moving average of the receive rate.", false, offsetof(IfaceStats, rx_ewma_bps) },
+    { "wirefish_transmit_ewma_bits_per_second", "Exponentially weighted moving average of the transmit rate.", false, offsetof(IfaceStats, tx_ewma_bps) },
+    { "wirefish_receive_min_bits_per_second", "Lowest receive rate in the rolling window.", false, offsetof(IfaceStats, rx_min_bps) },
+    { "wirefish_transmit_min_bits_per_second", "Lowest transmit rate in the rolling window.", false, offsetof(IfaceStats, tx_min_bps) },
+    { "wirefish_receive_max_bits_per_second", "Highest receive rate in the rolling window.", false, offsetof(IfaceStats, rx_max_bps) },
+    { "wirefish_transmit_max_bits_per_second", "Highest transmit rate in the rolling window.", false, offsetof(IfaceStats, tx_max_bps) },
+    { "wirefish_receive_stddev_bits_per_second", "Standard deviation of the receive rate over the rolling window.", false, offsetof(IfaceStats, rx_stddev_bps) },
+    { "wirefish_transmit_stddev_bits_per_second", "Standard deviation of the transmit rate over the rolling window.", false, offsetof(IfaceStats, tx_stddev_bps) },
+};
+
+/*
+ * Creates a non-blocking listening socket on one resolved address.
+ * Parameters:
+ *   ai       – address to bind
+ *   wildcard – no host was given (an IPv6 socket then accepts IPv4 too)
+ *   err      – set to errno on failure
+ * Returns:
+ *   Socket, or -1 on failure.
+ */
+static int exporter_listen(const struct addrinfo *ai, bool wildcard, int *err) {
+    int fd = socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, ai->ai_protocol);
+    if (fd < 0) {
+        *err = errno;
+        return -1;
+    }
+
+    // Restarting the monitor must not wait for old connections in TIME_WAIT
+    int one = 1, zero = 0;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (ai->ai_family == AF_INET6 && wildcard) {
+        setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &zero, sizeof(zero));  // "::" takes IPv4 too
+    }
+
+    if (bind(fd, ai->ai_addr, ai->ai_addrlen) < 0 || listen(fd, SOMAXCONN) < 0) {
+        *err = errno;
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/*
+ * Opens the listening socket and the epoll set.
+ * Parameters:
+ *   e    – exporter to initialize
+ *   host – address to listen on ("" = every address)
+ *   port – TCP port
+ * Returns:
+ *   0 on success, -1 with errno set on failure.
+ */
+int exporter_open(Exporter *e, const char *host, int port) {
+    memset(e, 0, sizeof(*e));
+    e->listen_fd = -1;
+    e->ep = -1;
+    for (size_t i = 0; i < EXPORTER_MAX_CONNS; i++) {
+        e->conn[i].fd = -1;
+    }
+
+    char service[16];
+    snprintf(service, sizeof(service), "%d", port);
+
+    struct addrinfo hints, *res = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE | AI_NUMERICSERV;
+
+    int rc = getaddrinfo(host[0] != '\0' ? host : NULL, service, &hints, &res);
+    if (rc != 0) {
+        if (rc != EAI_SYSTEM) {
+            errno = EADDRNOTAVAIL;
+        }
+        return -1;
+    }
+
+    // Pass 0 takes every address in order, except that with no host only the
+    // dual-stack "::" is tried there; pass 1 then falls back to "0.0.0.0"
+    bool wildcard = (host[0] == '\0');
+    int err = EADDRNOTAVAIL;
+    for (int pass = 0; pass < 2 && e->listen_fd < 0; pass++) {
+        for (struct addrinfo *ai = res; ai != NULL && e->listen_fd < 0; ai = ai->ai_next) {
+            if ((pass == 1 && !wildcard) || (wildcard && (ai->ai_family == AF_INET6) != (pass == 0))) {
+                continue;
+            }
+            e->listen_fd = exporter_listen(ai, wildcard, &err);
+        }
+    }
+    freeaddrinfo(res);
+
+    if (e->listen_fd < 0) {
+        errno = err;
+        return -1;
+    }
+
+    e->ep = epoll_create1(EPOLL_CLOEXEC);
+    if (e->ep < 0) {
+        exporter_close(e);
+        return -1;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u64 = EXPORTER_LISTEN;
+    if (epoll_ctl(e->ep, EPOLL_CTL_ADD, e->listen_fd, &ev) < 0) {
+        exporter_close(e);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Makes a sample the latest value of its interface.
+ * Parameters:
+ *   e      – exporter
+ *   sample – monitor sample
+ * Returns:
+ *   0 on success, -1 on allocation failure for a new interface.
+ */
+int exporter_update(Exporter *e, const IfaceStats *sample) {
+    size_t i = e->hint;
+
+    // Samples come in the same interface order every tick: try the next slot first
+    if (i >= e->nifs || strcmp(e->ifs[i].iface, sample->iface) != 0) {
+        for (i = 0; i < e->nifs; i++) {
+            if (strcmp(e->ifs[i].iface, sample->iface) == 0) {
+                break;
+            }
+        }
+    }
+
+    if (i == e->nifs) {
+        if (e->nifs == e->ifs_cap) {
+            size_t newcap = e->ifs_cap ? e->ifs_cap * 2 : 16;
+            IfaceStats *newifs = realloc(e->ifs, newcap * sizeof(IfaceStats));
+            if (!newifs) {
+                return -1;
+            }
+            e->ifs = newifs;
+            e->ifs_cap = newcap;
+        }
+        e->nifs++;
+    }
+
+    e->ifs[i] = *sample;
+    e->hint = i + 1;
+    e->dirty = true;
+    return 0;
+}
+
+/*
+ * Drops an interface from the snapshot (it disappeared from the host).
+ * Parameters:
+ *   e     – exporter
+ *   iface – interface name
+ */
+void exporter_remove(Exporter *e, const char *iface) {
+    for (size_t i = 0; i < e->nifs; i++) {
+        if (strcmp(e->ifs[i].iface, iface) == 0) {
+            memmove(&e->ifs[i], &e->ifs[i + 1], (e->nifs - i - 1) * sizeof(IfaceStats));
+            e->nifs--;
+            e->hint = 0;
+            e->dirty = true;
+            return;
+        }
+    }
+}
+
+/*
+ * Makes room for n more bytes in the rendered body.
+ * Returns:
+ *   0 on success, -1 on allocation failure.
+ */
+static int body_reserve(Exporter *e, size_t n) {
+    if (e->body_cap - e->body_len > n) {
+        return 0;
+    }
+
+    size_t newcap = e->body_cap ? e->body_cap * 2 : 8192;
+    while (newcap - e->body_len <= n) {
+        newcap *= 2;
+    }
+    char *newbody = realloc(e->body, newcap);
+    if (!newbody) {
+        return -1;
+    }
+    e->body = newbody;
+    e->body_cap = newcap;
+    return 0;
+}
+
+/*
+ * Appends formatted text to the rendered body, growing it when needed.
+ * Returns:
+ *   0 on success, -1 on allocation failure.
+ */
+static int body_printf(Exporter *e, const char *fmt, ...) {
+    va_list ap;
+
+    va_start(ap, fmt);
+    int n = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+    if (n < 0 || body_reserve(e, (size_t)n) < 0) {
+        return -1;
+    }
+
+    va_start(ap, fmt);
+    vsnprintf(e->body + e->body_len, e->body_cap - e->body_len, fmt, ap);
+    va_end(ap);
+    e->body_len += (size_t)n;
+    return 0;
+}
+
+/*
+ * Writes v in decimal at p.
+ * Returns:
+ *   End of the digits.
+ */
+static char *put_u64(char *p, unsigned long long v) {
+    char tmp[20];
+    int n = 0;
+
+    do {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v > 0);
+
+    while (n > 0) {
+        *p++ = tmp[--n];
+    }
+    return p;
+}
+
+/*
+ * Writes a gauge value at p, rounded to 3 decimals without trailing zeros
+ * (printf only for values too large for that, or not finite).
+ * Returns:
+ *   End of the value.
+ */
+static char *put_value(char *p, double v) {
+    if (!(v > -1e15 && v < 1e15)) {
+        return p + snprintf(p, 32, "%.15g", v);
+    }
+
+    long long m = (long long)(v * 1000.0 + (v < 0 ? -0.5 : 0.5));
+    if (m < 0) {
+        *p++ = '-';
+        m = -m;
+    }
+
+    p = put_u64(p, (unsigned long long)(m / 1000));
+    int frac = (int)(m % 1000);
+    if (frac != 0) {
+        *p++ = '.';
+        *p++ = (char)('0' + frac / 100);
+        if (frac % 100 != 0) {
+            *p++ = (char)('0' + frac / 10 % 10);
+            if (frac % 10 != 0) {
+                *p++ = (char)('0' + frac % 10);
+            }
+        }
+    }
+    return p;
+}
+
+/*
+ * Writes the start of a sample line, name{iface="..."} and a space, at p,
+ * escaping \, " and newline in the interface name.
+ * Returns:
+ *   Where the value goes.
+ */
+static char *put_series(char *p, const char *name, size_t name_len, const char *iface) {
+    memcpy(p, name, name_len);
+    p += name_len;
+    memcpy(p, "{iface=\"", 8);
+    p += 8;
+
+    for (const char *c = iface; *c; c++) {
+        if (*c == '\\' || *c == '"') {
+            *p++ = '\\';
+            *p++ = *c;
+        } else if (*c == '\n') {
+            *p++ = '\\';
+            *p++ = 'n';
+        } else {
+            *p++ = *c;
+        }
+    }
+
+    memcpy(p, "\"} ", 3);
+    return p + 3;
+}
+
+/*
+ * Renders the snapshot in the text exposition format into e->body.
+ * Metric families are grouped, one line per interface, as the format requires.
+ * Sample lines are written straight into the body: with many interfaces,
+ * printf-style formatting of every value would dominate the scrape.
+ * Returns:
+ *   0 on success, -1 on allocation failure (body left empty).
+ */
+static int exporter_render(Exporter *e) {
+    e->body_len = 0;
+
+    for (size_t m = 0; m < sizeof(exporter_metrics) / sizeof(exporter_metrics[0]); m++) {
+        const ExporterMetric *mt = &exporter_metrics[m];
+        size_t name_len = strlen(mt->name);
+
+        if (body_printf(e, "# HELP %s %s\n# TYPE %s %s\n", mt->name, mt->help, mt->name,
+                        mt->counter ? "counter" : "gauge") < 0) {
+            e->body_len = 0;
+            return -1;
+        }
+
+        for (size_t i = 0; i < e->nifs; i++) {
+            if (body_reserve(e, EXPORTER_LINE_MAX) < 0) {
+                e->body_len = 0;
+                return -1;
+            }
+
+            const char *field = (const char *)&e->ifs[i] + mt->off;
+            char *p = put_series(e->body + e->body_len, mt->name, name_len, e->ifs[i].iface);
+            if (mt->counter) {
+                p = put_u64(p, *(const unsigned long long *)field);
+            } else {
+                p = put_value(p, *(const double *)field);
+            }
+            *p++ = '\n';
+            e->body_len = (size_t)(p - e->body);
+        }
+    }
+
+    // When each interface was last sampled, to spot a stalled monitor
+    static const char ts_name[] = "wirefish_last_sample_timestamp_seconds";
+    if (body_printf(e, "# HELP %s Unix time of the interface's latest sample.\n# TYPE %s gauge\n",
+                    ts_name, ts_name) < 0) {
+        e->body_len = 0;
+        return -1;
+    }
+    for (size_t i = 0; i < e->nifs; i++) {
+        if (body_reserve(e, EXPORTER_LINE_MAX) < 0) {
+            e->body_len = 0;
+            return -1;
+        }
+
+        long long ts = e->ifs[i].ts_ms > 0 ? e->ifs[i].ts_ms : 0;
+        char *p = put_series(e->body + e->body_len, ts_name, sizeof(ts_name) - 1, e->ifs[i].iface);
+        p = put_u64(p, (unsigned long long)(ts / 1000));
+        *p++ = '.';
+        *p++ = (char)('0' + ts % 1000 / 100);
+        *p++ = (char)('0' + ts % 100 / 10);
+        *p++ = (char)('0' + ts % 10);
+        *p++ = '\n';
+        e->body_len = (size_t)(p - e->body);
+    }
+
+    e->dirty = false;
+    return 0;
+}
+
+/*
+ * Frees a connection slot (its response buffer is kept for the next client).
+ */
+static void conn_close(ExporterConn *c) {
+    if (c->fd >= 0) {
+        close(c->fd);  // Also removes it from the epoll set
+    }
+    c->fd = -1;
+    c->in_len = 0;
+    c->out_len = 0;
+    c->out_sent = 0;
+}
+
+/*
+ * Fills a connection's response buffer.
+ * Parameters:
+ *   c       – connection
+ *   status  – status line text, e.g. "200 OK"
+ *   type    – Content-Type
+ *   extra   – additional header lines, each ending in \r\n ("" = none)
+ *   body    – response body and its length
+ *   head    – HEAD request: headers only
+ * Returns:
+ *   0 on success, -1 on allocation failure.
+ */
+static int conn_reply(ExporterConn *c, const char *status, const char *type, const char *extra,
+                      const char *body, size_t body_len, bool head) {
+    size_t need = EXPORTER_HEAD_MAX + strlen(extra) + (head ? 0 : body_len);
+
+    if (need > c->out_cap) {
+        char *newout = realloc(c->out, need);
+        if (!newout) {
+            return -1;
+        }
+        c->out = newout;
+        c->out_cap = need;
+    }
+
+    int n = snprintf(c->out, c->out_cap,
+                     "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\nConnection: close\r\n%s\r\n",
+                     status, type, body_len, extra);
+    if (n < 0 || (size_t)n >= c->out_cap) {
+        return -1;
+    }
+
+    c->out_len = (size_t)n;
+    if (!head && body_len > 0) {
+        memcpy(c->out + c->out_len, body, body_len);
+        c->out_len += body_len;
+    }
+    c->out_sent = 0;
+    return 0;
+}
+
+/*
+ * Answers a complete request head.
+ * Returns:
+ *   0 on success, -1 if no response could be built.
+ */
+static int conn_respond(Exporter *e, ExporterConn *c) {
+    static const char index_page[] = "Wirefish exporter\nMetrics: /metrics\n";
+    static const char not_found[] = "Not found\n";
+    static const char bad_method[] = "Only GET and HEAD are supported\n";
+    static const char bad_request[] = "Bad request\n";
+
+    // Request line: METHOD SP PATH[?QUERY] SP VERSION
+    char *line = c->in;
+    size_t mlen = strcspn(line, " \r\n");
+    if (line[mlen] != ' ') {
+        return conn_reply(c, "400 Bad Request", "text/plain", "", bad_request, sizeof(bad_request) - 1, false);
+    }
+    char *path = line + mlen + 1;
+    size_t plen = strcspn(path, " ?\r\n");
+
+    bool head = (mlen == 4 && memcmp(line, "HEAD", 4) == 0);
+    if (!head && !(mlen == 3 && memcmp(line, "GET", 3) == 0)) {
+        return conn_reply(c, "405 Method Not Allowed", "text/plain", "Allow: GET, HEAD\r\n",
+                          bad_method, sizeof(bad_method) - 1, false);
+    }
+
+    if (plen == 8 && memcmp(path, "/metrics", 8) == 0) {
+        // Only re-render when a sample arrived since the last scrape
+        if (e->dirty && exporter_render(e) < 0) {
+            return -1;
+        }
+        e->scrapes++;
+        return conn_reply(c, "200 OK", EXPORTER_CONTENT_TYPE, "", e->body, e->body_len, head);
+    }
+
+    if (plen == 1 && path[0] == '/') {
+        return conn_reply(c, "200 OK", "text/plain", "", index_page, sizeof(index_page) - 1, head);
+    }
+    return conn_reply(c, "404 Not Found", "text/plain", "", not_found, sizeof(not_found) - 1, head);
+}
+
+/*
+ * Sends as much of the response as the socket takes; closes the
+ * connection once it is all out, or waits for EPOLLOUT.
+ */
+static void conn_send(Exporter *e, ExporterConn *c, size_t slot) {
+    while (c->out_sent < c->out_len) {
+        ssize_t w = send(c->fd, c->out + c->out_sent, c->out_len - c->out_sent, MSG_NOSIGNAL);
+        if (w < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                struct epoll_event ev;
+                memset(&ev, 0, sizeof(ev));
+                ev.events = EPOLLOUT;
+                ev.data.u64 = slot;
+                if (epoll_ctl(e->ep, EPOLL_CTL_MOD, c->fd, &ev) < 0) {
+                    conn_close(c);
+                }
+                return;
+            }
+            conn_close(c);
+            return;
+        }
+        c->out_sent += (size_t)w;
+    }
+    conn_close(c);
+}
+
+/*
+ * Reads from a connection until the request head is complete, then answers it.
+ */
+static void conn_read(Exporter *e, ExporterConn *c, size_t slot) {
+    ssize_t r = recv(c->fd, c->in + c->in_len, sizeof(c->in) - 1 - c->in_len, 0);
+    if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return;
+    }
+    if (r <= 0) {
+        conn_close(c);  // Peer went away (or error) before finishing the request
+        return;
+    }
+
+    c->in_len += (size_t)r;
+    c->in[c->in_len] = '\0';
+
+    int rc;
+    if (strstr(c->in, "\r\n\r\n") != NULL || strstr(c->in, "\n\n") != NULL) {
+        rc = conn_respond(e, c);
+    } else if (c->in_len == sizeof(c->in) - 1) {
+        static const char too_large[] = "Request head too large\n";
+        rc = conn_reply(c, "431 Request Header Fields Too Large", "text/plain", "",
+                        too_large, sizeof(too_large) - 1, false);
+    } else {
+        return;  // Wait for the rest of the head
+    }
+
+    if (rc < 0) {
+        conn_close(c);
+        return;
+    }
+    conn_send(e, c, slot);
+}
+
+/*
+ * Accepts every pending connection.
+ */
+static void exporter_accept(Exporter *e) {
+    for (;;) {
+        int fd = accept4(e->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;  // EAGAIN: no more pending; anything else: try again on the next event
+        }
+
+        // Free slot, or else the oldest connection gives way
+        size_t slot = 0;
+        for (size_t i = 0; i < EXPORTER_MAX_CONNS; i++) {
+            if (e->conn[i].fd < 0) {
+                slot = i;
+                break;
+            }
+            if (e->conn[i].seq < e->conn[slot].seq) {
+                slot = i;
+            }
+        }
+
+        ExporterConn *c = &e->conn[slot];
+        conn_close(c);
+        c->fd = fd;
+        c->seq = ++e->accepted;
+
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.u64 = slot;
+        if (epoll_ctl(e->ep, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            conn_close(c);
+        }
+    }
+}
+
+/*
+ * Handles whatever is ready on the listening socket and the connections,
+ * without waiting. Call when e->ep becomes readable.
+ */
+void exporter_poll(Exporter *e) {
+    struct epoll_event ev[EXPORTER_MAX_CONNS + 1];
+
+    int n = epoll_wait(e->ep, ev, EXPORTER_MAX_CONNS + 1, 0);
+    for (int i = 0; i < n; i++) {
+        size_t slot = (size_t)ev[i].data.u64;
+
+        if (slot == EXPORTER_LISTEN) {
+            exporter_accept(e);
+            continue;
+        }
+
+        ExporterConn *c = &e->conn[slot];
+        if (c->fd < 0) {
+            continue;  // Closed earlier in this batch
+        }
+        if (c->out_len > 0) {
+            conn_send(e, c, slot);
+        } else {
+            conn_read(e, c, slot);
+        }
+    }
+}
+
+/*
+ * Closes every socket and frees the snapshot and buffers.
+ */
+void exporter_close(Exporter *e) {
+    for (size_t i = 0; i < EXPORTER_MAX_CONNS; i++) {
+        conn_close(&e->conn[i]);
+        free(e->conn[i].out);
+        e->conn[i].out = NULL;
+        e->conn[i].out_cap = 0;
+    }
+    if (e->listen_fd >= 0) {
+        close(e->listen_fd);
+    }
+    if (e->ep >= 0) {
+        close(e->ep);
+    }
+    free(e->ifs);
+    free(e->body);
+    e->listen_fd = -1;
+    e->ep = -1;
+    e->ifs = NULL;
+    e->nifs = e->ifs_cap = 0;
+    e->body = NULL;
+    e->body_len = e->body_cap = 0;
+}
@@ -0,0 +1,101 @@
+/*
+ * File: exporter.h
+ * Summary: Prometheus/OpenMetrics endpoint for the monitor (--serve).
+ *
+ * Responsibilities:
+ *  - Listen on a TCP address and answer "GET /metrics" over HTTP/1.x from
+ *    one non-blocking epoll loop (no threads)
+ *  - Keep the latest sample of every interface as the scrape snapshot
+ *  - Render the snapshot in the text exposition format into a buffer that
+ *    is reused from scrape to scrape, and only re-rendered after new samples
+ *
+ * Data & Types:
+ *  - typedef struct ExporterConn { int fd; char in[EXPORTER_REQ_MAX]; char *out; ... }
+ *  - typedef struct Exporter { int listen_fd, ep; IfaceStats *ifs; char *body; ExporterConn conn[EXPORTER_MAX_CONNS]; ... }
+ *
+ * Public API:
+ *  - int  exporter_open(Exporter *e, const char *host, int port);
+ *  - int  exporter_update(Exporter *e, const IfaceStats *sample);
+ *  - void exporter_remove(Exporter *e, const char *iface);
+ *  - void exporter_poll(Exporter *e);
+ *  - void exporter_close(Exporter *e);
+ *
+ * Notes:
+ *  - e->ep is itself pollable: the monitor waits on it together with its
+ *    sampling timer and calls exporter_poll() when it becomes readable,
+ *    so scrapes are served between ticks and sampling never waits on a client
+ *  - Sockets are non-blocking; a response the client does not read at once
+ *    stays in the connection's buffer and is sent as the socket drains
+ *  - One request per connection (Connection: close)
+ *  - When every slot is busy, a new connection replaces the oldest one
+ *  - Interfaces the monitor stops seeing are removed, so their series go
+ *    stale in Prometheus instead of repeating their last value
+ *
+ * AUTHOR: Youssef Elshafei
+ * DATE:   2025-12-03
+ */
+#ifndef EXPORTER_H
+#define EXPORTER_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "../model/model.h"
+
+/* Clients served at the same time */
+#define EXPORTER_MAX_CONNS 32
+
+/* Largest request head accepted (request line and headers) */
+#define EXPORTER_REQ_MAX 4096
+
+/*
+ * One client connection.
+ * fd:                socket (-1 = free slot)
+ * seq:               accept order, to find the oldest connection
+ * in, in_len:        request head received so far
+ * out, out_cap:      response buffer (kept and reused when the slot is freed)
+ * out_len, out_sent: response size and bytes already sent (out_len = 0: still reading)
+ */
+typedef struct ExporterConn {
+    int fd;
+    unsigned long long seq;
+    char in[EXPORTER_REQ_MAX];
+    size_t in_len;
+    char *out;
+    size_t out_cap;
+    size_t out_len, out_sent;
+} ExporterConn;
+
+/*
+ * Metrics endpoint.
+ * listen_fd:          listening socket
+ * ep:                 epoll instance watching listen_fd and every connection
+ * ifs, nifs:          latest sample of each interface, in the order first seen
+ * ifs_cap:            allocated entries in ifs
+ * hint:               slot expected for the next sample (samples arrive in interface order)
+ * body, body_len:     rendered exposition of the snapshot
+ * body_cap:           allocated size of body
+ * dirty:              the snapshot changed since body was rendered
+ * conn:               client slots
+ * accepted:           connections accepted so far
+ * scrapes:            /metrics responses sent so far
+ */
+typedef struct Exporter {
+    int listen_fd, ep;
+    IfaceStats *ifs;
+    size_t nifs, ifs_cap;
+    size_t hint;
+    char *body;
+    size_t body_len, body_cap;
+    bool dirty;
+    ExporterConn conn[EXPORTER_MAX_CONNS];
+    unsigned long long accepted;
+    unsigned long long scrapes;
+} Exporter;
+
+int  exporter_open(Exporter *e, const char *host, int port);
+int  exporter_update(Exporter *e, const IfaceStats *sample);
+void exporter_remove(Exporter *e, const char *iface);
+void exporter_poll(Exporter *e);
+void exporter_close(Exporter *e);
+
+#endif /* EXPORTER_H */
@@ -0,0 +1,63 @@
+/*
+ * File: ifstats.h
+ * Summary: Interface counter source for the monitor: netlink or /proc/net/dev.
+ *
+ * Responsibilities:
+ *  - Open the requested backend (auto = netlink, falling back to /proc/net/dev)
+ *  - Take samples and look interfaces up, whichever backend is in use
+ *
+ * Data & Types:
+ *  - typedef enum IfStatsBackend { IFSTATS_AUTO, IFSTATS_NETLINK, IFSTATS_PROCFS }
+ *  - typedef struct IfStats { IfStatsBackend backend; NlStats nl; ProcNetDev proc; const IfCounters *ifs; size_t nifs; }
+ *
+ * Public API:
+ *  - int  ifstats_open(IfStats *s, IfStatsBackend want);
+ *  - int  ifstats_sample(IfStats *s);
+ *  - const IfCounters *ifstats_find(const IfStats *s, const char *name);
+ *  - const char *ifstats_backend_name(IfStatsBackend backend);
+ *  - void ifstats_close(IfStats *s);
+ *
+ * AUTHOR: Youssef Elshafei
+ * DATE:   2025-12-03
+ */
+#ifndef IFSTATS_H
+#define IFSTATS_H
+
+#include <stddef.h>
+#include "../model/model.h"
+#include "procnet.h"
+#include "nlstats.h"
+
+/*
+ * Where counters come from.
+ * IFSTATS_AUTO:    netlink if it works, else /proc/net/dev
+ * IFSTATS_NETLINK: rtnetlink stats dump (binary, 64-bit counters)
+ * IFSTATS_PROCFS:  /proc/net/dev text
+ */
+typedef enum IfStatsBackend {
+    IFSTATS_AUTO = 0,
+    IFSTATS_NETLINK,
+    IFSTATS_PROCFS
+} IfStatsBackend;
+
+/*
+ * Open counter source.
+ * backend:    backend actually in use (never IFSTATS_AUTO once open)
+ * nl, proc:   backend state (only the one in use is open)
+ * ifs, nifs:  interfaces from the last sample
+ */
+typedef struct IfStats {
+    IfStatsBackend backend;
+    NlStats nl;
+    ProcNetDev proc;
+    const IfCounters *ifs;
+    size_t nifs;
+} IfStats;
+
+int  ifstats_open(IfStats *s, IfStatsBackend want);
+int  ifstats_sample(IfStats *s);
+const IfCounters *ifstats_find(const IfStats *s, const char *name);
+const char *ifstats_backend_name(IfStatsBackend backend);
+void ifstats_close(IfStats *s);
+
+#endif /* IFSTATS_H */
@@ -2,9 +2,17 @@
  * File: monitor.c
  * Purpose: Implements network interface bandwidth monitoring.
  *
- * Reads /proc/net/dev to extract RX/TX byte counters, computes
- * instantaneous bit-rates, calculates rolling averages, and stores
- * samples in a dynamically growing MonitorSeries.
+ * Reads interface counters (over netlink, or /proc/net/dev through
+ * the persistent reader in procnet.c; see ifstats.c), computes
+ * instantaneous bit-rates, calculates rolling averages, and hands
+ * each sample to the caller's callback and/or stores it in a
+ * MonitorSeries (growing, or a fixed ring of the last N samples).
+ *
+ * Counters are not trusted to only grow: a 32-bit counter that wraps
+ * is corrected, and a counter that goes back (driver reset, interface
+ * deleted and re-created under the same name) restarts the interface
+ * from a new baseline instead of producing a huge rate. Which of the
+ * two a step back is gets decided in counter.c.
  *
  * AUTHOR: Youssef Elshafei
  * DATE:   2025-12-03
@@ -12,229 +20,297 @@
  */
 
 #include "monitor.h"
+#include "ifstats.h"
+#include "ringbuf.h"
+#include "counter.h"
 #include "../timeutil/timeutil.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdbool.h>
 #include <signal.h>
+#include <errno.h>
+#include <fnmatch.h>
+#include <unistd.h>
+#include <sys/epoll.h>
 
-// Path to Linux kernel network device statistics */
-#define PROC_NET_DEV "/proc/net/dev"  
-#define WINDOW_SIZE 10
+/* Samples a watched interface may go unlisted before it is dropped. One
+ * that comes back in time keeps its state, so a delete and re-create
+ * that straddles a read is a counter reset, not a new interface */
+#define TRACK_GRACE 5
 
 // Global flag modified by signal handler to stop monitoring loop
 static volatile int running = 1;
 
 /*
- * Ring buffer structure used to compute rolling averages.
- * values: dynamically allocated array of doubles
- * size:   total capacity
- * head:   index for next insertion
- * count:  number of items currently stored (<= size)
+ * Signal handler used to request a stop of the monitoring loop.
+ * Sets global flag 'running' to 0.
+ */
+static void signal_handler(int sig) {
+    (void)sig;  // Explicitly ignore unused parameter
+    running = 0; // Set flag to break monitoring loop
+}
+/*
+ * Allows external code to stop monitoring (used by API).
+ */
+void monitor_stop(void) {
+    running = 0;
+}
+
+/*
+ * Per-interface monitoring state.
+ * name:              interface name
+ * prev:              counters at the previous sample
+ * prev_ns:           CLOCK_MONOTONIC time those counters were read
+ * rx_ring, tx_ring:  rolling windows of this interface's rates
+ * gen:               last sample that listed the interface
  */
 typedef struct {
-    double *values;    // Array to store the values
-    size_t size;       // Maximum capacity of the buffer
-    size_t head;       // Index where next value will be inserted
-    size_t count;      // Current number of elements in buffer
-} RingBuffer;
+    char name[IFACE_NAME_MAX];
+    IfCounters prev;
+    long long prev_ns;
+    RingBuf rx_ring;
+    RingBuf tx_ring;
+    unsigned long long gen;
+} IfaceTrack;
 
 /*
- * Creates and initializes a ring buffer of given size.
- * Parameters:
- *   size – number of elements to allocate
- * Returns:
- *   Pointer to a new RingBuffer, or NULL on allocation failure.
+ * Set of interfaces being monitored, in the order they were first seen.
+ * gen:  number of the current sample (interfaces it has not listed for
+ *       more than TRACK_GRACE samples are dropped)
  */
-static RingBuffer* ringbuf_create(size_t size) {
-    // Allocate memory for the ring buffer structure
-    RingBuffer *rb = malloc(sizeof(RingBuffer));
-    if (!rb) return NULL;
-    
-    // Allocate memory for the values array and initialize to zero
-    rb->values = calloc(size, sizeof(double));
-    if (!rb->values) {
-        free(rb);  // Clean up if allocation fails
-        return NULL;
-    }
-    
-    // Initialize ring buffer properties
-    rb->size = size;
-    rb->head = 0;    // Start at beginning
-    rb->count = 0;   // Buffer is initially empty
-    return rb;
-}
+typedef struct {
+    IfaceTrack *v;
+    size_t len, cap;
+    unsigned long long gen;
+} IfaceTrackSet;
 
 /*
- * Inserts a new value into the ring buffer.
- * Overwrites the oldest item if the buffer is full.
+ * Where finished samples go.
+ * series:     output series (a ring once keep samples are stored)
+ * keep:       MonitorOptions.keep
+ * next:       ring slot the next sample overwrites once the ring is full
+ * on_sample:  per-sample callback (NULL = none) and its context
+ * on_gone:    callback for interfaces that disappear (NULL = none)
  */
-static void ringbuf_push(RingBuffer *rb, double value) {
-    // Store value at current head position
-    rb->values[rb->head] = value;
-    // Move head to next position, wrapping around if needed
-    rb->head = (rb->head + 1) % rb->size;
-    // Increase count until buffer is full, then stop counting up
-    if (rb->count < rb->size) {
-        rb->count++;
-    }
-}
+typedef struct {
+    MonitorSeries *series;
+    size_t keep;
+    size_t next;
+    MonitorSampleFn on_sample;
+    MonitorGoneFn on_gone;
+    void *ctx;
+} SampleSink;
 
 /*
- * Computes the arithmetic mean of all values stored in the buffer.
- * Returns 0.0 if the buffer is empty.
+ * Tells whether an --iface specification selects more than one exact name.
+ * Parameters:
+ *   spec – "all", a comma list, or a name containing glob characters
+ * Returns:
+ *   1 if spec is a pattern, 0 if it names one interface.
  */
-static double ringbuf_average(const RingBuffer *rb) {
-    if (rb->count == 0) return 0.0;
-    
-    // Sum all values in the buffer
-    double sum = 0.0;
-    for (size_t i = 0; i < rb->count; i++) {
-        sum += rb->values[i];
-    }
-    // Return average
-    return sum / rb->count;
+static int iface_spec_is_pattern(const char *spec) {
+    return strcmp(spec, "all") == 0 || strpbrk(spec, "*?[,") != NULL;
 }
 
 /*
- * Frees all memory used by a ring buffer.
+ * Matches an interface name against an --iface specification.
+ * Parameters:
+ *   spec – "all" or a comma-separated list of fnmatch() globs
+ *   name – interface name from the counter source
+ * Returns:
+ *   1 if any element of spec matches, 0 otherwise.
  */
-static void ringbuf_free(RingBuffer *rb) {
-    if (rb) {
-        free(rb->values);  // Free the values array
-        free(rb);          // Free the structure itself
+static int iface_spec_matches(const char *spec, const char *name) {
+    if (strcmp(spec, "all") == 0) {
+        return 1;
     }
+
+    char glob[256];
+    const char *p = spec;
+
+    while (*p) {
+        // Copy the next comma-separated element
+        size_t n = strcspn(p, ",");
+        if (n > 0 && n < sizeof(glob)) {
+            memcpy(glob, p, n);
+            glob[n] = '\0';
+            if (fnmatch(glob, name, 0) == 0) {
+                return 1;
+            }
+        }
+
+        p += n;
+        if (*p == ',') {
+            p++;
+        }
+    }
+    return 0;
 }
 
 /*
- * Signal handler used to request a stop of the monitoring loop.
- * Sets global flag 'running' to 0.
+ * Finds an interface's state, trying slot 'hint' first.
+ * Counter sources list interfaces in the same order every sample,
+ * so the hint is almost always right and the lookup is O(1).
+ * Returns:
+ *   Pointer to the state, or NULL if the interface is not tracked yet.
  */
-static void signal_handler(int sig) {
-    (void)sig;  // Explicitly ignore unused parameter
-    running = 0; // Set flag to break monitoring loop
+static IfaceTrack *track_find(IfaceTrackSet *set, size_t hint, const char *name) {
+    if (hint < set->len && strcmp(set->v[hint].name, name) == 0) {
+        return &set->v[hint];
+    }
+
+    for (size_t i = 0; i < set->len; i++) {
+        if (strcmp(set->v[i].name, name) == 0) {
+            return &set->v[i];
+        }
+    }
+    return NULL;
 }
+
 /*
- * Allows external code to stop monitoring (used by API).
+ * Starts tracking an interface, with c as its baseline counters.
+ * Parameters:
+ *   set    – per-interface state
+ *   c      – the interface's counters from this sample
+ *   now_ns – when the sample was read (CLOCK_MONOTONIC)
+ *   window – rolling window length in samples
+ *   alpha  – EWMA weight of each new rate
+ * Returns:
+ *   Pointer to the new state, or NULL on allocation failure.
  */
-void monitor_stop(void) {
-    running = 0;
+static IfaceTrack *track_add(IfaceTrackSet *set, const IfCounters *c, long long now_ns, size_t window, double alpha) {
+    if (set->len == set->cap) {
+        size_t newcap = set->cap ? set->cap * 2 : 16;
+        IfaceTrack *newv = realloc(set->v, newcap * sizeof(IfaceTrack));
+        if (!newv) {
+            return NULL;
+        }
+        set->v = newv;
+        set->cap = newcap;
+    }
+
+    IfaceTrack *t = &set->v[set->len];
+    memset(t, 0, sizeof(*t));
+    strncpy(t->name, c->name, sizeof(t->name) - 1);
+    t->prev = *c;
+    t->prev_ns = now_ns;
+    t->gen = set->gen;
+
+    /* Rolling windows for the rate statistics (O(1) per sample, any length) */
+    if (ring_init(&t->rx_ring, window, alpha) < 0) {  // For receive rates
+        return NULL;
+    }
+    if (ring_init(&t->tx_ring, window, alpha) < 0) {  // For transmit rates
+        ring_free(&t->rx_ring);
+        return NULL;
+    }
+
+    set->len++;
+    return t;
 }
 
 /*
- * Reads RX/TX byte counters for the specified interface.
+ * Stops tracking the interfaces the last TRACK_GRACE + 1 samples did not
+ * list, keeping the others in the order they were first seen.
  * Parameters:
- *   iface     – interface name ("eth0", "wlan0", etc.)
- *   rx_bytes  – output pointer for received byte counter
- *   tx_bytes  – output pointer for transmitted byte counter
- * Returns:
- *   0 on success, -1 if interface not found or read fails.
+ *   set  – per-interface state
+ *   sink – its on_gone callback is told about each interface dropped
+ *
+ * An interface missing from fewer samples stays, with its last counters
+ * and ifindex: if the name comes back, track_update() compares against
+ * them and counts a reset when the interface was re-created.
  */
-static int read_iface_stats(const char *iface, unsigned long long *rx_bytes, unsigned long long *tx_bytes) {
-    // Open the kernel's network statistics file
-    FILE *fp = fopen(PROC_NET_DEV, "r");
-    if (!fp) {
-        perror("Cannot open /proc/net/dev");
-        return -1;
-    }
-    
-    char line[256];
-    int found = 0;
-    
-    /* Skip first two header lines in /proc/net/dev
-     * Line 1: "Inter-|   Receive..."  
-     * Line 2: " face |bytes    packets..." */
-    fgets(line, sizeof(line), fp);
-    fgets(line, sizeof(line), fp);
-    
-    /* Parse each interface line in the file
-     * Format: iface_name: rx_bytes rx_packets rx_errs ... tx_bytes tx_packets ... */
-    while (fgets(line, sizeof(line), fp)) {
-        char iface_name[64];
-        unsigned long long rx, tx;
-        unsigned long long dummy;  // For fields we don't care about
-        
-        /* Parse the line - we need the first 10 fields:
-         * 1: interface name (with colon)
-         * 2-9: RX statistics (we only care about bytes)
-         * 10: TX bytes */
-        int n = sscanf(line, " %63[^:]: %llu %llu %llu %llu %llu %llu %llu %llu %llu",
-                       iface_name, &rx, &dummy, &dummy, &dummy, &dummy, &dummy, &dummy, &dummy, &tx);
-        
-        // Check if we found our interface and parsed enough fields
-        if (n >= 10 && strcmp(iface_name, iface) == 0) {
-            *rx_bytes = rx;
-            *tx_bytes = tx;
-            found = 1;
-            break;
+static void track_sweep(IfaceTrackSet *set, const SampleSink *sink) {
+    size_t kept = 0;
+
+    for (size_t i = 0; i < set->len; i++) {
+        IfaceTrack *t = &set->v[i];
+
+        if (set->gen - t->gen <= TRACK_GRACE) {
+            if (kept != i) {
+                set->v[kept] = *t;
+            }
+            kept++;
+            continue;
         }
+
+        // Deleted, renamed or moved to another namespace
+        if (sink->on_gone) {
+            sink->on_gone(t->name, sink->ctx);
+        }
+        ring_free(&t->rx_ring);
+        ring_free(&t->tx_ring);
     }
-    
-    fclose(fp);
-    
-    if (!found) {
-        fprintf(stderr, "Interface '%s' not found in /proc/net/dev\n", iface);
-        return -1;
+    set->len = kept;
+}
+
+/*
+ * Frees every interface's state.
+ */
+static void track_free(IfaceTrackSet *set) {
+    for (size_t i = 0; i < set->len; i++) {
+        ring_free(&set->v[i].rx_ring);
+        ring_free(&set->v[i].tx_ring);
     }
-    
-    return 0;
+    free(set->v);
+    memset(set, 0, sizeof(*set));
 }
 
 /*
- * Selects the first non-loopback interface from /proc/net/dev.
+ * Selects the first non-loopback interface from the counter source.
  * Parameters:
+ *   src       – open counter source
  *   iface_out – output buffer for detected interface name
  *   len       – length of output buffer
  * Returns:
  *   0 on success, -1 if no suitable interface exists.
  */
-static int get_default_interface(char *iface_out, size_t len) {
-    FILE *fp = fopen(PROC_NET_DEV, "r");
-    if (!fp) {
+static int get_default_interface(IfStats *src, char *iface_out, size_t len) {
+    if (ifstats_sample(src) < 0) {
         return -1;
     }
-    
-    char line[256];
-    
-    // Skip header lines
-    fgets(line, sizeof(line), fp);
-    fgets(line, sizeof(line), fp);
-    
+
     /* Find first non-loopback interface
      * Loopback interface "lo" is excluded as it's for local traffic only */
-    while (fgets(line, sizeof(line), fp)) {
-        char iface_name[64];
-        // Extract just the interface name (before colon)
-        if (sscanf(line, " %63[^:]:", iface_name) == 1) {
-            // Skip loopback interface
-            if (strcmp(iface_name, "lo") != 0) {
-                // Copy found interface name to output buffer
-                strncpy(iface_out, iface_name, len - 1);
-                iface_out[len - 1] = '\0';  // Ensure null termination
-                fclose(fp);
-                return 0;
-            }
+    for (size_t i = 0; i < src->nifs; i++) {
+        if (strcmp(src->ifs[i].name, "lo") != 0) {
+            // Copy found interface name to output buffer
+            strncpy(iface_out, src->ifs[i].name, len - 1);
+            iface_out[len - 1] = '\0';  // Ensure null termination
+            return 0;
         }
     }
-    
-    fclose(fp);
+
     return -1;  // No suitable interface found
 }
 
 /*
  * Appends an IfaceStats sample into a MonitorSeries, growing
- * the internal buffer as needed. Capacity doubles when full.
+ * the internal buffer as needed. Capacity doubles when full,
+ * up to 'keep' samples; after that the oldest sample is
+ * overwritten, starting at slot *next.
  */
-static void monitor_append(MonitorSeries *series, const IfaceStats *stats) {
+static void monitor_append(MonitorSeries *series, size_t keep, size_t *next, const IfaceStats *stats) {
     // Safety check
-    if (series == NULL) {
+    if (series == NULL || keep == 0) {
+        return;
+    }
+
+    // Ring full: overwrite the oldest sample instead of growing
+    if (series->len == keep) {
+        series->samples[*next] = *stats;
+        *next = (*next + 1 == keep) ? 0 : *next + 1;
         return;
     }
 
     // Check if we need to expand the array
     if (series->len == series->cap) {
-        // Double the capacity (or start at 16 if currently 0)
+        // Double the capacity (or start at 16 if currently 0), never beyond keep
         size_t newcap = series->cap ? series->cap * 2 : 16;
+        if (newcap > keep) {
+            newcap = keep;
+        }
 
         // Reallocate memory with new capacity
         IfaceStats *newbuf = realloc(series->samples, newcap * sizeof(IfaceStats));
@@ -251,38 +327,319 @@ static void monitor_append(MonitorSeries *series, const IfaceStats *stats) {
     series->samples[series->len++] = *stats;
 }
 
+/*
+ * Delivers one finished sample: to the callback first, then to the series.
+ */
+static void sink_put(SampleSink *sink, const IfaceStats *stats) {
+    if (sink->on_sample) {
+        sink->on_sample(stats, sink->ctx);
+    }
+    monitor_append(sink->series, sink->keep, &sink->next, stats);
+}
+
+/*
+ * Rotates a wrapped ring so the series runs oldest to newest again.
+ * Parameters:
+ *   series – output series
+ *   next   – slot holding the oldest sample
+ */
+static void monitor_unwrap(MonitorSeries *series, size_t next) {
+    if (next == 0 || series->len < 2) {
+        return;
+    }
+
+    IfaceStats *ordered = malloc(series->len * sizeof(IfaceStats));
+    if (!ordered) {
+        return;  // Keep the ring as is rather than lose samples
+    }
+
+    size_t tail = series->len - next;
+    memcpy(ordered, series->samples + next, tail * sizeof(IfaceStats));
+    memcpy(ordered + tail, series->samples, next * sizeof(IfaceStats));
+    memcpy(series->samples, ordered, series->len * sizeof(IfaceStats));
+    free(ordered);
+}
+
+/*
+ * Copies an interface's rolling window statistics into a sample.
+ */
+static void track_window_stats(const IfaceTrack *t, IfaceStats *stats) {
+    stats->rx_avg_bps = ring_mean(&t->rx_ring);  // Rolling average receive rate
+    stats->tx_avg_bps = ring_mean(&t->tx_ring);  // Rolling average transmit rate
+    stats->rx_ewma_bps = ring_ewma(&t->rx_ring);
+    stats->tx_ewma_bps = ring_ewma(&t->tx_ring);
+    stats->rx_min_bps = ring_min(&t->rx_ring);
+    stats->rx_max_bps = ring_max(&t->rx_ring);
+    stats->tx_min_bps = ring_min(&t->tx_ring);
+    stats->tx_max_bps = ring_max(&t->tx_ring);
+    stats->rx_stddev_bps = ring_stddev(&t->rx_ring);
+    stats->tx_stddev_bps = ring_stddev(&t->tx_ring);
+}
+
+/*
+ * Turns one interface's new counters into a sample and makes them its baseline.
+ * Parameters:
+ *   t      – interface state
+ *   curr   – counters from this sample
+ *   now_ns – when the sample was read (CLOCK_MONOTONIC)
+ *   now_ms – when the sample was read (wall clock, Unix epoch)
+ *   sink   – where the sample goes
+ *
+ * After a counter reset no sample is produced: the counters only become
+ * the new baseline, and the next sample has a true rate. A new ifindex
+ * under the same name means the interface was re-created, so its rolling
+ * windows start over too; after a plain reset they carry on.
+ */
+static void track_update(IfaceTrack *t, const IfCounters *curr, long long now_ns, long long now_ms, SampleSink *sink) {
+    /* Time since this interface's previous sample, from monotonic nanoseconds */
+    double time_delta_sec = (now_ns - t->prev_ns) / 1e9;
+    if (time_delta_sec <= 0) {
+        return;
+    }
+
+    /* Calculate how many bytes transferred since last sample */
+    unsigned long long rx_delta, tx_delta;
+    CounterStep rx_step = counter_step(t->prev.rx_bytes, curr->rx_bytes, &t->rx_ring, time_delta_sec, &rx_delta);
+    CounterStep tx_step = counter_step(t->prev.tx_bytes, curr->tx_bytes, &t->tx_ring, time_delta_sec, &tx_delta);
+
+    bool recreated = (curr->ifindex != 0 && t->prev.ifindex != 0 && curr->ifindex != t->prev.ifindex);
+    if (recreated || rx_step == COUNTER_RESET || tx_step == COUNTER_RESET) {
+        if (recreated) {
+            ring_clear(&t->rx_ring);
+            ring_clear(&t->tx_ring);
+        }
+        sink->series->counter_resets++;
+        t->prev = *curr;
+        t->prev_ns = now_ns;
+        return;
+    }
+    sink->series->counter_wraps += (rx_step == COUNTER_WRAPPED) + (tx_step == COUNTER_WRAPPED);
+
+    /* Calculate instantaneous transfer rates in bits per second
+     * Multiply by 8 to convert bytes to bits */
+    double rx_rate = (rx_delta * 8.0) / time_delta_sec;
+    double tx_rate = (tx_delta * 8.0) / time_delta_sec;
+
+    /* Update rolling averages with new rates */
+    ring_push(&t->rx_ring, rx_rate);
+    ring_push(&t->tx_ring, tx_rate);
+
+    /* Package all statistics into a structure */
+    IfaceStats stats;
+    memset(&stats, 0, sizeof(stats));
+    strncpy(stats.iface, t->name, sizeof(stats.iface) - 1);
+    stats.rx_bytes = curr->rx_bytes;      // Total received bytes
+    stats.tx_bytes = curr->tx_bytes;      // Total transmitted bytes
+    stats.rx_rate_bps = rx_rate;   // Instantaneous receive rate (bps)
+    stats.tx_rate_bps = tx_rate;   // Instantaneous transmit rate (bps)
+    track_window_stats(t, &stats);           // Rolling mean, EWMA, min, max, stddev
+    stats.rx_packets = curr->rx_packets;
+    stats.tx_packets = curr->tx_packets;
+    stats.rx_errors = curr->rx_errors;
+    stats.tx_errors = curr->tx_errors;
+    stats.rx_dropped = curr->rx_dropped;
+    stats.tx_dropped = curr->tx_dropped;
+    stats.multicast = curr->rx_multicast;
+    stats.ts_ms = now_ms;
+
+    // Hand the sample to the callback and/or the output series
+    sink_put(sink, &stats);
+
+    /* Update previous values for next iteration */
+    t->prev = *curr;
+    t->prev_ns = now_ns;
+}
+
+/*
+ * Takes one sample and updates every interface that matches spec.
+ * Parameters:
+ *   src            – open counter source
+ *   spec           – interface name or pattern
+ *   opt            – window length and EWMA alpha for new interfaces
+ *   set            – per-interface state
+ *   baseline       – only record counters (first sample), no rates
+ *   sink           – where samples go
+ * Returns:
+ *   Number of matching interfaces, or -1 if the source could not be read.
+ *
+ * Interfaces seen for the first time only record their baseline;
+ * their first rate comes with the next sample. Interfaces no longer
+ * listed are dropped after TRACK_GRACE samples (see track_sweep()); one
+ * that comes back sooner carries on from its old counters, and one that
+ * comes back later starts again from a new baseline.
+ */
+static int monitor_sample(IfStats *src, const char *spec, const MonitorOptions *opt, IfaceTrackSet *set, bool baseline, SampleSink *sink) {
+    // One netlink dump or one pread() of /proc/net/dev for every interface
+    if (ifstats_sample(src) < 0) {
+        fprintf(stderr, "Cannot read interface counters (%s)\n", ifstats_backend_name(src->backend));
+        return -1;
+    }
+
+    // Rates divide by the time between reads, so stamp right after this one
+    long long now_ns = ns_mono();
+    long long now_ms = ms_now();
+    int matched = 0;
+    size_t hint = 0;
+
+    set->gen++;
+
+    for (size_t i = 0; i < src->nifs; i++) {
+        const IfCounters *c = &src->ifs[i];
+        if (!iface_spec_matches(spec, c->name)) {
+            continue;
+        }
+        matched++;
+
+        IfaceTrack *t = track_find(set, hint, c->name);
+        if (!t) {
+            track_add(set, c, now_ns, opt->window, opt->alpha);
+            hint = set->len;
+            continue;
+        }
+
+        hint = (size_t)(t - set->v) + 1;
+        t->gen = set->gen;
+        if (!baseline) {
+            track_update(t, c, now_ns, now_ms, sink);
+        }
+    }
+
+    track_sweep(set, sink);
+    return matched;
+}
+
+/*
+ * Creates the epoll set of the sampling timer and the caller's descriptor.
+ * Returns:
+ *   epoll descriptor, or -1 on failure.
+ */
+static int monitor_poll_open(int timer_fd, int poll_fd) {
+    int ep = epoll_create1(EPOLL_CLOEXEC);
+    if (ep < 0) {
+        return -1;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = timer_fd;
+    if (epoll_ctl(ep, EPOLL_CTL_ADD, timer_fd, &ev) < 0) {
+        close(ep);
+        return -1;
+    }
+    ev.data.fd = poll_fd;
+    if (epoll_ctl(ep, EPOLL_CTL_ADD, poll_fd, &ev) < 0) {
+        close(ep);
+        return -1;
+    }
+    return ep;
+}
+
+/*
+ * Waits until the next tick is due, running opt->on_poll each time
+ * opt->poll_fd becomes readable in the meantime.
+ * Returns:
+ *   1 when the timer has expired, 0 if interrupted by a signal, -1 on error.
+ */
+static int monitor_poll_wait(int ep, int timer_fd, const MonitorOptions *opt) {
+    for (;;) {
+        struct epoll_event ev[2];
+        int n = epoll_wait(ep, ev, 2, -1);
+        if (n < 0) {
+            return (errno == EINTR) ? 0 : -1;
+        }
+
+        bool due = false;
+        for (int i = 0; i < n; i++) {
+            if (ev[i].data.fd == timer_fd) {
+                due = true;
+            } else {
+                opt->on_poll(opt->ctx);
+            }
+        }
+        if (due) {
+            return 1;
+        }
+    }
+}
+
 /*
  * Main bandwidth monitoring loop.
  *
  * Parameters:
- *   iface        – interface to monitor (NULL = auto-detect)
- *   interval_ms  – sampling interval in milliseconds
- *   duration_sec – total duration (0 = run indefinitely)
- *   out          – output series to store collected samples
+ *   opt – what to monitor and how:
+ *         iface        – interface to monitor (NULL = auto-detect), "all",
+ *                        or a comma list of globs such as "eth*,bond0"
+ *         interval_us  – sampling interval in microseconds
+ *         duration_us  – total duration (0 = run indefinitely)
+ *         backend      – counter source (IFSTATS_AUTO = netlink, else /proc/net/dev)
+ *         window       – rolling window length in samples
+ *         alpha        – EWMA weight of each new rate (0 < alpha <= 1)
+ *         keep         – samples retained in out (MONITOR_KEEP_ALL, 0, or the last N)
+ *         on_sample    – called with each sample as it is taken (NULL = none)
+ *         on_gone      – called when a watched interface disappears (NULL = none)
+ *         on_poll      – called between ticks when poll_fd is readable (NULL = none)
+ *   out – output series to store collected samples (and the tick counts)
  *
  * Returns:
  *   0 on success, -1 on invalid arguments or setup failure.
  *
+ * Every tick reads all interfaces from one sample of the counter source
+ * and appends one IfaceStats per matching interface, so samples of
+ * different interfaces are interleaved in time order.
+ *
+ * Ticks come from an absolute-deadline timerfd (see ticker_start()), so
+ * the time spent reading and storing a sample does not stretch the
+ * period. Ticks that pass while a sample is still being taken are
+ * skipped and counted in out->missed_ticks. Rates always divide by the
+ * measured monotonic time between reads, so a late tick is not
+ * mistaken for a burst.
+ *
+ * Interfaces may come and go during the run (--iface all or globs on a
+ * container host): new ones are picked up at the next sample, vanished
+ * ones are dropped once they have been missing for TRACK_GRACE samples
+ * (on_gone is called then), and neither ends the run. Counter resets and 32-bit
+ * wraps are counted in out->counter_resets and out->counter_wraps.
+ *
+ * With keep = N the series holds at most N samples: once full, each new
+ * sample overwrites the oldest, and the ring is put back in time order
+ * before returning. With keep = 0 nothing is stored, so a run with
+ * duration_us = 0 and an on_sample callback uses constant memory.
+ *
+ * With on_poll set, the wait for the next tick is an epoll_wait() on the
+ * timerfd and poll_fd together, so the caller can serve its own sockets
+ * (the --serve metrics endpoint) between samples on the same thread.
+ *
  * Side effects:
- *   Installs SIGINT/SIGTERM handlers.
+ *   Installs SIGINT/SIGTERM handlers (without SA_RESTART, so a signal
+ *   ends the wait for the next tick at once).
  *   Allocates memory inside 'out' which must be freed
  *   with monitorseries_free().
  */
-int monitor_run(const char *iface, int interval_ms, int duration_sec, MonitorSeries *out) {
-    // Validate output parameter
-    if (out == NULL) {
+int monitor_run(const MonitorOptions *opt, MonitorSeries *out) {
+    // Validate parameters
+    if (opt == NULL || out == NULL || opt->window == 0 || !(opt->alpha > 0.0 && opt->alpha <= 1.0)) {
         return -1;
     }
 
-    char iface_name[64];
+    const char *iface = opt->iface;
+
+    char iface_name[256];
     // Initialize output structure to zero
     memset(out, 0, sizeof(*out));
+
+    /* Keep the counter source (netlink socket or /proc/net/dev) open for the whole run */
+    IfStats src;
+    if (ifstats_open(&src, opt->backend) < 0) {
+        return -1;
+    }
     
     /* Determine which interface to monitor */
     if (iface == NULL) {
         // Auto-detect first non-loopback interface
-        if (get_default_interface(iface_name, sizeof(iface_name)) < 0) {
+        if (get_default_interface(&src, iface_name, sizeof(iface_name)) < 0) {
             fprintf(stderr, "Could not auto-detect interface\n");
+            ifstats_close(&src);
             return -1;
         }
     } else {
@@ -291,102 +648,117 @@ int monitor_run(const char *iface, int interval_ms, int duration_sec, MonitorSer
         iface_name[sizeof(iface_name) - 1] = '\0';  // Ensure null termination
     }
     
-    /* Set up signal handlers for graceful shutdown */
-    signal(SIGINT, signal_handler);   // Ctrl+C
-    signal(SIGTERM, signal_handler);  // Termination request
+    /* Set up signal handlers for graceful shutdown.
+     * No SA_RESTART: the blocked timerfd read must return EINTR */
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = signal_handler;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);   // Ctrl+C
+    sigaction(SIGTERM, &sa, NULL);  // Termination request
+
+    SampleSink sink = {
+        .series = out,
+        .keep = opt->keep,
+        .next = 0,
+        .on_sample = opt->on_sample,
+        .on_gone = opt->on_gone,
+        .ctx = opt->ctx
+    };
     
-    /* Create ring buffers for calculating rolling averages */
-    RingBuffer *rx_ring = ringbuf_create(WINDOW_SIZE);  // For receive rates
-    RingBuffer *tx_ring = ringbuf_create(WINDOW_SIZE);  // For transmit rates
-    if (!rx_ring || !tx_ring) {
-        fprintf(stderr, "Failed to allocate ring buffers\n");
-        ringbuf_free(rx_ring);
-        ringbuf_free(tx_ring);
+    /* Take initial reading to establish baseline */
+    IfaceTrackSet set = {0};
+    int matched = monitor_sample(&src, iface_name, opt, &set, true, &sink);
+    if (matched <= 0 || set.len == 0) {
+        if (matched > 0) {
+            fprintf(stderr, "Failed to allocate ring buffers\n");
+        } else if (matched == 0 && iface_spec_is_pattern(iface_name)) {
+            fprintf(stderr, "Interface pattern '%s' matches no interface\n", iface_name);
+        } else if (matched == 0) {
+            fprintf(stderr, "Interface '%s' not found in %s\n", iface_name,
+                    src.backend == IFSTATS_NETLINK ? "netlink stats dump" : PROC_NET_DEV);
+        }
+        track_free(&set);
+        ifstats_close(&src);
         return -1;
     }
     
-    /* Take initial reading to establish baseline */
-    unsigned long long prev_rx, prev_tx, curr_rx, curr_tx;
-    if (read_iface_stats(iface_name, &prev_rx, &prev_tx) < 0) {
-        ringbuf_free(rx_ring);
-        ringbuf_free(tx_ring);
+    /* Start the sampling clock: deadlines at baseline + k * interval */
+    Ticker tick;
+    if (ticker_start(&tick, opt->interval_us * 1000LL) < 0) {
+        perror("Cannot start sampling timer");
+        track_free(&set);
+        ifstats_close(&src);
         return -1;
     }
-    
-    /* Initialize timing variables */
+
+    // Run for a whole number of intervals (0 = until stopped)
+    unsigned long long max_ticks = 0;
+    if (opt->duration_us > 0) {
+        max_ticks = (unsigned long long)(opt->duration_us / opt->interval_us);
+        if (max_ticks == 0) {
+            max_ticks = 1;
+        }
+    }
+
+    // Watch the caller's descriptor alongside the timer
+    int ep = -1;
+    if (opt->on_poll != NULL) {
+        ep = monitor_poll_open(tick.fd, opt->poll_fd);
+        if (ep < 0) {
+            perror("Cannot watch descriptors");
+            ticker_stop(&tick);
+            track_free(&set);
+            ifstats_close(&src);
+            return -1;
+        }
+    }
+
     running = 1;
-    long start_time = ms_now();  // Get current time in milliseconds
-    long end_time = (duration_sec > 0) ? start_time + (duration_sec * 1000) : 0;
-    long prev_time = start_time;
-    
+
     /* Main monitoring loop */
     while (running) {
-        /* Sleep for the specified interval */
-        if (ms_sleep(interval_ms) < 0) {
-            break;  // Sleep was interrupted
+        if (ep >= 0) {
+            int ready = monitor_poll_wait(ep, tick.fd, opt);
+            if (ready < 0) {
+                break;  // epoll error
+            }
+            if (ready == 0) {
+                continue;  // Interrupted by a signal: re-check running
+            }
         }
-        
-        /* Check if we've exceeded the requested duration */
-        long curr_time = ms_now();
-        if (end_time > 0 && curr_time >= end_time) {
-            break;  // Time's up
+
+        /* Block until the next deadline (returns at once once epoll saw it expire) */
+        long long due = ticker_wait(&tick);
+        if (due < 0) {
+            break;  // Timer error
         }
-        
-        /* Read current network statistics */
-        if (read_iface_stats(iface_name, &curr_rx, &curr_tx) < 0) {
-            continue;  // Skip this iteration if read fails
+        if (due == 0) {
+            continue;  // Interrupted by a signal: re-check running
         }
         
-        /* Calculate time difference since last sample (in seconds) */
-        long time_delta_ms = ms_diff(prev_time, curr_time);
-        double time_delta_sec = time_delta_ms / 1000.0;
-        
-        // Skip if time difference is invalid
-        if (time_delta_sec <= 0) {
-            continue;
+        /* Read current network statistics for every matching interface */
+        monitor_sample(&src, iface_name, opt, &set, false, &sink);
+
+        /* Check if we've covered the requested duration */
+        if (max_ticks > 0 && tick.ticks >= max_ticks) {
+            break;  // Time's up
         }
-        
-        /* Calculate how many bytes transferred since last sample */
-        unsigned long long rx_delta = curr_rx - prev_rx;  // Received bytes delta
-        unsigned long long tx_delta = curr_tx - prev_tx;  // Transmitted bytes delta
-        
-        /* Calculate instantaneous transfer rates in bits per second
-         * Multiply by 8 to convert bytes to bits */
-        double rx_rate = (rx_delta * 8.0) / time_delta_sec;
-        double tx_rate = (tx_delta * 8.0) / time_delta_sec;
-        
-        /* Update rolling averages with new rates */
-        ringbuf_push(rx_ring, rx_rate);
-        ringbuf_push(tx_ring, tx_rate);
-        
-        // Calculate current rolling averages
-        double rx_avg = ringbuf_average(rx_ring);
-        double tx_avg = ringbuf_average(tx_ring);
-        
-        /* Package all statistics into a structure */
-        IfaceStats stats;
-        memset(&stats, 0, sizeof(stats));        
-        strncpy(stats.iface, iface_name, sizeof(stats.iface) - 1);
-        stats.iface[sizeof(stats.iface) - 1] = '\0';
-        stats.rx_bytes = curr_rx;      // Total received bytes
-        stats.tx_bytes = curr_tx;      // Total transmitted bytes
-        stats.rx_rate_bps = rx_rate;   // Instantaneous receive rate (bps)
-        stats.tx_rate_bps = tx_rate;   // Instantaneous transmit rate (bps)
-        stats.rx_avg_bps = rx_avg;     // Rolling average receive rate
-        stats.tx_avg_bps = tx_avg;     // Rolling average transmit rate
-
-        // Store this sample in the output series
-        monitor_append(out, &stats);
-        
-        /* Update previous values for next iteration */
-        prev_rx = curr_rx;
-        prev_tx = curr_tx;
-        prev_time = curr_time;
     }
+
+    out->ticks = tick.ticks;
+    out->missed_ticks = tick.missed;
+    ticker_stop(&tick);
+    if (ep >= 0) {
+        close(ep);
+    }
+
+    // A ring that wrapped starts mid-array: put the oldest sample first
+    monitor_unwrap(out, sink.next);
     
     /* Clean up allocated resources */
-    ringbuf_free(rx_ring);
-    ringbuf_free(tx_ring);
+    track_free(&set);
+    ifstats_close(&src);
     
     return 0;
 }
@@ -404,4 +776,87 @@ void monitorseries_free(MonitorSeries *series) {
     series->samples = NULL;  // Prevent dangling pointer
     series->len = 0;         // Reset length
     series->cap = 0;         // Reset capacity
-}
\ No newline at end of file
+}
+
+/*
+ * Reorders a series interface by interface (in the order interfaces first
+ * appear), keeping each interface's samples in time order.
+ * The series is left interleaved if the temporary copy cannot be allocated.
+ */
+void monitorseries_group(MonitorSeries *series) {
+    if (series == NULL || series->len < 2) {
+        return;
+    }
+
+    IfaceStats *sorted = malloc(series->len * sizeof(IfaceStats));
+    char *done = calloc(series->len, 1);
+    if (!sorted || !done) {
+        free(sorted);
+        free(done);
+        return;
+    }
+
+    size_t n = 0;
+    for (size_t i = 0; i < series->len; i++) {
+        if (done[i]) {
+            continue;
+        }
+
+        // Sample i is the first of a new interface: gather all of its samples
+        for (size_t j = i; j < series->len; j++) {
+            if (!done[j] && strcmp(series->samples[j].iface, series->samples[i].iface) == 0) {
+                sorted[n++] = series->samples[j];
+                done[j] = 1;
+            }
+        }
+    }
+
+    memcpy(series->samples, sorted, series->len * sizeof(IfaceStats));
+    free(sorted);
+    free(done);
+}
+
+/*
+ * Recomputes the rolling statistics (mean, EWMA, min, max, stddev) of
+ * every sample from the instantaneous rates, interface by interface,
+ * as the live monitor would have. Used for series read back from a
+ * file, which store only counters and rates.
+ * Parameters:
+ *   series – samples in time order
+ *   window – rolling window length in samples
+ *   alpha  – EWMA weight of each new rate
+ * Returns:
+ *   0 on success, -1 on invalid arguments or allocation failure.
+ */
+int monitorseries_restat(MonitorSeries *series, size_t window, double alpha) {
+    if (series == NULL || window == 0 || !(alpha > 0.0 && alpha <= 1.0)) {
+        return -1;
+    }
+
+    IfaceTrackSet set = {0};
+    size_t hint = 0;
+
+    for (size_t i = 0; i < series->len; i++) {
+        IfaceStats *s = &series->samples[i];
+
+        IfaceTrack *t = track_find(&set, hint, s->iface);
+        if (!t) {
+            IfCounters c;
+            memset(&c, 0, sizeof(c));
+            snprintf(c.name, sizeof(c.name), "%s", s->iface);
+            t = track_add(&set, &c, 0, window, alpha);
+            if (!t) {
+                track_free(&set);
+                return -1;
+            }
+        }
+        hint = (size_t)(t - set.v) + 1;
+
+        ring_push(&t->rx_ring, s->rx_rate_bps);
+        ring_push(&t->tx_ring, s->tx_rate_bps);
+        track_window_stats(t, s);
+    }
+
+    track_free(&set);
+    return 0;
+}
@@ -1,46 +1,116 @@
 /*
  * File: monitor.h
- * Summary: Interface bandwidth monitor using /proc/net/dev sampling.
+ * Summary: Interface bandwidth monitor using netlink or /proc/net/dev sampling.
  *
  * Responsibilities:
- *  - Sample RX/TX byte counters for an interface at fixed intervals
- *  - Compute instantaneous rates (bps) and rolling averages
+ *  - Sample RX/TX byte counters at fixed intervals on absolute monotonic deadlines
+ *  - Watch many interfaces ("all" or globs) from one read of the counter source
+ *  - Compute instantaneous rates (bps) and rolling mean, EWMA, min, max and
+ *    standard deviation (ringbuf.h, O(1) per sample whatever the window)
+ *  - Keep rates sane across counter resets, 32-bit counter wraps and
+ *    interfaces that are re-created, appear or disappear mid-run
  *
  * Data & Types:
- *  - typedef struct IfaceStats { char iface[64]; U64 rx_bytes, tx_bytes; double rx_rate_bps, tx_rate_bps; double rx_avg_bps, tx_avg_bps; }
+ *  - typedef struct IfaceStats { char iface[IFACE_NAME_MAX]; U64 rx_bytes, tx_bytes; double rx_rate_bps, tx_rate_bps; double rx_avg_bps, tx_avg_bps; }
  *  - typedef struct MonitorSeries { IfaceStats *samples; size_t len, cap; }
+ *  - typedef struct MonitorOptions { const char *iface; long interval_us; long long duration_us; IfStatsBackend backend; size_t window; double alpha; size_t keep; MonitorSampleFn on_sample; MonitorGoneFn on_gone; int poll_fd; MonitorPollFn on_poll; void *ctx; }
  *
  * Public API:
- *  - int  monitor_run(const char *iface, int interval_ms, int duration_sec);
+ *  - int  monitor_run(const MonitorOptions *opt, MonitorSeries *out);
+ *  - void monitorseries_group(MonitorSeries *series);
+ *  - int  monitorseries_restat(MonitorSeries *series, size_t window, double alpha);
  *  - void monitor_print_header(void);
  *  - void monitor_print_stats(const IfaceStats *stats);
  *
  * Inputs:
- *  - iface: interface name (e.g., "eth0", "wlan0", NULL for first available)
- *  - interval_ms: sampling interval in milliseconds
- *  - duration_sec: monitoring duration in seconds (0 for infinite)
+ *  - iface: interface name (e.g., "eth0", "wlan0", NULL for first available),
+ *           "all", or a comma list of fnmatch() globs (e.g., "eth*,bond0")
+ *  - interval_us: sampling interval in microseconds (timerfd deadlines, no drift)
+ *  - duration_us: monitoring duration in microseconds (0 for infinite)
+ *  - backend: counter source (IFSTATS_AUTO tries netlink, then /proc/net/dev)
+ *  - window: rolling window length in samples (mean, min, max, stddev)
+ *  - alpha: EWMA weight of each new rate
+ *  - keep: samples retained for the caller (all, none, or the last N in a ring)
+ *  - on_sample: callback run with every sample as soon as it is taken
+ *  - on_gone: callback run when a watched interface is no longer listed
+ *  - poll_fd, on_poll: a descriptor waited on together with the sampling
+ *           timer, and the callback run whenever it is readable (--serve)
  *
  * Outputs:
- *  - Series of timestamped samples with computed rates
+ *  - Series of timestamped samples with computed rates, one per matching
+ *    interface per interval (interleaved; monitorseries_group() regroups)
+ *  - With keep = 0 and an on_sample callback, memory stays constant however
+ *    long the run: nothing is retained once the callback has seen a sample
+ *  - Counts of counter resets and corrected 32-bit wraps (MonitorSeries)
  *  - Format: IFACE RX_BYTES TX_BYTES RX_BPS TX_BPS RX_AVG_BPS TX_AVG_BPS
  *
  * Returns:
  *  - 0 on success; <0 on error (iface not found, file read error)
  *
- * Dependencies: timeutil.h
+ * Dependencies: timeutil.h, ifstats.h, ringbuf.h, counter.h
  */
 #ifndef MONITOR_H
 #define MONITOR_H
 
 #include <stddef.h>
 #include "../model/model.h"
+#include "ifstats.h"
+
+/* MonitorOptions.keep value that retains every sample */
+#define MONITOR_KEEP_ALL ((size_t)-1)
+
+/* Receives each sample as it is taken; ctx is MonitorOptions.ctx */
+typedef void (*MonitorSampleFn)(const IfaceStats *sample, void *ctx);
+
+/* Receives the name of an interface that left the counter source; ctx is MonitorOptions.ctx */
+typedef void (*MonitorGoneFn)(const char *iface, void *ctx);
+
+/* Runs between ticks whenever MonitorOptions.poll_fd is readable; must not block */
+typedef void (*MonitorPollFn)(void *ctx);
+
+/*
+ * Monitor settings.
+ * iface:         interface name, "all" or globs (NULL = auto-detect)
+ * interval_us:   sampling interval in microseconds
+ * duration_us:   total run time (0 = until stopped)
+ * backend:       counter source
+ * window:        rolling window length in samples
+ * alpha:         EWMA weight of each new rate, 0 < alpha <= 1
+ * keep:          samples retained in the output series: MONITOR_KEEP_ALL,
+ *                0 (none), or N for the last N (fixed ring, oldest overwritten)
+ * on_sample:     called with every sample as it is taken (NULL = none)
+ * on_gone:       called when a watched interface disappears (NULL = none)
+ * poll_fd:       descriptor to watch while waiting for the next tick
+ * on_poll:       called when poll_fd is readable (NULL = none, poll_fd unused)
+ * ctx:           passed through to on_sample, on_gone and on_poll
+ */
+typedef struct MonitorOptions {
+    const char *iface;
+    long interval_us;
+    long long duration_us;
+    IfStatsBackend backend;
+    size_t window;
+    double alpha;
+    size_t keep;
+    MonitorSampleFn on_sample;
+    MonitorGoneFn on_gone;
+    int poll_fd;
+    MonitorPollFn on_poll;
+    void *ctx;
+} MonitorOptions;
 
 /* Run bandwidth monitoring on interface */
-int monitor_run(const char *iface, int interval_ms, int duration_sec, MonitorSeries *out);
+int monitor_run(const MonitorOptions *opt, MonitorSeries *out);
 
 /* Stop monitoring (signal handler safe) */
 void monitor_stop(void);
 
+/* Reorder samples interface by interface (default order is by sample time) */
+void monitorseries_group(MonitorSeries *series);
+
+/* Recompute rolling statistics from the stored rates (series read from a file) */
+int monitorseries_restat(MonitorSeries *series, size_t window, double alpha);
+
 /* Free any heap memory owned by a MonitorSeries */
 void monitorseries_free(MonitorSeries *series);
 
@@ -0,0 +1,401 @@
+/*
+ * File: nlstats.c
+ * Purpose: Implements the rtnetlink interface counter reader.
+ *
+ * Two kinds of dump are used:
+ *  - RTM_GETLINK: one RTM_NEWLINK message per interface with every link
+ *    attribute; only IFLA_IFNAME and IFLA_STATS64 are kept. This is how
+ *    names and indexes are learnt.
+ *  - RTM_GETSTATS with filter IFLA_STATS_LINK_64: one small RTM_NEWSTATS
+ *    message per interface holding just its ifindex and rtnl_link_stats64.
+ *    Every steady-state sample is one of these.
+ * Both arrive packed into as many datagrams as needed, closed by NLMSG_DONE.
+ *
+ * A second socket listens to RTMGRP_LINK. Any RTM_NEWLINK / RTM_DELLINK
+ * notification queued there since the last sample (a link added, removed,
+ * renamed or moved to another namespace) makes the next sample a full
+ * RTM_GETLINK dump, so names never go stale while indexes stay the same.
+ *
+ * AUTHOR: Youssef Elshafei
+ * DATE:   2025-12-03
+ */
+
+#include "nlstats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/if_link.h>
+
+#define NLSTATS_INITIAL_IFS 16
+
+/* Handles one reply message of a dump; returns -1 to abort the dump */
+typedef int (*NlMsgFn)(NlStats *n, const struct nlmsghdr *nh);
+
+/*
+ * Opens a non-blocking NETLINK_ROUTE socket subscribed to link notifications.
+ * Returns:
+ *   The socket, or -1 if the group cannot be joined.
+ */
+static int nlstats_open_events(void) {
+    int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_ROUTE);
+    if (fd < 0) {
+        return -1;
+    }
+
+    struct sockaddr_nl local;
+    memset(&local, 0, sizeof(local));
+    local.nl_family = AF_NETLINK;
+    local.nl_groups = RTMGRP_LINK;
+
+    if (bind(fd, (struct sockaddr *)&local, sizeof(local)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/*
+ * Opens the NETLINK_ROUTE sockets and the receive buffer.
+ * Returns:
+ *   0 on success, -1 if netlink is not available.
+ */
+int nlstats_open(NlStats *n) {
+    memset(n, 0, sizeof(*n));
+    n->getstats = true;
+    n->evfd = -1;
+
+    n->fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (n->fd < 0) {
+        return -1;
+    }
+
+    n->buf = malloc(NLSTATS_BUF_LEN);
+    if (!n->buf) {
+        close(n->fd);
+        n->fd = -1;
+        return -1;
+    }
+
+    // Optional: without it, names are re-learnt every NLSTATS_RESYNC samples
+    n->evfd = nlstats_open_events();
+    return 0;
+}
+
+/*
+ * Drains the link notification socket.
+ * Returns:
+ *   true if a link was added, removed or changed (or notifications were
+ *   lost) since the last call, or if no notifications are available and
+ *   NLSTATS_RESYNC samples have passed; false otherwise.
+ */
+static bool nlstats_links_changed(NlStats *n) {
+    if (n->evfd < 0) {
+        return ++n->since >= NLSTATS_RESYNC;
+    }
+
+    bool changed = false;
+
+    for (;;) {
+        ssize_t got = recv(n->evfd, n->buf, NLSTATS_BUF_LEN, 0);
+
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // ENOBUFS: the socket overflowed and notifications were dropped
+            if (errno == ENOBUFS) {
+                changed = true;
+                continue;
+            }
+            break;
+        }
+
+        int len = (int)(got > NLSTATS_BUF_LEN ? NLSTATS_BUF_LEN : got);
+
+        for (const struct nlmsghdr *nh = (const struct nlmsghdr *)n->buf; NLMSG_OK(nh, len); nh = NLMSG_NEXT(nh, len)) {
+            if (nh->nlmsg_type == RTM_NEWLINK || nh->nlmsg_type == RTM_DELLINK) {
+                changed = true;
+            }
+        }
+    }
+    return changed;
+}
+
+/*
+ * Sends a dump request and feeds every reply message of that type to fn.
+ * Parameters:
+ *   n    – reader
+ *   type – RTM_GETLINK or RTM_GETSTATS
+ *   fn   – handler for the RTM_NEWLINK / RTM_NEWSTATS replies
+ * Returns:
+ *   0 once NLMSG_DONE arrives, -1 on error (errno set).
+ */
+static int nlstats_dump(NlStats *n, int type, NlMsgFn fn) {
+    struct {
+        struct nlmsghdr nh;
+        union {
+            struct ifinfomsg ifi;
+            struct if_stats_msg ism;
+        } body;
+    } req;
+
+    memset(&req, 0, sizeof(req));
+    req.nh.nlmsg_type = (unsigned short)type;
+    req.nh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    req.nh.nlmsg_seq = ++n->seq;
+
+    if (type == RTM_GETSTATS) {
+        req.nh.nlmsg_len = NLMSG_LENGTH(sizeof(struct if_stats_msg));
+        req.body.ism.family = AF_UNSPEC;
+        req.body.ism.filter_mask = IFLA_STATS_FILTER_BIT(IFLA_STATS_LINK_64);
+    } else {
+        req.nh.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifinfomsg));
+        req.body.ifi.ifi_family = AF_UNSPEC;
+    }
+
+    struct sockaddr_nl kernel;
+    memset(&kernel, 0, sizeof(kernel));
+    kernel.nl_family = AF_NETLINK;
+
+    if (sendto(n->fd, &req, req.nh.nlmsg_len, 0, (struct sockaddr *)&kernel, sizeof(kernel)) < 0) {
+        return -1;
+    }
+
+    int reply = (type == RTM_GETSTATS) ? RTM_NEWSTATS : RTM_NEWLINK;
+
+    for (;;) {
+        // MSG_TRUNC makes recv() return the real datagram size
+        ssize_t got = recv(n->fd, n->buf, NLSTATS_BUF_LEN, MSG_TRUNC);
+
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+
+        if (got > NLSTATS_BUF_LEN) {
+            errno = EMSGSIZE;
+            return -1;
+        }
+
+        int len = (int)got;
+
+        for (const struct nlmsghdr *nh = (const struct nlmsghdr *)n->buf; NLMSG_OK(nh, len); nh = NLMSG_NEXT(nh, len)) {
+            // Leftovers of an earlier, abandoned dump
+            if (nh->nlmsg_seq != n->seq) {
+                continue;
+            }
+
+            if (nh->nlmsg_type == NLMSG_DONE) {
+                return 0;
+            }
+
+            if (nh->nlmsg_type == NLMSG_ERROR) {
+                const struct nlmsgerr *err = NLMSG_DATA(nh);
+                errno = err->error ? -err->error : EIO;
+                return -1;
+            }
+
+            if (nh->nlmsg_type == reply && fn(n, nh) < 0) {
+                return -1;
+            }
+        }
+    }
+}
+
+/*
+ * Copies a kernel stats block into counters.
+ * rx_dropped folds in rx_missed_errors, as /proc/net/dev does.
+ */
+static void nlstats_copy(IfCounters *c, const struct rtnl_link_stats64 *st) {
+    c->rx_bytes = st->rx_bytes;
+    c->rx_packets = st->rx_packets;
+    c->rx_errors = st->rx_errors;
+    c->rx_dropped = st->rx_dropped + st->rx_missed_errors;
+    c->rx_multicast = st->multicast;
+    c->tx_bytes = st->tx_bytes;
+    c->tx_packets = st->tx_packets;
+    c->tx_errors = st->tx_errors;
+    c->tx_dropped = st->tx_dropped;
+}
+
+/*
+ * RTM_GETLINK handler: appends the interface (index, name, counters) to n->ifs.
+ * Returns:
+ *   0 on success (messages without a name or counters are skipped), -1 on allocation failure.
+ */
+static int nlstats_on_link(NlStats *n, const struct nlmsghdr *nh) {
+    if (n->nifs == n->ifs_cap) {
+        size_t newcap = n->ifs_cap ? n->ifs_cap * 2 : NLSTATS_INITIAL_IFS;
+        IfCounters *newifs = realloc(n->ifs, newcap * sizeof(IfCounters));
+        if (!newifs) {
+            return -1;
+        }
+        n->ifs = newifs;
+        n->ifs_cap = newcap;
+    }
+
+    const struct ifinfomsg *ifi = NLMSG_DATA(nh);
+    int len = (int)IFLA_PAYLOAD(nh);
+
+    IfCounters *c = &n->ifs[n->nifs];
+    int have_name = 0, have_stats64 = 0, have_stats32 = 0;
+    struct rtnl_link_stats64 st;
+    struct rtnl_link_stats st32;
+
+    memset(c, 0, sizeof(*c));
+
+    for (const struct rtattr *a = IFLA_RTA(ifi); RTA_OK(a, len); a = RTA_NEXT(a, len)) {
+        size_t plen = RTA_PAYLOAD(a);
+
+        if (a->rta_type == IFLA_IFNAME && plen > 0) {
+            size_t nlen = strnlen(RTA_DATA(a), plen);
+            if (nlen >= sizeof(c->name)) {
+                nlen = sizeof(c->name) - 1;
+            }
+            memcpy(c->name, RTA_DATA(a), nlen);
+            c->name[nlen] = '\0';
+            have_name = 1;
+        }
+        else if (a->rta_type == IFLA_STATS64 && plen >= sizeof(st)) {
+            // Attribute data is only 4-byte aligned: copy before reading 64-bit fields
+            memcpy(&st, RTA_DATA(a), sizeof(st));
+            have_stats64 = 1;
+        }
+        else if (a->rta_type == IFLA_STATS && plen >= sizeof(st32)) {
+            memcpy(&st32, RTA_DATA(a), sizeof(st32));
+            have_stats32 = 1;
+        }
+    }
+
+    if (!have_name || (!have_stats64 && !have_stats32)) {
+        return 0;
+    }
+
+    if (!have_stats64) {
+        // Old kernel: widen the 32-bit block
+        memset(&st, 0, sizeof(st));
+        st.rx_bytes = st32.rx_bytes;
+        st.rx_packets = st32.rx_packets;
+        st.rx_errors = st32.rx_errors;
+        st.rx_dropped = st32.rx_dropped;
+        st.rx_missed_errors = st32.rx_missed_errors;
+        st.multicast = st32.multicast;
+        st.tx_bytes = st32.tx_bytes;
+        st.tx_packets = st32.tx_packets;
+        st.tx_errors = st32.tx_errors;
+        st.tx_dropped = st32.tx_dropped;
+    }
+
+    nlstats_copy(c, &st);
+    c->ifindex = ifi->ifi_index;
+    n->nifs++;
+    return 0;
+}
+
+/*
+ * RTM_GETSTATS handler: updates the counters of an interface already in n->ifs.
+ * An index that is not there marks the table stale (a new interface appeared).
+ * Returns:
+ *   0 (never aborts the dump).
+ */
+static int nlstats_on_stats(NlStats *n, const struct nlmsghdr *nh) {
+    const struct if_stats_msg *ism = NLMSG_DATA(nh);
+    int len = (int)(nh->nlmsg_len - NLMSG_LENGTH(sizeof(*ism)));
+    const struct rtattr *a = (const struct rtattr *)((const char *)ism + NLMSG_ALIGN(sizeof(*ism)));
+
+    for (; RTA_OK(a, len); a = RTA_NEXT(a, len)) {
+        if (a->rta_type != IFLA_STATS_LINK_64 || RTA_PAYLOAD(a) < sizeof(struct rtnl_link_stats64)) {
+            continue;
+        }
+
+        // Dumps come in the same order every time: try the next slot first
+        size_t i = n->seen;
+        if (i >= n->nifs || n->ifs[i].ifindex != (int)ism->ifindex) {
+            for (i = 0; i < n->nifs && n->ifs[i].ifindex != (int)ism->ifindex; i++) {
+            }
+        }
+
+        if (i == n->nifs) {
+            n->stale = true;
+            return 0;
+        }
+
+        struct rtnl_link_stats64 st;
+        memcpy(&st, RTA_DATA(a), sizeof(st));
+        nlstats_copy(&n->ifs[i], &st);
+        n->seen++;
+        return 0;
+    }
+    return 0;
+}
+
+/*
+ * Rebuilds the interface table (names, indexes, counters) from an RTM_GETLINK dump.
+ * Returns:
+ *   Number of interfaces, or -1 on error.
+ */
+static int nlstats_refresh(NlStats *n) {
+    n->nifs = 0;
+    n->since = 0;
+
+    if (nlstats_dump(n, RTM_GETLINK, nlstats_on_link) < 0) {
+        return -1;
+    }
+    return (int)n->nifs;
+}
+
+/*
+ * Takes one sample of every interface's counters into n->ifs.
+ * Returns:
+ *   Number of interfaces found, or -1 on error.
+ */
+int nlstats_sample(NlStats *n) {
+    bool changed = nlstats_links_changed(n);
+
+    // First sample, a link changed (names may have too), or a kernel without RTM_GETSTATS: full link dump
+    if (!n->getstats || n->nifs == 0 || changed) {
+        return nlstats_refresh(n);
+    }
+
+    n->seen = 0;
+    n->stale = false;
+
+    if (nlstats_dump(n, RTM_GETSTATS, nlstats_on_stats) < 0) {
+        if (errno != EOPNOTSUPP && errno != EINVAL) {
+            return -1;
+        }
+        n->getstats = false;
+        return nlstats_refresh(n);
+    }
+
+    // An interface came or went: learn the new set (and its names)
+    if (n->stale || n->seen != n->nifs) {
+        return nlstats_refresh(n);
+    }
+
+    return (int)n->nifs;
+}
+
+/*
+ * Closes the sockets and frees the reader's buffers.
+ */
+void nlstats_close(NlStats *n) {
+    if (n->fd >= 0) {
+        close(n->fd);
+    }
+    if (n->evfd >= 0) {
+        close(n->evfd);
+    }
+    free(n->buf);
+    free(n->ifs);
+    memset(n, 0, sizeof(*n));
+    n->fd = -1;
+    n->evfd = -1;
+}
@@ -0,0 +1,81 @@
+/*
+ * File: nlstats.h
+ * Summary: Interface counters over rtnetlink (RTM_GETLINK / RTM_GETSTATS dumps).
+ *
+ * Responsibilities:
+ *  - Keep one NETLINK_ROUTE socket open for the whole run
+ *  - Learn every interface's index, name and 64-bit counters (IFLA_STATS64)
+ *    from an RTM_GETLINK dump
+ *  - After that, take each sample with an RTM_GETSTATS dump that carries only
+ *    IFLA_STATS_LINK_64 per interface (no names, no other link attributes)
+ *  - Redo the RTM_GETLINK dump whenever the set of interfaces changes, or a
+ *    link notification (RTMGRP_LINK) reports a new, deleted or renamed link
+ *  - Keep the counters in an array owned by the reader (same shape as procnet.h)
+ *
+ * Data & Types:
+ *  - IfCounters (model.h): counters of one interface
+ *  - typedef struct NlStats { int fd, evfd; unsigned int seq; char *buf; bool getstats; IfCounters *ifs; size_t nifs, ifs_cap; ... }
+ *
+ * Public API:
+ *  - int  nlstats_open(NlStats *n);
+ *  - int  nlstats_sample(NlStats *n);
+ *  - void nlstats_close(NlStats *n);
+ *
+ * Notes:
+ *  - rx_dropped includes rx_missed_errors, like the "drop" column of /proc/net/dev,
+ *    so both sources report the same numbers
+ *  - A full RTM_GETLINK reply is several times larger than the stats-only one
+ *    (every link attribute), which is why it is only used to learn names
+ *  - Kernels without RTM_GETSTATS (before 4.7) get an RTM_GETLINK dump every sample;
+ *    the 32-bit IFLA_STATS block is used if a kernel sends no IFLA_STATS64
+ *  - Renaming an interface keeps its index, so the stats dump alone cannot see
+ *    it; the link notifications can. Without them (the group cannot be joined)
+ *    the names are re-learnt every NLSTATS_RESYNC samples
+ *
+ * AUTHOR: Youssef Elshafei
+ * DATE:   2025-12-03
+ */
+#ifndef NLSTATS_H
+#define NLSTATS_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "../model/model.h"
+
+/* Receive buffer: large enough for the biggest dump datagram the kernel sends */
+#define NLSTATS_BUF_LEN 32768
+
+/* Samples between RTM_GETLINK dumps when link notifications are unavailable */
+#define NLSTATS_RESYNC 64
+
+/*
+ * Open netlink counter reader.
+ * fd:          NETLINK_ROUTE socket kept open between samples
+ * evfd:        non-blocking NETLINK_ROUTE socket joined to RTMGRP_LINK (-1 if unavailable)
+ * since:       samples since the last RTM_GETLINK dump
+ * seq:         sequence number of the last dump request
+ * buf:         NLSTATS_BUF_LEN receive buffer
+ * getstats:    false once the kernel has refused RTM_GETSTATS
+ * ifs, nifs:   interfaces from the last sample (IfCounters.ifindex set)
+ * ifs_cap:     allocated entries in ifs
+ * seen:        interfaces matched by the current RTM_GETSTATS dump
+ * stale:       the current dump listed an interface not in ifs
+ */
+typedef struct NlStats {
+    int fd;
+    int evfd;
+    unsigned int seq;
+    unsigned int since;
+    char *buf;
+    bool getstats;
+    IfCounters *ifs;
+    size_t nifs, ifs_cap;
+    size_t seen;
+    bool stale;
+} NlStats;
+
+int  nlstats_open(NlStats *n);
+int  nlstats_sample(NlStats *n);
+void nlstats_close(NlStats *n);
+
+#endif /* NLSTATS_H */
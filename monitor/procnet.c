@@ -0,0 +1,227 @@
+/*
+ * File: procnet.c
+ * Purpose: Implements the persistent /proc/net/dev reader.
+ *
+ * The file is opened once; every sample is a single pread() at offset 0
+ * into a buffer that is reused (and only grown if the file outgrows it).
+ * Lines are parsed in place: skip to the ':' after the interface name,
+ * then read the 16 decimal counters with a small integer scanner.
+ *
+ * AUTHOR: Youssef Elshafei
+ * DATE:   2025-12-03
+ */
+
+#include "procnet.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define PROCNET_INITIAL_BUF 4096
+#define PROCNET_INITIAL_IFS 16
+#define PROCNET_FIELDS 16    // 8 RX counters followed by 8 TX counters
+
+/*
+ * Opens /proc/net/dev and prepares an empty reader.
+ * Returns:
+ *   0 on success, -1 if the file cannot be opened.
+ */
+int procnet_open(ProcNetDev *p) {
+    memset(p, 0, sizeof(*p));
+
+    p->fd = open(PROC_NET_DEV, O_RDONLY | O_CLOEXEC);
+    if (p->fd < 0) {
+        perror("Cannot open /proc/net/dev");
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Reads the whole file into p->buf.
+ * procfs fills the buffer as far as it can, so a read that leaves room
+ * means the end of the file was reached; only a full buffer needs another read.
+ * Returns:
+ *   Number of bytes read, or -1 on error.
+ */
+static long procnet_read_file(ProcNetDev *p) {
+    size_t len = 0;
+
+    for (;;) {
+        // Keep one byte spare for the terminating NUL
+        if (p->buf_cap - len < 2) {
+            size_t newcap = p->buf_cap ? p->buf_cap * 2 : PROCNET_INITIAL_BUF;
+            char *newbuf = realloc(p->buf, newcap);
+            if (!newbuf) {
+                return -1;
+            }
+            p->buf = newbuf;
+            p->buf_cap = newcap;
+        }
+
+        size_t room = p->buf_cap - len - 1;
+        ssize_t n = pread(p->fd, p->buf + len, room, (off_t)len);
+
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+
+        len += (size_t)n;
+
+        // Short read (or EOF): that was everything
+        if ((size_t)n < room) {
+            break;
+        }
+    }
+
+    p->buf[len] = '\0';
+    return (long)len;
+}
+
+/*
+ * Reads one unsigned decimal number, skipping leading blanks.
+ * Parameters:
+ *   s – current position (NUL-terminated buffer)
+ *   v – output value
+ * Returns:
+ *   Position after the number, or NULL if there was no number before end of line.
+ */
+static const char *scan_u64(const char *s, unsigned long long *v) {
+    while (*s == ' ' || *s == '\t') {
+        s++;
+    }
+
+    if (*s < '0' || *s > '9') {
+        return NULL;
+    }
+
+    unsigned long long x = 0;
+    while (*s >= '0' && *s <= '9') {
+        x = x * 10 + (unsigned long long)(*s - '0');
+        s++;
+    }
+
+    *v = x;
+    return s;
+}
+
+/*
+ * Parses one interface line ("  eth0: 123 4 0 ...") into c.
+ * Parameters:
+ *   line – start of the line
+ *   c    – output counters
+ * Returns:
+ *   1 if the line held an interface, 0 otherwise (headers, short lines).
+ */
+static int parse_line(const char *line, IfCounters *c) {
+    while (*line == ' ') {
+        line++;
+    }
+
+    // Interface names cannot contain ':', so the first one ends the name
+    const char *colon = line;
+    while (*colon != ':' && *colon != '\n' && *colon != '\0') {
+        colon++;
+    }
+
+    size_t name_len = (size_t)(colon - line);
+    if (*colon != ':' || name_len == 0 || name_len >= sizeof(c->name)) {
+        return 0;
+    }
+
+    unsigned long long f[PROCNET_FIELDS];
+    const char *s = colon + 1;
+
+    for (int i = 0; i < PROCNET_FIELDS; i++) {
+        s = scan_u64(s, &f[i]);
+        if (!s) {
+            return 0;
+        }
+    }
+
+    memcpy(c->name, line, name_len);
+    c->name[name_len] = '\0';
+    c->ifindex = 0;  // Not in /proc/net/dev
+
+    c->rx_bytes = f[0];
+    c->rx_packets = f[1];
+    c->rx_errors = f[2];
+    c->rx_dropped = f[3];
+    c->rx_multicast = f[7];
+    c->tx_bytes = f[8];
+    c->tx_packets = f[9];
+    c->tx_errors = f[10];
+    c->tx_dropped = f[11];
+    return 1;
+}
+
+/*
+ * Takes one sample: re-reads the file and parses every interface into p->ifs.
+ * Returns:
+ *   Number of interfaces found, or -1 on read/allocation error.
+ */
+int procnet_sample(ProcNetDev *p) {
+    if (procnet_read_file(p) < 0) {
+        return -1;
+    }
+
+    p->nifs = 0;
+
+    // The first two lines are column headers; parse_line rejects them
+    for (const char *line = p->buf; *line != '\0'; ) {
+        if (p->nifs == p->ifs_cap) {
+            size_t newcap = p->ifs_cap ? p->ifs_cap * 2 : PROCNET_INITIAL_IFS;
+            IfCounters *newifs = realloc(p->ifs, newcap * sizeof(IfCounters));
+            if (!newifs) {
+                return -1;
+            }
+            p->ifs = newifs;
+            p->ifs_cap = newcap;
+        }
+
+        if (parse_line(line, &p->ifs[p->nifs])) {
+            p->nifs++;
+        }
+
+        // Next line
+        const char *nl = strchr(line, '\n');
+        if (!nl) {
+            break;
+        }
+        line = nl + 1;
+    }
+
+    return (int)p->nifs;
+}
+
+/*
+ * Looks up an interface in the last sample.
+ * Returns:
+ *   Pointer to its counters, or NULL if it was not listed.
+ */
+const IfCounters *procnet_find(const ProcNetDev *p, const char *name) {
+    for (size_t i = 0; i < p->nifs; i++) {
+        if (strcmp(p->ifs[i].name, name) == 0) {
+            return &p->ifs[i];
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Closes the file and frees the reader's buffers.
+ */
+void procnet_close(ProcNetDev *p) {
+    if (p->fd >= 0) {
+        close(p->fd);
+    }
+    free(p->buf);
+    free(p->ifs);
+    memset(p, 0, sizeof(*p));
+    p->fd = -1;
+}
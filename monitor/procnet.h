@@ -0,0 +1,57 @@
+/*
+ * File: procnet.h
+ * Summary: Low-overhead reader for /proc/net/dev.
+ *
+ * Responsibilities:
+ *  - Keep /proc/net/dev open for the whole run (no fopen/fclose per sample)
+ *  - pread() the whole file into a reusable buffer each sample
+ *  - Parse every interface line with a hand-written integer scanner (no sscanf)
+ *  - Keep the parsed counters in an array owned by the reader
+ *
+ * Data & Types:
+ *  - IfCounters (model.h): counters of one interface
+ *  - typedef struct ProcNetDev { int fd; char *buf; size_t buf_cap; IfCounters *ifs; size_t nifs, ifs_cap; }
+ *
+ * Public API:
+ *  - int  procnet_open(ProcNetDev *p);
+ *  - int  procnet_sample(ProcNetDev *p);
+ *  - const IfCounters *procnet_find(const ProcNetDev *p, const char *name);
+ *  - void procnet_close(ProcNetDev *p);
+ *
+ * Notes:
+ *  - Memory is only allocated when the file or the interface list grows,
+ *    so steady-state sampling does not allocate
+ *
+ * AUTHOR: Youssef Elshafei
+ * DATE:   2025-12-03
+ */
+#ifndef PROCNET_H
+#define PROCNET_H
+
+#include <stddef.h>
+#include "../model/model.h"
+
+/* Path to Linux kernel network device statistics */
+#define PROC_NET_DEV "/proc/net/dev"
+
+/*
+ * Open /proc/net/dev reader.
+ * fd:             descriptor kept open between samples
+ * buf, buf_cap:   file contents of the last sample (grown to fit)
+ * ifs, nifs:      interfaces parsed from the last sample
+ * ifs_cap:        allocated entries in ifs
+ */
+typedef struct ProcNetDev {
+    int fd;
+    char *buf;
+    size_t buf_cap;
+    IfCounters *ifs;
+    size_t nifs, ifs_cap;
+} ProcNetDev;
+
+int  procnet_open(ProcNetDev *p);
+int  procnet_sample(ProcNetDev *p);
+const IfCounters *procnet_find(const ProcNetDev *p, const char *name);
+void procnet_close(ProcNetDev *p);
+
+#endif /* PROCNET_H */
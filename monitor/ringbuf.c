@@ -1,4 +1,208 @@
 /*
  * File: ringbuf.c
- * Implements fixed-size circular buffer and mean computation.
+ * Purpose: Implements O(1) rolling window statistics.
+ *
+ * The sum and sum of squares are updated by adding the new sample and
+ * subtracting the one it evicts. Plain floating-point add/subtract would
+ * drift over millions of samples, so both use Kahan compensation.
+ * Min and max come from monotonic deques: the min deque holds samples
+ * in increasing order (anything larger than a newer sample can never be
+ * the minimum again and is dropped), the max deque the reverse.
+ *
+ * AUTHOR: Youssef Elshafei
+ * DATE:   2025-12-03
  */
+
+#include "ringbuf.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/*
+ * Kahan-compensated addition: *sum += x, carrying the rounding error in *comp.
+ */
+static void kahan_add(double *sum, double *comp, double x) {
+    double y = x - *comp;
+    double t = *sum + y;
+    *comp = (t - *sum) - y;
+    *sum = t;
+}
+
+/*
+ * Returns position i of a deque (0 = front), as a slot index into data.
+ */
+static size_t deque_get(const RingBuf *rb, const RingDeque *d, size_t i) {
+    size_t pos = d->head + i;
+    return pos < rb->cap ? d->slot[pos] : d->slot[pos - rb->cap];
+}
+
+/*
+ * Adds the sample in data[slot] to the back of a deque after dropping
+ * every entry it dominates.
+ * Parameters:
+ *   rb   – window (for sample values and capacity)
+ *   d    – deque to update
+ *   slot – where the new sample is stored
+ *   less – 1 for the min deque, 0 for the max deque
+ */
+static void deque_push(const RingBuf *rb, RingDeque *d, size_t slot, int less) {
+    double v = rb->data[slot];
+
+    while (d->len > 0) {
+        double back = rb->data[deque_get(rb, d, d->len - 1)];
+        if (less ? back < v : back > v) {
+            break;
+        }
+        d->len--;
+    }
+
+    size_t pos = d->head + d->len;
+    d->slot[pos < rb->cap ? pos : pos - rb->cap] = slot;
+    d->len++;
+}
+
+/*
+ * Drops the front of a deque if it is the sample in data[slot], which is
+ * about to be overwritten. Only the front can be that old: entries are in
+ * arrival order and the overwritten slot holds the oldest sample.
+ */
+static void deque_expire(const RingBuf *rb, RingDeque *d, size_t slot) {
+    if (d->len > 0 && d->slot[d->head] == slot) {
+        d->head = (d->head + 1 == rb->cap) ? 0 : d->head + 1;
+        d->len--;
+    }
+}
+
+/*
+ * Initializes an empty window.
+ * Parameters:
+ *   rb    – window to initialize
+ *   cap   – window size in samples (>= 1)
+ *   alpha – EWMA weight of each new sample, 0 < alpha <= 1
+ * Returns:
+ *   0 on success, -1 on invalid arguments or allocation failure.
+ */
+int ring_init(RingBuf *rb, size_t cap, double alpha) {
+    memset(rb, 0, sizeof(*rb));
+
+    if (cap == 0 || !(alpha > 0.0 && alpha <= 1.0)) {
+        return -1;
+    }
+
+    rb->data = calloc(cap, sizeof(double));
+    rb->min.slot = malloc(cap * sizeof(size_t));
+    rb->max.slot = malloc(cap * sizeof(size_t));
+    if (!rb->data || !rb->min.slot || !rb->max.slot) {
+        ring_free(rb);
+        return -1;
+    }
+
+    rb->cap = cap;
+    rb->alpha = alpha;
+    return 0;
+}
+
+/*
+ * Empties the window and restarts the EWMA, keeping the allocation.
+ */
+void ring_clear(RingBuf *rb) {
+    rb->len = 0;
+    rb->head = 0;
+    rb->pushed = 0;
+    rb->sum = rb->sum_c = 0.0;
+    rb->sumsq = rb->sumsq_c = 0.0;
+    rb->ewma = 0.0;
+    rb->min.head = rb->min.len = 0;
+    rb->max.head = rb->max.len = 0;
+}
+
+/*
+ * Adds a sample, evicting the oldest one if the window is full.
+ */
+void ring_push(RingBuf *rb, double v) {
+    size_t slot = rb->head;
+
+    if (rb->len == rb->cap) {
+        // The oldest sample leaves the window: its slot is about to be reused
+        double old = rb->data[slot];
+        kahan_add(&rb->sum, &rb->sum_c, -old);
+        kahan_add(&rb->sumsq, &rb->sumsq_c, -old * old);
+        deque_expire(rb, &rb->min, slot);
+        deque_expire(rb, &rb->max, slot);
+    } else {
+        rb->len++;
+    }
+
+    rb->data[slot] = v;
+    rb->head = (slot + 1 == rb->cap) ? 0 : slot + 1;
+
+    kahan_add(&rb->sum, &rb->sum_c, v);
+    kahan_add(&rb->sumsq, &rb->sumsq_c, v * v);
+    deque_push(rb, &rb->min, slot, 1);
+    deque_push(rb, &rb->max, slot, 0);
+
+    rb->ewma = (rb->pushed == 0) ? v : rb->ewma + rb->alpha * (v - rb->ewma);
+    rb->pushed++;
+}
+
+/*
+ * Returns the mean of the samples in the window.
+ */
+double ring_mean(const RingBuf *rb) {
+    if (rb->len == 0) {
+        return 0.0;
+    }
+    return rb->sum / rb->len;
+}
+
+/*
+ * Returns the population standard deviation of the samples in the window.
+ */
+double ring_stddev(const RingBuf *rb) {
+    if (rb->len == 0) {
+        return 0.0;
+    }
+
+    double mean = rb->sum / rb->len;
+    double var = rb->sumsq / rb->len - mean * mean;
+
+    // Rounding can leave a tiny negative variance for a constant window
+    return var > 0.0 ? sqrt(var) : 0.0;
+}
+
+/*
+ * Returns the smallest sample in the window.
+ */
+double ring_min(const RingBuf *rb) {
+    if (rb->min.len == 0) {
+        return 0.0;
+    }
+    return rb->data[deque_get(rb, &rb->min, 0)];
+}
+
+/*
+ * Returns the largest sample in the window.
+ */
+double ring_max(const RingBuf *rb) {
+    if (rb->max.len == 0) {
+        return 0.0;
+    }
+    return rb->data[deque_get(rb, &rb->max, 0)];
+}
+
+/*
+ * Returns the exponentially weighted moving average of every sample pushed.
+ */
+double ring_ewma(const RingBuf *rb) {
+    return rb->ewma;
+}
+
+/*
+ * Frees the window's buffers.
+ */
+void ring_free(RingBuf *rb) {
+    free(rb->data);
+    free(rb->min.slot);
+    free(rb->max.slot);
+    memset(rb, 0, sizeof(*rb));
+}
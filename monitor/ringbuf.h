@@ -1,27 +1,80 @@
 /*
  * File: ringbuf.h
- * Summary: Rolling window buffer for smoothing rates/RTT.
+ * Summary: Rolling window statistics with O(1) cost per sample.
+ *
+ * Responsibilities:
+ *  - Keep the last 'cap' samples in a circular buffer
+ *  - Maintain a running sum and sum of squares (Kahan-compensated), so the
+ *    window mean and standard deviation never need a pass over the window
+ *  - Maintain an exponentially weighted moving average (EWMA) with a configurable alpha
+ *  - Maintain the window minimum and maximum with monotonic deques
+ *
+ * Data & Types:
+ *  - typedef struct RingBuf { double *data; size_t len, cap, head; ... }
  *
  * Public API:
- *  - int  ring_init(RingBuf *rb, size_t cap);
- *  - void ring_push(RingBuf *rb, double v);
+ *  - int    ring_init(RingBuf *rb, size_t cap, double alpha);
+ *  - void   ring_push(RingBuf *rb, double v);
+ *  - void   ring_clear(RingBuf *rb);
  *  - double ring_mean(const RingBuf *rb);
- *  - void ring_free(RingBuf *rb);
+ *  - double ring_stddev(const RingBuf *rb);
+ *  - double ring_min(const RingBuf *rb);
+ *  - double ring_max(const RingBuf *rb);
+ *  - double ring_ewma(const RingBuf *rb);
+ *  - void   ring_free(RingBuf *rb);
+ *
+ * Notes:
+ *  - ring_push() is amortised O(1): each sample enters and leaves each deque once
+ *  - The EWMA covers every sample pushed, not only the window
+ *  - Statistics of an empty buffer are 0.0
+ *
+ * AUTHOR: Youssef Elshafei
+ * DATE:   2025-12-03
  */
 #ifndef RINGBUF_H
 #define RINGBUF_H
 
 #include <stddef.h>
 
+/*
+ * Monotonic deque of window slots (circular, capacity = window).
+ * slot:       indexes into RingBuf.data, oldest sample at head
+ * head, len:  position of the oldest entry and number of entries
+ */
 typedef struct {
-  double *data;
-  size_t len, cap;
-  size_t head;
+    size_t *slot;
+    size_t head, len;
+} RingDeque;
+
+/*
+ * Rolling window.
+ * data:             last 'cap' samples; data[head] is the next slot to overwrite
+ * len, cap:         samples currently in the window and window size
+ * pushed:           samples pushed so far
+ * sum, sum_c:       running sum of the window and its Kahan compensation
+ * sumsq, sumsq_c:   running sum of squares and its Kahan compensation
+ * alpha, ewma:      EWMA weight of a new sample and the current average
+ * min, max:         deques whose front is the window minimum / maximum
+ */
+typedef struct RingBuf {
+    double *data;
+    size_t len, cap;
+    size_t head;
+    size_t pushed;
+    double sum, sum_c;
+    double sumsq, sumsq_c;
+    double alpha, ewma;
+    RingDeque min, max;
 } RingBuf;
 
-int  ring_init(RingBuf *rb, size_t cap);
-void ring_push(RingBuf *rb, double v);
+int    ring_init(RingBuf *rb, size_t cap, double alpha);
+void   ring_push(RingBuf *rb, double v);
+void   ring_clear(RingBuf *rb);
 double ring_mean(const RingBuf *rb);
-void ring_free(RingBuf *rb);
+double ring_stddev(const RingBuf *rb);
+double ring_min(const RingBuf *rb);
+double ring_max(const RingBuf *rb);
+double ring_ewma(const RingBuf *rb);
+void   ring_free(RingBuf *rb);
 
 #endif /* RINGBUF_H */
@@ -0,0 +1,308 @@
+/*
+ * File: rollup.c
+ * Purpose: Implements the multi-resolution rate history.
+ *
+ * Each interface owns one block of buckets, split into one ring per
+ * tier. A raw sample is folded into the newest bucket of every tier,
+ * or opens a new bucket (overwriting the oldest once the ring is full)
+ * when it falls past the end of the newest one. Nothing is ever
+ * recomputed from stored samples, so the cost of a sample depends only
+ * on the number of tiers.
+ *
+ * AUTHOR: Youssef Elshafei
+ * DATE:   2025-12-03
+ */
+
+#include "rollup.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Initializes an empty rollup.
+ * Parameters:
+ *   r      – rollup to initialize
+ *   tiers  – resolutions, finest first (strictly increasing widths)
+ *   ntiers – number of tiers, 1 to ROLLUP_MAX_TIERS
+ * Returns:
+ *   0 on success, -1 on invalid tiers.
+ */
+int rollup_init(Rollup *r, const RollupTier *tiers, size_t ntiers) {
+    memset(r, 0, sizeof(*r));
+
+    if (ntiers == 0 || ntiers > ROLLUP_MAX_TIERS) {
+        return -1;
+    }
+
+    for (size_t t = 0; t < ntiers; t++) {
+        if (tiers[t].width_ms <= 0 || tiers[t].cap == 0) {
+            return -1;
+        }
+        if (t > 0 && tiers[t].width_ms <= tiers[t - 1].width_ms) {
+            return -1;
+        }
+        r->tier[t] = tiers[t];
+    }
+
+    r->ntiers = ntiers;
+    return 0;
+}
+
+/*
+ * Finds an interface's history, trying slot r->hint first.
+ * Returns:
+ *   Pointer to the history, or NULL if the interface is new.
+ */
+static RollupIface *rollup_find(Rollup *r, const char *iface) {
+    if (r->hint < r->nifs && strcmp(r->ifs[r->hint].iface, iface) == 0) {
+        return &r->ifs[r->hint];
+    }
+
+    for (size_t i = 0; i < r->nifs; i++) {
+        if (strcmp(r->ifs[i].iface, iface) == 0) {
+            return &r->ifs[i];
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Starts the history of a new interface: every tier's ring is
+ * allocated here, once, at full capacity.
+ * Returns:
+ *   Pointer to the history, or NULL on allocation failure.
+ */
+static RollupIface *rollup_add_iface(Rollup *r, const char *iface) {
+    if (r->nifs == r->ifs_cap) {
+        size_t newcap = r->ifs_cap ? r->ifs_cap * 2 : 16;
+        RollupIface *newifs = realloc(r->ifs, newcap * sizeof(RollupIface));
+        if (!newifs) {
+            return NULL;
+        }
+        r->ifs = newifs;
+        r->ifs_cap = newcap;
+    }
+
+    size_t total = 0;
+    for (size_t t = 0; t < r->ntiers; t++) {
+        total += r->tier[t].cap;
+    }
+
+    RollupIface *ri = &r->ifs[r->nifs];
+    memset(ri, 0, sizeof(*ri));
+    strncpy(ri->iface, iface, sizeof(ri->iface) - 1);
+
+    ri->store = malloc(total * sizeof(RollupBucket));
+    if (!ri->store) {
+        return NULL;
+    }
+
+    // Carve the block into one ring per tier
+    RollupBucket *b = ri->store;
+    for (size_t t = 0; t < r->ntiers; t++) {
+        ri->ring[t].b = b;
+        b += r->tier[t].cap;
+    }
+
+    r->nifs++;
+    return ri;
+}
+
+/*
+ * Opens a bucket holding a single sample.
+ */
+static void bucket_start(RollupBucket *b, long long start_ms, double rx, double tx) {
+    b->start_ms = start_ms;
+    b->samples = 1;
+    b->rx_min_bps = b->rx_max_bps = b->rx_sum_bps = b->rx_last_bps = rx;
+    b->tx_min_bps = b->tx_max_bps = b->tx_sum_bps = b->tx_last_bps = tx;
+}
+
+/*
+ * Folds one more sample into a bucket.
+ */
+static void bucket_fold(RollupBucket *b, double rx, double tx) {
+    b->samples++;
+    if (rx < b->rx_min_bps) {
+        b->rx_min_bps = rx;
+    }
+    if (rx > b->rx_max_bps) {
+        b->rx_max_bps = rx;
+    }
+    if (tx < b->tx_min_bps) {
+        b->tx_min_bps = tx;
+    }
+    if (tx > b->tx_max_bps) {
+        b->tx_max_bps = tx;
+    }
+    b->rx_sum_bps += rx;
+    b->tx_sum_bps += tx;
+    b->rx_last_bps = rx;
+    b->tx_last_bps = tx;
+}
+
+/*
+ * Folds a raw sample into every tier of its interface.
+ * Parameters:
+ *   r      – rollup
+ *   sample – monitor sample (iface, ts_ms and the instantaneous rates are used)
+ * Returns:
+ *   0 on success, -1 on allocation failure for a new interface.
+ */
+int rollup_add(Rollup *r, const IfaceStats *sample) {
+    RollupIface *ri = rollup_find(r, sample->iface);
+    if (!ri) {
+        ri = rollup_add_iface(r, sample->iface);
+        if (!ri) {
+            return -1;
+        }
+    }
+    r->hint = (size_t)(ri - r->ifs) + 1;
+
+    long long ts = sample->ts_ms;
+    if (r->first_ms == 0) {
+        r->first_ms = ts;
+    }
+    if (ts > r->last_ms) {
+        r->last_ms = ts;
+    }
+
+    for (size_t t = 0; t < r->ntiers; t++) {
+        RollupRing *ring = &ri->ring[t];
+        long long width = r->tier[t].width_ms;
+        long long start = ts - ts % width;
+
+        // Same span as the newest bucket (or the clock went back): fold in
+        if (ring->len > 0 && start <= ring->b[ring->newest].start_ms) {
+            bucket_fold(&ring->b[ring->newest], sample->rx_rate_bps, sample->tx_rate_bps);
+            continue;
+        }
+
+        // New span: take the next slot, overwriting the oldest bucket once full
+        if (ring->len == 0) {
+            ring->newest = 0;
+        } else {
+            ring->newest = (ring->newest + 1 == r->tier[t].cap) ? 0 : ring->newest + 1;
+        }
+        if (ring->len < r->tier[t].cap) {
+            ring->len++;
+        }
+        bucket_start(&ring->b[ring->newest], start, sample->rx_rate_bps, sample->tx_rate_bps);
+    }
+    return 0;
+}
+
+/*
+ * Appends one row to a query answer.
+ * Returns:
+ *   0 on success, -1 on allocation failure.
+ */
+static int view_append(RollupView *view, const char *iface, const RollupBucket *b) {
+    if (view->len == view->cap) {
+        size_t newcap = view->cap ? view->cap * 2 : 16;
+        RollupRow *newrows = realloc(view->rows, newcap * sizeof(RollupRow));
+        if (!newrows) {
+            return -1;
+        }
+        view->rows = newrows;
+        view->cap = newcap;
+    }
+
+    RollupRow *row = &view->rows[view->len++];
+    memset(row->iface, 0, sizeof(row->iface));
+    strncpy(row->iface, iface, sizeof(row->iface) - 1);
+    row->bucket = *b;
+    return 0;
+}
+
+/*
+ * Tells whether a tier still holds from_ms for every interface: its ring
+ * has not wrapped yet (nothing lost), or its oldest bucket starts at or
+ * before from_ms.
+ */
+static int rollup_tier_covers(const Rollup *r, size_t t, long long from_ms) {
+    size_t cap = r->tier[t].cap;
+
+    for (size_t i = 0; i < r->nifs; i++) {
+        const RollupRing *ring = &r->ifs[i].ring[t];
+        if (ring->len < cap) {
+            continue;
+        }
+
+        // Oldest bucket sits just after the newest once the ring has wrapped
+        size_t oldest = (ring->newest + 1 == cap) ? 0 : ring->newest + 1;
+        if (ring->b[oldest].start_ms > from_ms) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+ * Lists the buckets that overlap [from_ms, to_ms], interface by interface,
+ * oldest first, from the finest tier that has not yet overwritten from_ms
+ * (the coarsest tier if every tier has). Where the range falls decides the
+ * tier, not only its length: a short range from long ago may need a
+ * coarse tier.
+ * Parameters:
+ *   r       – rollup
+ *   from_ms – start of the range (Unix epoch, milliseconds)
+ *   to_ms   – end of the range
+ *   out     – answer; free with rollupview_free()
+ * Returns:
+ *   Number of rows, or -1 on allocation failure.
+ */
+int rollup_query(const Rollup *r, long long from_ms, long long to_ms, RollupView *out) {
+    memset(out, 0, sizeof(*out));
+    if (r->ntiers == 0) {
+        return 0;
+    }
+
+    // Finest tier that remembers far enough back
+    size_t t = 0;
+    while (t + 1 < r->ntiers && !rollup_tier_covers(r, t, from_ms)) {
+        t++;
+    }
+    out->width_ms = r->tier[t].width_ms;
+
+    for (size_t i = 0; i < r->nifs; i++) {
+        const RollupRing *ring = &r->ifs[i].ring[t];
+        size_t cap = r->tier[t].cap;
+
+        // Oldest bucket sits just after the newest once the ring has wrapped
+        size_t slot = (ring->len == cap) ? ring->newest + 1 : 0;
+        for (size_t k = 0; k < ring->len; k++, slot++) {
+            if (slot == cap) {
+                slot = 0;
+            }
+
+            const RollupBucket *b = &ring->b[slot];
+            if (b->start_ms + out->width_ms <= from_ms || b->start_ms > to_ms) {
+                continue;
+            }
+            if (view_append(out, r->ifs[i].iface, b) < 0) {
+                rollupview_free(out);
+                return -1;
+            }
+        }
+    }
+    return (int)out->len;
+}
+
+/*
+ * Frees the rows of a query answer.
+ */
+void rollupview_free(RollupView *view) {
+    free(view->rows);
+    memset(view, 0, sizeof(*view));
+}
+
+/*
+ * Frees every interface's history.
+ */
+void rollup_free(Rollup *r) {
+    for (size_t i = 0; i < r->nifs; i++) {
+        free(r->ifs[i].store);
+    }
+    free(r->ifs);
+    memset(r, 0, sizeof(*r));
+}
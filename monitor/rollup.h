@@ -0,0 +1,104 @@
+/*
+ * File: rollup.h
+ * Summary: Multi-resolution history of monitor rates (e.g. 1 s -> 1 min -> 1 h).
+ *
+ * Responsibilities:
+ *  - Keep, per interface and per tier, a fixed ring of buckets holding the
+ *    min, max, average and last RX/TX rate over one bucket width
+ *  - Fold each raw sample into the open bucket of every tier as it arrives
+ *    (O(tiers) per sample, no pass over stored history)
+ *  - Answer a time-range query from the finest tier that still holds its start
+ *
+ * Data & Types:
+ *  - RollupBucket, RollupRow, RollupView (model.h): buckets and query answers
+ *  - typedef struct RollupTier { long long width_ms; size_t cap; }
+ *  - typedef struct Rollup { RollupTier tier[ROLLUP_MAX_TIERS]; size_t ntiers; RollupIface *ifs; size_t nifs, ifs_cap; ... }
+ *
+ * Public API:
+ *  - int  rollup_init(Rollup *r, const RollupTier *tiers, size_t ntiers);
+ *  - int  rollup_add(Rollup *r, const IfaceStats *sample);
+ *  - int  rollup_query(const Rollup *r, long long from_ms, long long to_ms, RollupView *out);
+ *  - void rollupview_free(RollupView *view);
+ *  - void rollup_free(Rollup *r);
+ *
+ * Notes:
+ *  - Buckets are aligned to multiples of their width on the wall clock
+ *    (sample ts_ms), so a 1 min tier starts every bucket on a whole minute
+ *  - Every tier folds the raw samples directly, so a coarse bucket's average
+ *    is the plain mean of its samples, not a mean of finer averages
+ *  - Memory is fixed per interface (sum of the tier capacities), allocated
+ *    when the interface is first seen; spans without samples take no bucket
+ *  - A sample stamped before the newest bucket (wall clock stepped back) is
+ *    folded into the newest bucket rather than reopening an old one
+ *
+ * AUTHOR: Youssef Elshafei
+ * DATE:   2025-12-03
+ */
+#ifndef ROLLUP_H
+#define ROLLUP_H
+
+#include <stddef.h>
+#include "../model/model.h"
+
+/* Most tiers a rollup can have */
+#define ROLLUP_MAX_TIERS 4
+
+/*
+ * One resolution of the history.
+ * width_ms:  time span of each bucket
+ * cap:       buckets kept (retention = width_ms * cap)
+ */
+typedef struct RollupTier {
+    long long width_ms;
+    size_t cap;
+} RollupTier;
+
+/*
+ * Ring of buckets of one tier.
+ * b:        cap buckets (slice of RollupIface.store)
+ * newest:   slot of the newest bucket
+ * len:      buckets in use
+ */
+typedef struct {
+    RollupBucket *b;
+    size_t newest;
+    size_t len;
+} RollupRing;
+
+/*
+ * History of one interface.
+ * iface:    interface name
+ * store:    buckets of every tier, allocated once
+ * ring:     one ring per tier
+ */
+typedef struct {
+    char iface[IFACE_NAME_MAX];
+    RollupBucket *store;
+    RollupRing ring[ROLLUP_MAX_TIERS];
+} RollupIface;
+
+/*
+ * Rollup of every monitored interface.
+ * tier, ntiers:     resolutions, finest first
+ * ifs, nifs:        interfaces in the order they were first seen
+ * ifs_cap:          allocated entries in ifs
+ * hint:             slot expected for the next sample (samples arrive in interface order)
+ * first_ms:         ts_ms of the first sample (0 = none yet)
+ * last_ms:          ts_ms of the latest sample
+ */
+typedef struct Rollup {
+    RollupTier tier[ROLLUP_MAX_TIERS];
+    size_t ntiers;
+    RollupIface *ifs;
+    size_t nifs, ifs_cap;
+    size_t hint;
+    long long first_ms, last_ms;
+} Rollup;
+
+int  rollup_init(Rollup *r, const RollupTier *tiers, size_t ntiers);
+int  rollup_add(Rollup *r, const IfaceStats *sample);
+int  rollup_query(const Rollup *r, long long from_ms, long long to_ms, RollupView *out);
+void rollupview_free(RollupView *view);
+void rollup_free(Rollup *r);
+
+#endif /* ROLLUP_H */
@@ -0,0 +1,860 @@
+/*
+ * File: tsdb.c
+ * Purpose: Implements the compressed time-series file (see tsdb.h).
+ *
+ * Each block is one bit stream of records. A record is:
+ *  - series id:  '0' = the series after the previous record's (interfaces
+ *                come round in the same order every tick), else '1' and a
+ *                varint id; an id equal to the number of known series
+ *                introduces a new one, followed by its name
+ *  - ts_ms:      raw 64 bits for a series' first record in the block, then
+ *                the delta-of-delta: '0' (same step as before), '10' + 7,
+ *                '110' + 9, '1110' + 12 or '1111' + 64 bits, zigzag-encoded
+ *  - counters:   raw varints first, then per counter the delta-of-delta:
+ *                '0' when the counter moved exactly as much as last time
+ *                (idle links: by zero), else '1' and a zigzag varint
+ *  - rates:      raw 64 bits first, then XOR with the previous value: '0' if
+ *                equal, '10' + the bits inside the previous leading/trailing
+ *                zero window, or '11' + 5 bits leading zeros + 6 bits length
+ *                + the meaningful bits
+ * Varints are written into the bit stream as 8-bit groups: a continuation
+ * bit and 7 value bits.
+ *
+ * AUTHOR: Youssef Elshafei
+ * DATE:   2025-12-03
+ */
+
+#include "tsdb.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define TSDB_VERSION 1
+#define TSDB_HEADER_LEN 16
+#define TSDB_BLOCK_HEADER_LEN 32
+#define TSDB_INDEX_ENTRY_LEN 24
+#define TSDB_TRAILER_LEN 24
+#define TSDB_DATA_BITS ((TSDB_BLOCK_SIZE - TSDB_BLOCK_HEADER_LEN) * 8)
+
+/* Largest record: id varint, new name, ts, counter varints, two 64-bit XORs */
+#define TSDB_RECORD_MAX_BITS 1280
+
+static const char FILE_MAGIC[4] = {'W', 'F', 'T', 'S'};
+static const char BLOCK_MAGIC[4] = {'W', 'F', 'B', 'K'};
+static const char INDEX_MAGIC[4] = {'W', 'F', 'I', 'X'};
+
+/* ---- Little-endian fields ---- */
+
+static void put_u32(unsigned char *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (unsigned char)(v >> (8 * i));
+    }
+}
+
+static void put_u64(unsigned char *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) {
+        p[i] = (unsigned char)(v >> (8 * i));
+    }
+}
+
+static uint32_t get_u32(const unsigned char *p) {
+    uint32_t v = 0;
+    for (int i = 3; i >= 0; i--) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+static uint64_t get_u64(const unsigned char *p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+/* ---- Bit stream ---- */
+
+/*
+ * Bit stream over a buffer, most significant bit first.
+ * buf:       bytes being written (must start zeroed)
+ * rbuf:      bytes being read
+ * len_bits:  readable bits (reader only)
+ * pos:       next bit
+ * err:       set when a read runs past len_bits
+ */
+typedef struct {
+    unsigned char *buf;
+    const unsigned char *rbuf;
+    size_t len_bits;
+    size_t pos;
+    int err;
+} BitStream;
+
+/*
+ * Writes the low nbits of v (0 to 64 bits).
+ */
+static void bits_put(BitStream *s, uint64_t v, int nbits) {
+    for (int i = nbits - 1; i >= 0; i--) {
+        if ((v >> i) & 1) {
+            s->buf[s->pos >> 3] |= (unsigned char)(0x80 >> (s->pos & 7));
+        }
+        s->pos++;
+    }
+}
+
+/*
+ * Reads nbits (0 to 64 bits). Past the end: returns 0 and sets s->err.
+ */
+static uint64_t bits_get(BitStream *s, int nbits) {
+    if (s->pos + (size_t)nbits > s->len_bits) {
+        s->err = 1;
+        return 0;
+    }
+
+    uint64_t v = 0;
+    for (int i = 0; i < nbits; i++) {
+        v = (v << 1) | ((s->rbuf[s->pos >> 3] >> (7 - (s->pos & 7))) & 1);
+        s->pos++;
+    }
+    return v;
+}
+
+static void varint_put(BitStream *s, uint64_t v) {
+    do {
+        uint64_t group = v & 0x7f;
+        v >>= 7;
+        bits_put(s, v ? 1 : 0, 1);
+        bits_put(s, group, 7);
+    } while (v);
+}
+
+static uint64_t varint_get(BitStream *s) {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64 && !s->err; shift += 7) {
+        int more = (int)bits_get(s, 1);
+        v |= bits_get(s, 7) << shift;
+        if (!more) {
+            return v;
+        }
+    }
+    s->err = 1;
+    return 0;
+}
+
+static uint64_t zigzag(int64_t v) {
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static int64_t unzigzag(uint64_t v) {
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+/* ---- Sample fields ---- */
+
+/*
+ * Copies a sample's counters into the stored order.
+ */
+static void counters_of(const IfaceStats *s, uint64_t c[TSDB_COUNTERS]) {
+    c[0] = s->rx_bytes;
+    c[1] = s->tx_bytes;
+    c[2] = s->rx_packets;
+    c[3] = s->tx_packets;
+    c[4] = s->rx_errors;
+    c[5] = s->tx_errors;
+    c[6] = s->rx_dropped;
+    c[7] = s->tx_dropped;
+    c[8] = s->multicast;
+}
+
+/*
+ * Copies stored counters back into a sample.
+ */
+static void counters_to(IfaceStats *s, const uint64_t c[TSDB_COUNTERS]) {
+    s->rx_bytes = c[0];
+    s->tx_bytes = c[1];
+    s->rx_packets = c[2];
+    s->tx_packets = c[3];
+    s->rx_errors = c[4];
+    s->tx_errors = c[5];
+    s->rx_dropped = c[6];
+    s->tx_dropped = c[7];
+    s->multicast = c[8];
+}
+
+static uint64_t double_bits(double d) {
+    uint64_t v;
+    memcpy(&v, &d, sizeof(v));
+    return v;
+}
+
+static double bits_double(uint64_t v) {
+    double d;
+    memcpy(&d, &v, sizeof(d));
+    return d;
+}
+
+/* ---- Field codecs (writer and reader mirror each other) ---- */
+
+static void ts_put(BitStream *s, TsdbSeries *t, long long ts, int first) {
+    if (first) {
+        bits_put(s, (uint64_t)ts, 64);
+        t->prev_delta = 0;
+    } else {
+        long long delta = ts - t->prev_ts;
+        uint64_t z = zigzag(delta - t->prev_delta);
+
+        if (z == 0) {
+            bits_put(s, 0, 1);
+        } else if (z < 128) {
+            bits_put(s, 0x2, 2);
+            bits_put(s, z, 7);
+        } else if (z < 512) {
+            bits_put(s, 0x6, 3);
+            bits_put(s, z, 9);
+        } else if (z < 4096) {
+            bits_put(s, 0xe, 4);
+            bits_put(s, z, 12);
+        } else {
+            bits_put(s, 0xf, 4);
+            bits_put(s, z, 64);
+        }
+        t->prev_delta = delta;
+    }
+    t->prev_ts = ts;
+}
+
+static long long ts_get(BitStream *s, TsdbSeries *t, int first) {
+    if (first) {
+        t->prev_ts = (long long)bits_get(s, 64);
+        t->prev_delta = 0;
+        return t->prev_ts;
+    }
+
+    uint64_t z;
+    if (bits_get(s, 1) == 0) {
+        z = 0;
+    } else if (bits_get(s, 1) == 0) {
+        z = bits_get(s, 7);
+    } else if (bits_get(s, 1) == 0) {
+        z = bits_get(s, 9);
+    } else if (bits_get(s, 1) == 0) {
+        z = bits_get(s, 12);
+    } else {
+        z = bits_get(s, 64);
+    }
+
+    t->prev_delta += unzigzag(z);
+    t->prev_ts += t->prev_delta;
+    return t->prev_ts;
+}
+
+static void counters_put(BitStream *s, TsdbSeries *t, const uint64_t c[TSDB_COUNTERS], int first) {
+    for (int i = 0; i < TSDB_COUNTERS; i++) {
+        if (first) {
+            varint_put(s, c[i]);
+            t->prev_cd[i] = 0;
+        } else {
+            // Unsigned wrap-around arithmetic: lossless whatever the counter does
+            uint64_t d = c[i] - t->prev_c[i];
+            uint64_t z = zigzag((int64_t)(d - t->prev_cd[i]));
+            if (z == 0) {
+                bits_put(s, 0, 1);
+            } else {
+                bits_put(s, 1, 1);
+                varint_put(s, z);
+            }
+            t->prev_cd[i] = d;
+        }
+        t->prev_c[i] = c[i];
+    }
+}
+
+static void counters_get(BitStream *s, TsdbSeries *t, uint64_t c[TSDB_COUNTERS], int first) {
+    for (int i = 0; i < TSDB_COUNTERS; i++) {
+        if (first) {
+            t->prev_c[i] = varint_get(s);
+            t->prev_cd[i] = 0;
+        } else {
+            if (bits_get(s, 1)) {
+                t->prev_cd[i] += (uint64_t)unzigzag(varint_get(s));
+            }
+            t->prev_c[i] += t->prev_cd[i];
+        }
+        c[i] = t->prev_c[i];
+    }
+}
+
+static void rate_put(BitStream *s, TsdbSeries *t, int i, double rate, int first) {
+    uint64_t v = double_bits(rate);
+
+    if (first) {
+        bits_put(s, v, 64);
+        t->lead[i] = -1;
+        t->prev_rate[i] = v;
+        return;
+    }
+
+    uint64_t x = v ^ t->prev_rate[i];
+    t->prev_rate[i] = v;
+
+    if (x == 0) {
+        bits_put(s, 0, 1);
+        return;
+    }
+
+    int lead = __builtin_clzll(x);
+    int trail = __builtin_ctzll(x);
+    if (lead > 31) {
+        lead = 31;
+    }
+
+    // Meaningful bits fit in the previous window: reuse it
+    if (t->lead[i] >= 0 && lead >= t->lead[i] && trail >= t->trail[i]) {
+        bits_put(s, 0x2, 2);
+        bits_put(s, x >> t->trail[i], 64 - t->lead[i] - t->trail[i]);
+        return;
+    }
+
+    int sig = 64 - lead - trail;
+    bits_put(s, 0x3, 2);
+    bits_put(s, (uint64_t)lead, 5);
+    bits_put(s, (uint64_t)(sig & 63), 6);  // 64 is stored as 0
+    bits_put(s, x >> trail, sig);
+    t->lead[i] = lead;
+    t->trail[i] = trail;
+}
+
+static double rate_get(BitStream *s, TsdbSeries *t, int i, int first) {
+    if (first) {
+        t->prev_rate[i] = bits_get(s, 64);
+        t->lead[i] = -1;
+        return bits_double(t->prev_rate[i]);
+    }
+
+    if (bits_get(s, 1) == 0) {
+        return bits_double(t->prev_rate[i]);
+    }
+
+    uint64_t x;
+    if (bits_get(s, 1) == 0) {
+        if (t->lead[i] < 0) {
+            s->err = 1;
+            return 0.0;
+        }
+        x = bits_get(s, 64 - t->lead[i] - t->trail[i]) << t->trail[i];
+    } else {
+        int lead = (int)bits_get(s, 5);
+        int sig = (int)bits_get(s, 6);
+        if (sig == 0) {
+            sig = 64;
+        }
+        if (lead + sig > 64) {
+            s->err = 1;
+            return 0.0;
+        }
+        t->lead[i] = lead;
+        t->trail[i] = 64 - lead - sig;
+        x = bits_get(s, sig) << t->trail[i];
+    }
+
+    t->prev_rate[i] ^= x;
+    return bits_double(t->prev_rate[i]);
+}
+
+/* ---- Index ---- */
+
+/*
+ * Appends an entry to an in-memory block index.
+ * Returns:
+ *   0 on success, -1 on allocation failure.
+ */
+static int index_add(TsdbIndexEntry **index, size_t *n, size_t *cap, uint64_t offset, long long first_ms, long long last_ms) {
+    if (*n == *cap) {
+        size_t newcap = *cap ? *cap * 2 : 64;
+        TsdbIndexEntry *newindex = realloc(*index, newcap * sizeof(TsdbIndexEntry));
+        if (!newindex) {
+            return -1;
+        }
+        *index = newindex;
+        *cap = newcap;
+    }
+
+    (*index)[*n].offset = offset;
+    (*index)[*n].first_ms = first_ms;
+    (*index)[*n].last_ms = last_ms;
+    (*n)++;
+    return 0;
+}
+
+/*
+ * Loads the block index of an existing file: from the footer when it is
+ * intact, else by walking the block headers (writer killed before closing).
+ * Parameters:
+ *   fd        – open file
+ *   size      – file size
+ *   index, n  – index (allocated here, free() it)
+ *   cap       – allocated entries in index
+ *   data_end  – end of the last block (where a footer is, or new blocks go)
+ * Returns:
+ *   0 on success, -1 if the file is not a wirefish time-series file (errno = EINVAL)
+ *   or cannot be read.
+ */
+static int index_load(int fd, uint64_t size, TsdbIndexEntry **index, size_t *n, size_t *cap, uint64_t *data_end) {
+    unsigned char hdr[TSDB_BLOCK_HEADER_LEN];
+
+    *index = NULL;
+    *n = *cap = 0;
+
+    if (size < TSDB_HEADER_LEN || pread(fd, hdr, TSDB_HEADER_LEN, 0) != TSDB_HEADER_LEN ||
+        memcmp(hdr, FILE_MAGIC, 4) != 0 || get_u32(hdr + 8) != TSDB_BLOCK_SIZE) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    // Intact footer: index entries sit between the last block and the trailer
+    unsigned char tr[TSDB_TRAILER_LEN];
+    if (size >= TSDB_HEADER_LEN + TSDB_TRAILER_LEN &&
+        pread(fd, tr, TSDB_TRAILER_LEN, (off_t)(size - TSDB_TRAILER_LEN)) == TSDB_TRAILER_LEN &&
+        memcmp(tr + 20, INDEX_MAGIC, 4) == 0) {
+
+        uint64_t ioff = get_u64(tr);
+        uint64_t count = get_u64(tr + 8);
+
+        if (ioff >= TSDB_HEADER_LEN && (ioff - TSDB_HEADER_LEN) % TSDB_BLOCK_SIZE == 0 &&
+            count == (ioff - TSDB_HEADER_LEN) / TSDB_BLOCK_SIZE &&
+            ioff + count * TSDB_INDEX_ENTRY_LEN + TSDB_TRAILER_LEN == size) {
+
+            unsigned char e[TSDB_INDEX_ENTRY_LEN];
+            for (uint64_t i = 0; i < count; i++) {
+                if (pread(fd, e, sizeof(e), (off_t)(ioff + i * TSDB_INDEX_ENTRY_LEN)) != (ssize_t)sizeof(e) ||
+                    index_add(index, n, cap, get_u64(e), (long long)get_u64(e + 8), (long long)get_u64(e + 16)) < 0) {
+                    free(*index);
+                    return -1;
+                }
+            }
+            *data_end = ioff;
+            return 0;
+        }
+    }
+
+    // No usable footer: every complete block with a valid header counts
+    uint64_t off = TSDB_HEADER_LEN;
+    while (off + TSDB_BLOCK_SIZE <= size) {
+        if (pread(fd, hdr, sizeof(hdr), (off_t)off) != (ssize_t)sizeof(hdr) || memcmp(hdr, BLOCK_MAGIC, 4) != 0) {
+            break;
+        }
+        if (index_add(index, n, cap, off, (long long)get_u64(hdr + 8), (long long)get_u64(hdr + 16)) < 0) {
+            free(*index);
+            return -1;
+        }
+        off += TSDB_BLOCK_SIZE;
+    }
+    *data_end = off;
+    return 0;
+}
+
+/* ---- Writer ---- */
+
+/*
+ * Opens a file for appending samples, creating it if needed.
+ * Parameters:
+ *   w    – writer to initialize
+ *   path – file path
+ * Returns:
+ *   0 on success, -1 on error (errno = EINVAL if the file is not a
+ *   wirefish time-series file).
+ */
+int tsdb_writer_open(TsdbWriter *w, const char *path) {
+    memset(w, 0, sizeof(*w));
+
+    w->fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (w->fd < 0) {
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(w->fd, &st) < 0) {
+        goto fail;
+    }
+
+    if (st.st_size == 0) {
+        // New file: just the header
+        unsigned char hdr[TSDB_HEADER_LEN] = {0};
+        memcpy(hdr, FILE_MAGIC, 4);
+        hdr[4] = TSDB_VERSION;
+        put_u32(hdr + 8, TSDB_BLOCK_SIZE);
+        if (pwrite(w->fd, hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr)) {
+            goto fail;
+        }
+        w->data_end = TSDB_HEADER_LEN;
+    } else {
+        // Existing file: keep its blocks, drop the footer (rewritten on close)
+        if (index_load(w->fd, (uint64_t)st.st_size, &w->index, &w->nblocks, &w->index_cap, &w->data_end) < 0) {
+            goto fail;
+        }
+        if (ftruncate(w->fd, (off_t)w->data_end) < 0) {
+            goto fail;
+        }
+    }
+
+    w->block = calloc(1, TSDB_BLOCK_SIZE);
+    if (!w->block) {
+        goto fail;
+    }
+    return 0;
+
+fail:
+    {
+        int saved = errno;
+        close(w->fd);
+        free(w->index);
+        memset(w, 0, sizeof(*w));
+        w->fd = -1;
+        errno = saved;
+    }
+    return -1;
+}
+
+/*
+ * Writes the block being filled and starts an empty one.
+ * Returns:
+ *   0 on success, -1 on write error.
+ */
+static int tsdb_flush_block(TsdbWriter *w) {
+    if (w->nrec == 0) {
+        return 0;
+    }
+
+    memcpy(w->block, BLOCK_MAGIC, 4);
+    put_u32(w->block + 4, w->nrec);
+    put_u64(w->block + 8, (uint64_t)w->first_ms);
+    put_u64(w->block + 16, (uint64_t)w->last_ms);
+    put_u32(w->block + 24, (uint32_t)w->bitpos);
+
+    if (pwrite(w->fd, w->block, TSDB_BLOCK_SIZE, (off_t)w->data_end) != TSDB_BLOCK_SIZE) {
+        return -1;
+    }
+    if (index_add(&w->index, &w->nblocks, &w->index_cap, w->data_end, w->first_ms, w->last_ms) < 0) {
+        return -1;
+    }
+    w->data_end += TSDB_BLOCK_SIZE;
+
+    // Next block decodes on its own: forget every series
+    memset(w->block, 0, TSDB_BLOCK_SIZE);
+    w->bitpos = 0;
+    w->nrec = 0;
+    w->nseries = 0;
+    w->last_id = 0;
+    return 0;
+}
+
+/*
+ * Appends one sample.
+ * Parameters:
+ *   w      – open writer
+ *   sample – monitor sample (iface, ts_ms, counters and instantaneous rates are stored)
+ * Returns:
+ *   0 on success, -1 on write or allocation error.
+ */
+int tsdb_append(TsdbWriter *w, const IfaceStats *sample) {
+    if (w->bitpos + TSDB_RECORD_MAX_BITS > TSDB_DATA_BITS && tsdb_flush_block(w) < 0) {
+        return -1;
+    }
+
+    BitStream s = { .buf = w->block + TSDB_BLOCK_HEADER_LEN, .pos = w->bitpos };
+
+    // Series id: usually the one after the previous record's
+    size_t expected = (w->nseries > 0) ? (w->last_id + 1) % w->nseries : 0;
+    size_t id = expected;
+    if (id >= w->nseries || strcmp(w->series[id].iface, sample->iface) != 0) {
+        for (id = 0; id < w->nseries && strcmp(w->series[id].iface, sample->iface) != 0; id++) {
+        }
+    }
+
+    int first = (id == w->nseries);
+    if (first) {
+        if (w->nseries == w->series_cap) {
+            size_t newcap = w->series_cap ? w->series_cap * 2 : 16;
+            TsdbSeries *newseries = realloc(w->series, newcap * sizeof(TsdbSeries));
+            if (!newseries) {
+                return -1;
+            }
+            w->series = newseries;
+            w->series_cap = newcap;
+        }
+        memset(&w->series[id], 0, sizeof(TsdbSeries));
+        snprintf(w->series[id].iface, sizeof(w->series[id].iface), "%s", sample->iface);
+        w->nseries++;
+    }
+
+    if (id == expected && !first) {
+        bits_put(&s, 0, 1);
+    } else {
+        bits_put(&s, 1, 1);
+        varint_put(&s, id);
+        if (first) {
+            size_t len = strlen(w->series[id].iface);
+            bits_put(&s, len, 4);
+            for (size_t i = 0; i < len; i++) {
+                bits_put(&s, (unsigned char)w->series[id].iface[i], 8);
+            }
+        }
+    }
+
+    TsdbSeries *t = &w->series[id];
+    uint64_t c[TSDB_COUNTERS];
+    counters_of(sample, c);
+
+    ts_put(&s, t, sample->ts_ms, first);
+    counters_put(&s, t, c, first);
+    rate_put(&s, t, 0, sample->rx_rate_bps, first);
+    rate_put(&s, t, 1, sample->tx_rate_bps, first);
+
+    if (w->nrec == 0 || sample->ts_ms < w->first_ms) {
+        w->first_ms = sample->ts_ms;
+    }
+    if (w->nrec == 0 || sample->ts_ms > w->last_ms) {
+        w->last_ms = sample->ts_ms;
+    }
+    w->nrec++;
+    w->last_id = id;
+    w->bitpos = s.pos;
+    return 0;
+}
+
+/*
+ * Writes the last block and the footer index, and closes the file.
+ * Returns:
+ *   0 on success, -1 on write error (the blocks already written stay readable).
+ */
+int tsdb_writer_close(TsdbWriter *w) {
+    int result = tsdb_flush_block(w);
+
+    if (result == 0) {
+        size_t len = w->nblocks * TSDB_INDEX_ENTRY_LEN + TSDB_TRAILER_LEN;
+        unsigned char *footer = calloc(1, len);
+
+        if (!footer) {
+            result = -1;
+        } else {
+            for (size_t i = 0; i < w->nblocks; i++) {
+                unsigned char *e = footer + i * TSDB_INDEX_ENTRY_LEN;
+                put_u64(e, w->index[i].offset);
+                put_u64(e + 8, (uint64_t)w->index[i].first_ms);
+                put_u64(e + 16, (uint64_t)w->index[i].last_ms);
+            }
+
+            unsigned char *tr = footer + w->nblocks * TSDB_INDEX_ENTRY_LEN;
+            put_u64(tr, w->data_end);
+            put_u64(tr + 8, w->nblocks);
+            memcpy(tr + 20, INDEX_MAGIC, 4);
+
+            if (pwrite(w->fd, footer, len, (off_t)w->data_end) != (ssize_t)len) {
+                result = -1;
+            }
+            free(footer);
+        }
+    }
+
+    if (close(w->fd) < 0) {
+        result = -1;
+    }
+    free(w->block);
+    free(w->series);
+    free(w->index);
+    memset(w, 0, sizeof(*w));
+    w->fd = -1;
+    return result;
+}
+
+/* ---- Reader ---- */
+
+/*
+ * Opens a file for reading and maps it.
+ * Returns:
+ *   0 on success, -1 on error (errno = EINVAL if the file is not a
+ *   wirefish time-series file).
+ */
+int tsdb_reader_open(TsdbReader *r, const char *path) {
+    memset(r, 0, sizeof(*r));
+
+    r->fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (r->fd < 0) {
+        return -1;
+    }
+
+    struct stat st;
+    size_t cap = 0;
+    uint64_t data_end;
+
+    if (fstat(r->fd, &st) < 0 ||
+        index_load(r->fd, (uint64_t)st.st_size, &r->index, &r->nblocks, &cap, &data_end) < 0) {
+        int saved = errno;
+        close(r->fd);
+        r->fd = -1;
+        errno = saved;
+        return -1;
+    }
+
+    r->size = (size_t)st.st_size;
+    void *map = mmap(NULL, r->size, PROT_READ, MAP_PRIVATE, r->fd, 0);
+    if (map == MAP_FAILED) {
+        int saved = errno;
+        tsdb_reader_close(r);
+        errno = saved;
+        return -1;
+    }
+    r->map = map;
+    return 0;
+}
+
+/*
+ * Appends a decoded sample to a series.
+ * Returns:
+ *   0 on success, -1 on allocation failure.
+ */
+static int series_append(MonitorSeries *out, const IfaceStats *stats) {
+    if (out->len == out->cap) {
+        size_t newcap = out->cap ? out->cap * 2 : 64;
+        IfaceStats *newbuf = realloc(out->samples, newcap * sizeof(IfaceStats));
+        if (!newbuf) {
+            return -1;
+        }
+        out->samples = newbuf;
+        out->cap = newcap;
+    }
+    out->samples[out->len++] = *stats;
+    return 0;
+}
+
+/*
+ * Decodes one block, appending its samples stamped within [from_ms, to_ms].
+ * Returns:
+ *   0 on success, -1 on a corrupt block (errno = EINVAL) or allocation failure.
+ */
+static int tsdb_decode_block(const unsigned char *block, long long from_ms, long long to_ms, MonitorSeries *out) {
+    uint32_t nrec = get_u32(block + 4);
+    uint32_t nbits = get_u32(block + 24);
+
+    if (memcmp(block, BLOCK_MAGIC, 4) != 0 || nbits > TSDB_DATA_BITS) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    BitStream s = { .rbuf = block + TSDB_BLOCK_HEADER_LEN, .len_bits = nbits };
+    TsdbSeries *series = NULL;
+    size_t nseries = 0, cap = 0, last_id = 0;
+    int result = 0;
+
+    for (uint32_t k = 0; k < nrec && result == 0; k++) {
+        size_t id = (nseries > 0) ? (last_id + 1) % nseries : 0;
+
+        if (bits_get(&s, 1)) {
+            id = (size_t)varint_get(&s);
+        } else if (nseries == 0) {
+            s.err = 1;
+        }
+
+        int first = (id == nseries);
+        if (id > nseries || s.err) {
+            errno = EINVAL;
+            result = -1;
+            break;
+        }
+
+        if (first) {
+            if (nseries == cap) {
+                size_t newcap = cap ? cap * 2 : 16;
+                TsdbSeries *grown = realloc(series, newcap * sizeof(TsdbSeries));
+                if (!grown) {
+                    result = -1;
+                    break;
+                }
+                series = grown;
+                cap = newcap;
+            }
+            memset(&series[id], 0, sizeof(TsdbSeries));
+            size_t len = (size_t)bits_get(&s, 4);
+            for (size_t i = 0; i < len; i++) {
+                series[id].iface[i] = (char)bits_get(&s, 8);
+            }
+            nseries++;
+        }
+
+        TsdbSeries *t = &series[id];
+        IfaceStats stats;
+        uint64_t c[TSDB_COUNTERS];
+
+        memset(&stats, 0, sizeof(stats));
+        memcpy(stats.iface, t->iface, sizeof(stats.iface));
+        stats.ts_ms = ts_get(&s, t, first);
+        counters_get(&s, t, c, first);
+        counters_to(&stats, c);
+        stats.rx_rate_bps = rate_get(&s, t, 0, first);
+        stats.tx_rate_bps = rate_get(&s, t, 1, first);
+        last_id = id;
+
+        if (s.err) {
+            errno = EINVAL;
+            result = -1;
+        } else if (stats.ts_ms >= from_ms && stats.ts_ms <= to_ms) {
+            result = series_append(out, &stats);
+        }
+    }
+
+    free(series);
+    return result;
+}
+
+/*
+ * Collects the samples stamped within [from_ms, to_ms], in file order.
+ * Only blocks whose index range overlaps the request are decoded.
+ * Parameters:
+ *   r        – open reader
+ *   from_ms  – start of the range (Unix epoch, milliseconds)
+ *   to_ms    – end of the range
+ *   out      – series to fill (only counters, rates, iface and ts_ms are set);
+ *              free with monitorseries_free()
+ * Returns:
+ *   Number of samples, or -1 on a corrupt block (errno = EINVAL) or allocation failure.
+ */
+int tsdb_scan(const TsdbReader *r, long long from_ms, long long to_ms, MonitorSeries *out) {
+    memset(out, 0, sizeof(*out));
+
+    for (size_t i = 0; i < r->nblocks; i++) {
+        const TsdbIndexEntry *e = &r->index[i];
+
+        if (e->last_ms < from_ms || e->first_ms > to_ms) {
+            continue;  // Never touched: its pages are not even faulted in
+        }
+        if (e->offset + TSDB_BLOCK_SIZE > r->size) {
+            errno = EINVAL;
+            return -1;
+        }
+        if (tsdb_decode_block(r->map + e->offset, from_ms, to_ms, out) < 0) {
+            return -1;
+        }
+    }
+    return (int)out->len;
+}
+
+/*
+ * Unmaps and closes the file.
+ */
+void tsdb_reader_close(TsdbReader *r) {
+    if (r->map) {
+        munmap((void *)r->map, r->size);
+    }
+    if (r->fd >= 0) {
+        close(r->fd);
+    }
+    free(r->index);
+    memset(r, 0, sizeof(*r));
+    r->fd = -1;
+}
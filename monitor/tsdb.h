@@ -0,0 +1,139 @@
+/*
+ * File: tsdb.h
+ * Summary: Compact append-only time-series file for monitor samples.
+ *
+ * Responsibilities:
+ *  - Append samples to fixed-size blocks, Gorilla-style compressed:
+ *      * timestamps: delta-of-delta in variable-width bit buckets
+ *      * counters: delta-of-delta, zigzag varint (one bit when steady)
+ *      * rates: XOR with the previous value, leading/trailing-zero windows
+ *  - End the file with a footer index (per block: offset and time range)
+ *  - Read a file through mmap() and decode only the blocks that overlap
+ *    the requested time range
+ *
+ * File layout (all integers little-endian):
+ *  - header:   "WFTS" magic, version, block size
+ *  - blocks:   TSDB_BLOCK_SIZE bytes each; a 32-byte block header (record
+ *              count, first/last ts_ms, bits used) then the bit stream
+ *  - index:    one 24-byte entry per block (offset, first ts_ms, last ts_ms)
+ *  - trailer:  index offset, block count, "WFIX" magic
+ *
+ * Data & Types:
+ *  - typedef struct TsdbWriter { int fd; unsigned char *block; ... }
+ *  - typedef struct TsdbReader { int fd; const unsigned char *map; size_t size; ... }
+ *
+ * Public API:
+ *  - int  tsdb_writer_open(TsdbWriter *w, const char *path);
+ *  - int  tsdb_append(TsdbWriter *w, const IfaceStats *sample);
+ *  - int  tsdb_writer_close(TsdbWriter *w);
+ *  - int  tsdb_reader_open(TsdbReader *r, const char *path);
+ *  - int  tsdb_scan(const TsdbReader *r, long long from_ms, long long to_ms, MonitorSeries *out);
+ *  - void tsdb_reader_close(TsdbReader *r);
+ *
+ * Notes:
+ *  - Every block starts from scratch (its own interface table and
+ *    first values), so any block decodes on its own
+ *  - Stored per sample: iface, ts_ms, the nine counters and the two
+ *    instantaneous rates; rolling statistics are recomputed on replay
+ *  - Reopening a file for append drops its footer, adds new blocks after
+ *    the old ones and writes a new footer on close. A file whose footer
+ *    is missing (the writer was killed) is still read, and appended to,
+ *    by walking the block headers
+ *  - Samples reach the disk a block at a time; a kill loses at most the
+ *    block being filled
+ *
+ * AUTHOR: Youssef Elshafei
+ * DATE:   2025-12-03
+ */
+#ifndef TSDB_H
+#define TSDB_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../model/model.h"
+
+/* Size of every data block (bytes) */
+#define TSDB_BLOCK_SIZE 4096
+
+/* Counters stored per sample */
+#define TSDB_COUNTERS 9
+
+/* Rates stored per sample (rx, tx) */
+#define TSDB_RATES 2
+
+/*
+ * Encoder/decoder state of one interface within the current block.
+ * iface:               interface name
+ * prev_ts, prev_delta: last timestamp and last timestamp delta
+ * prev_c, prev_cd:     last counters and last counter deltas
+ * prev_rate:           bit patterns of the last rates
+ * lead, trail:         XOR window of the last stored rate (lead = -1: none yet)
+ */
+typedef struct {
+    char iface[IFACE_NAME_MAX];
+    long long prev_ts, prev_delta;
+    uint64_t prev_c[TSDB_COUNTERS], prev_cd[TSDB_COUNTERS];
+    uint64_t prev_rate[TSDB_RATES];
+    int lead[TSDB_RATES], trail[TSDB_RATES];
+} TsdbSeries;
+
+/*
+ * Footer index entry.
+ * offset:             file offset of the block
+ * first_ms, last_ms:  time range of the block's samples
+ */
+typedef struct {
+    uint64_t offset;
+    long long first_ms, last_ms;
+} TsdbIndexEntry;
+
+/*
+ * Open file being appended to.
+ * fd:                 file descriptor
+ * block:              TSDB_BLOCK_SIZE buffer of the block being filled
+ * bitpos:             bits used in the block's stream
+ * nrec:               samples in the block
+ * first_ms, last_ms:  time range of the block
+ * series, nseries:    interfaces of the block, in order of first appearance
+ * series_cap:         allocated entries in series
+ * last_id:            series of the previous sample
+ * index, nblocks:     footer index of every block written
+ * index_cap:          allocated entries in index
+ * data_end:           file offset where the next block goes
+ */
+typedef struct TsdbWriter {
+    int fd;
+    unsigned char *block;
+    size_t bitpos;
+    uint32_t nrec;
+    long long first_ms, last_ms;
+    TsdbSeries *series;
+    size_t nseries, series_cap;
+    size_t last_id;
+    TsdbIndexEntry *index;
+    size_t nblocks, index_cap;
+    uint64_t data_end;
+} TsdbWriter;
+
+/*
+ * Open file being read.
+ * fd:                 file descriptor
+ * map, size:          read-only mapping of the whole file
+ * index, nblocks:     footer index (read from the file, or rebuilt from block headers)
+ */
+typedef struct TsdbReader {
+    int fd;
+    const unsigned char *map;
+    size_t size;
+    TsdbIndexEntry *index;
+    size_t nblocks;
+} TsdbReader;
+
+int  tsdb_writer_open(TsdbWriter *w, const char *path);
+int  tsdb_append(TsdbWriter *w, const IfaceStats *sample);
+int  tsdb_writer_close(TsdbWriter *w);
+int  tsdb_reader_open(TsdbReader *r, const char *path);
+int  tsdb_scan(const TsdbReader *r, long long from_ms, long long to_ms, MonitorSeries *out);
+void tsdb_reader_close(TsdbReader *r);
+
+#endif /* TSDB_H */
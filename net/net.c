@@ -13,7 +13,7 @@
  * Aryan Verma, 400575438, McMaster University
  */
 
-#define _XOPEN_SOURCE 700
+#define _GNU_SOURCE   // SCM_TIMESTAMPNS and friends (implies _XOPEN_SOURCE 700)
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -72,7 +72,39 @@
  */
 #include <sys/select.h>
 
+/*
+ * Provides struct iovec used by recvmsg() scatter/gather buffers
+ */
+#include <sys/uio.h>
+
+/*
+ * Provides struct timespec carried in SCM_TIMESTAMPNS control messages
+ */
+#include <time.h>
+
+/*
+ * Provides struct sock_extended_err and SO_EE_OFFENDER() for IP_RECVERR error queues
+ */
+#include <linux/errqueue.h>
+
+/*
+ * Provides struct sock_fprog for SO_ATTACH_FILTER (classic BPF socket filters)
+ */
+#include <linux/filter.h>
+
+/*
+ * Provides getifaddrs() to list interfaces with their addresses
+ */
+#include <ifaddrs.h>
+
+/*
+ * Provides struct ifreq and SIOCGIFMTU to read an interface's MTU
+ */
+#include <net/if.h>
+#include <sys/ioctl.h>
+
 #include "net.h"
+#include "../timeutil/timeutil.h"
 
 /*
  * Function: net_resolve
@@ -339,6 +371,7 @@ int net_icmp_raw_socket() {
         if (errno == EPERM) {
             fprintf(stderr, "Error: ICMP raw socket requires root privileges\n");
             fprintf(stderr, "       Run with: sudo ./wirefish --trace ...\n");
+            fprintf(stderr, "       or allow unprivileged ICMP: sysctl -w net.ipv4.ping_group_range=\"0 2147483647\"\n");
         } else {
             perror("socket IPPROTO_ICMP");
         }
@@ -346,4 +379,614 @@ int net_icmp_raw_socket() {
     }
     
     return sockfd;
-}
\ No newline at end of file
+}
+
+/*
+ * Function: net_icmp_dgram_socket
+ *
+ * Creates an unprivileged ICMP "ping" socket (SOCK_DGRAM + IPPROTO_ICMP)
+ *
+ * How it differs from a raw socket:
+ *  - No root needed, only membership of a group in net.ipv4.ping_group_range
+ *  - The kernel owns the ICMP identifier (the socket's "port") and only delivers
+ *    Echo Replies carrying it, so no other process's traffic reaches us
+ *  - Replies arrive without the IP header
+ *  - ICMP errors (Time Exceeded, Unreachable) are not read normally; with
+ *    IP_RECVERR they are queued on the socket's error queue instead
+ *    (see net_recv_icmp_error)
+ *
+ * Parameters:
+ *   id_out - filled with the ICMP identifier the kernel assigned (may be NULL)
+ *
+ * Returns:
+ *  - socket file descriptor
+ *  - -1 if ping sockets are not allowed (no message printed; callers fall back to raw)
+ */
+int net_icmp_dgram_socket(uint16_t *id_out) {
+
+    int sockfd = socket(AF_INET, SOCK_DGRAM, IPPROTO_ICMP);
+    if (sockfd < 0) {
+        return -1;
+    }
+
+    // Binding to port 0 makes the kernel pick a free identifier now, so we can read it back
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    if (bind(sockfd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(sockfd);
+        return -1;
+    }
+
+    socklen_t len = sizeof(addr);
+    if (getsockname(sockfd, (struct sockaddr *)&addr, &len) < 0) {
+        close(sockfd);
+        return -1;
+    }
+
+    // Ask for ICMP errors about our probes on the error queue
+    int on = 1;
+    if (setsockopt(sockfd, IPPROTO_IP, IP_RECVERR, &on, sizeof(on)) < 0) {
+        close(sockfd);
+        return -1;
+    }
+
+    if (id_out != NULL) {
+        *id_out = ntohs(addr.sin_port);
+    }
+
+    return sockfd;
+}
+
+/*
+ * Function: net_tcp_raw_socket
+ *
+ * Creates a raw TCP socket for sending hand-built SYN probes and
+ * receiving the SYN-ACK/RST answers (used by TCP traceroute)
+ *
+ * The kernel still adds the IP header (no IP_HDRINCL), so only the TCP header
+ * has to be built. Like raw ICMP sockets this requires root permissions
+ */
+int net_tcp_raw_socket(void) {
+
+    // AF_INET: IPv4, SOCK_RAW: raw socket, IPPROTO_TCP: deliver copies of incoming TCP segments
+    int sockfd = socket(AF_INET, SOCK_RAW, IPPROTO_TCP);
+    if (sockfd < 0) {
+         // Special error message for permission denied
+        if (errno == EPERM) {
+            fprintf(stderr, "Error: TCP raw socket requires root privileges\n");
+            fprintf(stderr, "       Run with: sudo ./wirefish --trace ...\n");
+        } else {
+            perror("socket IPPROTO_TCP");
+        }
+        return -1;
+    }
+
+    return sockfd;
+}
+
+/*
+ * Function: net_bound_socket
+ *
+ * Creates a UDP or TCP socket bound to a kernel-chosen (ephemeral) port
+ *
+ * Used for:
+ *  - UDP traceroute: the socket sends the probes, its port identifies them
+ *  - TCP traceroute: holding the port keeps other programs from using the
+ *    source port our raw SYN probes claim
+ *
+ * Parameters:
+ *   type     - SOCK_DGRAM or SOCK_STREAM
+ *   port_out - filled with the bound port (host byte order)
+ *
+ * Returns:
+ *  - socket file descriptor
+ *  - -1 for error
+ */
+int net_bound_socket(int type, uint16_t *port_out) {
+
+    int sockfd = socket(AF_INET, type, 0);
+    if (sockfd < 0) {
+        perror("socket");
+        return -1;
+    }
+
+    // Port 0 asks the kernel to pick a free port
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = 0;
+
+    if (bind(sockfd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        perror("bind");
+        close(sockfd);
+        return -1;
+    }
+
+    // Read back which port we got
+    socklen_t len = sizeof(addr);
+    if (getsockname(sockfd, (struct sockaddr *)&addr, &len) < 0) {
+        perror("getsockname");
+        close(sockfd);
+        return -1;
+    }
+
+    if (port_out != NULL) {
+        *port_out = ntohs(addr.sin_port);
+    }
+
+    return sockfd;
+}
+
+/*
+ * Function: net_source_addr
+ *
+ * Finds the local IP address the kernel would use to reach 'dst'
+ *
+ * How it works:
+ *   1. connect() a UDP socket to the destination (no packet is sent)
+ *   2. The kernel does a route lookup and picks a source address
+ *   3. getsockname() reads that address back
+ *
+ * Returns:
+ *  - 0 for success
+ *  - -1 for error
+ */
+int net_source_addr(const struct sockaddr_in *dst, struct in_addr *src) {
+
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sockfd < 0) {
+        return -1;
+    }
+
+    // Any port works, UDP connect() only sets up the route
+    struct sockaddr_in peer = *dst;
+    if (peer.sin_port == 0) {
+        peer.sin_port = htons(9);
+    }
+
+    if (connect(sockfd, (struct sockaddr *)&peer, sizeof(peer)) < 0) {
+        close(sockfd);
+        return -1;
+    }
+
+    struct sockaddr_in local;
+    socklen_t len = sizeof(local);
+    if (getsockname(sockfd, (struct sockaddr *)&local, &len) < 0) {
+        close(sockfd);
+        return -1;
+    }
+
+    *src = local.sin_addr;
+    close(sockfd);
+    return 0;
+}
+
+/*
+ * Function: net_set_pmtu_probe
+ *
+ * Sets the Don't Fragment bit on everything the socket sends, without letting
+ * the kernel's path MTU cache shrink what we are allowed to send
+ *
+ * Why IP_PMTUDISC_PROBE and not IP_PMTUDISC_DO?
+ *  - DO also sets DF, but once a Fragmentation Needed error arrives the kernel
+ *    caches the smaller MTU and refuses (EMSGSIZE) larger sends to that host,
+ *    which would stop us from re-testing sizes ourselves
+ *  - PROBE only refuses packets bigger than the outgoing interface MTU
+ *
+ * Returns:
+ *  - 0 for success
+ *  - -1 for error
+ */
+int net_set_pmtu_probe(int sockfd) {
+
+    int mode = IP_PMTUDISC_PROBE;
+
+    if (setsockopt(sockfd, IPPROTO_IP, IP_MTU_DISCOVER, &mode, sizeof(mode)) < 0) {
+        perror("setsockopt IP_MTU_DISCOVER");
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Function: net_route_mtu
+ *
+ * Finds the MTU of the interface the kernel would send to a destination through
+ *
+ * How?
+ *  - net_source_addr() does the route lookup and gives our source address
+ *  - getifaddrs() tells which interface owns that address
+ *  - ioctl(SIOCGIFMTU) reads that interface's MTU
+ *
+ * Why not getsockopt(IP_MTU)?
+ *  - IP_MTU reports the kernel's cached path MTU, which a previous run (or any
+ *    other program) may have lowered; we want to re-test from the top every time
+ *
+ * Returns:
+ *  - 0 for success
+ *  - -1 for error
+ */
+int net_route_mtu(const struct sockaddr_in *dst, int *mtu) {
+
+    struct in_addr src;
+    if (net_source_addr(dst, &src) != 0) {
+        return -1;
+    }
+
+    struct ifaddrs *ifas;
+    if (getifaddrs(&ifas) != 0) {
+        return -1;
+    }
+
+    // Find the interface name that owns the source address
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+
+    for (struct ifaddrs *ifa = ifas; ifa != NULL; ifa = ifa->ifa_next) {
+        if (ifa->ifa_addr != NULL && ifa->ifa_addr->sa_family == AF_INET &&
+            ((struct sockaddr_in *)ifa->ifa_addr)->sin_addr.s_addr == src.s_addr) {
+            strncpy(ifr.ifr_name, ifa->ifa_name, IFNAMSIZ - 1);
+            break;
+        }
+    }
+
+    freeifaddrs(ifas);
+
+    if (ifr.ifr_name[0] == '\0') {
+        return -1;
+    }
+
+    // Any socket works for interface ioctls
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sockfd < 0) {
+        return -1;
+    }
+
+    if (ioctl(sockfd, SIOCGIFMTU, &ifr) < 0) {
+        close(sockfd);
+        return -1;
+    }
+
+    close(sockfd);
+    *mtu = ifr.ifr_mtu;
+    return 0;
+}
+
+/*
+ * Function: net_enable_timestamps
+ *
+ * Asks the kernel to stamp every received packet with the time it arrived
+ *
+ * Why kernel timestamps?
+ *  - A userspace clock read after select()/recvfrom() returns also measures
+ *    scheduler wakeup latency and syscall overhead
+ *  - SO_TIMESTAMPNS records the arrival time in the network stack (CLOCK_REALTIME,
+ *    nanosecond resolution) and hands it back as a control message on recvmsg()
+ *
+ * Returns:
+ *  - 0 for success
+ *  - -1 if the option is not supported (callers fall back to userspace time)
+ */
+int net_enable_timestamps(int sockfd) {
+
+    int on = 1;
+
+    // SOL_SOCKET: socket level option
+    // SO_TIMESTAMPNS: deliver a struct timespec with every datagram
+    if (setsockopt(sockfd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) < 0) {
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Function: net_attach_filter
+ *
+ * Attaches a classic BPF program to a socket
+ *
+ * Why?
+ *  - A raw ICMP socket gets a copy of every ICMP packet the host receives
+ *  - The filter runs in the kernel for each packet; rejected packets are never
+ *    queued, so they cost no recvmsg() call and no copy to userspace
+ *
+ * Packets that were queued before the filter was attached still arrive,
+ * so callers must keep checking what they read
+ *
+ * Returns:
+ *  - 0 for success
+ *  - -1 for error (callers can continue unfiltered)
+ */
+int net_attach_filter(int sockfd, const struct sock_filter *prog, size_t len) {
+
+    struct sock_fprog fprog;
+    fprog.len = (unsigned short)len;
+    fprog.filter = (struct sock_filter *)prog;
+
+    if (setsockopt(sockfd, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog)) < 0) {
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Function: net_cmsg_timestamp
+ *
+ * Finds the SCM_TIMESTAMPNS record in a received message's control data
+ *
+ * Returns:
+ *  - receive time in microseconds since the epoch
+ *  - the current time if the kernel did not attach a timestamp
+ */
+static long long net_cmsg_timestamp(struct msghdr *msg) {
+
+    for (struct cmsghdr *cm = CMSG_FIRSTHDR(msg); cm != NULL; cm = CMSG_NXTHDR(msg, cm)) {
+        if (cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_TIMESTAMPNS) {
+            struct timespec ts;
+            memcpy(&ts, CMSG_DATA(cm), sizeof(ts));
+            return (long long)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+        }
+    }
+
+    // Fallback: no kernel timestamp, use the time we got the packet
+    return us_now();
+}
+
+/*
+ * Function: net_recv_timestamped
+ *
+ * Receives one datagram along with its kernel receive timestamp
+ *
+ * How it works:
+ *   1. recvmsg() fills the data buffer and a separate control buffer
+ *   2. The control buffer holds "cmsg" records; we look for SCM_TIMESTAMPNS
+ *   3. If the kernel did not attach one, the current time is used instead
+ *
+ * Parameters:
+ *   buf, len - data buffer
+ *   from     - filled with the sender's address (may be NULL)
+ *   fromlen  - in/out size of 'from'
+ *   rx_us    - receive time in microseconds since the epoch
+ *
+ * Returns:
+ *  - number of bytes received
+ *  - -1 for error
+ */
+ssize_t net_recv_timestamped(int sockfd, void *buf, size_t len, struct sockaddr *from, socklen_t *fromlen, long long *rx_us) {
+
+    // Data goes into 'buf' through a single iovec
+    struct iovec iov;
+    iov.iov_base = buf;
+    iov.iov_len = len;
+
+    // Control buffer sized for one timespec record (aligned for cmsghdr)
+    union {
+        char buf[CMSG_SPACE(sizeof(struct timespec))];
+        struct cmsghdr align;
+    } control;
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = from;
+    msg.msg_namelen = (from != NULL && fromlen != NULL) ? *fromlen : 0;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    ssize_t n = recvmsg(sockfd, &msg, 0);
+    if (n < 0) {
+        return -1;
+    }
+
+    if (fromlen != NULL) {
+        *fromlen = msg.msg_namelen;
+    }
+
+    // Walk the control messages looking for the kernel timestamp
+    if (rx_us != NULL) {
+        *rx_us = net_cmsg_timestamp(&msg);
+    }
+
+    return n;
+}
+
+/*
+ * Function: net_recv_icmp_error
+ *
+ * Reads one ICMP error from a socket's error queue (IP_RECVERR)
+ *
+ * How it works:
+ *   1. recvmsg(MSG_ERRQUEUE) returns the packet WE sent that caused the error
+ *   2. An IP_RECVERR control message describes the error (sock_extended_err):
+ *      ICMP type/code and, right after it, the address of the router that sent it
+ *   3. The kernel timestamp of the ICMP error rides along as SCM_TIMESTAMPNS
+ *
+ * Parameters:
+ *   buf, len  - filled with the original probe (ICMP header onwards for ping sockets)
+ *   offender  - filled with the address of the router/host that sent the error
+ *   type,code - ICMP type and code of the error (type -1: not an ICMP error)
+ *   rx_us     - receive time in microseconds since the epoch
+ *
+ * Returns:
+ *  - number of bytes of the original probe
+ *  - 0 with *type = -1 if the entry did not come from ICMP (skip it, keep reading)
+ *  - -1 if the queue is empty (EAGAIN) or on error
+ */
+ssize_t net_recv_icmp_error(int sockfd, void *buf, size_t len, struct sockaddr_in *offender, int *type, int *code, long long *rx_us) {
+
+    struct iovec iov;
+    iov.iov_base = buf;
+    iov.iov_len = len;
+
+    // Room for the extended error (plus offender address) and the timestamp
+    union {
+        char buf[CMSG_SPACE(sizeof(struct sock_extended_err) + sizeof(struct sockaddr_in)) + CMSG_SPACE(sizeof(struct timespec))];
+        struct cmsghdr align;
+    } control;
+
+    struct sockaddr_in dest;
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = &dest;
+    msg.msg_namelen = sizeof(dest);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    ssize_t n = recvmsg(sockfd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT);
+    if (n < 0) {
+        return -1;
+    }
+
+    const struct sock_extended_err *ee = NULL;
+    for (struct cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm != NULL; cm = CMSG_NXTHDR(&msg, cm)) {
+        if (cm->cmsg_level == IPPROTO_IP && cm->cmsg_type == IP_RECVERR) {
+            ee = (const struct sock_extended_err *)CMSG_DATA(cm);
+        }
+    }
+
+    // Local errors (e.g. EMSGSIZE from our own stack) have no router behind them,
+    // but ICMP errors may still be queued after them
+    if (ee == NULL || ee->ee_origin != SO_EE_ORIGIN_ICMP) {
+        if (type != NULL) {
+            *type = -1;
+        }
+        return 0;
+    }
+
+    if (offender != NULL) {
+        memcpy(offender, SO_EE_OFFENDER(ee), sizeof(*offender));
+    }
+    if (type != NULL) {
+        *type = ee->ee_type;
+    }
+    if (code != NULL) {
+        *code = ee->ee_code;
+    }
+    if (rx_us != NULL) {
+        *rx_us = net_cmsg_timestamp(&msg);
+    }
+
+    return n;
+}
+
+/*
+ * Function: net_send_batch
+ *
+ * Sends several packets with one sendmmsg() system call
+ *
+ * Each packet carries its own destination and IP TTL; the TTL travels as an
+ * IP_TTL control message, so no setsockopt() is needed between packets
+ *
+ * Parameters:
+ *   pkts - packets to send (buf, len, addr, ttl used)
+ *   n    - number of packets (at most NET_BATCH_MAX)
+ *
+ * Returns:
+ *  - number of packets sent (may be fewer than n)
+ *  - -1 for error (errno set)
+ */
+int net_send_batch(int sockfd, const NetPacket *pkts, size_t n) {
+
+    if (n > NET_BATCH_MAX) {
+        n = NET_BATCH_MAX;
+    }
+
+    struct mmsghdr msgs[NET_BATCH_MAX];
+    struct iovec iov[NET_BATCH_MAX];
+
+    // One IP_TTL record per message (aligned for cmsghdr)
+    union {
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control[NET_BATCH_MAX];
+
+    memset(msgs, 0, n * sizeof(msgs[0]));
+
+    for (size_t i = 0; i < n; i++) {
+        iov[i].iov_base = pkts[i].buf;
+        iov[i].iov_len = pkts[i].len;
+
+        struct msghdr *msg = &msgs[i].msg_hdr;
+        msg->msg_name = (void *)&pkts[i].addr;
+        msg->msg_namelen = sizeof(pkts[i].addr);
+        msg->msg_iov = &iov[i];
+        msg->msg_iovlen = 1;
+        msg->msg_control = control[i].buf;
+        msg->msg_controllen = sizeof(control[i].buf);
+
+        struct cmsghdr *cm = CMSG_FIRSTHDR(msg);
+        cm->cmsg_level = IPPROTO_IP;
+        cm->cmsg_type = IP_TTL;
+        cm->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cm), &pkts[i].ttl, sizeof(int));
+    }
+
+    return sendmmsg(sockfd, msgs, (unsigned int)n, 0);
+}
+
+/*
+ * Function: net_recv_batch
+ *
+ * Receives every packet already queued on a socket (up to n) with one
+ * recvmmsg() system call, without blocking
+ *
+ * Parameters:
+ *   pkts - receive slots; buf/cap must be set, len/addr/rx_us are filled in
+ *   n    - number of slots (at most NET_BATCH_MAX)
+ *
+ * Returns:
+ *  - number of packets received
+ *  - -1 if nothing was queued or on error
+ */
+int net_recv_batch(int sockfd, NetPacket *pkts, size_t n) {
+
+    if (n > NET_BATCH_MAX) {
+        n = NET_BATCH_MAX;
+    }
+
+    struct mmsghdr msgs[NET_BATCH_MAX];
+    struct iovec iov[NET_BATCH_MAX];
+
+    // One timestamp record per message (aligned for cmsghdr)
+    union {
+        char buf[CMSG_SPACE(sizeof(struct timespec))];
+        struct cmsghdr align;
+    } control[NET_BATCH_MAX];
+
+    memset(msgs, 0, n * sizeof(msgs[0]));
+
+    for (size_t i = 0; i < n; i++) {
+        iov[i].iov_base = pkts[i].buf;
+        iov[i].iov_len = pkts[i].cap;
+
+        struct msghdr *msg = &msgs[i].msg_hdr;
+        msg->msg_name = &pkts[i].addr;
+        msg->msg_namelen = sizeof(pkts[i].addr);
+        msg->msg_iov = &iov[i];
+        msg->msg_iovlen = 1;
+        msg->msg_control = control[i].buf;
+        msg->msg_controllen = sizeof(control[i].buf);
+    }
+
+    int got = recvmmsg(sockfd, msgs, (unsigned int)n, MSG_DONTWAIT, NULL);
+    if (got <= 0) {
+        return -1;
+    }
+
+    // Timestamps come per message; without one, all share the time we read them
+    for (int i = 0; i < got; i++) {
+        pkts[i].len = msgs[i].msg_len;
+        pkts[i].rx_us = net_cmsg_timestamp(&msgs[i].msg_hdr);
+    }
+
+    return got;
+}
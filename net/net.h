@@ -10,6 +10,18 @@
  *  - int net_tcp_connect(const struct sockaddr *sa, socklen_t slen, int timeout_ms)
  *  - int net_set_ttl(int sockfd, int ttl)
  *  - int net_icmp_raw_socket()
+ *  - int net_icmp_dgram_socket(uint16_t *id_out)
+ *  - int net_tcp_raw_socket()
+ *  - int net_bound_socket(int type, uint16_t *port_out)
+ *  - int net_source_addr(const struct sockaddr_in *dst, struct in_addr *src)
+ *  - int net_set_pmtu_probe(int sockfd)
+ *  - int net_route_mtu(const struct sockaddr_in *dst, int *mtu)
+ *  - int net_enable_timestamps(int sockfd)
+ *  - int net_attach_filter(int sockfd, const struct sock_filter *prog, size_t len)
+ *  - ssize_t net_recv_timestamped(int sockfd, void *buf, size_t len, struct sockaddr *from, socklen_t *fromlen, long long *rx_us)
+ *  - ssize_t net_recv_icmp_error(int sockfd, void *buf, size_t len, struct sockaddr_in *offender, int *type, int *code, long long *rx_us)
+ *  - int net_send_batch(int sockfd, const NetPacket *pkts, size_t n)
+ *  - int net_recv_batch(int sockfd, NetPacket *pkts, size_t n)
  * 
  * Aryan Verma, 400575438, McMaster University
  */
@@ -17,13 +29,48 @@
 #ifndef NET_H
 #define NET_H
 
+#include <stdint.h>
+#include <sys/types.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <linux/filter.h>
+
+// Most packets moved by one net_send_batch/net_recv_batch call
+#define NET_BATCH_MAX 64
+
+/*
+ * One packet of a sendmmsg()/recvmmsg() batch
+ *  - buf, cap: packet memory and its size (receive)
+ *  - len: bytes to send / bytes received
+ *  - addr: destination (send) or source (receive)
+ *  - ttl: IP TTL to send with
+ *  - rx_us: kernel receive timestamp in microseconds since the epoch
+ */
+typedef struct NetPacket {
+    void *buf;
+    size_t cap;
+    size_t len;
+    struct sockaddr_in addr;
+    int ttl;
+    long long rx_us;
+} NetPacket;
 
 int net_resolve(const char *host, struct sockaddr_storage *out, socklen_t *outlen);
 int net_tcp_connect(const struct sockaddr *sa, socklen_t slen, int timeout_ms);
 int net_set_ttl(int sockfd, int ttl);
 int net_icmp_raw_socket(void);
+int net_icmp_dgram_socket(uint16_t *id_out);
+int net_tcp_raw_socket(void);
+int net_bound_socket(int type, uint16_t *port_out);
+int net_source_addr(const struct sockaddr_in *dst, struct in_addr *src);
+int net_set_pmtu_probe(int sockfd);
+int net_route_mtu(const struct sockaddr_in *dst, int *mtu);
+int net_enable_timestamps(int sockfd);
+int net_attach_filter(int sockfd, const struct sock_filter *prog, size_t len);
+ssize_t net_recv_timestamped(int sockfd, void *buf, size_t len, struct sockaddr *from, socklen_t *fromlen, long long *rx_us);
+ssize_t net_recv_icmp_error(int sockfd, void *buf, size_t len, struct sockaddr_in *offender, int *type, int *code, long long *rx_us);
+int net_send_batch(int sockfd, const NetPacket *pkts, size_t n);
+int net_recv_batch(int sockfd, NetPacket *pkts, size_t n);
 
 #endif 
 
@@ -0,0 +1,573 @@
+/*
+ * File: sweep.c
+ * Implements the ICMP ping sweep of a CIDR block (--scan --subnet)
+ *
+ * This file finds live hosts in a subnet and measures loss and RTT for each of them
+ * Every address gets cfg->count Echo Requests; replies are matched back to the
+ * request that caused them and folded into per-host statistics
+ *
+ * Implementation Notes:
+ *  - Requests are interleaved: round 0 goes to every host, then round 1, and so on,
+ *    so the requests to one host are spread over the whole sweep instead of bunched
+ *  - A single socket sends at cfg->rate requests per second in sendmmsg() batches
+ *    and drains replies with recvmmsg() between batches (no thread per host)
+ *  - Demultiplexing needs no lookup: the source address gives the host index and
+ *    the Echo sequence number gives the round
+ *  - Uses an unprivileged ping socket when ping_group_range allows it, raw ICMP otherwise
+ *
+ * Why not a loop of pings?
+ *  - Waiting for each reply (or timeout) in turn costs hosts * count * timeout:
+ *    hours for a /16. Here the sweep costs hosts * count / rate plus one timeout
+ *
+ * Aryan Verma, 400575438, McMaster University
+ */
+
+#include "sweep.h"
+#include "../net/net.h"
+#include "../tracer/icmp.h"
+#include "../timeutil/timeutil.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <math.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/ip_icmp.h>
+#include <arpa/inet.h>
+
+// Echo payload bytes (same as ping's default)
+#define SWEEP_PAYLOAD_LEN 56
+
+// How long to wait for late replies after the last request (milliseconds)
+#define SWEEP_TIMEOUT_MS 1000
+
+// Bytes per receive slot (IP header + Echo Reply with our payload)
+#define SWEEP_RX_SLOT_LEN 256
+
+// Receive buffer asked for, so reply bursts from a big subnet are not dropped
+#define SWEEP_RCVBUF (4 * 1024 * 1024)
+
+// Send buffer asked for: requests to unresolved on-link neighbours sit in it until ARP gives up
+#define SWEEP_SNDBUF (4 * 1024 * 1024)
+
+// How long sends may stay blocked (full buffers) before due requests are counted as lost
+#define SWEEP_STALL_MS 100
+
+// TTL of the Echo Requests
+#define SWEEP_TTL 64
+
+/*
+ * Running statistics for one address
+ *  - received: replies matched so far
+ *  - min_us, max_us: RTT extremes
+ *  - sum_us, sumsq_us: sums for the mean and standard deviation
+ */
+typedef struct {
+    unsigned long received;
+    long min_us, max_us;
+    double sum_us, sumsq_us;
+} SweepHost;
+
+/*
+ * Sweep state shared by the send and receive paths
+ *  - first, nhosts: addresses first .. first + nhosts - 1 (host order)
+ *  - sent_us: send time per request, indexed round * nhosts + host (0 = answered or unsent)
+ *  - pkts: one finished Echo Request per round (only the destination differs per host)
+ *  - stall_us: when sends started failing with a full buffer (0 = not stalled)
+ */
+typedef struct {
+    int fd;
+    bool dgram;
+    uint16_t id;
+    uint32_t first;
+    uint32_t nhosts;
+    int count;
+    long long *sent_us;
+    SweepHost *hosts;
+    unsigned char (*pkts)[sizeof(struct icmphdr) + SWEEP_PAYLOAD_LEN];
+    size_t pkt_len;
+    unsigned long sent, replies;
+    long long stall_us;
+} SweepState;
+
+/*
+ * Function: parse_cidr
+ *
+ * Purpose: Turn "a.b.c.d/len" into the range of addresses to probe
+ *          The network and broadcast addresses are skipped for blocks bigger than /31
+ *
+ * Parameters:
+ *   cidr   - The block as given on the command line
+ *   first  - First address to probe (host order)
+ *   nhosts - Number of addresses to probe
+ *
+ * Returns: 0 on success, -1 on invalid input
+ */
+static int parse_cidr(const char *cidr, uint32_t *first, uint32_t *nhosts) {
+
+    char addr_str[INET_ADDRSTRLEN];
+    const char *slash = strchr(cidr, '/');
+
+    if (!slash || (size_t)(slash - cidr) >= sizeof(addr_str)) {
+        fprintf(stderr, "Error: --subnet must be in CIDR form (ex, 192.168.1.0/24)\n");
+        return -1;
+    }
+
+    memcpy(addr_str, cidr, (size_t)(slash - cidr));
+    addr_str[slash - cidr] = '\0';
+
+    struct in_addr addr;
+    if (inet_pton(AF_INET, addr_str, &addr) != 1) {
+        fprintf(stderr, "Error: Invalid subnet address '%s'\n", addr_str);
+        return -1;
+    }
+
+    char *endptr;
+    long prefix = strtol(slash + 1, &endptr, 10);
+
+    if (endptr == slash + 1 || *endptr != '\0' || prefix < SWEEP_MIN_PREFIX || prefix > 32) {
+        fprintf(stderr, "Error: Subnet prefix must be /%d to /32\n", SWEEP_MIN_PREFIX);
+        return -1;
+    }
+
+    // Mask off any host bits the user left in (192.168.1.7/24 means 192.168.1.0/24)
+    uint32_t size = 1U << (32 - prefix);
+    uint32_t net = ntohl(addr.s_addr) & ~(size - 1);
+
+    if (prefix <= 30) {
+        *first = net + 1;
+        *nhosts = size - 2;
+    } else {
+        *first = net;
+        *nhosts = size;
+    }
+
+    return 0;
+}
+
+/*
+ * Function: sweep_open
+ *
+ * Purpose: Open the Echo socket (ping socket if allowed, raw otherwise)
+ *
+ * Parameters:
+ *   st - Sweep state (fd, dgram and id are filled in)
+ *
+ * Returns: 0 on success, -1 on error (message already printed)
+ */
+static int sweep_open(SweepState *st) {
+
+    st->fd = net_icmp_dgram_socket(&st->id);
+    st->dgram = st->fd >= 0;
+
+    if (st->dgram) {
+        // Unreachable errors for dead hosts would otherwise fail our next send;
+        // without IP_RECVERR the kernel drops them for unconnected ping sockets
+        int off = 0;
+        setsockopt(st->fd, IPPROTO_IP, IP_RECVERR, &off, sizeof(off));
+    } else {
+        st->fd = net_icmp_raw_socket();
+        if (st->fd < 0) {
+            return -1;
+        }
+
+        st->id = (uint16_t)(getpid() & 0xFFFF);
+
+        // Only Echo Replies with our identifier get queued
+        struct sock_filter filter[ICMP_FILTER_LEN];
+        if (icmp_build_filter(IPPROTO_ICMP, st->id, true, filter, ICMP_FILTER_LEN) == ICMP_FILTER_LEN) {
+            net_attach_filter(st->fd, filter, ICMP_FILTER_LEN);
+        }
+    }
+
+    // Both are best effort: without them RTTs are a little less precise, and
+    // replies may be dropped on very fast sweeps
+    net_enable_timestamps(st->fd);
+
+    // The FORCE variants (root only) may exceed net.core.rmem_max/wmem_max
+    int rcvbuf = SWEEP_RCVBUF;
+    if (setsockopt(st->fd, SOL_SOCKET, SO_RCVBUFFORCE, &rcvbuf, sizeof(rcvbuf)) < 0) {
+        setsockopt(st->fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    }
+
+    int sndbuf = SWEEP_SNDBUF;
+    if (setsockopt(st->fd, SOL_SOCKET, SO_SNDBUFFORCE, &sndbuf, sizeof(sndbuf)) < 0) {
+        setsockopt(st->fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+    }
+
+    return 0;
+}
+
+/*
+ * Function: sweep_send
+ *
+ * Purpose: Send requests [next, end) in one sendmmsg() batch (at most NET_BATCH_MAX)
+ *
+ * Parameters:
+ *   st   - Sweep state
+ *   next - Index of the first request (round * nhosts + host)
+ *   end  - One past the last request that is due
+ *
+ * Returns: Number of requests used up (0 = the socket is full, try again later), -1 on error
+ *
+ * Note: a full buffer usually means requests to dead on-link hosts are waiting for ARP,
+ *       which takes seconds to fail. After SWEEP_STALL_MS of that, due requests are
+ *       counted as lost instead of holding up the whole sweep
+ */
+static long sweep_send(SweepState *st, unsigned long next, unsigned long end) {
+
+    NetPacket batch[NET_BATCH_MAX];
+    size_t n = 0;
+    long long now = us_now();
+
+    while (next + n < end && n < NET_BATCH_MAX) {
+        unsigned long probe = next + n;
+        uint32_t host = (uint32_t)(probe % st->nhosts);
+        int round = (int)(probe / st->nhosts);
+
+        memset(&batch[n], 0, sizeof(batch[n]));
+        batch[n].buf = st->pkts[round];
+        batch[n].len = st->pkt_len;
+        batch[n].addr.sin_family = AF_INET;
+        batch[n].addr.sin_addr.s_addr = htonl(st->first + host);
+        batch[n].ttl = SWEEP_TTL;
+
+        st->sent_us[probe] = now;
+        n++;
+    }
+
+    int sent = net_send_batch(st->fd, batch, n);
+
+    if (sent > 0) {
+        st->sent += (unsigned long)sent;
+        st->stall_us = 0;
+
+        // Anything after a partial send goes out with the next batch
+        for (size_t i = (size_t)sent; i < n; i++) {
+            st->sent_us[next + i] = 0;
+        }
+        return sent;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        st->sent_us[next + i] = 0;
+    }
+
+    // Queue or neighbour table full: back off, then give up on the request
+    if (errno == EAGAIN || errno == ENOBUFS) {
+        if (st->stall_us == 0) {
+            st->stall_us = now;
+        }
+        return (now - st->stall_us < (long long)SWEEP_STALL_MS * 1000LL) ? 0 : 1;
+    }
+
+    // The first request was refused (no route, etc.): count it as lost and move on
+    if (errno == ENETUNREACH || errno == EHOSTUNREACH || errno == EACCES || errno == EPERM) {
+        return 1;
+    }
+
+    perror("sendmmsg");
+    return -1;
+}
+
+/*
+ * Function: sweep_receive
+ *
+ * Purpose: Drain every queued reply and fold it into the per-host statistics
+ *
+ * Parameters:
+ *   st    - Sweep state
+ *   arena - NET_BATCH_MAX receive slots of SWEEP_RX_SLOT_LEN bytes
+ */
+static void sweep_receive(SweepState *st, unsigned char *arena) {
+
+    NetPacket batch[NET_BATCH_MAX];
+    int got;
+
+    for (size_t i = 0; i < NET_BATCH_MAX; i++) {
+        batch[i].buf = arena + i * SWEEP_RX_SLOT_LEN;
+        batch[i].cap = SWEEP_RX_SLOT_LEN;
+    }
+
+    while ((got = net_recv_batch(st->fd, batch, NET_BATCH_MAX)) > 0) {
+
+        for (int i = 0; i < got; i++) {
+            NetPacket *pkt = &batch[i];
+
+            // Ping sockets deliver the ICMP message alone, raw sockets include the IP header
+            IcmpReply reply;
+            int rc = st->dgram ? icmp_parse_dgram_reply(pkt->buf, pkt->len, &reply)
+                               : icmp_parse_reply(pkt->buf, pkt->len, &reply);
+
+            if (rc != 0 || reply.type != ICMP_ECHOREPLY || reply.id != st->id || reply.seq >= st->count) {
+                continue;
+            }
+
+            // Source address -> host, sequence number -> round
+            uint32_t host = ntohl(pkt->addr.sin_addr.s_addr) - st->first;
+            if (host >= st->nhosts) {
+                continue;
+            }
+
+            unsigned long probe = (unsigned long)reply.seq * st->nhosts + host;
+
+            // 0: never sent, or a duplicate of a reply we already counted
+            if (st->sent_us[probe] == 0) {
+                continue;
+            }
+
+            long long rx_us = pkt->rx_us > 0 ? pkt->rx_us : us_now();
+            long rtt = (long)(rx_us - st->sent_us[probe]);
+            if (rtt < 0) {
+                rtt = 0;
+            }
+
+            st->sent_us[probe] = 0;
+            st->replies++;
+
+            SweepHost *h = &st->hosts[host];
+            if (h->received == 0 || rtt < h->min_us) {
+                h->min_us = rtt;
+            }
+            if (h->received == 0 || rtt > h->max_us) {
+                h->max_us = rtt;
+            }
+            h->received++;
+            h->sum_us += (double)rtt;
+            h->sumsq_us += (double)rtt * (double)rtt;
+        }
+    }
+}
+
+/*
+ * Function: sweeptable_add
+ *
+ * Purpose: Add one host's statistics to the table (grows the array if needed)
+ *
+ * Parameters:
+ *   t   - Pointer to SweepTable
+ *   row - Pointer to HostPing to copy in
+ *
+ * Returns: 0 on success, -1 on memory allocation failure
+ */
+static int sweeptable_add(SweepTable *t, const HostPing *row) {
+    // Check if we need to grow the array
+    if (t->len >= t->cap) {
+        size_t new_cap = t->cap ? t->cap * 2 : 64;
+
+        HostPing *new_rows = realloc(t->rows, new_cap * sizeof(HostPing));
+        if (!new_rows) {
+            fprintf(stderr, "Error: Memory reallocation failed for SweepTable\n");
+            return -1;
+        }
+
+        t->rows = new_rows;
+        t->cap = new_cap;
+    }
+
+    t->rows[t->len++] = *row;
+    return 0;
+}
+
+/*
+ * Function: sweeptable_free
+ *
+ * Purpose: Free memory allocated for a SweepTable
+ * Parameters: t - Pointer to SweepTable to free
+ */
+void sweeptable_free(SweepTable *t) {
+    if (t && t->rows) {
+        free(t->rows);
+        t->rows = NULL;
+        t->len = 0;
+        t->cap = 0;
+    }
+}
+
+/*
+ * Function: sweep_close
+ *
+ * Purpose: Release the socket and buffers of a sweep
+ * Parameters: st - Sweep state
+ */
+static void sweep_close(SweepState *st) {
+    if (st->fd >= 0) {
+        close(st->fd);
+    }
+    free(st->sent_us);
+    free(st->hosts);
+    free(st->pkts);
+}
+
+/*
+ * Function: sweep_run
+ *
+ * Purpose: Ping every address of cfg->subnet cfg->count times and collect statistics
+ *
+ * Parameters:
+ *   cfg - CommandLine configuration containing subnet, count and rate
+ *   out - Pointer to SweepTable to store results (hosts that replied)
+ *
+ * Returns: 0 on success, -1 on error
+ */
+int sweep_run(const CommandLine *cfg, SweepTable *out) {
+    // Check for NULL pointers
+    if (!cfg || !out) {
+        fprintf(stderr, "Error: NULL pointer passed to sweep_run\n");
+        return -1;
+    }
+
+    SweepState st;
+    memset(&st, 0, sizeof(st));
+    st.fd = -1;
+    st.count = cfg->count;
+
+    if (parse_cidr(cfg->subnet, &st.first, &st.nhosts) < 0) {
+        return -1;
+    }
+
+    // One send time per request, statistics per host, one packet per round
+    unsigned long total = (unsigned long)st.nhosts * (unsigned long)st.count;
+    st.sent_us = calloc(total, sizeof(long long));
+    st.hosts = calloc(st.nhosts, sizeof(SweepHost));
+    st.pkts = calloc((size_t)st.count, sizeof(*st.pkts));
+    unsigned char *arena = malloc(NET_BATCH_MAX * SWEEP_RX_SLOT_LEN);
+
+    if (!st.sent_us || !st.hosts || !st.pkts || !arena) {
+        fprintf(stderr, "Error: Memory allocation failed for sweep state\n");
+        free(arena);
+        sweep_close(&st);
+        return -1;
+    }
+
+    if (sweep_open(&st) < 0) {
+        free(arena);
+        sweep_close(&st);
+        return -1;
+    }
+
+    // Every host gets the same packet in a given round: build them once
+    unsigned char payload[SWEEP_PAYLOAD_LEN];
+    for (size_t i = 0; i < sizeof(payload); i++) {
+        payload[i] = (unsigned char)i;
+    }
+
+    for (int round = 0; round < st.count; round++) {
+        icmp_build_echo(st.id, (uint16_t)round, payload, sizeof(payload), st.pkts[round], &st.pkt_len);
+    }
+
+    // Pace by elapsed time: request i is due at start + i / rate
+    unsigned long next = 0;
+    long long start = us_now();
+    long long end = 0;
+    bool backoff = false;
+    int rc = 0;
+
+    while (1) {
+        long long now = us_now();
+
+        backoff = false;
+
+        if (next < total) {
+            unsigned long due = (unsigned long)((double)(now - start) * cfg->rate / 1e6) + 1;
+            if (due > total) {
+                due = total;
+            }
+
+            while (next < due) {
+                long used = sweep_send(&st, next, due);
+                if (used < 0) {
+                    rc = -1;
+                    break;
+                }
+                if (used == 0) {
+                    backoff = true;
+                    break;
+                }
+                next += (unsigned long)used;
+            }
+
+            if (rc < 0) {
+                break;
+            }
+
+            // Last request out: give the replies one timeout to come back
+            if (next == total) {
+                end = us_now() + (long long)SWEEP_TIMEOUT_MS * 1000LL;
+            }
+        }
+
+        sweep_receive(&st, arena);
+
+        now = us_now();
+        if (next == total && (st.replies == st.sent || now >= end)) {
+            break;
+        }
+
+        // Sleep until the next request is due or the final timeout expires
+        long long wake = (next < total) ? start + (long long)((double)next * 1e6 / cfg->rate) : end;
+        int wait_ms = (wake > now) ? (int)((wake - now + 999) / 1000) : 0;
+
+        // Blocked sends: give the kernel a moment instead of spinning
+        if (backoff && wait_ms < 1) {
+            wait_ms = 1;
+        }
+
+        struct pollfd pfd = { .fd = st.fd, .events = POLLIN };
+        if (poll(&pfd, 1, wait_ms) < 0 && errno != EINTR) {
+            perror("poll");
+            rc = -1;
+            break;
+        }
+    }
+
+    free(arena);
+
+    if (rc < 0) {
+        sweep_close(&st);
+        return -1;
+    }
+
+    // Report hosts that answered at least once, in address order
+    strncpy(out->subnet, cfg->subnet, sizeof(out->subnet) - 1);
+    out->subnet[sizeof(out->subnet) - 1] = '\0';
+    out->hosts = st.nhosts;
+    out->count = st.count;
+
+    for (uint32_t i = 0; i < st.nhosts; i++) {
+        const SweepHost *h = &st.hosts[i];
+        if (h->received == 0) {
+            continue;
+        }
+
+        HostPing row;
+        memset(&row, 0, sizeof(row));
+
+        struct in_addr addr;
+        addr.s_addr = htonl(st.first + i);
+        inet_ntop(AF_INET, &addr, row.ip, sizeof(row.ip));
+
+        row.sent = (unsigned long)st.count;
+        row.received = h->received;
+        row.min_us = h->min_us;
+        row.max_us = h->max_us;
+        row.avg_us = h->sum_us / (double)h->received;
+
+        // mdev as ping prints it: sqrt(E[rtt^2] - E[rtt]^2)
+        double var = h->sumsq_us / (double)h->received - row.avg_us * row.avg_us;
+        row.mdev_us = var > 0 ? sqrt(var) : 0.0;
+
+        if (sweeptable_add(out, &row) < 0) {
+            sweep_close(&st);
+            sweeptable_free(out);
+            return -1;
+        }
+    }
+
+    sweep_close(&st);
+    return 0;
+}
@@ -0,0 +1,43 @@
+/*
+ * File: sweep.h
+ * Summary: Public API for the ICMP ping sweep of a subnet (host discovery)
+ *
+ * Responsibilities:
+ *  - Send N ICMP Echo Requests to every address of a CIDR block
+ *  - Interleave the requests across the whole block at a paced rate
+ *  - Match replies to hosts by (id, seq, source address)
+ *  - Report sent/received/loss and min/avg/max/mdev RTT per responding host
+ *
+ * Data & Types:
+ *  - typedef struct HostPing { char ip[64]; unsigned long sent, received; long min_us, max_us; double avg_us, mdev_us; }
+ *  - typedef struct SweepTable { HostPing *rows; size_t len, cap; char subnet[64]; unsigned long hosts; int count; }
+ *
+ * Public API:
+ *  - int  sweep_run(const CommandLine *cfg, SweepTable *out);
+ *  - void sweeptable_free(SweepTable *t);
+ *
+ * Inputs:
+ *  - cfg->subnet (a.b.c.d/len, len >= SWEEP_MIN_PREFIX), cfg->count, cfg->rate
+ * Outputs:
+ *  - out->rows: one entry per host that answered at least once, in address order
+ *
+ * Returns:
+ *  - 0 on success
+ *  - -1 on error (bad CIDR, no socket permissions, etc.)
+ *
+ * Aryan Verma, 400575438, McMaster University
+ */
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include "../cli/cli.h"
+#include "../model/model.h"
+
+// Largest block swept at once (/16 = 65536 addresses)
+#define SWEEP_MIN_PREFIX 16
+
+int sweep_run(const CommandLine *cfg, SweepTable *out);
+void sweeptable_free(SweepTable *t);
+
+#endif
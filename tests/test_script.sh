@@ -571,7 +571,7 @@ run_test "./wirefish --monitor --iface lo --interval 200 --json" 0 "\"type\":\"m
 run_test "./wirefish --monitor --iface lo --interval 200 --csv" 0 "iface,rx_bytes,tx_bytes" ""
 
 # 153 - monitor invalid interface should report not found
-run_test "./wirefish --monitor --iface notreal123 --interval 200" 1 "" "not found in /proc/net/dev"
+run_test "./wirefish --monitor --iface notreal123 --interval 200 --stats procfs" 1 "" "not found in /proc/net/dev"
 
 # 154 - monitor interval = 0 should error
 run_test "./wirefish --monitor --iface lo --interval 0" 1 "" "Interval must be positive"
@@ -697,7 +697,7 @@ run_test "./wirefish --scan --target 127.0.0.1 --ports 1-1 --json" 0 "\"latency_
 run_test "./wirefish --monitor --iface lo --interval 200" 0 "RX_BYTES" ""
 
 # 195  empty iface string: monitor_run should say interface not found
-run_test "./wirefish --monitor --interval 200 --iface \"\"" 1 "" "not found in /proc/net/dev"
+run_test "./wirefish --monitor --interval 200 --stats procfs --iface \"\"" 1 "" "not found in /proc/net/dev"
 
 # 196  empty target string: scanner_run attempts DNS and fails
 run_test "./wirefish --scan --target \"\" --ports 80-80" 1 "" "Failed to resolve target"
@@ -1468,6 +1468,439 @@ run_test "./wirefish --monitor --interval 50 --iface lo" 0 "IFACE" ""
 run_test "./wirefish --monitor --interval 50 --iface lo --json" 0 "monitor" ""
 run_test "./wirefish --monitor --interval 50 --iface lo --csv" 0 "iface,rx_bytes" ""
 
+#######################################
+# continuous trace (--continuous / --cycles)
+#######################################
+
+# 482 - --cycles needs a value
+run_test "./wirefish --trace --target 127.0.0.1 --continuous --cycles" 1 "" "Error: --cycles requires"
+
+# 483 - --cycles must be a number
+run_test "./wirefish --trace --target 127.0.0.1 --continuous --cycles abc" 1 "" "Invalid --cycles value"
+
+# 484 - --cycles cannot be negative
+run_test "./wirefish --trace --target 127.0.0.1 --continuous --cycles -3" 1 "" "--cycles must be between"
+
+# 485 - help lists the continuous option
+run_test "./wirefish --help" 0 "--continuous" ""
+
+# 486 - continuous trace still needs a target
+run_test "./wirefish --trace --continuous --cycles 2" 1 "" "Error: --target required for trace mode"
+
+#######################################
+# paris / ecmp enumeration
+#######################################
+
+# 487 - --flows needs a value
+run_test "./wirefish --trace --target 127.0.0.1 --enumerate --flows" 1 "" "Error: --flows requires"
+
+# 488 - --flows must be a number
+run_test "./wirefish --trace --target 127.0.0.1 --enumerate --flows x1" 1 "" "Invalid --flows value"
+
+# 489 - zero probe budget is rejected
+run_test "./wirefish --trace --target 127.0.0.1 --enumerate --flows 0" 1 "" "--flows must be in range"
+
+# 490 - enumeration has no continuous form
+run_test "./wirefish --trace --target 127.0.0.1 --enumerate --continuous" 1 "" "Cannot combine --enumerate with --continuous"
+
+# 491 - help lists paris mode
+run_test "./wirefish --help" 0 "--paris" ""
+
+# 492 - --proto needs a value
+run_test "./wirefish --trace --target 127.0.0.1 --proto" 1 "" "Error: --proto requires"
+
+# 493 - unknown probe type is rejected
+run_test "./wirefish --trace --target 127.0.0.1 --proto sctp" 1 "" "Invalid --proto value"
+
+# 494 - --port must be a valid port
+run_test "./wirefish --trace --target 127.0.0.1 --proto tcp --port 70000" 1 "" "--port must be in range"
+
+# 495 - --port has no meaning for ICMP probes
+run_test "./wirefish --trace --target 127.0.0.1 --port 443" 1 "" "--port requires --proto udp or --proto tcp"
+
+# 496 - Paris mode is ICMP only
+run_test "./wirefish --trace --target 127.0.0.1 --proto udp --paris" 1 "" "require --proto icmp"
+
+# 497 - help lists probe types
+run_test "./wirefish --help" 0 "--proto" ""
+
+# 498 - loopback trace (ping socket when ping_group_range allows, raw socket as root)
+run_test "./wirefish --trace --target 127.0.0.1 --ttl 1-2 --csv" 0 "127.0.0.1" ""
+
+# 499 - PMTU discovery is its own kind of trace
+run_test "./wirefish --trace --target 127.0.0.1 --pmtu --continuous" 1 "" "--pmtu cannot be combined"
+
+# 500 - several targets only make sense for PMTU discovery
+run_test "./wirefish --trace --target 127.0.0.1,127.0.0.2" 1 "" "Multiple targets require --pmtu"
+
+# 501 - empty entries in the target list are rejected
+run_test "./wirefish --trace --pmtu --target 127.0.0.1,,127.0.0.2" 1 "" "comma-separated targets"
+
+# 502 - loopback carries the largest IPv4 datagram (raw socket, needs root)
+run_test "./wirefish --trace --pmtu --target 127.0.0.1,127.0.0.2 --json" 0 "\"pmtu\":65535" ""
+
+# 503 - help lists PMTU mode
+run_test "./wirefish --help" 0 "--pmtu" ""
+
+# 504 - ping sweep of a small loopback block (ping socket or raw socket)
+run_test "./wirefish --scan --subnet 127.0.0.0/30 --count 2 --csv" 0 "127.0.0.2,2,2,0.0" ""
+
+# 505 - summary line counts the hosts that answered
+run_test "./wirefish --scan --subnet 127.0.0.0/29 --count 1" 0 "6 of 6 hosts up" ""
+
+# 506 - JSON carries sweep totals
+run_test "./wirefish --scan --subnet 127.0.0.8/31 --count 1 --json" 0 "\"hosts\":2,\"hosts_up\":2" ""
+
+# 507 - blocks bigger than a /16 are refused
+run_test "./wirefish --scan --subnet 10.0.0.0/8" 1 "" "Subnet prefix must be /16 to /32"
+
+# 508 - --subnet needs CIDR notation
+run_test "./wirefish --scan --subnet 10.0.0.1" 1 "" "CIDR form"
+
+# 509 - port scan target and sweep block are exclusive
+run_test "./wirefish --scan --target 127.0.0.1 --subnet 127.0.0.0/30" 1 "" "Cannot use both --target and --subnet"
+
+# 510 - --subnet is a scan option
+run_test "./wirefish --trace --subnet 127.0.0.0/30" 1 "" "--subnet is only valid with --scan"
+
+# 511 - --count range
+run_test "./wirefish --scan --subnet 127.0.0.0/30 --count 0" 1 "" "--count must be in range 1-100"
+
+# 512 - --rate range
+run_test "./wirefish --scan --subnet 127.0.0.0/30 --rate 0" 1 "" "--rate must be in range"
+
+# 513 - loopback targets merge into one graph rooted at this host
+run_test "./wirefish --trace --graph --target 127.0.0.1,127.0.0.2" 0 "2 traces" ""
+
+# 514 - DOT output is a Graphviz digraph
+run_test "./wirefish --trace --graph --target 127.0.0.2 --dot" 0 "digraph wirefish" ""
+
+# 515 - JSON lists nodes with adjacency and edges
+run_test "./wirefish --trace --graph --target 127.0.0.2 --json" 0 "\"type\":\"topology\"" ""
+
+# 516 - targets can come from a file, one per line
+printf '# loopback\n127.0.0.2\n127.0.0.3\n' > tmp_targets
+run_test "./wirefish --trace --graph --target @tmp_targets --csv" 0 "127.0.0.3" ""
+rm -f tmp_targets
+
+# 517 - --dot belongs to --graph
+run_test "./wirefish --trace --target 127.0.0.1 --dot" 1 "" "--dot is only valid with --trace --graph"
+
+# 518 - --dot cannot be mixed with another format
+run_test "./wirefish --trace --graph --target 127.0.0.1 --dot --json" 1 "" "Cannot combine --dot"
+
+# 519 - the graph merges ordinary traces only
+run_test "./wirefish --trace --graph --pmtu --target 127.0.0.1" 1 "" "--graph cannot be combined"
+
+# 520 - the hop cache can be turned off (every TTL probed for every target)
+run_test "./wirefish --trace --graph --target 127.0.0.2,127.0.0.3 --no-hop-cache" 0 "2 traces" ""
+
+# 521 - a single trace is unaffected by the switch
+run_test "./wirefish --trace --target 127.0.0.1 --no-hop-cache" 0 "DEST" ""
+
+# 522 - help lists the hop cache switch
+run_test "./wirefish --help" 0 "--no-hop-cache" ""
+
+# 523 - --asn tags each hop with the most specific matching route
+printf '127.0.0.0/8,64500\n127.0.0.0/24,AS64501\n' > tmp_asn
+run_test "./wirefish --trace --target 127.0.0.1 --asn tmp_asn" 0 "AS64501" ""
+
+# 524 - pfx2as (tab separated) dumps work too, and JSON carries the prefix
+printf '127.0.0.0\t8\t64500\n' > tmp_asn
+run_test "./wirefish --trace --target 127.0.0.1 --asn tmp_asn --json" 0 "\"prefix\":\"127.0.0.0/8\"" ""
+
+# 525 - sweep hosts are tagged as well
+run_test "./wirefish --scan --subnet 127.0.0.0/30 --asn tmp_asn --csv" 0 ",64500,127.0.0.0/8" ""
+rm -f tmp_asn
+
+# 526 - a missing table fails before probing
+run_test "./wirefish --trace --target 127.0.0.1 --asn tmp_no_such_table" 1 "" "cannot open AS table"
+
+# 527 - a table without a single route is rejected
+printf 'not a route\n' > tmp_asn
+run_test "./wirefish --scan --target 127.0.0.1 --ports 80-80 --asn tmp_asn" 1 "" "no routes found"
+rm -f tmp_asn
+
+# 528 - --asn has nothing to tag in monitor mode or continuous traces
+run_test "./wirefish --monitor --asn tmp_asn" 1 "" "--asn is only valid with --scan or --trace"
+run_test "./wirefish --trace --continuous --target 127.0.0.1 --asn tmp_asn" 1 "" "--asn cannot be combined"
+
+# 529 - --queries sends several probes per TTL and shows every RTT
+run_test "./wirefish --trace --target 127.0.0.1 --queries 3" 0 "DEST" ""
+
+# 530 - CSV lists every probe's RTT and responder
+run_test "./wirefish --trace --target 127.0.0.1 --queries 2 --csv" 0 "rtts_ms,responders" ""
+
+# 531 - JSON carries one entry per probe
+run_test "./wirefish --trace --target 127.0.0.1 --queries 2 --json" 0 "\"probes\":[{\"ip\":\"127.0.0.1\"" ""
+
+# 532 - --queries range is enforced
+run_test "./wirefish --trace --target 127.0.0.1 --queries 11" 1 "" "--queries must be in range 1-10"
+run_test "./wirefish --trace --target 127.0.0.1 --queries 0" 1 "" "--queries must be in range"
+
+# 533 - modes that pace their own probes reject --queries
+run_test "./wirefish --trace --target 127.0.0.1 --queries 3 --continuous" 1 "" "--queries cannot be combined"
+
+# 534 - the persistent /proc/net/dev reader finds the interface
+run_test "./wirefish --monitor --iface lo --interval 50" 0 "lo " ""
+
+# 535 - 1 ms sampling works with the pread reader
+run_test "./wirefish --monitor --iface lo --interval 1 --csv" 0 "lo," ""
+
+# 536 - an interface missing from /proc/net/dev is still reported
+run_test "./wirefish --monitor --iface nosuchif0 --interval 50" 1 "" "Interface 'nosuchif0' not found"
+
+# 537 - both counter backends can be chosen explicitly
+run_test "./wirefish --monitor --iface lo --stats netlink --interval 50" 0 "lo " ""
+run_test "./wirefish --monitor --iface lo --stats procfs --interval 50 --json" 0 "\"rx_packets\":" ""
+
+# 538 - monitor output carries packet, error and drop counters
+run_test "./wirefish --monitor --iface lo --interval 50 --csv" 0 "rx_packets,tx_packets,rx_errors,tx_errors,rx_dropped,tx_dropped,multicast" ""
+
+# 539 - --stats values and mode are validated
+run_test "./wirefish --monitor --iface lo --stats sysfs" 1 "" "Invalid --stats value"
+run_test "./wirefish --trace --target 127.0.0.1 --stats netlink" 1 "" "--stats is only valid with --monitor"
+
+# 540 - netlink picks up interfaces in another namespace (root only)
+if [ "$(id -u)" = 0 ] && ip netns add wftest 2>/dev/null; then
+    ip -n wftest link add wfa type veth peer name wfb
+    ip -n wftest link set wfa up
+    ip -n wftest link set wfb up
+    run_test "ip netns exec wftest ./wirefish --monitor --iface wfa --stats netlink --interval 50" 0 "wfa " ""
+    run_test "ip netns exec wftest ./wirefish --monitor --iface wfb --stats procfs --interval 50" 0 "wfb " ""
+    # Renamed in place (same ifindex): the new name is picked up from the link notification
+    ip netns exec wftest ./wirefish --monitor --iface wfa,wfc --stats netlink --interval 20 --duration 1 --csv > tmp_rename 2>&1 &
+    sleep 0.4
+    ip -n wftest link set wfa down
+    ip -n wftest link set wfa name wfc
+    ip -n wftest link set wfc up
+    wait
+    run_test "cat tmp_rename" 0 "wfc," ""
+    rm -f tmp_rename
+    ip netns del wftest
+fi
+
+# 541 - --iface all watches every interface from one sample
+run_test "./wirefish --monitor --iface all --interval 50 --csv" 0 "lo," ""
+
+# 542 - glob lists match several interfaces; no match is an error
+run_test "./wirefish --monitor --iface l*,nosuch0 --interval 50" 0 "lo " ""
+run_test "./wirefish --monitor --iface zzz* --interval 50" 1 "" "Interface pattern 'zzz*' matches no interface"
+
+# 543 - --group orders output by interface and needs --monitor
+run_test "./wirefish --monitor --iface all --group --interval 50 --json" 0 "\"type\":\"monitor\"" ""
+run_test "./wirefish --trace --target 127.0.0.1 --group" 1 "" "--group is only valid with --monitor"
+
+# 544 - several interfaces in another namespace, grouped (root only)
+if [ "$(id -u)" = 0 ] && ip netns add wftest 2>/dev/null; then
+    ip -n wftest link add wfa type veth peer name wfb
+    ip -n wftest link set wfa up
+    ip -n wftest link set wfb up
+    run_test "ip netns exec wftest ./wirefish --monitor --iface wf* --group --interval 50 --csv" 0 "wfa," ""
+    run_test "ip netns exec wftest ./wirefish --monitor --iface wf* --group --interval 50 --csv" 0 "wfb," ""
+    ip netns del wftest
+fi
+
+# 545 - monitor output carries EWMA, window min/max and stddev
+run_test "./wirefish --monitor --iface lo --interval 50 --csv" 0 "rx_ewma_bps,tx_ewma_bps,rx_min_bps,rx_max_bps,tx_min_bps,tx_max_bps,rx_stddev_bps,tx_stddev_bps" ""
+run_test "./wirefish --monitor --iface lo --interval 50 --json --window 5000 --alpha 0.05" 0 "\"rx_stddev_bps\":" ""
+
+# 546 - --window and --alpha are range checked
+run_test "./wirefish --monitor --iface lo --window 0" 1 "" "--window must be in range 1-1000000"
+run_test "./wirefish --monitor --iface lo --alpha 0" 1 "" "Invalid --alpha value '0'"
+run_test "./wirefish --monitor --iface lo --alpha 1.5" 1 "" "Invalid --alpha value '1.5'"
+run_test "./wirefish --monitor --iface lo --alpha nan" 1 "" "Invalid --alpha value 'nan'"
+
+# 547 - --window and --alpha need --monitor
+run_test "./wirefish --trace --target 127.0.0.1 --window 5" 1 "" "--window and --alpha are only valid with --monitor"
+
+# 548 - the timerfd clock reports its tick count and overruns
+run_test "./wirefish --monitor --iface lo --interval 50 --json" 0 "\"ticks\":10,\"missed_ticks\":" ""
+
+# 549 - monitor intervals may be fractions of a millisecond
+run_test "./wirefish --monitor --iface lo --interval 0.5 --csv" 0 "lo," ""
+
+# 550 - other modes still pace in whole milliseconds
+run_test "./wirefish --trace --target 127.0.0.1 --continuous --interval 0.5" 1 "" "Fractional --interval is only valid with --monitor"
+
+# 551 - interval bounds
+run_test "./wirefish --monitor --iface lo --interval 0.0001" 1 "" "Interval must be positive"
+run_test "./wirefish --monitor --iface lo --interval 100000000" 1 "" "Interval must be at most 86400000 ms"
+
+# 552 - --stream prints samples as they come, JSON as one object per line
+run_test "./wirefish --monitor --iface lo --interval 20 --stream --json" 0 "{\"type\":\"monitor_end\",\"ticks\":10," ""
+run_test "./wirefish --monitor --iface lo --interval 20 --stream --csv" 0 ",ts_ms" ""
+
+# 553 - --duration sets the run time (seconds)
+run_test "./wirefish --monitor --iface lo --interval 250 --duration 1 --json" 0 "\"ticks\":4," ""
+
+# 554 - --keep reports only the last samples
+run_test "./wirefish --monitor --iface lo --interval 10 --keep 2 --json" 0 "\"tx_stddev_bps\":0.00}],\"ticks\":10" ""
+run_test "./wirefish --monitor --iface lo --keep 0" 1 "" "--keep must be in range 1-1000000"
+
+# 555 - streaming flag combinations
+run_test "./wirefish --monitor --iface lo --stream --keep 5" 1 "" "--keep cannot be combined with --stream"
+run_test "./wirefish --monitor --iface lo --stream --group" 1 "" "--group cannot be combined with --stream"
+run_test "./wirefish --trace --target 127.0.0.1 --stream" 1 "" "--duration, --stream and --keep are only valid with --monitor"
+
+# 556 - --rollup reports history buckets from the finest tier covering the run
+run_test "./wirefish --monitor --iface lo --interval 20 --duration 1 --rollup 200ms:50,1s:60 --json" 0 "{\"type\":\"monitor_rollup\",\"width_ms\":200," ""
+run_test "./wirefish --monitor --iface lo --interval 50 --duration 1 --rollup 100ms:3,1s:60 --csv" 0 "lo,1000," ""
+run_test "./wirefish --monitor --iface lo --interval 20 --stream --json --rollup 1s:10" 0 "\"type\":\"monitor_rollup\"" ""
+
+# 557 - --rollup tier validation
+run_test "./wirefish --monitor --iface lo --rollup 1x:3" 1 "" "Invalid --rollup tiers"
+run_test "./wirefish --monitor --iface lo --rollup 2s:3,1s:4" 1 "" "--rollup tier widths must increase"
+run_test "./wirefish --monitor --iface lo --rollup 1s:1,2s:1,3s:1,4s:1,5s:1" 1 "" "--rollup allows at most 4 tiers"
+run_test "./wirefish --monitor --iface lo --rollup 1s:3 --keep 3" 1 "" "--rollup cannot be combined with --keep or --group"
+run_test "./wirefish --trace --target 127.0.0.1 --rollup 1s:3" 1 "" "--rollup is only valid with --monitor"
+
+# 558 - --record appends samples to a time-series file, --replay prints them back
+rm -f tmp_wfts
+run_test "./wirefish --monitor --iface lo --interval 10 --record tmp_wfts --csv" 0 "lo," ""
+run_test "./wirefish --monitor --iface lo --interval 10 --record tmp_wfts --json" 0 "\"ticks\":10," ""
+run_test "./wirefish --monitor --replay tmp_wfts --json" 0 "{\"type\":\"monitor\",\"samples\":[{\"iface\":\"lo\"," ""
+run_test "./wirefish --monitor --replay tmp_wfts --from 9999999999999 --json" 0 "{\"type\":\"monitor\",\"samples\":[]," ""
+
+# 559 - --replay errors
+run_test "./wirefish --monitor --replay tmp_wfts --iface lo" 1 "" "--replay only combines with"
+run_test "./wirefish --monitor --replay tmp_wfts --from 5 --to 4" 1 "" "--from must not be after --to"
+run_test "./wirefish --monitor --iface lo --from 5" 1 "" "--from and --to are only valid with --replay"
+rm -f tmp_wfts
+printf 'not a time series\n' > tmp_wfts
+run_test "./wirefish --monitor --replay tmp_wfts" 1 "" "is not a wirefish time-series file"
+run_test "./wirefish --monitor --iface lo --record tmp_wfts" 1 "" "is not a wirefish time-series file"
+rm -f tmp_wfts
+run_test "./wirefish --monitor --replay tmp_wfts" 1 "" "No such file or directory"
+
+# 560 - --serve answers Prometheus scrapes between monitor ticks
+./wirefish --monitor --iface lo --interval 50 --duration 3 --serve 127.0.0.1:19100 >/dev/null 2>&1 &
+sleep 0.5
+run_test "curl -s http://127.0.0.1:19100/metrics" 0 "wirefish_receive_bytes_total{iface=\"lo\"} " ""
+run_test "curl -s http://127.0.0.1:19100/metrics" 0 "# TYPE wirefish_receive_avg_bits_per_second gauge" ""
+run_test "curl -s -I http://127.0.0.1:19100/metrics" 0 "Content-Type: text/plain; version=0.0.4" ""
+run_test "curl -s -o /dev/null -w %{http_code} http://127.0.0.1:19100/nothing" 0 "404" ""
+run_test "curl -s -o /dev/null -w %{http_code} -X POST http://127.0.0.1:19100/metrics" 0 "405" ""
+wait
+
+# 561 - --serve validation
+run_test "./wirefish --monitor --iface lo --serve 9100" 1 "" "Invalid --serve address"
+run_test "./wirefish --monitor --iface lo --serve :70000" 1 "" "Invalid --serve address"
+run_test "./wirefish --trace --target 127.0.0.1 --serve :9100" 1 "" "--serve is only valid with --monitor"
+run_test "./wirefish --monitor --replay tmp_wfts --serve :9100" 1 "" "--replay only combines with"
+run_test "./wirefish --monitor --iface lo --serve 192.0.2.1:19100" 1 "" "cannot serve metrics on 192.0.2.1:19100"
+
+# 562 - monitor output reports counter resets and 32-bit wraps
+run_test "./wirefish --monitor --iface lo --interval 10 --json" 0 "\"counter_resets\":0,\"counter_wraps\":0}" ""
+run_test "./wirefish --monitor --iface lo --interval 10 --stream --json" 0 "\"missed_ticks\":0,\"counter_resets\":0," ""
+
+# 563 - re-created, new and deleted interfaces mid-run (root only)
+if [ "$(id -u)" = 0 ] && ip netns add wftest 2>/dev/null && ip netns add wftest2 2>/dev/null; then
+    # Waits until the monitor has streamed $2 more samples of interface $1 (at most 3 s)
+    churn_wait() {
+        local want=$(( $(grep -c "\"iface\":\"$1\"" tmp_churn) + $2 ))
+        for i in $(seq 300); do
+            [ "$(grep -c "\"iface\":\"$1\"" tmp_churn)" -ge "$want" ] && return
+            sleep 0.01
+        done
+    }
+    ip -n wftest link set lo up
+    ip -n wftest link add wfa type veth peer name wfb netns wftest2
+    ip -n wftest addr add 10.99.0.1/24 dev wfa
+    ip -n wftest link set wfa up
+    ip -n wftest2 addr add 10.99.0.2/24 dev wfb
+    ip -n wftest2 link set wfb up
+    # Resolved up front, so none of the UDP below waits on ARP
+    ip -n wftest neigh replace 10.99.0.2 lladdr "$(ip netns exec wftest2 cat /sys/class/net/wfb/address)" dev wfa
+    : > tmp_churn
+    ip netns exec wftest ./wirefish --monitor --iface 'wf*' --interval 20 --duration 30 --stream --json --serve 127.0.0.1:19100 > tmp_churn 2>/dev/null &
+    churn_pid=$!
+    churn_wait wfa 2
+    ip netns exec wftest bash -c 'for i in $(seq 300); do printf "%01000d" 0 > /dev/udp/10.99.0.2/9; done'
+    churn_wait wfa 3
+    # Delete and re-create in one batch: the new wfa has a new ifindex and lower counters
+    printf 'link del wfa\nlink add wfa type veth peer name wfb netns wftest2\nlink set wfa up\n' | ip -n wftest -batch -
+    churn_wait wfa 3
+    ip -n wftest link add wfc type veth peer name wfd netns wftest2
+    ip -n wftest link set wfc up
+    churn_wait wfc 3
+    # Gone for longer than the grace period (5 samples)
+    ip -n wftest link del wfa
+    churn_wait wfc 10
+    ip netns exec wftest curl -s -o tmp_metrics http://127.0.0.1:19100/metrics
+    kill -INT $churn_pid
+    wait $churn_pid
+    run_test "grep -E tx_bytes\":3[0-9]{5} tmp_churn" 0 "\"iface\":\"wfa\"" ""
+    run_test "cat tmp_churn" 0 "\"counter_resets\":1," ""
+    run_test "grep -E bps\":[0-9]{13} tmp_churn" 1 "" ""
+    run_test "cat tmp_metrics" 0 "wirefish_receive_bytes_total{iface=\"wfc\"}" ""
+    run_test "grep -c iface=\"wfa\" tmp_metrics" 1 "0" ""
+    ip netns del wftest
+    ip netns del wftest2
+    rm -f tmp_churn tmp_metrics
+fi
+
+# 564 - every checksum kernel matches the reference for all lengths and alignments
+make -s wirefish-bench
+run_test "./wirefish-bench checksum verify" 0 "checksum: all variants match" ""
+
+# 565 - AS trie lookups match a linear longest-prefix scan, built and mapped
+awk 'BEGIN{srand(7); for(i=0;i<20000;i++) printf "%d.%d.%d.0/%d,%d\n", 1+int(rand()*222), int(rand()*256), int(rand()*256), 8+int(rand()*17), 64512+i%1000}' > tmp_asn
+run_test "./wirefish-bench asn tmp_asn tmp_asn.bin" 0 "verify: 2000 lookups, 0 mismatches" ""
+run_test "./wirefish-bench asn tmp_asn.bin" 0 "verify: 2000 lookups, 0 mismatches" ""
+rm -f tmp_asn tmp_asn.bin
+
+# 566 - O(1) rolling statistics match a full recomputation of the window
+run_test "./wirefish-bench ring 1000 20000" 0 "statistics match" ""
+
+# 567 - the time-series file returns every sample unchanged
+rm -f tmp_tsdb.wfts
+run_test "./wirefish-bench tsdb 20000 tmp_tsdb.wfts" 0 "round trip matches" ""
+rm -f tmp_tsdb.wfts
+
+# 568 - --graph keeps many traces in flight: 40 silent targets finish well within the timeout (root only)
+if [ "$(id -u)" = 0 ] && ip netns add wfg 2>/dev/null && ip netns add wfr 2>/dev/null; then
+    ip -n wfg link set lo up
+    ip -n wfr link set lo up
+    ip -n wfg link add g0 type veth peer name r0 netns wfr
+    ip -n wfg addr add 10.96.0.1/30 dev g0
+    ip -n wfg link set g0 up
+    ip -n wfr addr add 10.96.0.2/30 dev r0
+    ip -n wfr link set r0 up
+    ip -n wfg route add 10.95.0.0/16 via 10.96.0.2
+    ip -n wfg route add 10.96.1.0/24 via 10.96.0.2
+    ip netns exec wfr sysctl -qw net.ipv4.ip_forward=1 net.ipv4.icmp_ratelimit=0
+    for i in $(seq 1 10); do ip -n wfr addr add 10.96.1.$i/32 dev lo; done
+    ip -n wfr link add r1 type veth peer name r2
+    ip -n wfr link set r1 up
+    ip -n wfr link set r2 up
+    ip -n wfr addr add 10.96.2.1/24 dev r1
+    ip -n wfr route add 10.95.0.0/16 via 10.96.2.2
+    ip -n wfr neigh add 10.96.2.2 lladdr 02:00:00:00:00:02 dev r1
+    seq -f "10.95.0.%g" 1 40 > tmp_targets
+    run_test "ip netns exec wfg ./wirefish --trace --graph --target @tmp_targets --ttl 1-3" 0 "40 traces" ""
+    # Traces in flight together still get their own replies
+    (seq -f "10.96.1.%g" 1 10; seq -f "10.95.0.%g" 1 10) > tmp_targets
+    run_test "ip netns exec wfg ./wirefish --trace --graph --target @tmp_targets --ttl 1-3 --csv" 0 "10.96.0.1,10.96.0.2,10.96.0.2,1,10," ""
+    run_test "ip netns exec wfg ./wirefish --trace --graph --target @tmp_targets --ttl 1-3 --proto udp --csv" 0 "10.96.0.1,10.96.1.7,10.96.1.7,1,1," ""
+    run_test "ip netns exec wfg ./wirefish --trace --graph --target 10.96.1.1,10.96.1.1 --ttl 1-3 --csv" 0 "10.96.0.1,10.96.1.1,10.96.1.1,1,2," ""
+    ip netns del wfg
+    ip netns del wfr
+    rm -f tmp_targets
+fi
+
+# 569 - a step back from just under 2^32 is a wrap only when the window's rates make it plausible
+run_test "./wirefish-bench counters" 0 "counters: 8 cases, all classified as expected" ""
+
+# 570 - a '#' comment in a target file ends at its own line, with or without a space after '#'
+printf '#c\n127.0.0.2\n127.0.0.3 #trailing\n' > tmp_targets
+run_test "./wirefish --trace --graph --target @tmp_targets --ttl 1-2 --csv" 0 "127.0.0.1,127.0.0.2,127.0.0.2," ""
+run_test "./wirefish --trace --graph --target @tmp_targets --ttl 1-2 --csv" 0 "127.0.0.1,127.0.0.3,127.0.0.3," ""
+rm -f tmp_targets
+
+# 571 - incrementally patched Echo templates carry the checksum a full recompute gives
+run_test "./wirefish-bench build verify" 0 "checksums match a full recompute" ""
+
 #######################################
 # Additional tests for better coverage
 #######################################
@@ -15,6 +15,10 @@
 #include <sys/time.h>
 #include <errno.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
 
 /*
  * ms_now
@@ -29,6 +33,21 @@ long ms_now(void) {
     return (long)(tv.tv_sec * 1000LL + tv.tv_usec / 1000);
 }
 
+/*
+ * us_now
+ * Returns current time in microseconds since the Unix epoch.
+ * Uses CLOCK_REALTIME, the clock the kernel stamps received packets
+ * with (SO_TIMESTAMPNS), so the two can be subtracted directly.
+ * Returns: timestamp in us, or -1 on failure.
+ */
+long long us_now(void) {
+    struct timespec ts;
+    if (clock_gettime(CLOCK_REALTIME, &ts) != 0) {
+        return -1;
+    }
+    return (long long)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
 /*
  * ms_sleep
  * Sleeps for the given number of milliseconds.
@@ -77,4 +96,89 @@ void format_timestamp(char *buf, size_t len) {
     tm_info = localtime(&tv.tv_sec);
     
     snprintf(buf, len, "%02d:%02d:%02d.%03ld", tm_info->tm_hour, tm_info->tm_min, tm_info->tm_sec, tv.tv_usec / 1000);
-}
\ No newline at end of file
+}
+
+/*
+ * ns_mono
+ * Returns CLOCK_MONOTONIC time in nanoseconds (unaffected by NTP steps
+ * or date changes; only meaningful as a difference).
+ * Returns: timestamp in ns, or -1 on failure.
+ */
+long long ns_mono(void) {
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+        return -1;
+    }
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*
+ * ticker_start
+ * Arms a periodic timer whose first deadline is one interval from now.
+ * t: ticker to start
+ * interval_ns: period in nanoseconds (> 0)
+ * Returns: 0 on success, -1 on error.
+ */
+int ticker_start(Ticker *t, long long interval_ns) {
+    memset(t, 0, sizeof(*t));
+    t->fd = -1;
+
+    if (interval_ns <= 0) {
+        return -1;
+    }
+
+    t->fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (t->fd < 0) {
+        return -1;
+    }
+
+    long long first = ns_mono() + interval_ns;
+
+    // Absolute first deadline plus a period: the kernel keeps every later
+    // deadline at first + k * interval however late we read
+    struct itimerspec its;
+    its.it_value.tv_sec = first / 1000000000LL;
+    its.it_value.tv_nsec = first % 1000000000LL;
+    its.it_interval.tv_sec = interval_ns / 1000000000LL;
+    its.it_interval.tv_nsec = interval_ns % 1000000000LL;
+
+    if (timerfd_settime(t->fd, TFD_TIMER_ABSTIME, &its, NULL) != 0) {
+        close(t->fd);
+        t->fd = -1;
+        return -1;
+    }
+
+    t->interval_ns = interval_ns;
+    return 0;
+}
+
+/*
+ * ticker_wait
+ * Blocks until the next deadline.
+ * t: started ticker
+ * Returns: number of deadlines that passed (1 = on time, more = some were
+ *          missed), 0 if interrupted by a signal, -1 on error.
+ */
+long long ticker_wait(Ticker *t) {
+    uint64_t expirations;
+
+    ssize_t n = read(t->fd, &expirations, sizeof(expirations));
+    if (n != (ssize_t)sizeof(expirations)) {
+        return (n < 0 && errno == EINTR) ? 0 : -1;
+    }
+
+    t->ticks += expirations;
+    t->missed += expirations - 1;
+    return (long long)expirations;
+}
+
+/*
+ * ticker_stop
+ * Disarms the timer and releases its descriptor.
+ */
+void ticker_stop(Ticker *t) {
+    if (t->fd >= 0) {
+        close(t->fd);
+    }
+    t->fd = -1;
+}
@@ -4,18 +4,47 @@
  *
  * Public API:
  *  - long ms_now(void);              // Get current time in milliseconds
+ *  - long long us_now(void);         // Get current time in microseconds
  *  - int  ms_sleep(int ms);          // Sleep for ms milliseconds
  *  - long ms_diff(long start, long end); // Calculate time difference
  *  - void format_timestamp(char *buf, size_t len); // Format current time as HH:MM:SS.mmm
+ *  - long long ns_mono(void);        // CLOCK_MONOTONIC time in nanoseconds
+ *  - int  ticker_start(Ticker *t, long long interval_ns); // Periodic absolute-deadline timer
+ *  - long long ticker_wait(Ticker *t); // Block until the next deadline
+ *  - void ticker_stop(Ticker *t);
+ *
+ * Ticker deadlines are start + k * interval on CLOCK_MONOTONIC (a timerfd),
+ * so the period does not stretch by the time spent between waits and is
+ * not disturbed by wall-clock steps. Deadlines that pass while the caller
+ * is busy are counted as missed, not made up.
  */
 #ifndef TIMEUTIL_H
 #define TIMEUTIL_H
 
 #include <stddef.h>
 
+/*
+ * Periodic sampling timer.
+ * fd:           timerfd on CLOCK_MONOTONIC (absolute deadlines)
+ * interval_ns:  period
+ * ticks:        deadlines passed since ticker_start()
+ * missed:       deadlines that passed while the caller was not waiting
+ */
+typedef struct Ticker {
+    int fd;
+    long long interval_ns;
+    unsigned long long ticks;
+    unsigned long long missed;
+} Ticker;
+
 long ms_now(void);
+long long us_now(void);
 int  ms_sleep(int ms);
 long ms_diff(long start_ms, long end_ms);
 void format_timestamp(char *buf, size_t len);
+long long ns_mono(void);
+int  ticker_start(Ticker *t, long long interval_ns);
+long long ticker_wait(Ticker *t);
+void ticker_stop(Ticker *t);
 
 #endif /* TIMEUTIL_H */
\ No newline at end of file
@@ -0,0 +1,875 @@
+/*asn.c - Implements the offline prefix -> AS lookup.
+ * Responsibilities:
+ *  - Parse text dumps into routes and radix sort them by (prefix, length)
+ *  - Compile the sorted routes into a poptrie (Asai & Ohara, SIGCOMM 2015): a direct table
+ *    indexed by the top 16 bits, then nodes covering 6 bits each; 'vector' marks which
+ *    of a node's 64 children are nodes and 'leafvec' where a run of equal leaves
+ *    starts, so a child is base + popcount(bits below it)
+ *  - Map compiled tables straight from disk: the file is header + nodes + leaves +
+ *    entries, exactly the arrays lookups use
+ *
+ * Why a poptrie and not the binary trie?
+ *  - A binary trie walks up to 32 dependent pointers per lookup; the poptrie reads one
+ *    direct slot and at most 3 nodes of 24 bytes, and leaf runs keep it compact
+ *
+ * Author: Shan Truong - 400576105 - truons8
+ * Date: December 3, 2025
+ * Coures: 2XC3
+ */
+
+#include "asn.h"
+#include "../net/net.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <arpa/inet.h>  // inet_pton(), inet_ntop()
+
+#if defined(__x86_64__) || defined(__i386__)
+#define ASN_X86 1
+#endif
+
+#define ASN_MAGIC "WFASN\0\0\1"     // file magic (last byte = format version)
+#define ASN_MAGIC_LEN 8
+#define ASN_LINE_MAX 512            // longest text line accepted
+
+/*
+ * Binary file header; the arrays follow in this order:
+ * uint32_t[1 << ASN_DIRECT_BITS], AsnNode[nnodes], uint32_t[nleaves], AsnEntry[nentries]
+ */
+typedef struct {
+    char magic[ASN_MAGIC_LEN];
+    uint32_t nnodes;
+    uint32_t nleaves;
+    uint32_t nentries;
+    uint32_t reserved[3];
+} AsnFileHeader;
+
+/*
+ * Growable arrays used while building.
+ * item_lo, item_hi, item_def: for each poptrie node, the run of sorted routes
+ * inside its address block and the best route above it (its slots inherit it)
+ */
+typedef struct {
+    uint32_t *direct;
+    AsnEntry *entries;
+    size_t nentries, entry_cap;
+    AsnNode *nodes;
+    size_t nnodes, node_cap;
+    uint32_t *item_lo;
+    uint32_t *item_hi;
+    uint32_t *item_def;
+    uint32_t *leaves;
+    size_t nleaves, leaf_cap;
+} AsnBuilder;
+
+/**
+ * Grow an array so it can hold one more element.
+ * @param arr Pointer to the array pointer
+ * @param cap Pointer to the capacity (elements)
+ * @param len Elements in use
+ * @param size Element size
+ * @return 0 on success, -1 on allocation failure
+ */
+static int asn_reserve(void **arr, size_t *cap, size_t len, size_t size){
+
+    if(len < *cap){
+        return 0;
+    }
+
+    size_t newcap = *cap ? *cap * 2 : 1024;
+    void *p = realloc(*arr, newcap * size);
+
+    if(p == NULL){
+        return -1;
+    }
+
+    *arr = p;
+    *cap = newcap;
+    return 0;
+}
+
+/**
+ * Parse one text line into a route.
+ * Accepts "10.0.0.0/8,64500[,...]" (CSV) and "10.0.0.0<TAB>8<TAB>64500" (pfx2as);
+ * AS sets like "64500_64501" or "{64500,64501}" keep the first AS.
+ * @param line Line to parse (modified)
+ * @param e Route to fill
+ * @return true if the line held a route, false for comments, headers and junk
+ */
+static bool asn_parse_line(char *line, AsnEntry *e){
+
+    char *p = line;
+
+    while(isspace((unsigned char)*p)){
+        p++;
+    }
+
+    // Address runs up to '/', ',' or whitespace
+    char *addr = p;
+
+    while(*p != '\0' && *p != '/' && *p != ',' && !isspace((unsigned char)*p)){
+        p++;
+    }
+
+    if(*p == '\0'){
+        return false;
+    }
+    *p++ = '\0';
+
+    struct in_addr in;
+
+    if(inet_pton(AF_INET, addr, &in) != 1){
+        return false;
+    }
+
+    while(*p == ' ' || *p == '\t'){
+        p++;
+    }
+
+    char *end;
+    unsigned long len = strtoul(p, &end, 10);
+
+    if(end == p || len > 32){
+        return false;
+    }
+    p = end;
+
+    // Separator, then an optional "AS" or '{' before the number
+    while(*p == ',' || *p == ' ' || *p == '\t' || *p == '{'){
+        p++;
+    }
+
+    if((p[0] == 'A' || p[0] == 'a') && (p[1] == 'S' || p[1] == 's')){
+        p += 2;
+    }
+
+    unsigned long asn = strtoul(p, &end, 10);
+
+    if(end == p || asn > UINT32_MAX){
+        return false;
+    }
+
+    uint32_t mask = len == 0 ? 0 : 0xFFFFFFFFu << (32 - len);
+
+    e->prefix = ntohl(in.s_addr) & mask;
+    e->len = (uint8_t)len;
+    e->asn = (uint32_t)asn;
+    return true;
+}
+
+/**
+ * Sort routes by (prefix, length), keeping input order among equals.
+ * LSD radix sort on the 38-bit key prefix << 6 | len, in three 13-bit passes.
+ * @param entries Routes
+ * @param n Number of routes
+ * @return 0 on success, -1 on allocation failure
+ */
+static int asn_sort(AsnEntry *entries, size_t n){
+
+    AsnEntry *tmp = malloc(n * sizeof(AsnEntry));
+    size_t *count = malloc(((size_t)1 << 13) * sizeof(size_t));
+
+    if(tmp == NULL || count == NULL){
+        free(tmp);
+        free(count);
+        return -1;
+    }
+
+    AsnEntry *src = entries;
+    AsnEntry *dst = tmp;
+
+    for(int shift = 0; shift < 39; shift += 13){
+
+        memset(count, 0, ((size_t)1 << 13) * sizeof(size_t));
+
+        for(size_t i = 0; i < n; i++){
+            uint64_t key = ((uint64_t)src[i].prefix << 6) | src[i].len;
+            count[(key >> shift) & 0x1FFF]++;
+        }
+
+        size_t sum = 0;
+
+        for(size_t d = 0; d < ((size_t)1 << 13); d++){
+            size_t c = count[d];
+            count[d] = sum;
+            sum += c;
+        }
+
+        for(size_t i = 0; i < n; i++){
+            uint64_t key = ((uint64_t)src[i].prefix << 6) | src[i].len;
+            dst[count[(key >> shift) & 0x1FFF]++] = src[i];
+        }
+
+        AsnEntry *swap = src;
+        src = dst;
+        dst = swap;
+    }
+
+    // Three passes: the result sits in tmp
+    memcpy(entries, src, n * sizeof(AsnEntry));
+
+    free(tmp);
+    free(count);
+    return 0;
+}
+
+/**
+ * Append a poptrie node to be filled later (nodes are filled in creation order).
+ * @param b Builder
+ * @param lo, hi Sorted routes inside the node's block
+ * @param def Best route above it (entry index + 1, 0 = none)
+ * @return 0 on success, -1 on allocation failure
+ */
+static int asn_push_node(AsnBuilder *b, uint32_t lo, uint32_t hi, uint32_t def){
+
+    size_t cap = b->node_cap;
+
+    if(asn_reserve((void **)&b->nodes, &b->node_cap, b->nnodes, sizeof(AsnNode)) != 0){
+        return -1;
+    }
+
+    // The per-node build items grow with the node array
+    if(b->node_cap != cap){
+
+        uint32_t *items[3] = { b->item_lo, b->item_hi, b->item_def };
+
+        for(int k = 0; k < 3; k++){
+
+            uint32_t *grown = realloc(items[k], b->node_cap * sizeof(uint32_t));
+
+            if(grown == NULL){
+                return -1;
+            }
+            items[k] = grown;
+        }
+
+        b->item_lo = items[0];
+        b->item_hi = items[1];
+        b->item_def = items[2];
+    }
+
+    memset(&b->nodes[b->nnodes], 0, sizeof(AsnNode));
+    b->item_lo[b->nnodes] = lo;
+    b->item_hi[b->nnodes] = hi;
+    b->item_def[b->nnodes] = def;
+    b->nnodes++;
+    return 0;
+}
+
+/**
+ * Lay the routes of one block out over its slots.
+ * Sorted order is also painting order: a route that covers another sorts before it,
+ * so the longer one paints last and wins.
+ * @param e Sorted routes
+ * @param lo, hi Routes inside the block
+ * @param offset Address bits above the block
+ * @param width Slot index bits (the block has 2^width slots)
+ * @param bits Address bits the slots resolve (width, or fewer at the bottom)
+ * @param def Best route above the block
+ * @param value Output: longest match per slot
+ * @param child_lo, child_hi Output: routes below each slot that need a node (lo == hi: none)
+ */
+static void asn_paint(const AsnEntry *e, uint32_t lo, uint32_t hi, int offset, int width, int bits, uint32_t def,
+                      uint32_t *value, uint32_t *child_lo, uint32_t *child_hi){
+
+    size_t nslots = (size_t)1 << width;
+
+    for(size_t s = 0; s < nslots; s++){
+        value[s] = def;
+        child_lo[s] = child_hi[s] = 0;
+    }
+
+    for(uint32_t r = lo; r < hi; r++){
+
+        int len = e[r].len;
+
+        // Already folded into def by the block above (the top block has none: /0 paints it all)
+        if(len <= offset && offset > 0){
+            continue;
+        }
+
+        size_t slot = (size_t)((((uint64_t)e[r].prefix << 32) << offset) >> (64 - width));
+
+        if(len > offset + bits){
+
+            // Routes of one slot are contiguous in sorted order
+            if(child_lo[slot] == child_hi[slot]){
+                child_lo[slot] = r;
+            }
+            child_hi[slot] = r + 1;
+            continue;
+        }
+
+        size_t span = (size_t)1 << (width - (len - offset));
+
+        for(size_t s = slot; s < slot + span; s++){
+            value[s] = r + 1;
+        }
+    }
+}
+
+/**
+ * Compile the sorted routes into the direct table and the poptrie below it.
+ * Nodes are filled in creation order, so every node's children, created
+ * together while filling it, sit next to each other as the popcount needs.
+ * @param b Builder (routes sorted, duplicates removed)
+ * @return 0 on success, -1 on allocation failure
+ */
+static int asn_compile(AsnBuilder *b){
+
+    size_t nslots = (size_t)1 << ASN_DIRECT_BITS;
+    uint32_t *value = malloc(nslots * sizeof(uint32_t));
+    uint32_t *child_lo = malloc(nslots * sizeof(uint32_t));
+    uint32_t *child_hi = malloc(nslots * sizeof(uint32_t));
+    int rc = 0;
+
+    b->direct = malloc(nslots * sizeof(uint32_t));
+
+    if(value == NULL || child_lo == NULL || child_hi == NULL || b->direct == NULL){
+        rc = -1;
+        goto out;
+    }
+
+    // Top bits: one slot per /16, either a route or the node holding its more-specifics
+    asn_paint(b->entries, 0, (uint32_t)b->nentries, 0, ASN_DIRECT_BITS, ASN_DIRECT_BITS, 0, value, child_lo, child_hi);
+
+    for(size_t s = 0; s < nslots && rc == 0; s++){
+
+        if(child_lo[s] == child_hi[s]){
+            b->direct[s] = ASN_DIRECT_LEAF | value[s];
+            continue;
+        }
+
+        b->direct[s] = (uint32_t)b->nnodes;
+        rc = asn_push_node(b, child_lo[s], child_hi[s], value[s]);
+    }
+
+    // Offset of the node being filled: the direct bits plus its depth times the stride
+    size_t level_end = b->nnodes;
+    int offset = ASN_DIRECT_BITS;
+
+    for(size_t i = 0; i < b->nnodes && rc == 0; i++){
+
+        if(i == level_end){
+            level_end = b->nnodes;
+            offset += ASN_STRIDE;
+        }
+
+        int bits = 32 - offset < ASN_STRIDE ? 32 - offset : ASN_STRIDE;
+        uint64_t vector = 0;
+
+        asn_paint(b->entries, b->item_lo[i], b->item_hi[i], offset, ASN_STRIDE, bits, b->item_def[i], value, child_lo, child_hi);
+
+        uint32_t base1 = (uint32_t)b->nnodes;
+
+        for(int s = 0; s < 64 && rc == 0; s++){
+
+            if(child_lo[s] != child_hi[s]){
+                vector |= 1ULL << s;
+                rc = asn_push_node(b, child_lo[s], child_hi[s], value[s]);
+            }
+        }
+
+        // Leaves: one entry per run of equal values (node children don't break a run)
+        uint32_t base0 = (uint32_t)b->nleaves;
+        uint64_t leafvec = 0;
+        bool first = true;
+        uint32_t prev = 0;
+
+        for(int s = 0; s < 64 && rc == 0; s++){
+
+            if((vector >> s) & 1){
+                continue;
+            }
+
+            if(first || value[s] != prev){
+
+                rc = asn_reserve((void **)&b->leaves, &b->leaf_cap, b->nleaves, sizeof(uint32_t));
+
+                if(rc == 0){
+                    b->leaves[b->nleaves++] = value[s];
+                    leafvec |= 1ULL << s;
+                    prev = value[s];
+                    first = false;
+                }
+            }
+        }
+
+        b->nodes[i].vector = vector;
+        b->nodes[i].leafvec = leafvec;
+        b->nodes[i].base0 = base0;
+        b->nodes[i].base1 = base1;
+    }
+
+out:
+    free(value);
+    free(child_lo);
+    free(child_hi);
+    return rc;
+}
+
+/**
+ * Build a table from a text dump.
+ * @param fp Open text file
+ * @param t Table to fill
+ * @return 0 on success, -1 on error
+ */
+static int asn_build(FILE *fp, AsnTable *t){
+
+    AsnBuilder b;
+    memset(&b, 0, sizeof(b));
+
+    char line[ASN_LINE_MAX];
+    int rc = 0;
+
+    while(rc == 0 && fgets(line, sizeof(line), fp) != NULL){
+
+        AsnEntry e;
+
+        if(!asn_parse_line(line, &e)){
+            continue;
+        }
+
+        rc = asn_reserve((void **)&b.entries, &b.entry_cap, b.nentries, sizeof(AsnEntry));
+
+        if(rc == 0){
+            b.entries[b.nentries++] = e;
+        }
+    }
+
+    if(rc == 0 && b.nentries == 0){
+        fprintf(stderr, "Error: no routes found in AS table\n");
+        rc = -1;
+    }
+
+    if(rc == 0){
+        rc = asn_sort(b.entries, b.nentries);
+    }
+
+    // A prefix listed twice keeps its last route
+    if(rc == 0){
+
+        size_t n = 0;
+
+        for(size_t i = 0; i < b.nentries; i++){
+
+            if(n > 0 && b.entries[n - 1].prefix == b.entries[i].prefix && b.entries[n - 1].len == b.entries[i].len){
+                b.entries[n - 1] = b.entries[i];
+            }
+            else{
+                b.entries[n++] = b.entries[i];
+            }
+        }
+        b.nentries = n;
+
+        rc = asn_compile(&b);
+    }
+
+    // Only the poptrie and its routes outlive the build
+    free(b.item_lo);
+    free(b.item_hi);
+    free(b.item_def);
+
+    if(rc != 0){
+        free(b.direct);
+        free(b.entries);
+        free(b.nodes);
+        free(b.leaves);
+        return -1;
+    }
+
+    memset(t, 0, sizeof(*t));
+    t->direct = b.direct;
+    t->nodes = b.nodes;
+    t->nnodes = b.nnodes;
+    t->leaves = b.leaves;
+    t->nleaves = b.nleaves;
+    t->entries = b.entries;
+    t->nentries = b.nentries;
+    return 0;
+}
+
+/**
+ * Longest-prefix match (body shared by the per-CPU variants below).
+ * @param t Table
+ * @param addr IPv4 address (host order)
+ * @return Matching route, or NULL if none covers addr
+ */
+static inline __attribute__((always_inline)) const AsnEntry *asn_lookup_body(const AsnTable *t, uint32_t addr){
+
+    if(t->direct == NULL){
+        return NULL;
+    }
+
+    // Most lookups end here: the /16 is covered by one route
+    uint32_t d = t->direct[addr >> (32 - ASN_DIRECT_BITS)];
+    uint32_t leaf = d & ~ASN_DIRECT_LEAF;
+
+    if(!(d & ASN_DIRECT_LEAF)){
+
+        // Address in the top half so every level can take 6 bits, zeros past bit 32
+        uint64_t key = (uint64_t)addr << 32;
+        const AsnNode *n = &t->nodes[d];
+
+        for(int offset = ASN_DIRECT_BITS; ; offset += ASN_STRIDE){
+
+            unsigned int v = (unsigned int)((key << offset) >> (64 - ASN_STRIDE));
+            uint64_t upto = (2ULL << v) - 1;   // children 0..v (all ones for v = 63)
+
+            if(!((n->vector >> v) & 1)){
+                leaf = t->leaves[n->base0 + __builtin_popcountll(n->leafvec & upto) - 1];
+                break;
+            }
+
+            // A well-formed trie ends by bit 32; asn_check() can't see depth, so stop here
+            if(offset + ASN_STRIDE >= 32){
+                return NULL;
+            }
+
+            n = &t->nodes[n->base1 + __builtin_popcountll(n->vector & upto) - 1];
+        }
+    }
+
+    return leaf != 0 ? &t->entries[leaf - 1] : NULL;
+}
+
+/**
+ * Lookup for any CPU (popcount done in software).
+ */
+static const AsnEntry *asn_lookup_generic(const AsnTable *t, uint32_t addr){
+    return asn_lookup_body(t, addr);
+}
+
+#ifdef ASN_X86
+/**
+ * Lookup with the POPCNT instruction (not in the x86-64 baseline the build targets).
+ */
+__attribute__((target("popcnt")))
+static const AsnEntry *asn_lookup_popcnt(const AsnTable *t, uint32_t addr){
+    return asn_lookup_body(t, addr);
+}
+#endif
+
+static const AsnEntry *(*asn_lookup_best)(const AsnTable *t, uint32_t addr) = asn_lookup_generic;
+
+/**
+ * Pick the fastest lookup the CPU supports.
+ */
+static void asn_select(void){
+
+#ifdef ASN_X86
+    __builtin_cpu_init();
+
+    if(__builtin_cpu_supports("popcnt")){
+        asn_lookup_best = asn_lookup_popcnt;
+    }
+#endif
+}
+
+/**
+ * Longest-prefix match.
+ * @param t Table
+ * @param addr IPv4 address (host order)
+ * @return Matching route, or NULL if none covers addr
+ */
+const AsnEntry *asn_lookup(const AsnTable *t, uint32_t addr){
+    return asn_lookup_best(t, addr);
+}
+
+/**
+ * Check a mapped table so corrupt files can't send lookups out of bounds.
+ * @param t Table pointing into the mapping
+ * @return true if every index stays in range and every node has children below it
+ */
+static bool asn_check(const AsnTable *t){
+
+    for(size_t s = 0; s < ((size_t)1 << ASN_DIRECT_BITS); s++){
+
+        uint32_t d = t->direct[s];
+
+        if((d & ASN_DIRECT_LEAF) ? (d & ~ASN_DIRECT_LEAF) > t->nentries : d >= t->nnodes){
+            return false;
+        }
+    }
+
+    for(size_t i = 0; i < t->nnodes; i++){
+
+        const AsnNode *n = &t->nodes[i];
+        uint64_t leaves = ~n->vector;
+
+        if(n->vector != 0 && (n->base1 <= i || n->base1 + (size_t)__builtin_popcountll(n->vector) > t->nnodes)){
+            return false;
+        }
+
+        if(n->base0 + (size_t)__builtin_popcountll(n->leafvec) > t->nleaves){
+            return false;
+        }
+
+        // The first leaf child must start a run, or its index would be base0 - 1
+        if(leaves != 0 && (n->leafvec & (leaves & -leaves)) == 0){
+            return false;
+        }
+    }
+
+    for(size_t i = 0; i < t->nleaves; i++){
+        if(t->leaves[i] > t->nentries){
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Map a compiled table file.
+ * @param fd Open file
+ * @param t Table to fill
+ * @return 0 on success, -1 on error
+ */
+static int asn_map(int fd, AsnTable *t){
+
+    struct stat st;
+
+    if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(AsnFileHeader)){
+        return -1;
+    }
+
+    size_t len = (size_t)st.st_size;
+    void *map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if(map == MAP_FAILED){
+        return -1;
+    }
+
+    const AsnFileHeader *h = (const AsnFileHeader *)map;
+    size_t need = sizeof(AsnFileHeader) + ((size_t)1 << ASN_DIRECT_BITS) * sizeof(uint32_t) + (size_t)h->nnodes * sizeof(AsnNode) +
+                  (size_t)h->nleaves * sizeof(uint32_t) + (size_t)h->nentries * sizeof(AsnEntry);
+
+    memset(t, 0, sizeof(*t));
+    t->map = map;
+    t->map_len = len;
+
+    if(need == len){
+
+        const unsigned char *p = (const unsigned char *)map + sizeof(AsnFileHeader);
+
+        t->direct = (const uint32_t *)p;
+        p += ((size_t)1 << ASN_DIRECT_BITS) * sizeof(uint32_t);
+
+        t->nodes = (const AsnNode *)p;
+        t->nnodes = h->nnodes;
+        p += t->nnodes * sizeof(AsnNode);
+
+        t->leaves = (const uint32_t *)p;
+        t->nleaves = h->nleaves;
+        p += t->nleaves * sizeof(uint32_t);
+
+        t->entries = (const AsnEntry *)p;
+        t->nentries = h->nentries;
+
+        if(asn_check(t)){
+            return 0;
+        }
+    }
+
+    munmap(map, len);
+    memset(t, 0, sizeof(*t));
+    return -1;
+}
+
+/**
+ * Load a prefix table: a compiled file (from asn_save) is mapped, text is parsed and compiled.
+ * @param path File name
+ * @param t Table to fill (free with asn_free)
+ * @return 0 on success, -1 on error (message printed)
+ */
+int asn_load(const char *path, AsnTable *t){
+
+    memset(t, 0, sizeof(*t));
+    asn_select();
+
+    int fd = open(path, O_RDONLY);
+
+    if(fd < 0){
+        fprintf(stderr, "Error: cannot open AS table %s\n", path);
+        return -1;
+    }
+
+    char magic[ASN_MAGIC_LEN];
+    ssize_t got = read(fd, magic, sizeof(magic));
+    int rc;
+
+    if(got == ASN_MAGIC_LEN && memcmp(magic, ASN_MAGIC, ASN_MAGIC_LEN) == 0){
+
+        rc = asn_map(fd, t);
+
+        if(rc != 0){
+            fprintf(stderr, "Error: AS table %s is corrupt\n", path);
+        }
+        close(fd);
+        return rc;
+    }
+
+    FILE *fp = fdopen(fd, "r");
+
+    if(fp == NULL){
+        close(fd);
+        return -1;
+    }
+
+    rewind(fp);
+    rc = asn_build(fp, t);
+    fclose(fp);
+    return rc;
+}
+
+/**
+ * Write a table in the binary format asn_load() maps.
+ * @param t Table
+ * @param path Output file name
+ * @return 0 on success, -1 on error
+ */
+int asn_save(const AsnTable *t, const char *path){
+
+    FILE *fp = fopen(path, "wb");
+
+    if(fp == NULL){
+        fprintf(stderr, "Error: cannot create %s\n", path);
+        return -1;
+    }
+
+    AsnFileHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, ASN_MAGIC, ASN_MAGIC_LEN);
+    h.nnodes = (uint32_t)t->nnodes;
+    h.nleaves = (uint32_t)t->nleaves;
+    h.nentries = (uint32_t)t->nentries;
+
+    size_t nslots = (size_t)1 << ASN_DIRECT_BITS;
+
+    bool ok = fwrite(&h, sizeof(h), 1, fp) == 1 &&
+              fwrite(t->direct, sizeof(uint32_t), nslots, fp) == nslots &&
+              fwrite(t->nodes, sizeof(AsnNode), t->nnodes, fp) == t->nnodes &&
+              fwrite(t->leaves, sizeof(uint32_t), t->nleaves, fp) == t->nleaves &&
+              fwrite(t->entries, sizeof(AsnEntry), t->nentries, fp) == t->nentries;
+
+    if(fclose(fp) != 0 || !ok){
+        fprintf(stderr, "Error: failed to write %s\n", path);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Look up an address string.
+ * @param t Table
+ * @param ip IPv4 address as text
+ * @param asn Output AS number (0 if no route)
+ * @param prefix Output "a.b.c.d/len" ("" if no route)
+ * @param prefix_len Size of prefix
+ * @return true if a route covers ip
+ */
+bool asn_lookup_ip(const AsnTable *t, const char *ip, unsigned int *asn, char *prefix, size_t prefix_len){
+
+    struct in_addr in;
+    const AsnEntry *e = NULL;
+
+    if(inet_pton(AF_INET, ip, &in) == 1){
+        e = asn_lookup(t, ntohl(in.s_addr));
+    }
+
+    *asn = 0;
+    prefix[0] = '\0';
+
+    if(e == NULL){
+        return false;
+    }
+
+    struct in_addr net = { htonl(e->prefix) };
+    char buf[INET_ADDRSTRLEN];
+
+    inet_ntop(AF_INET, &net, buf, sizeof(buf));
+    snprintf(prefix, prefix_len, "%s/%u", buf, (unsigned int)e->len);
+    *asn = e->asn;
+    return true;
+}
+
+/**
+ * Annotate every answering hop with its AS and prefix.
+ * @param t Table
+ * @param route Trace to annotate
+ */
+void asn_annotate_route(const AsnTable *t, TraceRoute *route){
+
+    for(size_t i = 0; i < route->len; i++){
+
+        Hop *h = &route->rows[i];
+
+        if(!h->timeout){
+            asn_lookup_ip(t, h->ip, &h->asn, h->prefix, sizeof(h->prefix));
+        }
+    }
+
+    route->has_asn = true;
+}
+
+/**
+ * Annotate every responding host of a sweep with its AS and prefix.
+ * @param t Table
+ * @param table Sweep to annotate
+ */
+void asn_annotate_sweep(const AsnTable *t, SweepTable *table){
+
+    for(size_t i = 0; i < table->len; i++){
+        asn_lookup_ip(t, table->rows[i].ip, &table->rows[i].asn, table->rows[i].prefix, sizeof(table->rows[i].prefix));
+    }
+
+    table->has_asn = true;
+}
+
+/**
+ * Annotate a port scan with the AS and prefix of its target.
+ * @param t Table
+ * @param target Scanned host (name or address)
+ * @param table Scan to annotate
+ */
+void asn_annotate_scan(const AsnTable *t, const char *target, ScanTable *table){
+
+    struct sockaddr_storage ss;
+    socklen_t ss_len;
+
+    table->ip[0] = '\0';
+
+    if(net_resolve(target, &ss, &ss_len) == 0 && ss.ss_family == AF_INET){
+        inet_ntop(AF_INET, &((struct sockaddr_in *)&ss)->sin_addr, table->ip, sizeof(table->ip));
+    }
+
+    asn_lookup_ip(t, table->ip, &table->asn, table->prefix, sizeof(table->prefix));
+    table->has_asn = true;
+}
+
+/**
+ * Release a table (unmaps it if it was mapped).
+ * @param t Table
+ */
+void asn_free(AsnTable *t){
+
+    if(t->map != NULL){
+        munmap(t->map, t->map_len);
+    }
+    else{
+        free((void *)t->direct);
+        free((void *)t->nodes);
+        free((void *)t->leaves);
+        free((void *)t->entries);
+    }
+
+    memset(t, 0, sizeof(*t));
+}
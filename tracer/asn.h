@@ -0,0 +1,109 @@
+/*
+ * File: asn.h
+ * Summary: Offline IPv4 prefix -> origin AS lookup (longest prefix match).
+ *
+ * Responsibilities:
+ *  - Load a prefix table from a text dump (CSV "prefix/len,asn" or pfx2as "ip len asn")
+ *  - Compile it into a poptrie: a /16 direct table, then 6-bit stride nodes whose
+ *    children and leaves are found by popcount over 64-bit bitmaps, with runs of
+ *    equal leaves stored once
+ *  - Save the compiled trie to a binary file and map it back with mmap() (no rebuild)
+ *  - Annotate hops, sweep hosts and scan targets with AS number and matched prefix
+ *
+ * Data & Types:
+ *  - typedef struct AsnEntry { uint32_t prefix; uint32_t asn; uint8_t len; }
+ *  - typedef struct AsnNode { uint64_t vector; uint64_t leafvec; uint32_t base0; uint32_t base1; }
+ *  - typedef struct AsnTable { const uint32_t *direct; const AsnNode *nodes; const uint32_t *leaves; const AsnEntry *entries; ... }
+ *
+ * Public API:
+ *  - int  asn_load(const char *path, AsnTable *t);
+ *  - int  asn_save(const AsnTable *t, const char *path);
+ *  - const AsnEntry *asn_lookup(const AsnTable *t, uint32_t addr);
+ *  - bool asn_lookup_ip(const AsnTable *t, const char *ip, unsigned int *asn, char *prefix, size_t prefix_len);
+ *  - void asn_annotate_route(const AsnTable *t, TraceRoute *route);
+ *  - void asn_annotate_sweep(const AsnTable *t, SweepTable *table);
+ *  - void asn_annotate_scan(const AsnTable *t, const char *target, ScanTable *table);
+ *  - void asn_free(AsnTable *t);
+ *
+ * Notes:
+ *  - Addresses passed to asn_lookup() are in host byte order
+ *  - The binary format is native-endian: build it on the machine that reads it
+ *
+ * Author: Shan Truong - 400576105 - truons8
+ * Date: December 3, 2025
+ * Coures: 2XC3
+ */
+
+#ifndef ASN_H
+#define ASN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "../model/model.h"
+
+// Bits consumed per trie level
+#define ASN_STRIDE 6
+
+// Top address bits resolved by the direct table (one slot per /16)
+#define ASN_DIRECT_BITS 16
+
+// Direct slot flag: the rest is a leaf value, not a node index
+#define ASN_DIRECT_LEAF 0x80000000u
+
+/**
+ * One route from the table.
+ * - prefix: network address (host order)
+ * - asn: origin AS number
+ * - len: prefix length
+ */
+typedef struct AsnEntry{
+    uint32_t prefix;
+    uint32_t asn;
+    uint8_t len;
+} AsnEntry;
+
+/**
+ * One poptrie node (64 children).
+ * - vector: bit i set = child i is another node
+ * - leafvec: bit i set = a new run of equal leaves starts at child i
+ * - base0: index of this node's first leaf in AsnTable.leaves
+ * - base1: index of this node's first child node in AsnTable.nodes
+ */
+typedef struct AsnNode{
+    uint64_t vector;
+    uint64_t leafvec;
+    uint32_t base0;
+    uint32_t base1;
+} AsnNode;
+
+/**
+ * A compiled prefix table.
+ * - direct: 2^ASN_DIRECT_BITS slots, each ASN_DIRECT_LEAF | leaf value or a node index
+ * - nodes, nnodes: trie nodes below the direct table
+ * - leaves, nleaves: leaf values (entry index + 1, 0 = no route)
+ * - entries, nentries: the routes
+ * - map, map_len: file mapping when loaded from a binary file (NULL if built in memory)
+ */
+typedef struct AsnTable{
+    const uint32_t *direct;
+    const AsnNode *nodes;
+    size_t nnodes;
+    const uint32_t *leaves;
+    size_t nleaves;
+    const AsnEntry *entries;
+    size_t nentries;
+    void *map;
+    size_t map_len;
+} AsnTable;
+
+int  asn_load(const char *path, AsnTable *t);
+int  asn_save(const AsnTable *t, const char *path);
+const AsnEntry *asn_lookup(const AsnTable *t, uint32_t addr);
+bool asn_lookup_ip(const AsnTable *t, const char *ip, unsigned int *asn, char *prefix, size_t prefix_len);
+void asn_annotate_route(const AsnTable *t, TraceRoute *route);
+void asn_annotate_sweep(const AsnTable *t, SweepTable *table);
+void asn_annotate_scan(const AsnTable *t, const char *target, ScanTable *table);
+void asn_free(AsnTable *t);
+
+#endif /* ASN_H */
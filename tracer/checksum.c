@@ -0,0 +1,313 @@
+/*checksum.c - Internet checksum kernels.
+ * Summary: Scalar, 64-bit word and SIMD (SSE2/AVX2) versions of the RFC 1071
+ *          checksum, with the best one chosen at runtime.
+ *
+ * Why wider words work:
+ *   The one's complement sum is taken mod 0xFFFF, and 2^16 = 1 (mod 0xFFFF),
+ *   so summing 32- or 64-bit words and folding the carries back down to 16
+ *   bits gives the same result as summing 16-bit words. Byte order inside
+ *   the words is preserved as long as chunks start at even offsets.
+ *
+ * Author: Shan Truong - 400576105 - truons8
+ * Date: December 3, 2025
+ * Coures: 2XC3
+ */
+
+#include "checksum.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CHECKSUM_X86 1
+#endif
+
+/**
+ * Fold a 64-bit partial sum to 16 bits with end-around carry.
+ * @param sum Partial sum
+ * @return 16-bit one's complement sum (not yet complemented)
+ */
+static uint16_t checksum_fold(uint64_t sum){
+
+    sum = (sum & 0xFFFFFFFFULL) + (sum >> 32);
+    sum = (sum & 0xFFFFFFFFULL) + (sum >> 32);
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    return (uint16_t)sum;
+}
+
+/**
+ * Add a 64-bit word to a one's complement accumulator (carry wraps around).
+ * @param acc Accumulator
+ * @param w Word to add
+ * @return New accumulator
+ */
+static inline uint64_t checksum_add64(uint64_t acc, uint64_t w){
+
+    acc += w;
+    return acc + (acc < w);
+}
+
+/**
+ * Partial sum of a buffer, 64 bits at a time (unaligned loads via memcpy).
+ * @param p Buffer
+ * @param len Length in bytes
+ * @return Unfolded one's complement partial sum
+ */
+static uint64_t checksum_sum64(const unsigned char *p, size_t len){
+
+    uint64_t a0 = 0, a1 = 0, a2 = 0, a3 = 0;
+
+    // Four independent accumulators keep the adds from waiting on each other
+    while(len >= 32){
+        uint64_t w0, w1, w2, w3;
+        memcpy(&w0, p, 8);
+        memcpy(&w1, p + 8, 8);
+        memcpy(&w2, p + 16, 8);
+        memcpy(&w3, p + 24, 8);
+        a0 = checksum_add64(a0, w0);
+        a1 = checksum_add64(a1, w1);
+        a2 = checksum_add64(a2, w2);
+        a3 = checksum_add64(a3, w3);
+        p += 32;
+        len -= 32;
+    }
+
+    while(len >= 8){
+        uint64_t w;
+        memcpy(&w, p, 8);
+        a0 = checksum_add64(a0, w);
+        p += 8;
+        len -= 8;
+    }
+
+    // Last 0-7 bytes: zero padding keeps them in their 16-bit lanes
+    if(len > 0){
+        uint64_t w = 0;
+        memcpy(&w, p, len);
+        a0 = checksum_add64(a0, w);
+    }
+
+    a0 = checksum_add64(a0, a1);
+    a2 = checksum_add64(a2, a3);
+    return checksum_add64(a0, a2);
+}
+
+/**
+ * Reference checksum: one 16-bit word at a time.
+ * @param buf Data
+ * @param len Length in bytes
+ * @return 16-bit checksum (as stored in a header)
+ */
+uint16_t checksum_ref(const void *buf, size_t len){
+
+    const unsigned char *p = (const unsigned char *)buf;
+    uint32_t sum = 0;
+
+    // Sum 16-bit words (memcpy: buf may be odd-aligned)
+    while(len > 1){
+        uint16_t w;
+        memcpy(&w, p, 2);
+        sum += w;
+        p += 2;
+        len -= 2;
+
+        // Fold before the 32-bit sum can overflow on huge buffers
+        if(sum & 0x80000000U){
+            sum = (sum & 0xFFFF) + (sum >> 16);
+        }
+    }
+
+    // If we have a leftover byte, pad it to 16 bits and add
+    if(len == 1){
+        uint16_t last = 0;
+        *(uint8_t *)&last = *p;
+        sum += last;
+    }
+
+    return (uint16_t)~checksum_fold(sum);
+}
+
+/**
+ * Checksum with 64-bit word accumulation (portable).
+ * @param buf Data
+ * @param len Length in bytes
+ * @return 16-bit checksum (as stored in a header)
+ */
+uint16_t checksum_word64(const void *buf, size_t len){
+
+    return (uint16_t)~checksum_fold(checksum_sum64((const unsigned char *)buf, len));
+}
+
+#ifdef CHECKSUM_X86
+
+/**
+ * Checksum with SSE2: 16 bytes per step, 32-bit words widened into
+ * 64-bit lanes so the lanes can't overflow.
+ * @param buf Data
+ * @param len Length in bytes
+ * @return 16-bit checksum (as stored in a header)
+ */
+__attribute__((target("sse2")))
+uint16_t checksum_sse2(const void *buf, size_t len){
+
+    const unsigned char *p = (const unsigned char *)buf;
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc0 = _mm_setzero_si128();
+    __m128i acc1 = _mm_setzero_si128();
+
+    while(len >= 32){
+        __m128i v0 = _mm_loadu_si128((const __m128i *)p);
+        __m128i v1 = _mm_loadu_si128((const __m128i *)(p + 16));
+        acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(v0, zero));
+        acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(v0, zero));
+        acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(v1, zero));
+        acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(v1, zero));
+        p += 32;
+        len -= 32;
+    }
+
+    uint64_t lanes[4];
+    _mm_storeu_si128((__m128i *)lanes, acc0);
+    _mm_storeu_si128((__m128i *)(lanes + 2), acc1);
+
+    // Each lane holds a sum of 32-bit words, so adding them can't overflow 64 bits
+    uint64_t sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    sum = checksum_add64(sum, checksum_sum64(p, len));
+
+    return (uint16_t)~checksum_fold(sum);
+}
+
+/**
+ * Checksum with AVX2: 64 bytes per step, same widening scheme as SSE2.
+ * @param buf Data
+ * @param len Length in bytes
+ * @return 16-bit checksum (as stored in a header)
+ */
+__attribute__((target("avx2")))
+uint16_t checksum_avx2(const void *buf, size_t len){
+
+    const unsigned char *p = (const unsigned char *)buf;
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc0 = _mm256_setzero_si256();
+    __m256i acc1 = _mm256_setzero_si256();
+
+    while(len >= 64){
+        __m256i v0 = _mm256_loadu_si256((const __m256i *)p);
+        __m256i v1 = _mm256_loadu_si256((const __m256i *)(p + 32));
+        acc0 = _mm256_add_epi64(acc0, _mm256_unpacklo_epi32(v0, zero));
+        acc1 = _mm256_add_epi64(acc1, _mm256_unpackhi_epi32(v0, zero));
+        acc0 = _mm256_add_epi64(acc0, _mm256_unpacklo_epi32(v1, zero));
+        acc1 = _mm256_add_epi64(acc1, _mm256_unpackhi_epi32(v1, zero));
+        p += 64;
+        len -= 64;
+    }
+
+    uint64_t lanes[8];
+    _mm256_storeu_si256((__m256i *)lanes, acc0);
+    _mm256_storeu_si256((__m256i *)(lanes + 4), acc1);
+
+    uint64_t sum = 0;
+    for(int i = 0; i < 8; i++){
+        sum += lanes[i];
+    }
+    sum = checksum_add64(sum, checksum_sum64(p, len));
+
+    return (uint16_t)~checksum_fold(sum);
+}
+
+#endif /* CHECKSUM_X86 */
+
+// Variant picked on first use (benign race: every thread picks the same one)
+static ChecksumFn checksum_best = NULL;
+static const char *checksum_best_name = NULL;
+
+/**
+ * Pick the fastest variant the CPU supports.
+ */
+static void checksum_select(void){
+
+#ifdef CHECKSUM_X86
+    __builtin_cpu_init();
+
+    if(__builtin_cpu_supports("avx2")){
+        checksum_best_name = "avx2";
+        checksum_best = checksum_avx2;
+        return;
+    }
+
+#endif
+
+#ifdef __i386__
+    // On x86-64 four 64-bit add-with-carry chains match 128-bit SIMD, so SSE2
+    // only pays off where general registers are 32 bits wide
+    if(__builtin_cpu_supports("sse2")){
+        checksum_best_name = "sse2";
+        checksum_best = checksum_sse2;
+        return;
+    }
+#endif
+
+    checksum_best_name = "word64";
+    checksum_best = checksum_word64;
+}
+
+/**
+ * Checksum with the fastest variant for this CPU.
+ * @param buf Data
+ * @param len Length in bytes
+ * @return 16-bit checksum (as stored in a header)
+ */
+uint16_t checksum_fast(const void *buf, size_t len){
+
+    if(checksum_best == NULL){
+        checksum_select();
+    }
+
+    return checksum_best(buf, len);
+}
+
+/**
+ * Name of the variant checksum_fast() uses.
+ * @return "avx2", "sse2" or "word64"
+ */
+const char *checksum_fast_name(void){
+
+    if(checksum_best == NULL){
+        checksum_select();
+    }
+
+    return checksum_best_name;
+}
+
+/**
+ * List the variants usable on this CPU (for tests and benchmarks).
+ * @param out Array to fill
+ * @param max Capacity of out (CHECKSUM_MAX_IMPLS is enough)
+ * @return Number of entries written
+ */
+size_t checksum_impls(ChecksumImpl *out, size_t max){
+
+    size_t n = 0;
+
+    if(n < max){
+        out[n++] = (ChecksumImpl){ "ref", checksum_ref };
+    }
+    if(n < max){
+        out[n++] = (ChecksumImpl){ "word64", checksum_word64 };
+    }
+
+#ifdef CHECKSUM_X86
+    __builtin_cpu_init();
+
+    if(n < max && __builtin_cpu_supports("sse2")){
+        out[n++] = (ChecksumImpl){ "sse2", checksum_sse2 };
+    }
+    if(n < max && __builtin_cpu_supports("avx2")){
+        out[n++] = (ChecksumImpl){ "avx2", checksum_avx2 };
+    }
+#endif
+
+    return n;
+}
@@ -0,0 +1,62 @@
+/*
+ * File: checksum.h
+ * Summary: Internet checksum (RFC 1071) kernels with runtime CPU dispatch.
+ *
+ * Responsibilities:
+ *  - Reference 16-bit-at-a-time checksum
+ *  - 64-bit word-at-a-time accumulation (portable)
+ *  - SSE2 and AVX2 variants on x86 (compiled with target attributes)
+ *  - Pick the fastest variant the running CPU supports, once
+ *
+ * Public API:
+ *  - uint16_t checksum_ref(const void *buf, size_t len);
+ *  - uint16_t checksum_word64(const void *buf, size_t len);
+ *  - uint16_t checksum_sse2(const void *buf, size_t len);   (x86 only)
+ *  - uint16_t checksum_avx2(const void *buf, size_t len);   (x86 only)
+ *  - uint16_t checksum_fast(const void *buf, size_t len);
+ *  - const char *checksum_fast_name(void);
+ *  - size_t checksum_impls(ChecksumImpl *out, size_t max);
+ *
+ * Notes:
+ *  - Every variant returns exactly what checksum_ref returns: the one's
+ *    complement of the one's complement sum of the buffer's 16-bit words as
+ *    stored (so no byte swapping), with an odd last byte zero-padded
+ *  - Any length and any alignment are accepted
+ *
+ * Author: Shan Truong - 400576105 - truons8
+ * Date: December 3, 2025
+ * Coures: 2XC3
+ */
+
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Most variants checksum_impls() can report
+#define CHECKSUM_MAX_IMPLS 4
+
+typedef uint16_t (*ChecksumFn)(const void *buf, size_t len);
+
+/**
+ * One checksum variant usable on this CPU.
+ * - name: "ref", "word64", "sse2" or "avx2"
+ * - fn: the kernel
+ */
+typedef struct ChecksumImpl{
+    const char *name;
+    ChecksumFn fn;
+} ChecksumImpl;
+
+uint16_t checksum_ref(const void *buf, size_t len);
+uint16_t checksum_word64(const void *buf, size_t len);
+#if defined(__x86_64__) || defined(__i386__)
+uint16_t checksum_sse2(const void *buf, size_t len);
+uint16_t checksum_avx2(const void *buf, size_t len);
+#endif
+uint16_t checksum_fast(const void *buf, size_t len);
+const char *checksum_fast_name(void);
+size_t checksum_impls(ChecksumImpl *out, size_t max);
+
+#endif /* CHECKSUM_H */
@@ -0,0 +1,226 @@
+/*hopcache.c - Implements the shared-prefix hop cache.
+ * Responsibilities:
+ *  - One table per source address, one entry per TTL: the router that last
+ *    answered there, its name, when, and for which destination
+ *  - An entry counts as shared once the same router answers for a second destination;
+ *    the usable prefix is the run of fresh shared entries starting at ttl_start
+ *  - A different router at some TTL means the path moved: that entry restarts and
+ *    everything deeper is dropped, since it described the old path
+ *
+ * Why check only the last prefix hop?
+ *  - If the router at the prefix's last TTL is still the cached one, the path up to
+ *    it almost certainly is too; tracer_run re-probes the prefix when it isn't
+ *
+ * Author: Shan Truong - 400576105 - truons8
+ * Date: December 3, 2025
+ * Coures: 2XC3
+ */
+
+#include "hopcache.h"
+#include "../timeutil/timeutil.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <arpa/inet.h>  // inet_pton()
+#include <netinet/ip_icmp.h>
+
+/*
+ * What one TTL looked like last time.
+ * addr:     router that answered (0 = nothing cached)
+ * last_dst: destination of the trace that saw it last
+ * shared:   number of times a different destination saw the same router
+ * seen_us:  when it was last confirmed
+ */
+typedef struct {
+    struct in_addr addr;
+    struct in_addr last_dst;
+    char host[256];
+    unsigned int shared;
+    long long seen_us;
+} HopCacheEntry;
+
+/*
+ * Cache for one source address.
+ * traces: prefix lookups so far (drives revalidation)
+ */
+typedef struct {
+    bool used;
+    struct in_addr src;
+    unsigned long traces;
+    HopCacheEntry hops[HOPCACHE_MAX_TTL + 1];
+} HopCache;
+
+static HopCache caches[HOPCACHE_MAX_SOURCES];
+
+/**
+ * Find the cache of a source address, optionally claiming a slot for it.
+ * @param src Local source address
+ * @param create true to take a free (or the oldest-used) slot if missing
+ * @return Pointer to the cache, or NULL
+ */
+static HopCache *hopcache_get(struct in_addr src, bool create){
+
+    for(int i = 0; i < HOPCACHE_MAX_SOURCES; i++){
+        if(caches[i].used && caches[i].src.s_addr == src.s_addr){
+            return &caches[i];
+        }
+    }
+
+    if(!create){
+        return NULL;
+    }
+
+    // Free slot first, else recycle the last one
+    HopCache *c = &caches[HOPCACHE_MAX_SOURCES - 1];
+
+    for(int i = 0; i < HOPCACHE_MAX_SOURCES; i++){
+        if(!caches[i].used){
+            c = &caches[i];
+            break;
+        }
+    }
+
+    memset(c, 0, sizeof(*c));
+    c->used = true;
+    c->src = src;
+    return c;
+}
+
+/**
+ * Check whether a cache entry is still usable.
+ * @param e Entry
+ * @param now Current time (microseconds)
+ * @return true if something is cached and not expired
+ */
+static bool hopcache_fresh(const HopCacheEntry *e, long long now){
+    return e->addr.s_addr != 0 && now - e->seen_us <= (long long)HOPCACHE_MAX_AGE_MS * 1000;
+}
+
+/**
+ * Find how much of the next trace can come from the cache.
+ * Counts as one trace for revalidation: every HOPCACHE_REVALIDATE-th call returns 0.
+ * @param src Local source address of the trace
+ * @param ttl_start First TTL the trace wants
+ * @param ttl_max Last TTL the trace wants
+ * @return Last TTL of the shared prefix (probe it to validate, copy the TTLs before it),
+ *         or 0 to probe everything
+ */
+int hopcache_prefix(struct in_addr src, int ttl_start, int ttl_max){
+
+    HopCache *c = hopcache_get(src, false);
+
+    if(c == NULL){
+        return 0;
+    }
+
+    // Periodic full trace keeps the cached prefix honest
+    if(++c->traces % HOPCACHE_REVALIDATE == 0){
+        return 0;
+    }
+
+    long long now = us_now();
+    int last = 0;
+
+    for(int ttl = ttl_start; ttl <= ttl_max && ttl <= HOPCACHE_MAX_TTL; ttl++){
+
+        const HopCacheEntry *e = &c->hops[ttl];
+
+        if(!hopcache_fresh(e, now) || e->shared == 0){
+            break;
+        }
+        last = ttl;
+    }
+
+    // The last prefix TTL is probed anyway: only worth it if something is skipped
+    return last > ttl_start ? last : 0;
+}
+
+/**
+ * Check a validation probe against the cache.
+ * @param src Local source address
+ * @param ttl TTL of the probe
+ * @param addr Router that answered it
+ * @return true if it is the cached router for that TTL
+ */
+bool hopcache_match(struct in_addr src, int ttl, struct in_addr addr){
+
+    const HopCache *c = hopcache_get(src, false);
+
+    if(c == NULL || ttl < 1 || ttl > HOPCACHE_MAX_TTL){
+        return false;
+    }
+
+    return hopcache_fresh(&c->hops[ttl], us_now()) && c->hops[ttl].addr.s_addr == addr.s_addr;
+}
+
+/**
+ * Fill a hop from the cache (no RTT: it wasn't measured this time).
+ * @param src Local source address
+ * @param ttl TTL to copy (from hopcache_prefix, so it is cached)
+ * @param h Hop to fill
+ */
+void hopcache_fill(struct in_addr src, int ttl, Hop *h){
+
+    const HopCache *c = hopcache_get(src, false);
+
+    memset(h, 0, sizeof(*h));
+    h->hop = ttl;
+    h->flow = -1;
+    h->rtt_us = -1;
+    h->icmp_type = ICMP_TIME_EXCEEDED;
+    h->cached = true;
+
+    inet_ntop(AF_INET, &c->hops[ttl].addr, h->ip, sizeof(h->ip));
+    snprintf(h->host, sizeof(h->host), "%s", c->hops[ttl].host);
+}
+
+/**
+ * Learn the near side of a finished trace.
+ * Only hops probed this time count; the destination itself is never cached.
+ * @param src Local source address
+ * @param dst Destination of the trace
+ * @param route Finished trace
+ */
+void hopcache_learn(struct in_addr src, struct in_addr dst, const TraceRoute *route){
+
+    HopCache *c = hopcache_get(src, true);
+    long long now = us_now();
+
+    for(size_t i = 0; i < route->len; i++){
+
+        const Hop *h = &route->rows[i];
+        struct in_addr addr;
+
+        if(h->hop > HOPCACHE_MAX_TTL || h->reached){
+            break;
+        }
+
+        // Silent hops and copied hops say nothing new
+        if(h->timeout || h->cached || inet_pton(AF_INET, h->ip, &addr) != 1){
+            continue;
+        }
+
+        HopCacheEntry *e = &c->hops[h->hop];
+
+        if(hopcache_fresh(e, now) && e->addr.s_addr == addr.s_addr){
+
+            if(e->last_dst.s_addr != dst.s_addr){
+                e->shared++;
+                e->last_dst = dst;
+            }
+            e->seen_us = now;
+            continue;
+        }
+
+        // New router here: the path moved, so deeper entries are stale too
+        for(int t = h->hop + 1; t <= HOPCACHE_MAX_TTL; t++){
+            c->hops[t].addr.s_addr = 0;
+        }
+
+        e->addr = addr;
+        e->last_dst = dst;
+        e->shared = 0;
+        e->seen_us = now;
+        snprintf(e->host, sizeof(e->host), "%s", h->host);
+    }
+}
@@ -0,0 +1,51 @@
+/*
+ * File: hopcache.h
+ * Summary: Cache of recently seen near-side hops, per local source address.
+ *
+ * Responsibilities:
+ *  - Remember which router answered each low TTL, for each source address
+ *  - Report the shared prefix: leading TTLs whose router is fresh and was seen
+ *    on the way to more than one destination
+ *  - Let tracer_run probe only the last hop of that prefix and copy the rest
+ *  - Force a full trace every HOPCACHE_REVALIDATE traces so the prefix stays honest
+ *
+ * Public API:
+ *  - int  hopcache_prefix(struct in_addr src, int ttl_start, int ttl_max);
+ *  - bool hopcache_match(struct in_addr src, int ttl, struct in_addr addr);
+ *  - void hopcache_fill(struct in_addr src, int ttl, Hop *h);
+ *  - void hopcache_learn(struct in_addr src, struct in_addr dst, const TraceRoute *route);
+ *
+ * Notes:
+ *  - The cache lives for the whole process (useful when one run traces many targets)
+ *  - Not thread-safe; tracing is single threaded
+ *
+ * Author: Shan Truong - 400576105 - truons8
+ * Date: December 3, 2025
+ * Coures: 2XC3
+ */
+
+#ifndef HOPCACHE_H
+#define HOPCACHE_H
+
+#include <stdbool.h>
+#include <netinet/in.h>
+#include "../model/model.h"
+
+// Deepest TTL the cache remembers (the near side of the path)
+#define HOPCACHE_MAX_TTL 32
+
+// Source addresses (interfaces) cached at once
+#define HOPCACHE_MAX_SOURCES 4
+
+// How long an observed hop stays usable
+#define HOPCACHE_MAX_AGE_MS 60000
+
+// Every Nth trace from a source probes its whole prefix again
+#define HOPCACHE_REVALIDATE 8
+
+int  hopcache_prefix(struct in_addr src, int ttl_start, int ttl_max);
+bool hopcache_match(struct in_addr src, int ttl, struct in_addr addr);
+void hopcache_fill(struct in_addr src, int ttl, Hop *h);
+void hopcache_learn(struct in_addr src, struct in_addr dst, const TraceRoute *route);
+
+#endif /* HOPCACHE_H */
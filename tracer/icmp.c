@@ -1,5 +1,7 @@
 /*icmp.c - ICMP packet building and parsing
- * Summary: ICMP packet construction and parsing utilities.
+ * Summary: ICMP packet construction and parsing utilities, plus the TCP SYN
+ *          probe builder and the quoted UDP/TCP header parsing used by
+ *          non-ICMP traceroute probes.
  * 
  * Author: Shan Truong - 400576105 - truons8
  * Date: December 3, 2025
@@ -7,53 +9,27 @@
  */
 
 #include "icmp.h"
+#include "checksum.h"
 #include <string.h>         // memcpy, memset
 #include <arpa/inet.h>      // htons()
+#include <stddef.h>         // offsetof()
 #include <netinet/ip_icmp.h> // struct icmphdr, ICMP_ECHO
 #include <netinet/ip.h>       // for struct iphdr
+#include <netinet/udp.h>      // struct udphdr (quoted UDP probes)
+#include <netinet/tcp.h>      // struct tcphdr (TCP SYN probes)
+#include <linux/filter.h>     // struct sock_filter, BPF_* opcodes
 
 /**
  * Compute ICMP checksum.
+ * Uses the fastest kernel for this CPU (see checksum.c); the result is
+ * identical to summing 16-bit words one at a time.
  * @param buf Pointer to ICMP message
  * @param len Length of ICMP message in bytes
  * @return 16-bit checksum
  */
 uint16_t icmp_checksum(const void *buf, size_t len) {
 
-    // Interpret buffer as array of 16-bit words
-    const uint16_t *data = (const uint16_t *)buf;
-
-    // Initialize sum
-    uint32_t sum = 0;
-
-    // Sum 16-bit words
-    while(len > 1) {
-        sum += *data++;
-        len -= 2;
-    }
-
-    // If we have a leftover byte, pad it to 16 bits and add
-    if(len == 1) {
-
-        //pad last byte with zeros to make 16 bits
-        uint16_t last = 0;
-
-        //cast to uint8_t pointer to copy single byte
-        *(uint8_t *)&last = *(const uint8_t *)data;
-
-        //add padded last byte to sum
-        sum += last;
-    }
-
-    // Fold 32-bit sum to 16 bits: keep adding carry into low 16 bits
-    while(sum >> 16) {
-
-        // Add high 16 bits to low 16 bits
-        sum = (sum & 0xFFFF) + (sum >> 16);
-    }
-
-    // One's complement of the result
-    return (uint16_t)(~sum);
+    return checksum_fast(buf, len);
 }
 
 /**
@@ -106,6 +82,202 @@ int icmp_build_echo(uint16_t id, uint16_t seq, const void *payload, size_t paylo
     return 0;
 }
 
+/**
+ * Build a flow-stable ("Paris") ICMP Echo Request.
+ *
+ * ECMP routers hash ICMP flows on the first 4 bytes of the ICMP header
+ * (type, code, checksum). Normal probes change the sequence number and
+ * therefore the checksum, so consecutive TTLs can hash onto different
+ * paths. Here the checksum field is pinned to the flow identifier and a
+ * 2-byte payload word is chosen so the packet still checksums correctly:
+ * probes with the same flow follow the same path whatever their seq.
+ *
+ * @param id Identifier
+ * @param seq Sequence number (free to vary per probe)
+ * @param flow Flow identifier; becomes the on-wire checksum
+ * @param out Output buffer (at least sizeof(struct icmphdr) + 2 bytes)
+ * @param out_len Updated with actual length
+ * @return 0 on success, -1 on error
+ */
+int icmp_build_echo_flow(uint16_t id, uint16_t seq, uint16_t flow, unsigned char *out, size_t *out_len){
+
+    //Validate output parameters
+    if(out == NULL || out_len == NULL){
+        return -1;
+    }
+
+    // Header + one compensation word
+    size_t total_len = sizeof(struct icmphdr) + ICMP_FLOW_PAYLOAD_LEN;
+
+    struct icmphdr *hdr = (struct icmphdr *)out;
+    memset(out, 0, total_len);
+
+    hdr->type = ICMP_ECHO;
+    hdr->code = 0;
+    hdr->un.echo.id = htons(id);
+    hdr->un.echo.sequence = htons(seq);
+
+    // Pin the checksum field to the flow identifier
+    hdr->checksum = htons(flow);
+
+    // With the compensation word still zero, icmp_checksum() returns the
+    // one's complement of the current sum; storing exactly that value in
+    // the payload makes the total sum 0xFFFF, i.e. a valid checksum.
+    uint16_t comp = icmp_checksum(out, total_len);
+    memcpy(out + sizeof(struct icmphdr), &comp, sizeof(comp));
+
+    *out_len = total_len;
+    return 0;
+}
+
+/**
+ * Adjust a checksum for one changed 16-bit word (RFC 1624, eqn. 3):
+ * HC' = ~(~HC + ~m + m'). Words are used as stored in the packet, so
+ * no byte swapping is needed.
+ * @param hc Current checksum (as stored)
+ * @param old_word Word before the change (as stored)
+ * @param new_word Word after the change (as stored)
+ * @return Updated checksum (as stored)
+ */
+static uint16_t icmp_checksum_adjust(uint16_t hc, uint16_t old_word, uint16_t new_word){
+
+    uint32_t sum = (uint16_t)~hc;
+    sum += (uint16_t)~old_word;
+    sum += new_word;
+
+    // Fold carries back in (at most twice for three 16-bit terms)
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    sum = (sum & 0xFFFF) + (sum >> 16);
+
+    return (uint16_t)~sum;
+}
+
+/**
+ * Build an Echo Request template once, for probes that only differ in
+ * sequence number (and flow, for Paris probes).
+ *
+ * The packet lives in caller-owned memory and is mutated in place by
+ * icmp_template_set_seq()/icmp_template_set_flow(), which patch the
+ * checksum incrementally, so a probe costs the same for any payload size.
+ *
+ * Paris templates pin the checksum to the flow like icmp_build_echo_flow();
+ * the compensation word at the start of the payload is what gets patched.
+ *
+ * @param t Template to initialize
+ * @param buf Packet memory (kept by the template)
+ * @param cap Size of buf
+ * @param id Identifier
+ * @param payload Payload bytes after the compensation word (may be NULL)
+ * @param payload_len Length of payload
+ * @param paris true for a flow-stable template (flow starts at 0)
+ * @return 0 on success, -1 on error
+ */
+int icmp_template_init(IcmpTemplate *t, unsigned char *buf, size_t cap, uint16_t id, const void *payload, size_t payload_len, bool paris){
+
+    //Validate parameters
+    if(t == NULL || buf == NULL){
+        return -1;
+    }
+
+    size_t comp_len = paris ? ICMP_FLOW_PAYLOAD_LEN : 0;
+    size_t total_len = sizeof(struct icmphdr) + comp_len + payload_len;
+    if(total_len > cap){
+        return -1;
+    }
+
+    memset(buf, 0, sizeof(struct icmphdr) + comp_len);
+
+    // Copy payload (if any) after the header and compensation word
+    if(payload_len > 0 && payload != NULL){
+        memcpy(buf + sizeof(struct icmphdr) + comp_len, payload, payload_len);
+    }
+    else if(payload_len > 0){
+        memset(buf + sizeof(struct icmphdr) + comp_len, 0, payload_len);
+    }
+
+    struct icmphdr *hdr = (struct icmphdr *)buf;
+    hdr->type = ICMP_ECHO;
+    hdr->code = 0;
+    hdr->un.echo.id = htons(id);
+    hdr->un.echo.sequence = 0;
+
+    // The only full checksum: over the template with seq 0 (and flow 0)
+    uint16_t sum = icmp_checksum(buf, total_len);
+    if(paris){
+        memcpy(buf + sizeof(struct icmphdr), &sum, sizeof(sum));
+    }
+    else{
+        hdr->checksum = sum;
+    }
+
+    t->pkt = buf;
+    t->len = total_len;
+    t->paris = paris;
+    return 0;
+}
+
+/**
+ * Word that absorbs changes in a template: the checksum field, or the
+ * compensation word for Paris templates (whose checksum is the flow).
+ * @param t Template
+ * @return Pointer to the word inside the packet
+ */
+static unsigned char *icmp_template_comp(IcmpTemplate *t){
+
+    if(t->paris){
+        return t->pkt + sizeof(struct icmphdr);
+    }
+
+    return t->pkt + offsetof(struct icmphdr, checksum);
+}
+
+/**
+ * Replace one header word of a template and patch the checksum to match.
+ * @param t Template
+ * @param off Byte offset of the word in the ICMP header
+ * @param value New value (network order)
+ */
+static void icmp_template_patch(IcmpTemplate *t, size_t off, uint16_t value){
+
+    uint16_t old_word;
+    uint16_t comp;
+    unsigned char *comp_p = icmp_template_comp(t);
+
+    // memcpy keeps this safe for any buffer alignment
+    memcpy(&old_word, t->pkt + off, sizeof(old_word));
+    memcpy(&comp, comp_p, sizeof(comp));
+
+    comp = icmp_checksum_adjust(comp, old_word, value);
+
+    memcpy(t->pkt + off, &value, sizeof(value));
+    memcpy(comp_p, &comp, sizeof(comp));
+}
+
+/**
+ * Set the sequence number of a template (incremental checksum update).
+ * @param t Template from icmp_template_init
+ * @param seq New sequence number
+ */
+void icmp_template_set_seq(IcmpTemplate *t, uint16_t seq){
+
+    icmp_template_patch(t, offsetof(struct icmphdr, un.echo.sequence), htons(seq));
+}
+
+/**
+ * Set the flow of a Paris template: the checksum field becomes the flow
+ * and the compensation word is adjusted to keep the packet valid.
+ * @param t Template from icmp_template_init (paris)
+ * @param flow New flow identifier
+ */
+void icmp_template_set_flow(IcmpTemplate *t, uint16_t flow){
+
+    if(!t->paris){
+        return;
+    }
+
+    icmp_template_patch(t, offsetof(struct icmphdr, checksum), htons(flow));
+}
+
 /**
  * Parse ICMP response packet.
  * @param packet Pointer to received packet
@@ -155,4 +327,324 @@ int icmp_parse_response(const void *packet, size_t len, const char *expected_ip,
     // Return ICMP type
     *out_type = icmph->type;
     return 0;
-}
\ No newline at end of file
+}
+
+/**
+ * Parse an ICMP reply and recover the id/seq of the probe it answers.
+ *
+ * Echo Replies carry the id/seq directly. Error messages (Time Exceeded,
+ * Destination Unreachable) quote the IP header plus the first 8 bytes of
+ * the packet that triggered them, so the probe's id/seq is read from the
+ * quoted ICMP header, or its ports/sequence from a quoted UDP/TCP header.
+ *
+ * @param packet Pointer to received packet (starting at the IP header)
+ * @param len Length of received packet
+ * @param out Filled with type, code, quoted protocol and probe id/seq (or ports)
+ * @return 0 if the packet is a reply/error for an ICMP/UDP/TCP probe, -1 otherwise
+ */
+int icmp_parse_reply(const void *packet, size_t len, IcmpReply *out){
+
+    //Validate parameters
+    if(packet == NULL || out == NULL){
+        return -1;
+    }
+
+    memset(out, 0, sizeof(*out));
+    out->type = -1;
+
+    const unsigned char *buf = (const unsigned char *)packet;
+
+    // Need at least an IP header (IPv4)
+    if(len < sizeof(struct iphdr)){
+        return -1;
+    }
+
+    // Outer IP header length in bytes
+    size_t iphdr_len = ((const struct iphdr *)buf)->ihl * 4;
+
+    // Make sure we have enough bytes for IP + ICMP header
+    if(len < iphdr_len + sizeof(struct icmphdr)){
+        return -1;
+    }
+
+    const struct icmphdr *icmph = (const struct icmphdr *)(buf + iphdr_len);
+    out->type = icmph->type;
+    out->code = icmph->code;
+
+    // Echo Reply: id/seq are right there
+    if(icmph->type == ICMP_ECHOREPLY){
+        out->quoted_proto = IPPROTO_ICMP;
+        out->id = ntohs(icmph->un.echo.id);
+        out->seq = ntohs(icmph->un.echo.sequence);
+        return 0;
+    }
+
+    // Only errors quote the original datagram
+    if(icmph->type != ICMP_TIME_EXCEEDED && icmph->type != ICMP_DEST_UNREACH){
+        return -1;
+    }
+
+    // Fragmentation Needed carries the MTU of the link that refused the probe
+    if(icmph->type == ICMP_DEST_UNREACH && icmph->code == ICMP_FRAG_NEEDED){
+        out->next_mtu = ntohs(icmph->un.frag.mtu);
+    }
+
+    // Quoted IP header starts right after the 8-byte ICMP error header
+    size_t inner_off = iphdr_len + sizeof(struct icmphdr);
+    if(len < inner_off + sizeof(struct iphdr)){
+        return -1;
+    }
+
+    const struct iphdr *inner = (const struct iphdr *)(buf + inner_off);
+    size_t inner_len = inner->ihl * 4;
+    out->quoted_proto = inner->protocol;
+    out->quoted_dst = inner->daddr;
+
+    // Routers only guarantee the first 8 bytes of the quoted transport header
+    size_t l4_off = inner_off + inner_len;
+    if(len < l4_off + 8){
+        return -1;
+    }
+
+    const unsigned char *l4 = buf + l4_off;
+
+    // Quoted UDP probe: source/destination ports identify it
+    if(inner->protocol == IPPROTO_UDP){
+        const struct udphdr *udp = (const struct udphdr *)l4;
+        out->sport = ntohs(udp->source);
+        out->dport = ntohs(udp->dest);
+        return 0;
+    }
+
+    // Quoted TCP probe: ports plus the sequence number (bytes 4-7)
+    if(inner->protocol == IPPROTO_TCP){
+        const struct tcphdr *tcp = (const struct tcphdr *)l4;
+        out->sport = ntohs(tcp->source);
+        out->dport = ntohs(tcp->dest);
+        out->tcp_seq = ntohl(tcp->seq);
+        return 0;
+    }
+
+    // Quoted ICMP probe: type, code, checksum, id, seq
+    if(inner->protocol != IPPROTO_ICMP){
+        return -1;
+    }
+
+    const struct icmphdr *quoted = (const struct icmphdr *)l4;
+    if(quoted->type != ICMP_ECHO){
+        return -1;
+    }
+
+    out->id = ntohs(quoted->un.echo.id);
+    out->seq = ntohs(quoted->un.echo.sequence);
+    return 0;
+}
+
+/**
+ * Parse an ICMP message read from a ping (SOCK_DGRAM) socket.
+ * Ping sockets strip the IP header and hand over only Echo Replies; ICMP
+ * errors come from the error queue as a copy of our own Echo Request, with
+ * the error's type/code reported separately (see net_recv_icmp_error).
+ * Either way the id/seq are in this header.
+ * @param packet Pointer to the ICMP header
+ * @param len Length of the message
+ * @param out Filled with type, code and probe id/seq
+ * @return 0 for an Echo Reply or our Echo Request, -1 otherwise
+ */
+int icmp_parse_dgram_reply(const void *packet, size_t len, IcmpReply *out){
+
+    //Validate parameters
+    if(packet == NULL || out == NULL){
+        return -1;
+    }
+
+    memset(out, 0, sizeof(*out));
+    out->type = -1;
+
+    if(len < sizeof(struct icmphdr)){
+        return -1;
+    }
+
+    const struct icmphdr *icmph = (const struct icmphdr *)packet;
+    if(icmph->type != ICMP_ECHOREPLY && icmph->type != ICMP_ECHO){
+        return -1;
+    }
+
+    out->type = icmph->type;
+    out->code = icmph->code;
+    out->quoted_proto = IPPROTO_ICMP;
+    out->id = ntohs(icmph->un.echo.id);
+    out->seq = ntohs(icmph->un.echo.sequence);
+    return 0;
+}
+
+/**
+ * Build a TCP SYN probe (TCP header only; the kernel adds the IP header).
+ * The TCP checksum covers a pseudo header with both IP addresses, so the
+ * source address the kernel will use must be known up front.
+ * @param src Source IPv4 address (network order)
+ * @param dst Destination IPv4 address (network order)
+ * @param sport Source port
+ * @param dport Destination port
+ * @param seq Sequence number (carries the probe id/seq)
+ * @param out Output buffer (at least sizeof(struct tcphdr) bytes)
+ * @param out_len Updated with actual length
+ * @return 0 on success, -1 on error
+ */
+int tcp_build_syn(uint32_t src, uint32_t dst, uint16_t sport, uint16_t dport, uint32_t seq, unsigned char *out, size_t *out_len){
+
+    //Validate output parameters
+    if(out == NULL || out_len == NULL){
+        return -1;
+    }
+
+    struct tcphdr *tcp = (struct tcphdr *)out;
+    memset(tcp, 0, sizeof(*tcp));
+
+    tcp->source = htons(sport);
+    tcp->dest = htons(dport);
+    tcp->seq = htonl(seq);
+    tcp->doff = sizeof(struct tcphdr) / 4;
+    tcp->syn = 1;
+    tcp->window = htons(TCP_PROBE_WINDOW);
+
+    // Pseudo header (src, dst, zero, protocol, TCP length) followed by the segment
+    struct {
+        uint32_t src, dst;
+        uint8_t zero, proto;
+        uint16_t len;
+        struct tcphdr tcp;
+    } pseudo;
+
+    pseudo.src = src;
+    pseudo.dst = dst;
+    pseudo.zero = 0;
+    pseudo.proto = IPPROTO_TCP;
+    pseudo.len = htons(sizeof(struct tcphdr));
+    pseudo.tcp = *tcp;
+
+    tcp->check = icmp_checksum(&pseudo, sizeof(pseudo));
+
+    *out_len = sizeof(struct tcphdr);
+    return 0;
+}
+
+/**
+ * Parse a TCP segment received on a raw TCP socket and decide whether it
+ * answers one of our SYN probes (SYN-ACK for open ports, RST for closed).
+ * @param packet Pointer to received packet (starting at the IP header)
+ * @param len Length of received packet
+ * @param out Filled with ports, flags and the acknowledged probe sequence
+ * @return 0 if it is a SYN-ACK or RST, -1 otherwise
+ */
+int tcp_parse_reply(const void *packet, size_t len, TcpReply *out){
+
+    //Validate parameters
+    if(packet == NULL || out == NULL){
+        return -1;
+    }
+
+    memset(out, 0, sizeof(*out));
+
+    const unsigned char *buf = (const unsigned char *)packet;
+    if(len < sizeof(struct iphdr)){
+        return -1;
+    }
+
+    const struct iphdr *iph = (const struct iphdr *)buf;
+    size_t iphdr_len = iph->ihl * 4;
+    if(iph->protocol != IPPROTO_TCP || len < iphdr_len + sizeof(struct tcphdr)){
+        return -1;
+    }
+
+    const struct tcphdr *tcp = (const struct tcphdr *)(buf + iphdr_len);
+
+    // Our own outgoing SYNs show up here too on loopback; only answers count
+    if(!(tcp->syn && tcp->ack) && !tcp->rst){
+        return -1;
+    }
+
+    out->saddr = iph->saddr;
+    out->sport = ntohs(tcp->source);
+    out->dport = ntohs(tcp->dest);
+    out->rst = tcp->rst;
+
+    // Both SYN-ACK and RST acknowledge our SYN with seq + 1
+    out->probe_seq = ntohl(tcp->ack_seq) - 1;
+    return 0;
+}
+
+/**
+ * Generate a classic BPF program for a raw ICMP socket that only lets
+ * through answers to our probes, so unrelated ICMP traffic on the host is
+ * dropped in the kernel instead of being copied to us.
+ *
+ * Accepted packets:
+ *  - Echo Reply whose identifier is 'key' (only if accept_echo)
+ *  - Time Exceeded / Destination Unreachable quoting a 'quoted_proto' probe
+ *    whose key field matches: ICMP id, UDP source port, or the upper half
+ *    of the TCP sequence number
+ *
+ * Raw sockets see the packet from the IP header on; IP header lengths are
+ * read from the packet (outer with BPF_MSH, quoted with ALU ops into X).
+ *
+ * @param quoted_proto IPPROTO_ICMP, IPPROTO_UDP or IPPROTO_TCP
+ * @param key Identifier / source port to match
+ * @param accept_echo true to accept Echo Replies (ICMP probes)
+ * @param out Output program (at least ICMP_FILTER_LEN instructions)
+ * @param max Capacity of out
+ * @return Number of instructions, or -1 on error
+ */
+int icmp_build_filter(int quoted_proto, uint16_t key, bool accept_echo, struct sock_filter *out, size_t max){
+
+    //Validate parameters
+    if(out == NULL || max < ICMP_FILTER_LEN){
+        return -1;
+    }
+
+    // Offset of the key field from the start of the quoted transport header
+    uint32_t key_off;
+    if(quoted_proto == IPPROTO_ICMP || quoted_proto == IPPROTO_TCP){
+        key_off = 4; // ICMP: id (after type, code, checksum); TCP: high half of seq
+    }
+    else if(quoted_proto == IPPROTO_UDP){
+        key_off = 0; // UDP: source port
+    }
+    else{
+        return -1;
+    }
+
+    // A 16-bit load never equals a 17-bit constant, so this turns the Echo branch off
+    uint32_t echo_key = accept_echo ? key : 0x10000;
+
+    const struct sock_filter prog[ICMP_FILTER_LEN] = {
+        // X = outer IP header length
+        /*  0 */ BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, 0),
+        // A = ICMP type
+        /*  1 */ BPF_STMT(BPF_LD | BPF_B | BPF_IND, 0),
+        /*  2 */ BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ICMP_ECHOREPLY, 2, 0),
+        /*  3 */ BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ICMP_TIME_EXCEEDED, 3, 0),
+        /*  4 */ BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ICMP_DEST_UNREACH, 2, 12),
+        // Echo Reply: identifier at ICMP offset 4
+        /*  5 */ BPF_STMT(BPF_LD | BPF_H | BPF_IND, 4),
+        /*  6 */ BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, echo_key, 9, 10),
+        // Error: quoted IP header starts at ICMP offset 8, its protocol byte at +9
+        /*  7 */ BPF_STMT(BPF_LD | BPF_B | BPF_IND, 8 + 9),
+        /*  8 */ BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, (uint32_t)quoted_proto, 0, 8),
+        // X += quoted IP header length
+        /*  9 */ BPF_STMT(BPF_LD | BPF_B | BPF_IND, 8),
+        /* 10 */ BPF_STMT(BPF_ALU | BPF_AND | BPF_K, 0x0f),
+        /* 11 */ BPF_STMT(BPF_ALU | BPF_LSH | BPF_K, 2),
+        /* 12 */ BPF_STMT(BPF_ALU | BPF_ADD | BPF_X, 0),
+        /* 13 */ BPF_STMT(BPF_MISC | BPF_TAX, 0),
+        // Quoted transport header is 8 bytes past X
+        /* 14 */ BPF_STMT(BPF_LD | BPF_H | BPF_IND, 8 + key_off),
+        /* 15 */ BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, key, 0, 1),
+        // Accept whole packet / drop
+        /* 16 */ BPF_STMT(BPF_RET | BPF_K, 0xffff),
+        /* 17 */ BPF_STMT(BPF_RET | BPF_K, 0),
+    };
+
+    memcpy(out, prog, sizeof(prog));
+    return ICMP_FILTER_LEN;
+}
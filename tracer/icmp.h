@@ -4,13 +4,31 @@
  *
  * Responsibilities:
  *  - Build ICMP Echo packets
+ *  - Build flow-stable (Paris traceroute) Echo packets
+ *  - Prebuilt Echo templates mutated with incremental (RFC 1624) checksum updates
  *  - Compute checksum
+ *  - Build TCP SYN probes (UDP probes need no builder: the kernel does it)
+ *  - Match replies and ICMP errors back to the probe that caused them
+ *  - Generate a cBPF socket filter that drops ICMP not meant for us
  *
  * Public API:
  *  - uint16_t icmp_checksum(const void *buf, size_t len);
  *  - int icmp_build_echo(uint16_t id, uint16_t seq,
  *                        const void *payload, size_t payload_len,
  *                        unsigned char *out, size_t *out_len);
+ *  - int icmp_build_echo_flow(uint16_t id, uint16_t seq, uint16_t flow,
+ *                             unsigned char *out, size_t *out_len);
+ *  - int icmp_template_init(IcmpTemplate *t, unsigned char *buf, size_t cap, uint16_t id,
+ *                           const void *payload, size_t payload_len, bool paris);
+ *  - void icmp_template_set_seq(IcmpTemplate *t, uint16_t seq);
+ *  - void icmp_template_set_flow(IcmpTemplate *t, uint16_t flow);
+ *  - int icmp_parse_reply(const void *packet, size_t len, IcmpReply *out);
+ *  - int icmp_parse_dgram_reply(const void *packet, size_t len, IcmpReply *out);
+ *  - int tcp_build_syn(uint32_t src, uint32_t dst, uint16_t sport, uint16_t dport,
+ *                      uint32_t seq, unsigned char *out, size_t *out_len);
+ *  - int tcp_parse_reply(const void *packet, size_t len, TcpReply *out);
+ *  - int icmp_build_filter(int quoted_proto, uint16_t key, bool accept_echo,
+ *                          struct sock_filter *out, size_t max);
  *
  * Notes:
  *  - Wire format must match platform endianness requirements
@@ -25,9 +43,75 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <stdbool.h>
+#include <linux/filter.h>   // struct sock_filter
+
+// Payload bytes used to hold the checksum compensation word of a Paris probe
+#define ICMP_FLOW_PAYLOAD_LEN 2
+
+// TCP window advertised by SYN probes
+#define TCP_PROBE_WINDOW 5840
+
+// Instructions in the program generated by icmp_build_filter
+#define ICMP_FILTER_LEN 18
+
+/**
+ * Echo Request built once and then mutated in place.
+ * - pkt: packet memory (owned by the caller)
+ * - len: packet length
+ * - paris: checksum pinned to the flow; the compensation word absorbs changes
+ */
+typedef struct IcmpTemplate{
+    unsigned char *pkt;
+    size_t len;
+    bool paris;
+} IcmpTemplate;
+
+/**
+ * Decoded reply to one of our probes.
+ * - type, code: ICMP type/code of the reply (-1 type if unparseable)
+ * - quoted_proto: protocol of the probe (IPPROTO_ICMP for echo probes)
+ * - quoted_dst: destination address of the quoted probe (network order, 0 for echo replies)
+ * - id, seq: identifier/sequence of the probe this reply answers (ICMP probes)
+ * - sport, dport: ports of the quoted probe (UDP/TCP probes)
+ * - tcp_seq: sequence number of the quoted probe (TCP probes)
+ * - next_mtu: next-hop MTU from a Fragmentation Needed error (0 if absent, RFC 1191)
+ */
+typedef struct IcmpReply{
+    int type, code;
+    int quoted_proto;
+    uint32_t quoted_dst;
+    uint16_t id, seq;
+    uint16_t sport, dport;
+    uint32_t tcp_seq;
+    int next_mtu;
+} IcmpReply;
+
+/**
+ * Decoded SYN-ACK/RST answering a TCP SYN probe.
+ * - saddr: source address (network order)
+ * - sport, dport: ports as seen on the reply (dport is our source port)
+ * - rst: true for RST (closed port), false for SYN-ACK (open port)
+ * - probe_seq: sequence number of the SYN being acknowledged
+ */
+typedef struct TcpReply{
+    uint32_t saddr;
+    uint16_t sport, dport;
+    bool rst;
+    uint32_t probe_seq;
+} TcpReply;
 
 uint16_t icmp_checksum(const void *buf, size_t len);
 int icmp_build_echo(uint16_t id, uint16_t seq, const void *payload, size_t payload_len, unsigned char *out, size_t *out_len);
+int icmp_build_echo_flow(uint16_t id, uint16_t seq, uint16_t flow, unsigned char *out, size_t *out_len);
+int icmp_template_init(IcmpTemplate *t, unsigned char *buf, size_t cap, uint16_t id, const void *payload, size_t payload_len, bool paris);
+void icmp_template_set_seq(IcmpTemplate *t, uint16_t seq);
+void icmp_template_set_flow(IcmpTemplate *t, uint16_t flow);
 int icmp_parse_response(const void *packet, size_t len, const char *expected_ip, int *out_type);
+int icmp_parse_reply(const void *packet, size_t len, IcmpReply *out);
+int icmp_parse_dgram_reply(const void *packet, size_t len, IcmpReply *out);
+int tcp_build_syn(uint32_t src, uint32_t dst, uint16_t sport, uint16_t dport, uint32_t seq, unsigned char *out, size_t *out_len);
+int tcp_parse_reply(const void *packet, size_t len, TcpReply *out);
+int icmp_build_filter(int quoted_proto, uint16_t key, bool accept_echo, struct sock_filter *out, size_t max);
 
 #endif /* ICMP_H */
@@ -0,0 +1,484 @@
+/*pmtu.c - Implements path MTU discovery with Don't Fragment ICMP Echo probes.
+ * Responsibilities:
+ *  - Keep a search window [lo, hi] per target: lo is the largest size that got an
+ *    Echo Reply, hi the largest size not yet ruled out
+ *  - Probe the top of the window first (most paths carry the full local MTU),
+ *    then follow Fragmentation Needed hints, and bisect only when routers stay silent
+ *  - One probe per unfinished target per round, all on one raw socket, so N targets
+ *    cost about as many round trips as the slowest one
+ *
+ * Why raw and not the ping socket?
+ *  - Fragmentation Needed errors for a ping socket are consumed by the kernel's own
+ *    PMTU cache and only surface as EMSGSIZE; the raw socket sees the error itself,
+ *    including the router that sent it and its next-hop MTU
+ *
+ * Author: Shan Truong - 400576105 - truons8
+ * Date: December 3, 2025
+ * Coures: 2XC3
+ */
+
+#include "pmtu.h"
+#include "icmp.h"
+#include "../net/net.h"
+#include "../timeutil/timeutil.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <arpa/inet.h>  // inet_ntop()
+#include <netinet/ip.h>
+#include <netinet/ip_icmp.h>
+
+#define PMTU_MIN 68             // every IPv4 link must carry 68 bytes (RFC 791)
+#define PMTU_MAX 65535          // largest IPv4 datagram
+#define PMTU_TIMEOUT_MS 1000    // how long to wait for a round's replies
+#define PMTU_TRIES 2            // silent sends of one size before it counts as too big
+
+// IPv4 + ICMP header bytes in front of the Echo payload
+#define PMTU_HDR_LEN ((int)(sizeof(struct iphdr) + sizeof(struct icmphdr)))
+
+/*
+ * Search state for one target.
+ * lo, hi:  window; lo = PMTU_MIN - 1 until something gets through
+ * next:    size to try next (hint or retry), 0 = bisect
+ * size:    size of the probe in flight
+ * seq:     its sequence number
+ * tries:   unanswered sends at 'size'
+ * silent:  some size timed out without a Fragmentation Needed
+ */
+typedef struct {
+    struct sockaddr_in addr;
+    int lo, hi;
+    int next;
+    int size;
+    uint16_t seq;
+    int tries;
+    long long sent_us;
+    bool waiting;
+    bool silent;
+    bool done;
+} PmtuState;
+
+/**
+ * Append a PmtuResult to PmtuTable, resizing if needed.
+ * @param table Pointer to PmtuTable
+ * @param r Pointer to PmtuResult to append
+ */
+static void pmtu_append(PmtuTable *table, const PmtuResult *r){
+
+    // Resize if needed
+    if(table->len == table->cap){
+
+        // Double capacity or start at 4
+        size_t newcap = table->cap ? table->cap * 2 : 4;
+
+        table->rows = realloc(table->rows, newcap * sizeof(PmtuResult));
+        table->cap = newcap;
+    }
+
+    table->rows[table->len++] = *r;
+}
+
+/**
+ * Split a comma-separated target list.
+ * @param list Targets as given on the command line
+ * @param names Output array of PMTU_MAX_TARGETS names
+ * @return Number of targets, or -1 if the list is empty/too long
+ */
+static int pmtu_split_targets(const char *list, char names[][256]){
+
+    int n = 0;
+    const char *p = list;
+
+    while(*p != '\0'){
+
+        const char *comma = strchr(p, ',');
+        size_t len = comma ? (size_t)(comma - p) : strlen(p);
+
+        if(len == 0 || len >= 256 || n == PMTU_MAX_TARGETS){
+            return -1;
+        }
+
+        memcpy(names[n], p, len);
+        names[n][len] = '\0';
+        n++;
+
+        if(comma == NULL){
+            break;
+        }
+        p = comma + 1;
+    }
+
+    return n > 0 ? n : -1;
+}
+
+/**
+ * Pick the next probe size for a target.
+ * @param st Target state
+ * @param first true if nothing was sent to this target yet
+ * @return Size in bytes (IP header included)
+ */
+static int pmtu_next_size(const PmtuState *st, bool first){
+
+    // A hint or retry inside the window wins
+    if(st->next > st->lo && st->next <= st->hi){
+        return st->next;
+    }
+
+    // Most paths carry the full local MTU: one round trip settles them
+    if(first){
+        return st->hi;
+    }
+
+    // Bisect, rounding up so the window always shrinks
+    return st->lo + (st->hi - st->lo + 1) / 2;
+}
+
+/**
+ * Send one DF Echo probe of st->size bytes.
+ * @param fd Raw ICMP socket
+ * @param id Echo identifier
+ * @param st Target state (size and seq set)
+ * @param pkt Scratch buffer of at least PMTU_MAX bytes
+ * @return 0 if sent, 1 if the size is over the local interface MTU, -1 on error
+ */
+static int pmtu_send(int fd, uint16_t id, PmtuState *st, unsigned char *pkt){
+
+    // Zero payload: only the size matters
+    static const unsigned char payload[PMTU_MAX];
+
+    size_t len = 0;
+    if(icmp_build_echo(id, st->seq, payload, (size_t)(st->size - PMTU_HDR_LEN), pkt, &len) != 0){
+        return -1;
+    }
+
+    st->sent_us = us_now();
+
+    if(sendto(fd, pkt, len, 0, (struct sockaddr *)&st->addr, sizeof(st->addr)) < 0){
+
+        // IP_PMTUDISC_PROBE only refuses what the interface itself can't carry
+        if(errno == EMSGSIZE){
+            return 1;
+        }
+
+        perror("sendto");
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Apply one received packet to the target it answers.
+ * @param states Target states
+ * @param n Number of targets
+ * @param rows Result rows (same order as states)
+ * @param id Echo identifier
+ * @param buf Packet (IP header included)
+ * @param len Packet length
+ * @param from Sender
+ * @param rx_us Receive timestamp
+ * @return true if a waiting probe was completed
+ */
+static bool pmtu_handle(PmtuState *states, int n, PmtuResult *rows, uint16_t id,
+                        const unsigned char *buf, size_t len, const struct sockaddr_in *from, long long rx_us){
+
+    IcmpReply reply;
+    if(icmp_parse_reply(buf, len, &reply) != 0 || reply.quoted_proto != IPPROTO_ICMP || reply.id != id){
+        return false;
+    }
+
+    // Sequence numbers are unique per run, so at most one target matches
+    PmtuState *st = NULL;
+    PmtuResult *row = NULL;
+    for(int i = 0; i < n; i++){
+        if(states[i].waiting && states[i].seq == reply.seq){
+            st = &states[i];
+            row = &rows[i];
+            break;
+        }
+    }
+
+    if(st == NULL){
+        return false;
+    }
+
+    // Echo Reply from the target: this size fits the whole path
+    if(reply.type == ICMP_ECHOREPLY){
+
+        if(from->sin_addr.s_addr != st->addr.sin_addr.s_addr){
+            return false;
+        }
+
+        st->lo = st->size;
+        st->next = 0;
+        row->rtt_us = (long)(rx_us - st->sent_us);
+    }
+
+    // Fragmentation Needed: too big, and usually the router says what would fit
+    else if(reply.type == ICMP_DEST_UNREACH && reply.code == ICMP_FRAG_NEEDED){
+
+        st->hi = st->size - 1;
+        st->next = 0;
+
+        // Trust a hint inside the window (old routers send 0, RFC 1191 section 5)
+        if(reply.next_mtu > st->lo && reply.next_mtu < st->size){
+            st->hi = reply.next_mtu;
+            st->next = reply.next_mtu;
+        }
+
+        row->hint_mtu = reply.next_mtu;
+        inet_ntop(AF_INET, &from->sin_addr, row->hint_from, sizeof(row->hint_from));
+    }
+
+    // Any other unreachable: no size will get through, keep what we have
+    else if(reply.type == ICMP_DEST_UNREACH){
+        st->hi = st->lo;
+    }
+
+    else{
+        return false;
+    }
+
+    st->waiting = false;
+    st->tries = 0;
+    return true;
+}
+
+/**
+ * Wait for replies until every probe is answered or the round times out.
+ * @param fd Raw ICMP socket
+ * @param states Target states
+ * @param n Number of targets
+ * @param rows Result rows
+ * @param id Echo identifier
+ * @param waiting Number of probes in flight
+ */
+static void pmtu_collect(int fd, PmtuState *states, int n, PmtuResult *rows, uint16_t id, int waiting){
+
+    static unsigned char buf[PMTU_MAX + 1];
+    long long deadline = us_now() + (long long)PMTU_TIMEOUT_MS * 1000LL;
+
+    while(waiting > 0){
+
+        long long remaining = deadline - us_now();
+        if(remaining <= 0){
+            break;
+        }
+
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        int ready = poll(&pfd, 1, (int)((remaining + 999) / 1000));
+
+        if(ready < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            perror("poll");
+            break;
+        }
+
+        if(ready == 0){
+            break;
+        }
+
+        struct sockaddr_in from;
+        socklen_t fromlen = sizeof(from);
+        long long rx_us = 0;
+
+        ssize_t got = net_recv_timestamped(fd, buf, sizeof(buf), (struct sockaddr *)&from, &fromlen, &rx_us);
+        if(got < 0){
+            continue;
+        }
+
+        if(pmtu_handle(states, n, rows, id, buf, (size_t)got, &from, rx_us)){
+            waiting--;
+        }
+    }
+}
+
+/**
+ * Discover the path MTU to every target in cmd->target.
+ * @param cmd Pointer to CommandLine (target list)
+ * @param out Pointer to PmtuTable to fill (one row per target, in order)
+ * @return 0 on success, -1 on error
+ */
+int tracer_pmtu(const CommandLine *cmd, PmtuTable *out){
+
+    //Validate parameters
+    if(cmd == NULL || out == NULL){
+        return -1;
+    }
+
+    static char names[PMTU_MAX_TARGETS][256];
+    int n = pmtu_split_targets(cmd->target, names);
+
+    if(n < 0){
+        fprintf(stderr, "Error: --pmtu takes 1-%d comma-separated targets\n", PMTU_MAX_TARGETS);
+        return -1;
+    }
+
+    PmtuState states[PMTU_MAX_TARGETS];
+    PmtuResult rows[PMTU_MAX_TARGETS];
+    memset(states, 0, sizeof(states));
+    memset(rows, 0, sizeof(rows));
+
+    for(int i = 0; i < n; i++){
+
+        struct sockaddr_storage ss;
+        socklen_t ss_len;
+
+        if(net_resolve(names[i], &ss, &ss_len) != 0 || ss.ss_family != AF_INET){
+            fprintf(stderr, "Error: Failed to resolve target '%s'\n", names[i]);
+            return -1;
+        }
+
+        memcpy(&states[i].addr, &ss, sizeof(states[i].addr));
+
+        // The route MTU is the most the first hop will take with DF set
+        int route_mtu = 0;
+        if(net_route_mtu(&states[i].addr, &route_mtu) != 0 || route_mtu < PMTU_MIN){
+            route_mtu = 1500;
+        }
+
+        states[i].lo = PMTU_MIN - 1;
+        states[i].hi = route_mtu > PMTU_MAX ? PMTU_MAX : route_mtu;
+
+        strncpy(rows[i].target, names[i], sizeof(rows[i].target) - 1);
+        inet_ntop(AF_INET, &states[i].addr.sin_addr, rows[i].ip, sizeof(rows[i].ip));
+        rows[i].rtt_us = -1;
+    }
+
+    int fd = net_icmp_raw_socket();
+    if(fd < 0){
+        return -1;
+    }
+
+    if(net_set_pmtu_probe(fd) != 0){
+        close(fd);
+        return -1;
+    }
+
+    // Timestamps and the filter are optimizations; carry on without them
+    net_enable_timestamps(fd);
+
+    uint16_t id = (uint16_t)(getpid() & 0xFFFF);
+
+    struct sock_filter filter[ICMP_FILTER_LEN];
+    if(icmp_build_filter(IPPROTO_ICMP, id, true, filter, ICMP_FILTER_LEN) == ICMP_FILTER_LEN){
+        net_attach_filter(fd, filter, ICMP_FILTER_LEN);
+    }
+
+    static unsigned char pkt[PMTU_MAX];
+    uint16_t next_seq = 1;
+    int active = n;
+
+    while(active > 0){
+
+        int waiting = 0;
+
+        // Send one probe to every target still searching
+        for(int i = 0; i < n; i++){
+
+            PmtuState *st = &states[i];
+
+            while(!st->done && !st->waiting){
+
+                if(st->lo >= st->hi){
+                    st->done = true;
+                    active--;
+                    break;
+                }
+
+                st->size = pmtu_next_size(st, rows[i].probes == 0);
+                st->seq = next_seq++;
+
+                int sent = pmtu_send(fd, id, st, pkt);
+                if(sent < 0){
+                    close(fd);
+                    return -1;
+                }
+
+                // Over the interface MTU: ruled out without a round trip
+                if(sent == 1){
+                    st->hi = st->size - 1;
+                    st->next = 0;
+                    continue;
+                }
+
+                rows[i].probes++;
+                st->waiting = true;
+                waiting++;
+            }
+        }
+
+        if(waiting == 0){
+            continue;
+        }
+
+        pmtu_collect(fd, states, n, rows, id, waiting);
+
+        // Unanswered: retry the same size, then treat it as too big
+        for(int i = 0; i < n; i++){
+
+            PmtuState *st = &states[i];
+            if(!st->waiting){
+                continue;
+            }
+
+            st->waiting = false;
+            st->tries++;
+
+            if(st->tries < PMTU_TRIES){
+                st->next = st->size;
+            }
+            else{
+                st->hi = st->size - 1;
+                st->next = 0;
+                st->tries = 0;
+                st->silent = true;
+
+                // Nothing through yet: check the target answers at all before bisecting
+                if(st->lo < PMTU_MIN){
+                    st->next = PMTU_MIN;
+                }
+            }
+        }
+    }
+
+    close(fd);
+
+    for(int i = 0; i < n; i++){
+
+        rows[i].mtu = (states[i].lo >= PMTU_MIN) ? states[i].lo : -1;
+
+        // Only a black hole if smaller packets did get through
+        rows[i].blackhole = states[i].silent && rows[i].mtu > 0;
+
+        pmtu_append(out, &rows[i]);
+    }
+
+    return 0;
+}
+
+/**
+ * Free memory allocated for PmtuTable.
+ * @param table Pointer to PmtuTable
+ */
+void pmtutable_free(PmtuTable *table){
+
+    //Check for NULL
+    if(table == NULL){
+        return;
+    }
+
+    //Free allocated rows
+    free(table->rows);
+
+    //Reset PmtuTable
+    table->rows = NULL;
+    table->len = 0;
+    table->cap = 0;
+}
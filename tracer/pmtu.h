@@ -0,0 +1,43 @@
+/*
+ * File: pmtu.h
+ * Summary: Path MTU discovery towards one or more targets.
+ *
+ * Responsibilities:
+ *  - Binary-search the largest ICMP Echo (Don't Fragment set) each target answers
+ *  - Jump straight to the next-hop MTU reported by Fragmentation Needed errors
+ *    (ICMP type 3 code 4, RFC 1191) instead of bisecting blindly
+ *  - Probe every target concurrently from one raw ICMP socket
+ *  - Flag PMTU black holes: big probes dropped without any Fragmentation Needed
+ *
+ * Data & Types:
+ *  - typedef struct PmtuResult { char target[256]; char ip[64]; int mtu; int hint_mtu; char hint_from[64]; int probes; long rtt_us; bool blackhole; }
+ *  - typedef struct PmtuTable { PmtuResult *rows; size_t len, cap; }
+ *
+ * Public API:
+ *  - int  tracer_pmtu(const CommandLine *cmd, PmtuTable *out);
+ *  - void pmtutable_free(PmtuTable *table);
+ *
+ * Inputs:
+ *  - cmd->target: one host, or several separated by commas
+ *
+ * Returns:
+ *  - 0 on success; <0 on error (raw socket permissions, resolve fail, etc.)
+ *
+ * Author: Shan Truong - 400576105 - truons8
+ * Date: December 3, 2025
+ * Coures: 2XC3
+ */
+
+#ifndef PMTU_H
+#define PMTU_H
+
+#include "../cli/cli.h"
+#include "../model/model.h"
+
+// Most targets one --pmtu run probes at once
+#define PMTU_MAX_TARGETS 32
+
+int  tracer_pmtu(const CommandLine *cmd, PmtuTable *out);
+void pmtutable_free(PmtuTable *table);
+
+#endif /* PMTU_H */
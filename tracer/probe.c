@@ -0,0 +1,794 @@
+/*probe.c - Parallel probe engine (ICMP Echo, UDP, TCP SYN).
+    * Responsibilities:
+    *  - Send every probe of a round without waiting for the previous one,
+    *    in sendmmsg() batches with per-packet TTLs
+    *  - Drain replies with recvmmsg() into a preallocated packet arena
+    *  - Match each reply (Echo Reply, SYN-ACK/RST or quoted ICMP error) to its probe by seq
+    *  - Time each probe with kernel receive timestamps
+    *  - Filter foreign ICMP in the kernel (cBPF) on raw sockets
+    *  - Wait on the rounds of several engines at once (one per destination)
+ *
+ * Author: Shan Truong - 400576105 - truons8
+ * Date: December 3, 2025
+ * Coures: 2XC3
+ */
+
+#include "probe.h"
+#include "icmp.h"
+#include "../net/net.h"
+#include "../timeutil/timeutil.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <netinet/ip_icmp.h>
+
+// Zero bytes carried by UDP probes (same size classic traceroute sends)
+#define UDP_PROBE_PAYLOAD_LEN 32
+
+// Send attempts on a ping socket whose pending ICMP error fails the send
+#define PROBE_SEND_RETRIES 4
+
+/**
+ * Attach a cBPF filter to the raw ICMP socket so only replies and errors
+ * for this engine's probes reach userspace. Failure is harmless: every
+ * packet is still matched in probe_match_icmp.
+ * @param eng Engine with proto, id and sport set
+ */
+static void probe_engine_filter(ProbeEngine *eng){
+
+    struct sock_filter prog[ICMP_FILTER_LEN];
+    int len;
+
+    //UDP errors are recognized by our source port, ICMP and TCP by the id
+    if(eng->proto == PROBE_UDP){
+        len = icmp_build_filter(IPPROTO_UDP, eng->sport, false, prog, ICMP_FILTER_LEN);
+    }
+    else if(eng->proto == PROBE_TCP){
+        len = icmp_build_filter(IPPROTO_TCP, eng->id, false, prog, ICMP_FILTER_LEN);
+    }
+    else{
+        len = icmp_build_filter(IPPROTO_ICMP, eng->id, true, prog, ICMP_FILTER_LEN);
+    }
+
+    if(len > 0){
+        net_attach_filter(eng->sockfd, prog, (size_t)len);
+    }
+}
+
+/**
+ * Open the sockets used for a run of probes.
+ * Every probe type needs the raw ICMP socket: routers answer UDP and TCP
+ * probes with ICMP Time Exceeded just like Echo probes.
+ * @param eng Engine to initialize
+ * @param proto Probe packet type
+ * @param port UDP base port or TCP destination port (ignored for ICMP)
+ * @param dst Destination address (from net_resolve)
+ * @param dst_len Length of dst
+ * @return 0 on success, -1 on error (message already printed)
+ */
+int probe_engine_open(ProbeEngine *eng, ProbeProto proto, uint16_t port, const struct sockaddr_storage *dst, socklen_t dst_len){
+
+    //Validate parameters
+    if(eng == NULL || dst == NULL){
+        return -1;
+    }
+
+    memset(eng, 0, sizeof(*eng));
+    eng->proto = proto;
+    eng->port = port;
+    eng->sendfd = -1;
+    eng->portfd = -1;
+
+    //Echo probes can use an unprivileged ping socket when ping_group_range allows it;
+    //the kernel then picks the identifier and only hands us our own replies
+    if(proto == PROBE_ICMP){
+        eng->sockfd = net_icmp_dgram_socket(&eng->id);
+        eng->dgram = eng->sockfd >= 0;
+    }
+
+    //creating raw ICMP socket (UDP/TCP probes always need it to see ICMP errors)
+    if(!eng->dgram){
+
+        eng->sockfd = net_icmp_raw_socket();
+        if(eng->sockfd < 0){
+            return -1; // error already printed
+        }
+
+        //Per-process identifier so concurrent wirefish runs don't steal each other's replies
+        eng->id = (uint16_t)(getpid() & 0xFFFF);
+    }
+
+    //Ask the kernel to timestamp replies on arrival (falls back to userspace time if unsupported)
+    net_enable_timestamps(eng->sockfd);
+    eng->next_seq = 1;
+
+    memcpy(&eng->dst, dst, sizeof(eng->dst));
+    eng->dst_len = dst_len;
+
+    //Packet arena shared by the send and receive batches
+    eng->arena = calloc(PROBE_BATCH, PROBE_TX_SLOT_LEN + PROBE_SLOT_LEN);
+    if(eng->arena == NULL){
+        fprintf(stderr, "Error: Memory allocation failed for probe buffers\n");
+        probe_engine_close(eng);
+        return -1;
+    }
+
+    //UDP probes: the kernel builds the datagrams, the bound source port marks them as ours
+    if(proto == PROBE_UDP){
+        eng->sendfd = net_bound_socket(SOCK_DGRAM, &eng->sport);
+        if(eng->sendfd < 0){
+            probe_engine_close(eng);
+            return -1;
+        }
+    }
+
+    //TCP probes: hand-built SYNs on a raw socket, which also receives the SYN-ACK/RST answers
+    if(proto == PROBE_TCP){
+
+        //Reserve a source port so no real connection ends up using it
+        eng->portfd = net_bound_socket(SOCK_STREAM, &eng->sport);
+        if(eng->portfd < 0){
+            probe_engine_close(eng);
+            return -1;
+        }
+
+        //The TCP checksum covers our source address, so find it before building anything
+        if(net_source_addr((const struct sockaddr_in *)dst, &eng->src) != 0){
+            fprintf(stderr, "Error: No route to target\n");
+            probe_engine_close(eng);
+            return -1;
+        }
+
+        eng->sendfd = net_tcp_raw_socket();
+        if(eng->sendfd < 0){
+            probe_engine_close(eng);
+            return -1;
+        }
+
+        net_enable_timestamps(eng->sendfd);
+    }
+
+    //Raw sockets see all ICMP on the host; drop what isn't ours before it is queued
+    if(!eng->dgram){
+        probe_engine_filter(eng);
+    }
+
+    return 0;
+}
+
+/**
+ * Number of destination ports UDP probes cycle through.
+ * @param eng Engine (port is the base)
+ * @return Ports available from the base port up, at most UDP_PORT_SPAN
+ */
+static size_t probe_udp_span(const ProbeEngine *eng){
+
+    size_t span = 65536 - (size_t)eng->port;
+    return span < UDP_PORT_SPAN ? span : UDP_PORT_SPAN;
+}
+
+/**
+ * Find the probe a sequence number belongs to.
+ * Sequence numbers of a round are consecutive, so this is a subtraction.
+ * @param probes Probes of the current round
+ * @param n Number of probes
+ * @param seq Sequence number from the reply
+ * @return Pointer to the probe, or NULL if seq is not from this round
+ */
+static Probe *probe_lookup(Probe *probes, size_t n, uint16_t seq){
+
+    if(n == 0){
+        return NULL;
+    }
+
+    //uint16_t arithmetic wraps the same way the engine hands out seqs
+    uint16_t idx = (uint16_t)(seq - probes[0].seq);
+    if(idx >= n){
+        return NULL;
+    }
+
+    return &probes[idx];
+}
+
+/**
+ * Find the probe a UDP destination port belongs to.
+ * Ports wrap every span probes, so the port is mapped back onto the
+ * round's seq range first.
+ * @param eng Engine (base port)
+ * @param probes Probes of the current round
+ * @param n Number of probes
+ * @param dport Destination port quoted in the ICMP error
+ * @return Pointer to the probe, or NULL if the port is not from this round
+ */
+static Probe *probe_lookup_port(const ProbeEngine *eng, Probe *probes, size_t n, uint16_t dport){
+
+    size_t span = probe_udp_span(eng);
+    if(n == 0 || dport < eng->port || (size_t)(dport - eng->port) >= span){
+        return NULL;
+    }
+
+    size_t off = (size_t)(dport - eng->port);
+    size_t first = probes[0].seq % span;
+    size_t idx = (off + span - first) % span;
+
+    return probe_lookup(probes, n, (uint16_t)(probes[0].seq + idx));
+}
+
+/**
+ * Build the Echo templates in the send slots, once per engine (and again
+ * if Paris mode is switched after probe_engine_open).
+ * @param eng Engine from probe_engine_open
+ * @return 0 on success, -1 on error
+ */
+static int probe_engine_templates(ProbeEngine *eng){
+
+    for(size_t i = 0; i < PROBE_BATCH; i++){
+        if(icmp_template_init(&eng->tmpl[i], eng->arena + i * PROBE_TX_SLOT_LEN, PROBE_TX_SLOT_LEN, eng->id, NULL, 0, eng->paris) != 0){
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Build one probe of the configured type into a batch slot.
+ * @param eng Engine from probe_engine_open
+ * @param p Probe with ttl, flow and seq filled in
+ * @param slot Send slot index (its arena memory holds the probe)
+ * @return 0 on success, -1 on error (message already printed)
+ */
+static int probe_build(ProbeEngine *eng, const Probe *p, size_t slot){
+
+    const struct sockaddr_in *dst = (const struct sockaddr_in *)&eng->dst;
+    NetPacket *pkt = &eng->batch[slot];
+    int built = 0;
+
+    pkt->buf = eng->arena + slot * PROBE_TX_SLOT_LEN;
+    pkt->addr = *dst;
+    pkt->ttl = p->ttl;
+
+    if(eng->proto == PROBE_UDP){
+
+        //Each probe gets its own destination port; that is all there is to identify it by
+        //(the payload is the slot's zeroed memory, never written)
+        pkt->addr.sin_port = htons((uint16_t)(eng->port + p->seq % probe_udp_span(eng)));
+        pkt->len = UDP_PROBE_PAYLOAD_LEN;
+    }
+    else if(eng->proto == PROBE_TCP){
+
+        //id in the upper half of the sequence number, probe seq in the lower half
+        uint32_t seq = ((uint32_t)eng->id << 16) | p->seq;
+        built = tcp_build_syn(eng->src.s_addr, dst->sin_addr.s_addr, eng->sport, eng->port, seq, pkt->buf, &pkt->len);
+    }
+    else{
+        //Echo probes only patch the template in this slot: seq, and the flow for Paris
+        //probes (pinning the checksum so every TTL hashes onto the same ECMP path)
+        IcmpTemplate *t = &eng->tmpl[slot];
+        if(eng->paris){
+            icmp_template_set_flow(t, p->flow);
+        }
+        icmp_template_set_seq(t, p->seq);
+        pkt->len = t->len;
+    }
+
+    if(built < 0){
+        fprintf(stderr, "Error: probe packet build failed\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Send a built batch with sendmmsg(), resuming after partial sends.
+ * @param eng Engine from probe_engine_open
+ * @param probes Probes matching the batch slots (send times are recorded)
+ * @param n Number of packets in eng->batch
+ * @return 0 on success, -1 on error (message already printed)
+ */
+static int probe_send_batch(ProbeEngine *eng, Probe *probes, size_t n){
+
+    int fd = (eng->proto == PROBE_ICMP) ? eng->sockfd : eng->sendfd;
+    size_t done = 0;
+    int tries = 0;
+
+    while(done < n){
+
+        // Record send time (same clock as the kernel receive timestamp); the
+        // whole batch leaves within one syscall so it shares one stamp
+        long long now = us_now();
+        for(size_t i = done; i < n; i++){
+            probes[i].sent_us = now;
+        }
+
+        int sent = net_send_batch(fd, eng->batch + done, n - done);
+
+        //A ping socket reports the latest ICMP error (e.g. an earlier probe's Time Exceeded)
+        //as the result of the next send; the failed send consumes that pending error,
+        //so the send can simply be repeated
+        if(sent < 0){
+            if(eng->dgram && ++tries < PROBE_SEND_RETRIES){
+                continue;
+            }
+            perror("sendmmsg");
+            return -1;
+        }
+
+        //Retries count consecutive failures: errors scattered across a large batch are fine
+        if(sent > 0){
+            tries = 0;
+        }
+        done += (size_t)sent;
+    }
+
+    return 0;
+}
+
+/**
+ * Match a packet from the raw ICMP socket to a probe of this round.
+ * @param eng Engine from probe_engine_open
+ * @param probes Probes of the current round
+ * @param n Number of probes
+ * @param reply Parsed ICMP reply
+ * @return Pointer to the probe, or NULL if the reply is for someone else
+ */
+static Probe *probe_match_icmp(const ProbeEngine *eng, Probe *probes, size_t n, const IcmpReply *reply){
+
+    if(eng->proto == PROBE_UDP){
+        if(reply->quoted_proto != IPPROTO_UDP || reply->sport != eng->sport){
+            return NULL;
+        }
+        return probe_lookup_port(eng, probes, n, reply->dport);
+    }
+
+    if(eng->proto == PROBE_TCP){
+        if(reply->quoted_proto != IPPROTO_TCP || reply->sport != eng->sport || (reply->tcp_seq >> 16) != eng->id){
+            return NULL;
+        }
+        return probe_lookup(probes, n, (uint16_t)(reply->tcp_seq & 0xFFFF));
+    }
+
+    //Echo probes: Echo Replies and quoted Echo Requests both carry id/seq
+    if(reply->quoted_proto != IPPROTO_ICMP || reply->id != eng->id){
+        return NULL;
+    }
+    return probe_lookup(probes, n, reply->seq);
+}
+
+/**
+ * Fill in a probe's result once its reply has been matched.
+ * @param p Probe to complete
+ * @param from Address that answered
+ * @param rx_us Receive timestamp
+ * @param icmp_type ICMP type of the reply (-1 for TCP answers)
+ * @param reached true if the destination itself answered
+ */
+static void probe_complete(Probe *p, const struct sockaddr_in *from, long long rx_us, int icmp_type, bool reached){
+
+    p->answered = true;
+    p->reached = reached;
+    p->icmp_type = icmp_type;
+    p->from = *from;
+    p->rtt_us = (long)(rx_us - p->sent_us);
+
+    //A wall-clock step between send and receive can make this negative; clamp it
+    if(p->rtt_us < 0){
+        p->rtt_us = 0;
+    }
+}
+
+/**
+ * Receive slot i of the engine arena (after the send slots).
+ * @param eng Engine from probe_engine_open
+ * @param i Slot index
+ * @return Pointer to the slot memory
+ */
+static unsigned char *probe_rx_slot(ProbeEngine *eng, size_t i){
+
+    return eng->arena + (size_t)PROBE_BATCH * PROBE_TX_SLOT_LEN + i * PROBE_SLOT_LEN;
+}
+
+/**
+ * Match one ping socket message to a probe.
+ * Echo Replies come through the normal queue, ICMP errors through the
+ * error queue; the kernel already dropped anything not addressed to us.
+ * @param eng Engine from probe_engine_open (dgram mode)
+ * @param probes Probes of the current round
+ * @param n Number of probes
+ * @param pkt Received message (Echo Reply, or our Echo Request for errors)
+ * @param type ICMP type of the error, or -1 for the normal queue
+ * @return 1 if a pending probe was answered, 0 otherwise
+ */
+static int probe_handle_dgram(const ProbeEngine *eng, Probe *probes, size_t n, const NetPacket *pkt, int type){
+
+    const struct sockaddr_in *dst = (const struct sockaddr_in *)&eng->dst;
+
+    IcmpReply reply;
+    if(icmp_parse_dgram_reply(pkt->buf, pkt->len, &reply) != 0){
+        return 0;
+    }
+
+    if(type < 0){
+        type = reply.type;
+    }
+
+    Probe *p = probe_lookup(probes, n, reply.seq);
+    if(p == NULL || p->answered){
+        return 0;
+    }
+
+    bool reached = type == ICMP_ECHOREPLY
+                || (type == ICMP_DEST_UNREACH && pkt->addr.sin_addr.s_addr == dst->sin_addr.s_addr);
+
+    probe_complete(p, &pkt->addr, pkt->rx_us, type, reached);
+    return 1;
+}
+
+/**
+ * Match one packet from a raw socket (ICMP or TCP) to a probe.
+ * @param eng Engine from probe_engine_open (raw mode)
+ * @param probes Probes of the current round
+ * @param n Number of probes
+ * @param fd Socket the packet came from
+ * @param pkt Received packet (starting at the IP header)
+ * @return 1 if a pending probe was answered, 0 otherwise
+ */
+static int probe_handle_raw(const ProbeEngine *eng, Probe *probes, size_t n, int fd, const NetPacket *pkt){
+
+    const struct sockaddr_in *dst = (const struct sockaddr_in *)&eng->dst;
+
+    Probe *p = NULL;
+    int icmp_type = -1;
+    bool reached = false;
+
+    if(fd == eng->sockfd){
+
+        //Skip anything that isn't an answer to one of our probes
+        IcmpReply reply;
+        if(icmp_parse_reply(pkt->buf, pkt->len, &reply) != 0){
+            return 0;
+        }
+
+        //Engines of one process share the id, and every raw socket sees every reply:
+        //keep only answers about this engine's destination
+        uint32_t about = reply.type == ICMP_ECHOREPLY ? pkt->addr.sin_addr.s_addr : reply.quoted_dst;
+        if(about != dst->sin_addr.s_addr){
+            return 0;
+        }
+
+        p = probe_match_icmp(eng, probes, n, &reply);
+        icmp_type = reply.type;
+
+        //Echo Reply, or the target itself refusing the probe (UDP Port Unreachable)
+        reached = reply.type == ICMP_ECHOREPLY
+               || (reply.type == ICMP_DEST_UNREACH && pkt->addr.sin_addr.s_addr == dst->sin_addr.s_addr);
+    }
+    else{
+
+        //SYN-ACK (open) or RST (closed) from the target port, addressed to our source port
+        TcpReply reply;
+        if(tcp_parse_reply(pkt->buf, pkt->len, &reply) != 0
+           || reply.saddr != dst->sin_addr.s_addr
+           || reply.sport != eng->port
+           || reply.dport != eng->sport
+           || (reply.probe_seq >> 16) != eng->id){
+            return 0;
+        }
+
+        p = probe_lookup(probes, n, (uint16_t)(reply.probe_seq & 0xFFFF));
+        reached = true;
+    }
+
+    if(p == NULL || p->answered){
+        return 0;
+    }
+
+    probe_complete(p, &pkt->addr, pkt->rx_us, icmp_type, reached);
+    return 1;
+}
+
+/**
+ * Drain everything queued on one socket with recvmmsg() into the arena
+ * and match it against the round.
+ * @param eng Engine from probe_engine_open
+ * @param probes Probes of the current round
+ * @param n Number of probes
+ * @param fd Socket to drain
+ * @return Number of pending probes answered
+ */
+static size_t probe_drain(ProbeEngine *eng, Probe *probes, size_t n, int fd){
+
+    size_t answered = 0;
+
+    for(;;){
+
+        for(size_t i = 0; i < PROBE_BATCH; i++){
+            eng->batch[i].buf = probe_rx_slot(eng, i);
+            eng->batch[i].cap = PROBE_SLOT_LEN;
+        }
+
+        int got = net_recv_batch(fd, eng->batch, PROBE_BATCH);
+        if(got <= 0){
+            break;
+        }
+
+        for(int i = 0; i < got; i++){
+            answered += eng->dgram
+                      ? (size_t)probe_handle_dgram(eng, probes, n, &eng->batch[i], -1)
+                      : (size_t)probe_handle_raw(eng, probes, n, fd, &eng->batch[i]);
+        }
+
+        //A short batch means the queue is empty
+        if(got < PROBE_BATCH){
+            break;
+        }
+    }
+
+    return answered;
+}
+
+/**
+ * Drain a ping socket's error queue (Time Exceeded, Unreachable).
+ * @param eng Engine from probe_engine_open (dgram mode)
+ * @param probes Probes of the current round
+ * @param n Number of probes
+ * @return Number of pending probes answered
+ */
+static size_t probe_drain_errors(ProbeEngine *eng, Probe *probes, size_t n){
+
+    size_t answered = 0;
+    NetPacket *pkt = &eng->batch[0];
+    pkt->buf = probe_rx_slot(eng, 0);
+    int type = -1;
+    int code = 0;
+
+    //The returned payload is our own Echo Request; the router is in addr.
+    //Entries that are not ICMP errors (local errors) are skipped, not the end of the queue
+    ssize_t got;
+    while((got = net_recv_icmp_error(eng->sockfd, pkt->buf, PROBE_SLOT_LEN, &pkt->addr, &type, &code, &pkt->rx_us)) >= 0){
+        if(type < 0){
+            continue;
+        }
+        pkt->len = (size_t)got;
+        answered += (size_t)probe_handle_dgram(eng, probes, n, pkt, type);
+    }
+
+    return answered;
+}
+
+/**
+ * Send one round of probes without waiting for the replies; they are
+ * collected by probe_engine_wait().
+ * @param eng Engine from probe_engine_open
+ * @param probes Array of probes; caller sets ttl, engine fills the rest
+ *               (must stay valid until the round has ended)
+ * @param n Number of probes
+ * @param timeout_ms How long to wait for stragglers after the last send
+ * @return 0 on success, -1 on send error
+ */
+int probe_engine_send(ProbeEngine *eng, Probe *probes, size_t n, int timeout_ms){
+
+    //Validate parameters
+    if(eng == NULL || probes == NULL){
+        return -1;
+    }
+
+    eng->round = NULL;
+
+    //UDP ports must not wrap inside one round or two probes would share a port
+    if(eng->proto == PROBE_UDP && n > probe_udp_span(eng)){
+        fprintf(stderr, "Error: UDP ports %u-65535 are too few for %zu probes\n", eng->port, n);
+        return -1;
+    }
+
+    size_t answered_early = 0;
+
+    //Echo templates are built once; Paris mode decides their layout
+    if(eng->proto == PROBE_ICMP && (eng->tmpl[0].pkt == NULL || eng->tmpl[0].paris != eng->paris)){
+        if(probe_engine_templates(eng) != 0){
+            fprintf(stderr, "Error: probe packet build failed\n");
+            return -1;
+        }
+    }
+
+    //Build and send the round in sendmmsg() batches
+    for(size_t base = 0; base < n; base += PROBE_BATCH){
+
+        size_t count = (n - base < PROBE_BATCH) ? n - base : PROBE_BATCH;
+
+        for(size_t i = 0; i < count; i++){
+
+            Probe *p = &probes[base + i];
+
+            //reset result fields
+            p->seq = eng->next_seq++;
+            p->answered = false;
+            p->reached = false;
+            p->rtt_us = -1;
+            p->icmp_type = -1;
+            memset(&p->from, 0, sizeof(p->from));
+
+            if(probe_build(eng, p, i) != 0){
+                return -1;
+            }
+        }
+
+        if(probe_send_batch(eng, probes + base, count) != 0){
+            return -1;
+        }
+
+        //Large rounds: pick up early replies between batches so the socket buffer can't overflow
+        if(base + count < n){
+            if(eng->dgram){
+                answered_early += probe_drain_errors(eng, probes, base + count);
+            }
+            answered_early += probe_drain(eng, probes, base + count, eng->sockfd);
+        }
+    }
+
+    //The round is open until all are in or the window closes
+    eng->round = probes;
+    eng->round_n = n;
+    eng->pending = n - answered_early;
+    eng->deadline_us = us_now() + (long long)timeout_ms * 1000LL;
+    return 0;
+}
+
+/**
+ * Collect replies for the open rounds of several engines until at least
+ * one round has ended (every probe answered, or its deadline passed).
+ * Ended rounds are closed: their engine's round is set to NULL.
+ * @param engs Engines; those without an open round are skipped
+ * @param n Number of engines (at most PROBE_WAIT_MAX)
+ * @return Number of rounds that ended, -1 if no round was open
+ */
+int probe_engine_wait(ProbeEngine *const *engs, size_t n){
+
+    if(n > PROBE_WAIT_MAX){
+        n = PROBE_WAIT_MAX;
+    }
+
+    for(;;){
+
+        //Close finished rounds and find the nearest deadline of the others
+        int ended = 0;
+        int open = 0;
+        long long now = us_now();
+        long long wake = 0;
+
+        for(size_t e = 0; e < n; e++){
+
+            ProbeEngine *eng = engs[e];
+
+            if(eng->round == NULL){
+                continue;
+            }
+
+            if(eng->pending == 0 || now >= eng->deadline_us){
+                eng->round = NULL;
+                ended++;
+                continue;
+            }
+
+            if(open++ == 0 || eng->deadline_us < wake){
+                wake = eng->deadline_us;
+            }
+        }
+
+        if(ended > 0){
+            return ended;
+        }
+        if(open == 0){
+            return -1;
+        }
+
+        //Wait on each ICMP socket, plus the raw TCP socket for SYN-ACK/RST answers
+        struct pollfd fds[2 * PROBE_WAIT_MAX];
+        ProbeEngine *owner[2 * PROBE_WAIT_MAX];
+        nfds_t nfds = 0;
+
+        for(size_t e = 0; e < n; e++){
+
+            ProbeEngine *eng = engs[e];
+
+            if(eng->round == NULL){
+                continue;
+            }
+
+            fds[nfds].fd = eng->sockfd;
+            fds[nfds].events = POLLIN;
+            owner[nfds++] = eng;
+
+            if(eng->proto == PROBE_TCP){
+                fds[nfds].fd = eng->sendfd;
+                fds[nfds].events = POLLIN;
+                owner[nfds++] = eng;
+            }
+        }
+
+        //Round the timeout up so a sub-millisecond remainder doesn't spin
+        int ready = poll(fds, nfds, (int)((wake - now + 999) / 1000));
+
+        //Interrupted (Ctrl+C in continuous mode) or failed: every round ends here
+        if(ready < 0){
+            for(size_t e = 0; e < n; e++){
+                if(engs[e]->round != NULL){
+                    engs[e]->round = NULL;
+                    ended++;
+                }
+            }
+            return ended;
+        }
+
+        for(nfds_t f = 0; f < nfds; f++){
+
+            ProbeEngine *eng = owner[f];
+            size_t answered = 0;
+
+            //Ping socket: errors wait on the error queue (POLLERR), replies on the normal one
+            if(eng->dgram && (fds[f].revents & POLLERR)){
+                answered += probe_drain_errors(eng, eng->round, eng->round_n);
+            }
+
+            if(fds[f].revents & POLLIN){
+                answered += probe_drain(eng, eng->round, eng->round_n, fds[f].fd);
+            }
+
+            eng->pending = (answered < eng->pending) ? eng->pending - answered : 0;
+        }
+    }
+}
+
+/**
+ * Send one round of probes and collect replies until every probe is
+ * answered or timeout_ms has passed since the last send.
+ * @param eng Engine from probe_engine_open
+ * @param probes Array of probes; caller sets ttl, engine fills the rest
+ * @param n Number of probes
+ * @param timeout_ms How long to wait for stragglers
+ * @return 0 on success, -1 on send error
+ */
+int probe_engine_round(ProbeEngine *eng, Probe *probes, size_t n, int timeout_ms){
+
+    if(probe_engine_send(eng, probes, n, timeout_ms) != 0){
+        return -1;
+    }
+
+    probe_engine_wait(&eng, 1);
+    return 0;
+}
+
+/**
+ * Release the engine's sockets.
+ * @param eng Engine to close
+ */
+void probe_engine_close(ProbeEngine *eng){
+
+    //Check for NULL
+    if(eng == NULL){
+        return;
+    }
+
+    if(eng->sockfd >= 0){
+        close(eng->sockfd);
+    }
+
+    if(eng->sendfd >= 0){
+        close(eng->sendfd);
+    }
+
+    if(eng->portfd >= 0){
+        close(eng->portfd);
+    }
+
+    free(eng->arena);
+    eng->arena = NULL;
+
+    eng->sockfd = -1;
+    eng->sendfd = -1;
+    eng->portfd = -1;
+}
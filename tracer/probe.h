@@ -0,0 +1,150 @@
+/*
+ * File: probe.h
+ * Summary: Parallel probe engine (ICMP, UDP, TCP SYN) shared by traceroute modes.
+ *
+ * Responsibilities:
+ *  - Send a whole round of probes (one per TTL) back to back in sendmmsg() batches
+ *  - Drain replies with recvmmsg() into a preallocated packet arena
+ *  - Probe with ICMP Echo, UDP to incrementing high ports, or TCP SYN to one port
+ *  - Demultiplex replies by (id, seq) so every probe is timed independently
+ *    (UDP: by destination port, TCP: by sequence number)
+ *  - Record kernel receive timestamps for microsecond RTTs
+ *  - Use an unprivileged ping socket for Echo probes when allowed, raw otherwise
+ *  - Optionally keep the ECMP flow identifier constant (Paris traceroute)
+ *  - Keep rounds of several engines (one per destination) in flight at once
+ *
+ * Data & Types:
+ *  - typedef enum ProbeProto { PROBE_ICMP, PROBE_UDP, PROBE_TCP }
+ *  - typedef struct Probe { int ttl; uint16_t flow; uint16_t seq; long long sent_us; bool answered; bool reached; long rtt_us; int icmp_type; struct sockaddr_in from; }
+ *  - typedef struct ProbeEngine { ProbeProto proto; int sockfd; bool dgram; int sendfd; int portfd; uint16_t id; uint16_t next_seq; bool paris; uint16_t sport; uint16_t port; struct in_addr src; struct sockaddr_storage dst; socklen_t dst_len; unsigned char *arena; NetPacket batch[PROBE_BATCH]; IcmpTemplate tmpl[PROBE_BATCH]; Probe *round; size_t round_n, pending; long long deadline_us; }
+ *
+ * Public API:
+ *  - int  probe_engine_open(ProbeEngine *eng, ProbeProto proto, uint16_t port, const struct sockaddr_storage *dst, socklen_t dst_len);
+ *  - int  probe_engine_round(ProbeEngine *eng, Probe *probes, size_t n, int timeout_ms);
+ *  - int  probe_engine_send(ProbeEngine *eng, Probe *probes, size_t n, int timeout_ms);
+ *  - int  probe_engine_wait(ProbeEngine *const *engs, size_t n);
+ *  - void probe_engine_close(ProbeEngine *eng);
+ *
+ * Returns:
+ *  - 0 on success; <0 on error (socket creation, send failure)
+ *
+ * Author: Shan Truong - 400576105 - truons8
+ * Date: December 3, 2025
+ * Coures: 2XC3
+ */
+
+#ifndef PROBE_H
+#define PROBE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include "../net/net.h"
+#include "icmp.h"
+
+// Probes per sendmmsg()/recvmmsg() call
+#define PROBE_BATCH NET_BATCH_MAX
+
+// Bytes per receive slot in the engine arena (largest ICMP error we parse)
+#define PROBE_SLOT_LEN 512
+
+// Bytes per send slot in the engine arena (largest probe we build)
+#define PROBE_TX_SLOT_LEN 64
+
+// UDP probes go to port + (seq % UDP_PORT_SPAN), like classic traceroute's 33434 and up
+#define UDP_PORT_SPAN 1024
+
+// Most engines probe_engine_wait() watches at once
+#define PROBE_WAIT_MAX 64
+
+/**
+ * Probe packet type.
+ * - PROBE_ICMP: ICMP Echo Request (default)
+ * - PROBE_UDP: UDP datagram to an incrementing high port
+ * - PROBE_TCP: TCP SYN to a fixed port (gets through firewalls that drop ICMP/UDP)
+ */
+typedef enum ProbeProto{
+    PROBE_ICMP = 0,
+    PROBE_UDP,
+    PROBE_TCP
+} ProbeProto;
+
+/**
+ * One probe in flight.
+ * - ttl: TTL the probe is sent with (filled by caller)
+ * - flow: flow identifier for Paris probes (filled by caller, ignored otherwise)
+ * - seq: ICMP sequence assigned by the engine
+ * - sent_us: send timestamp (microseconds)
+ * - answered: true once a matching reply arrived
+ * - reached: true if the reply came from the destination (Echo Reply,
+ *   Port Unreachable, SYN-ACK or RST)
+ * - rtt_us: round-trip time in microseconds (-1 if unanswered)
+ * - icmp_type: ICMP type of the reply (-1 if unanswered)
+ * - from: address of the responding router/host
+ */
+typedef struct Probe{
+    int ttl;
+    uint16_t flow;
+    uint16_t seq;
+    long long sent_us;
+    bool answered;
+    bool reached;
+    long rtt_us;
+    int icmp_type;
+    struct sockaddr_in from;
+} Probe;
+
+/**
+ * Probe engine state for one destination.
+ * - proto: probe packet type
+ * - sockfd: ICMP socket (sends ICMP probes, receives every ICMP reply/error)
+ * - dgram: true if sockfd is an unprivileged ping socket (SOCK_DGRAM), false for raw
+ * - sendfd: UDP socket or raw TCP socket for non-ICMP probes (-1 for ICMP)
+ * - portfd: TCP socket holding sport so the port isn't handed out twice (-1 otherwise)
+ * - id: identifier stamped on every probe (per process)
+ * - next_seq: next sequence number to hand out
+ * - paris: true to send flow-stable probes (checksum pinned to Probe.flow)
+ * - sport: local source port of UDP/TCP probes
+ * - port: UDP base port or TCP destination port
+ * - src: local source address (TCP checksum pseudo header)
+ * - dst, dst_len: destination address
+ * - arena: PROBE_BATCH send slots (PROBE_TX_SLOT_LEN) followed by PROBE_BATCH
+ *   receive slots (PROBE_SLOT_LEN), reused by every batch
+ * - batch: sendmmsg()/recvmmsg() descriptors pointing into the arena
+ * - tmpl: Echo templates living in the send slots (built on the first round)
+ * - round, round_n: probes of the round in flight (round is NULL once it has ended)
+ * - pending: probes of that round still unanswered
+ * - deadline_us: when the round ends even if probes are still unanswered
+ */
+typedef struct ProbeEngine{
+    ProbeProto proto;
+    int sockfd;
+    bool dgram;
+    int sendfd;
+    int portfd;
+    uint16_t id;
+    uint16_t next_seq;
+    bool paris;
+    uint16_t sport;
+    uint16_t port;
+    struct in_addr src;
+    struct sockaddr_storage dst;
+    socklen_t dst_len;
+    unsigned char *arena;
+    NetPacket batch[PROBE_BATCH];
+    IcmpTemplate tmpl[PROBE_BATCH];
+    Probe *round;
+    size_t round_n;
+    size_t pending;
+    long long deadline_us;
+} ProbeEngine;
+
+int  probe_engine_open(ProbeEngine *eng, ProbeProto proto, uint16_t port, const struct sockaddr_storage *dst, socklen_t dst_len);
+int  probe_engine_round(ProbeEngine *eng, Probe *probes, size_t n, int timeout_ms);
+int  probe_engine_send(ProbeEngine *eng, Probe *probes, size_t n, int timeout_ms);
+int  probe_engine_wait(ProbeEngine *const *engs, size_t n);
+void probe_engine_close(ProbeEngine *eng);
+
+#endif /* PROBE_H */
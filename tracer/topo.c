@@ -0,0 +1,625 @@
+/*topo.c - Implements the merged path topology graph.
+ * Responsibilities:
+ *  - Intern every responding hop address once, in an open-addressing hash table,
+ *    so a router shared by a thousand paths costs one node
+ *  - Keep one edge per (previous hop, hop) pair; timed-out hops in between are
+ *    skipped and counted in the edge's TTL gap instead of becoming fake nodes
+ *  - Chain each node's outgoing edges (first_out/next_out) for adjacency export
+ *  - Trace a target list (a,b,c or @file), several targets at a time, and merge
+ *    each route as it completes
+ *
+ * Why hash tables and not a scan of the node list?
+ *  - Every hop of every trace is a lookup; with hundreds of traces and thousands
+ *    of routers a linear scan turns the merge quadratic
+ *
+ * Author: Shan Truong - 400576105 - truons8
+ * Date: December 3, 2025
+ * Coures: 2XC3
+ */
+
+#include "topo.h"
+#include "tracer.h"
+#include "../net/net.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <arpa/inet.h>  // inet_pton(), inet_ntop()
+
+#define TOPO_INIT_SLOTS 64      // starting hash size (power of two)
+
+/**
+ * Fibonacci hash of a 64-bit key into a power-of-two table.
+ * @param key Key to hash
+ * @param slots Table size (power of two)
+ * @return Starting slot
+ */
+static size_t topo_hash(uint64_t key, size_t slots){
+
+    key ^= key >> 29;
+    key *= 0x9E3779B97F4A7C15ULL;
+
+    return (size_t)(key >> 32) & (slots - 1);
+}
+
+/**
+ * Key of an edge in the edge hash.
+ * @param from Source node index
+ * @param to Destination node index
+ * @return 64-bit key
+ */
+static uint64_t topo_edge_key(size_t from, size_t to){
+    return ((uint64_t)from << 32) | (uint64_t)(uint32_t)to;
+}
+
+/**
+ * Rebuild the node hash at twice its size.
+ * @param g Graph
+ * @return 0 on success, -1 on allocation failure
+ */
+static int topo_grow_nodes(TopoGraph *g){
+
+    size_t slots = g->node_slots ? g->node_slots * 2 : TOPO_INIT_SLOTS;
+    size_t *index = calloc(slots, sizeof(size_t));
+
+    if(index == NULL){
+        return -1;
+    }
+
+    for(size_t i = 0; i < g->nnodes; i++){
+
+        size_t s = topo_hash(g->nodes[i].addr, slots);
+
+        while(index[s] != 0){
+            s = (s + 1) & (slots - 1);
+        }
+        index[s] = i + 1;
+    }
+
+    free(g->node_index);
+    g->node_index = index;
+    g->node_slots = slots;
+    return 0;
+}
+
+/**
+ * Rebuild the edge hash at twice its size.
+ * @param g Graph
+ * @return 0 on success, -1 on allocation failure
+ */
+static int topo_grow_edges(TopoGraph *g){
+
+    size_t slots = g->edge_slots ? g->edge_slots * 2 : TOPO_INIT_SLOTS;
+    size_t *index = calloc(slots, sizeof(size_t));
+
+    if(index == NULL){
+        return -1;
+    }
+
+    for(size_t i = 0; i < g->nedges; i++){
+
+        size_t s = topo_hash(topo_edge_key(g->edges[i].from, g->edges[i].to), slots);
+
+        while(index[s] != 0){
+            s = (s + 1) & (slots - 1);
+        }
+        index[s] = i + 1;
+    }
+
+    free(g->edge_index);
+    g->edge_index = index;
+    g->edge_slots = slots;
+    return 0;
+}
+
+/**
+ * Find a node by address.
+ * @param g Graph
+ * @param addr IPv4 address (network order)
+ * @return Node index, or -1 if not in the graph
+ */
+long topo_find(const TopoGraph *g, unsigned int addr){
+
+    if(g->node_slots == 0){
+        return -1;
+    }
+
+    size_t s = topo_hash(addr, g->node_slots);
+
+    // Linear probing: stop at the first empty slot
+    while(g->node_index[s] != 0){
+
+        size_t i = g->node_index[s] - 1;
+
+        if(g->nodes[i].addr == addr){
+            return (long)i;
+        }
+        s = (s + 1) & (g->node_slots - 1);
+    }
+
+    return -1;
+}
+
+/**
+ * Find or add the node for a hop.
+ * @param g Graph
+ * @param addr IPv4 address (network order)
+ * @param ip Address string
+ * @param host Resolved name (or the address again)
+ * @param ttl TTL it was seen at
+ * @return Node index, or -1 on allocation failure
+ */
+static long topo_intern(TopoGraph *g, unsigned int addr, const char *ip, const char *host, int ttl){
+
+    long found = topo_find(g, addr);
+
+    if(found >= 0){
+
+        TopoNode *n = &g->nodes[found];
+
+        if(ttl < n->min_ttl){
+            n->min_ttl = ttl;
+        }
+        return found;
+    }
+
+    // Keep the hash at most 70% full
+    if((g->nnodes + 1) * 10 > g->node_slots * 7 && topo_grow_nodes(g) != 0){
+        return -1;
+    }
+
+    if(g->nnodes == g->node_cap){
+
+        size_t newcap = g->node_cap ? g->node_cap * 2 : 16;
+        TopoNode *nodes = realloc(g->nodes, newcap * sizeof(TopoNode));
+
+        if(nodes == NULL){
+            return -1;
+        }
+        g->nodes = nodes;
+        g->node_cap = newcap;
+    }
+
+    TopoNode *n = &g->nodes[g->nnodes];
+    memset(n, 0, sizeof(*n));
+    n->addr = addr;
+    snprintf(n->ip, sizeof(n->ip), "%s", ip);
+    snprintf(n->host, sizeof(n->host), "%s", host);
+    n->min_ttl = ttl;
+    n->first_out = -1;
+
+    size_t s = topo_hash(addr, g->node_slots);
+
+    while(g->node_index[s] != 0){
+        s = (s + 1) & (g->node_slots - 1);
+    }
+    g->node_index[s] = g->nnodes + 1;
+
+    return (long)g->nnodes++;
+}
+
+/**
+ * Find or add the edge between two nodes and fold one RTT sample into it.
+ * @param g Graph
+ * @param from Source node index
+ * @param to Destination node index
+ * @param gap TTL distance between them
+ * @param rtt_us RTT of the 'to' hop
+ * @return 0 on success, -1 on allocation failure
+ */
+static int topo_link(TopoGraph *g, size_t from, size_t to, int gap, long rtt_us){
+
+    uint64_t key = topo_edge_key(from, to);
+    TopoEdge *e = NULL;
+
+    if(g->edge_slots > 0){
+
+        size_t s = topo_hash(key, g->edge_slots);
+
+        while(g->edge_index[s] != 0){
+
+            TopoEdge *cand = &g->edges[g->edge_index[s] - 1];
+
+            if(cand->from == from && cand->to == to){
+                e = cand;
+                break;
+            }
+            s = (s + 1) & (g->edge_slots - 1);
+        }
+    }
+
+    if(e == NULL){
+
+        if((g->nedges + 1) * 10 > g->edge_slots * 7 && topo_grow_edges(g) != 0){
+            return -1;
+        }
+
+        if(g->nedges == g->edge_cap){
+
+            size_t newcap = g->edge_cap ? g->edge_cap * 2 : 16;
+            TopoEdge *edges = realloc(g->edges, newcap * sizeof(TopoEdge));
+
+            if(edges == NULL){
+                return -1;
+            }
+            g->edges = edges;
+            g->edge_cap = newcap;
+        }
+
+        e = &g->edges[g->nedges];
+        memset(e, 0, sizeof(*e));
+        e->from = from;
+        e->to = to;
+        e->gap = gap;
+        e->min_us = -1;
+        e->max_us = -1;
+
+        // Push onto the source's adjacency chain
+        e->next_out = g->nodes[from].first_out;
+        g->nodes[from].first_out = (long)g->nedges;
+
+        size_t s = topo_hash(key, g->edge_slots);
+
+        while(g->edge_index[s] != 0){
+            s = (s + 1) & (g->edge_slots - 1);
+        }
+        g->edge_index[s] = g->nedges + 1;
+        g->nedges++;
+    }
+
+    // Paths differ in how many hops stay silent: keep the tightest gap
+    if(gap < e->gap){
+        e->gap = gap;
+    }
+
+    e->traces++;
+
+    if(rtt_us >= 0){
+        if(e->min_us < 0 || rtt_us < e->min_us){
+            e->min_us = rtt_us;
+        }
+        if(rtt_us > e->max_us){
+            e->max_us = rtt_us;
+        }
+        e->sum_us += (double)rtt_us;
+        e->samples++;
+    }
+
+    return 0;
+}
+
+/**
+ * Start an empty graph whose node 0 is the local source.
+ * @param g Graph to initialise
+ * @param src_addr Local source address (network order)
+ * @return 0 on success, -1 on allocation failure
+ */
+int topo_init(TopoGraph *g, unsigned int src_addr){
+
+    memset(g, 0, sizeof(*g));
+
+    char ip[64];
+    inet_ntop(AF_INET, &src_addr, ip, sizeof(ip));
+
+    return topo_intern(g, src_addr, ip, ip, 0) == 0 ? 0 : -1;
+}
+
+/**
+ * Merge one finished trace into the graph.
+ * Safe to call in any order and any number of times.
+ * @param g Graph (from topo_init)
+ * @param route Trace to merge (one row per TTL)
+ * @return 0 on success, -1 on allocation failure
+ */
+int topo_add_trace(TopoGraph *g, const TraceRoute *route){
+
+    size_t prev = 0;            // start at the local source
+    int prev_ttl = 0;
+
+    for(size_t i = 0; i < route->len; i++){
+
+        const Hop *h = &route->rows[i];
+        struct in_addr addr;
+
+        // Silent hops widen the next edge's gap instead of becoming nodes
+        if(h->timeout || inet_pton(AF_INET, h->ip, &addr) != 1){
+            continue;
+        }
+
+        long node = topo_intern(g, addr.s_addr, h->ip, h->host, h->hop);
+
+        if(node < 0){
+            return -1;
+        }
+
+        // A router answering twice in one path (loops, rate limits) adds no edge to itself
+        if((size_t)node != prev){
+
+            if(topo_link(g, prev, (size_t)node, h->hop - prev_ttl, h->rtt_us) != 0){
+                return -1;
+            }
+            g->nodes[node].traces++;
+        }
+
+        if(h->reached){
+            g->nodes[node].target = true;
+        }
+
+        if(h->cached){
+            g->cached++;
+        }
+
+        prev = (size_t)node;
+        prev_ttl = h->hop;
+    }
+
+    g->nodes[0].traces++;
+    g->ntraces++;
+    return 0;
+}
+
+/**
+ * Free a graph's tables.
+ * @param g Graph
+ */
+void topo_free(TopoGraph *g){
+
+    free(g->nodes);
+    free(g->edges);
+    free(g->node_index);
+    free(g->edge_index);
+    memset(g, 0, sizeof(*g));
+}
+
+/**
+ * Split a target list in place at commas, whitespace and newlines.
+ * '#' starts a comment that runs to the end of its line (target files).
+ * @param list String to split (modified)
+ * @param names Output array of pointers into list (TOPO_MAX_TARGETS entries)
+ * @return Number of targets, or -1 if none or too many
+ */
+static int topo_split_targets(char *list, char *names[]){
+
+    int n = 0;
+    char *line_save = NULL;
+
+    for(char *line = strtok_r(list, "\n", &line_save); line != NULL; line = strtok_r(NULL, "\n", &line_save)){
+
+        char *comment = strchr(line, '#');
+        if(comment != NULL){
+            *comment = '\0';
+        }
+
+        char *save = NULL;
+        for(char *tok = strtok_r(line, ", \t\r", &save); tok != NULL; tok = strtok_r(NULL, ", \t\r", &save)){
+
+            if(n == TOPO_MAX_TARGETS){
+                return -1;
+            }
+            names[n++] = tok;
+        }
+    }
+
+    return n > 0 ? n : -1;
+}
+
+/**
+ * Read a whole target file into a NUL-terminated buffer.
+ * @param path File name
+ * @return malloc'd contents, or NULL on error
+ */
+static char *topo_read_file(const char *path){
+
+    FILE *fp = fopen(path, "r");
+
+    if(fp == NULL){
+        fprintf(stderr, "Error: cannot open target file %s\n", path);
+        return NULL;
+    }
+
+    size_t len = 0, cap = 4096;
+    char *buf = malloc(cap);
+
+    while(buf != NULL){
+
+        len += fread(buf + len, 1, cap - len - 1, fp);
+
+        if(len < cap - 1){
+            break;
+        }
+
+        char *bigger = realloc(buf, cap * 2);
+
+        if(bigger == NULL){
+            free(buf);
+            buf = NULL;
+            break;
+        }
+        buf = bigger;
+        cap *= 2;
+    }
+
+    fclose(fp);
+
+    if(buf != NULL){
+        buf[len] = '\0';
+    }
+    return buf;
+}
+
+/**
+ * Check whether a destination already has a trace in flight.
+ * Raw-socket engines of one process share the probe id, so two traces to
+ * the same address would take each other's replies.
+ * @param jobs Trace slots
+ * @param busy Which slots hold a trace
+ * @param addr Destination (network order)
+ * @return true if a busy slot traces addr
+ */
+static bool topo_in_flight(const TraceJob *jobs, const bool *busy, unsigned int addr){
+
+    for(int k = 0; k < TOPO_MAX_INFLIGHT; k++){
+        if(busy[k] && ((const struct sockaddr_in *)&jobs[k].eng.dst)->sin_addr.s_addr == addr){
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Trace every target and merge the routes into one graph as each one completes.
+ * Up to TOPO_MAX_INFLIGHT traces run at once, each on its own probe engine;
+ * a free slot takes the next target as soon as a trace completes, so N
+ * targets cost about N / TOPO_MAX_INFLIGHT probe timeouts, not N.
+ * Targets that fail to resolve or trace are reported and skipped.
+ * @param cmd CommandLine (target = a host, a comma-separated list, or @file with one host per line)
+ * @param out Output graph (free with topo_free)
+ * @return 0 if at least one trace was merged, -1 otherwise
+ */
+int tracer_graph(const CommandLine *cmd, TopoGraph *out){
+
+    char *list = cmd->target[0] == '@' ? topo_read_file(cmd->target + 1) : strdup(cmd->target);
+
+    if(list == NULL){
+        return -1;
+    }
+
+    char **names = malloc(TOPO_MAX_TARGETS * sizeof(char *));
+    int n = names ? topo_split_targets(list, names) : -1;
+
+    if(n < 0){
+        fprintf(stderr, "Error: --graph takes 1-%d targets\n", TOPO_MAX_TARGETS);
+        free(names);
+        free(list);
+        return -1;
+    }
+
+    TraceJob *jobs = calloc(TOPO_MAX_INFLIGHT, sizeof(TraceJob));
+    bool busy[TOPO_MAX_INFLIGHT] = {false};
+
+    if(jobs == NULL){
+        fprintf(stderr, "Error: Memory allocation failed for traces\n");
+        free(names);
+        free(list);
+        return -1;
+    }
+
+    // Node 0 is this host, as seen by the first target that resolves
+    bool started = false;
+    bool failed = false;
+    int merged = 0;
+    int next = 0;
+    int active = 0;
+
+    while(!failed && (next < n || active > 0)){
+
+        // Start traces in the free slots
+        for(int k = 0; k < TOPO_MAX_INFLIGHT && next < n && !failed; k++){
+
+            if(busy[k]){
+                continue;
+            }
+
+            struct sockaddr_storage ss;
+            socklen_t ss_len;
+
+            if(net_resolve(names[next], &ss, &ss_len) != 0 || ss.ss_family != AF_INET){
+                fprintf(stderr, "Error: cannot resolve %s\n", names[next]);
+                next++;
+                k--;
+                continue;
+            }
+
+            // Same destination as a trace in flight: wait for it to complete
+            const struct sockaddr_in *sin = (const struct sockaddr_in *)&ss;
+            if(topo_in_flight(jobs, busy, sin->sin_addr.s_addr)){
+                break;
+            }
+
+            if(!started){
+
+                struct in_addr src;
+
+                if(net_source_addr(sin, &src) != 0){
+                    src.s_addr = htonl(INADDR_ANY);
+                }
+
+                if(topo_init(out, src.s_addr) != 0){
+                    failed = true;
+                    break;
+                }
+                started = true;
+            }
+
+            // Same options, one target per slot
+            CommandLine one = *cmd;
+            snprintf(one.target, sizeof(one.target), "%s", names[next++]);
+
+            if(tracer_start(&one, &jobs[k]) != 0){
+                k--;
+                continue;
+            }
+
+            busy[k] = true;
+            active++;
+        }
+
+        if(active == 0){
+            continue;
+        }
+
+        // Wait until at least one trace's round ends
+        ProbeEngine *engs[TOPO_MAX_INFLIGHT];
+        size_t neng = 0;
+
+        for(int k = 0; k < TOPO_MAX_INFLIGHT; k++){
+            if(busy[k]){
+                engs[neng++] = &jobs[k].eng;
+            }
+        }
+
+        probe_engine_wait(engs, neng);
+
+        // Resume those traces; merge the ones that are complete
+        for(int k = 0; k < TOPO_MAX_INFLIGHT; k++){
+
+            if(!busy[k] || jobs[k].eng.round != NULL){
+                continue;
+            }
+
+            TraceRoute route;
+            int rc = tracer_resume(&jobs[k], &route);
+
+            if(rc == 0){
+                continue;
+            }
+
+            if(rc > 0 && !failed){
+                if(topo_add_trace(out, &route) != 0){
+                    failed = true;
+                }
+                else{
+                    merged++;
+                }
+            }
+
+            traceroute_free(&route);
+            tracer_job_free(&jobs[k]);
+            busy[k] = false;
+            active--;
+        }
+    }
+
+    // Out of memory mid-run: drop the traces still in flight
+    for(int k = 0; k < TOPO_MAX_INFLIGHT; k++){
+        if(busy[k]){
+            tracer_job_free(&jobs[k]);
+        }
+    }
+
+    free(jobs);
+    free(names);
+    free(list);
+    return merged > 0 ? 0 : -1;
+}
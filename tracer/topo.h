@@ -0,0 +1,52 @@
+/*
+ * File: topo.h
+ * Summary: Path topology graph merged from many traceroutes.
+ *
+ * Responsibilities:
+ *  - Intern hop addresses into a hash-indexed node table (one node per router)
+ *  - Keep one edge per pair of consecutive responding hops, with RTT statistics
+ *  - Merge traces incrementally, in any order, as they complete
+ *  - Trace a list of targets (a,b,c or @file) and build their combined graph (--trace --graph),
+ *    up to TOPO_MAX_INFLIGHT traces in flight at once
+ *
+ * Data & Types:
+ *  - typedef struct TopoNode { unsigned int addr; char ip[64]; char host[256]; int min_ttl; unsigned long traces; bool target; long first_out; }
+ *  - typedef struct TopoEdge { size_t from, to; int gap; unsigned long traces; long min_us, max_us; double sum_us; long next_out; }
+ *  - typedef struct TopoGraph { TopoNode *nodes; ...; TopoEdge *edges; ...; unsigned long ntraces; }
+ *
+ * Public API:
+ *  - int  topo_init(TopoGraph *g, unsigned int src_addr);
+ *  - int  topo_add_trace(TopoGraph *g, const TraceRoute *route);
+ *  - long topo_find(const TopoGraph *g, unsigned int addr);
+ *  - void topo_free(TopoGraph *g);
+ *  - int  tracer_graph(const CommandLine *cmd, TopoGraph *out);
+ *
+ * Notes:
+ *  - Timed-out hops are not nodes: the link skips them and records the TTL gap
+ *  - Addresses are IPv4 in network order
+ *
+ * Author: Shan Truong - 400576105 - truons8
+ * Date: December 3, 2025
+ * Coures: 2XC3
+ */
+
+#ifndef TOPO_H
+#define TOPO_H
+
+#include "../cli/cli.h"
+#include "../model/model.h"
+
+// Most targets one --graph run traces
+#define TOPO_MAX_TARGETS 4096
+
+// Traces --graph keeps in flight at once (at most PROBE_WAIT_MAX); kept modest
+// because routers rate-limit the ICMP errors they send to one host
+#define TOPO_MAX_INFLIGHT 16
+
+int  topo_init(TopoGraph *g, unsigned int src_addr);
+int  topo_add_trace(TopoGraph *g, const TraceRoute *route);
+long topo_find(const TopoGraph *g, unsigned int addr);
+void topo_free(TopoGraph *g);
+int  tracer_graph(const CommandLine *cmd, TopoGraph *out);
+
+#endif /* TOPO_H */
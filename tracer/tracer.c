@@ -3,7 +3,11 @@
     *  - Send ICMP Echo requests with increasing TTL to map network path
     * - Record per-hop IP, hostname (reverse DNS), RTT, and timeout status
     * - Return results in TraceRoute struct
-    * - Handle raw sockets, timeouts, and ICMP response parsing
+    * - Continuous (MTR-style) mode with per-hop running statistics in PathStats
+    * - Probing itself is done by the parallel engine in probe.c
+    * - Near-side hops shared with earlier traces come from the hop cache (hopcache.c)
+    * - A trace is a job that can be resumed as its rounds end, so callers can keep
+    *   many in flight (tracer_graph)
  *
  * Author: Shan Truong - 400576105 - truons8
  * Date: December 3, 2025
@@ -11,39 +15,61 @@
  */
 
 #include "tracer.h"
-#include "icmp.h"
+#include "probe.h"
+#include "hopcache.h"
 #include "../net/net.h"
 #include "../model/model.h"
+#include "../timeutil/timeutil.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
-#include <sys/time.h>   // gettimeofday()
+#include <sys/time.h>   // struct timeval for select()
 #include <arpa/inet.h>  // inet_ntop()
 #include <netinet/ip_icmp.h>
 #include <netdb.h>   // getnameinfo, NI_MAXHOST
-
-#define ICMP_ID  0x1234   // arbitrary unique ID
-#define ICMP_SEQ 1        // sequence number
+#include <signal.h>
 
 #define NI_MAXHOST 1025   // value used by GNU libc
 
-/**
- * Get current time in milliseconds.
- * @return Current time in ms since epoch
+#define PROBE_TIMEOUT_MS 1000   // how long to wait for a round's replies (1 second)
+
+#define JITTER_GAIN 16.0        // RFC 3550 smoothing factor for jitter
+
+#define PARIS_DEFAULT_FLOW 1    // flow identifier used by --paris probes
+
+#define MAX_NEXTHOPS 16         // distinct responders remembered per TTL when enumerating
+#define ENUM_SILENT_PROBES 3    // give up on a TTL after this many unanswered flows
+
+/*
+ * Multipath Detection Algorithm stopping points (95% confidence):
+ * once k next hops have been seen at a TTL, mda_stop[k-1] probes in total
+ * are enough to rule out a (k+1)-th one.
  */
-static long now_ms() {
-    
-    // gettimeofday returns seconds + microseconds
-    struct timeval tv;
+static const int mda_stop[MAX_NEXTHOPS] = {6, 11, 16, 21, 27, 33, 38, 44, 51, 57, 63, 70, 76, 83, 90, 96};
 
-    //get current time to determine round trip time (RTT)
-    gettimeofday(&tv, NULL);
-    
-    // Convert to milliseconds
-    return (tv.tv_sec * 1000L) + (tv.tv_usec / 1000);
-}
+/*
+ * Enumeration state for one TTL.
+ * sent:  flows probed so far
+ * nhops: distinct responders seen (entries used in 'seen')
+ * done:  no more probes needed for this TTL
+ */
+typedef struct {
+    int sent;
+    int nhops;
+    bool done;
+    struct {
+        struct sockaddr_in addr;
+        uint16_t flow;
+        long rtt_us;
+        int icmp_type;
+        bool reached;
+    } seen[MAX_NEXTHOPS];
+} TtlEnum;
+
+// Global flag modified by signal handler to stop the continuous loop
+static volatile int running = 1;
 
 /**
  * Append a Hop to TraceRoute, resizing if needed.
@@ -70,15 +96,68 @@ static void tracer_append(TraceRoute *route, const Hop *h) {
 }
 
 /**
- * Run traceroute using ICMP Echo requests.
- * @param cfg Pointer to CommandLine config
- * @param out Pointer to TraceRoute to fill
- * @return 0 on success, -1 on error
+ * Fill Hop host field by reverse DNS, falling back to the IP string.
+ * @param addr Address of the responder
+ * @param host Output buffer
+ * @param hostlen Size of output buffer
+ * @param ip IP string used as fallback
  */
-int tracer_run(const CommandLine *cfg, TraceRoute *out){
+static void tracer_resolve_host(const struct sockaddr_in *addr, char *host, size_t hostlen, const char *ip){
 
-    //clear TraceRoute to empty
-    memset(out, 0, sizeof(*out));
+    //Resolve hostname (reverse DNS lookup)
+    char hostbuf[NI_MAXHOST];
+
+    //taking ip address from addr and getting hostname
+    int gi = getnameinfo((const struct sockaddr *)addr, sizeof(*addr), hostbuf, sizeof(hostbuf), NULL, 0, 0);
+
+    //check getnameinfo result
+    if(gi == 0){
+
+        // Successfully resolved a hostname
+        strncpy(host, hostbuf, hostlen - 1);
+    }
+    
+    else{
+
+        // Fallback: just use the IP string
+        strncpy(host, ip, hostlen - 1);
+    }
+
+    host[hostlen - 1] = '\0';
+}
+
+/**
+ * Build the probe list for one round: 'queries' probes per TTL in [ttl_start, ttl_end],
+ * grouped by TTL (probes of one TTL are adjacent).
+ * @param probes Array with room for (ttl_end - ttl_start + 1) * queries probes
+ * @param ttl_start First TTL
+ * @param ttl_end Last TTL
+ * @param queries Probes per TTL
+ * @return Number of probes filled
+ */
+static size_t tracer_fill_round(Probe *probes, int ttl_start, int ttl_end, int queries){
+
+    size_t n = 0;
+
+    for(int ttl = ttl_start; ttl <= ttl_end; ttl++){
+        for(int q = 0; q < queries; q++){
+            memset(&probes[n], 0, sizeof(Probe));
+            probes[n].ttl = ttl;
+            probes[n].flow = PARIS_DEFAULT_FLOW;   // only used in Paris mode
+            n++;
+        }
+    }
+
+    return n;
+}
+
+/**
+ * Resolve target and open the probe engine.
+ * @param cfg Pointer to CommandLine config
+ * @param eng Engine to open
+ * @return 0 on success, -1 on error (message already printed)
+ */
+static int tracer_open(const CommandLine *cfg, ProbeEngine *eng){
 
     //resolving target
     struct sockaddr_storage target_addr;
@@ -86,181 +165,663 @@ int tracer_run(const CommandLine *cfg, TraceRoute *out){
     //length of target_addr
     socklen_t target_len;
 
-    //casting to struct sockaddr pointer for net_resolve
-    struct sockaddr *sa = (struct sockaddr *)&target_addr;
-
     //resolve target hostname/IP
     if(net_resolve(cfg->target, &target_addr, &target_len) != 0){
         fprintf(stderr, "Error: Failed to resolve target '%s'\n", cfg->target);
         return -1;
     }
 
-    //creating raw ICMP socket
-    int sockfd = net_icmp_raw_socket();
-    if(sockfd < 0){
-        return -1; // error already printed
+    //CLI protocol choice maps one to one onto the engine's probe types
+    ProbeProto proto = PROBE_ICMP;
+    if(cfg->proto == PROTO_UDP){
+        proto = PROBE_UDP;
+    }
+    else if(cfg->proto == PROTO_TCP){
+        proto = PROBE_TCP;
     }
 
-    //Iterate TTL from cfg->ttl_start → cfg->ttl_max
-    for(int ttl = cfg->ttl_start; ttl <= cfg->ttl_max; ttl++){
+    //creating the probe sockets inside the engine
+    if(probe_engine_open(eng, proto, (uint16_t)cfg->port, &target_addr, target_len) != 0){
+        return -1;
+    }
+
+    //Enumeration needs control over the flow identifier too
+    eng->paris = cfg->paris || cfg->enumerate;
+    return 0;
+}
 
-        //Set socket TTL
-        net_set_ttl(sockfd, ttl);
+/**
+ * Check the cached prefix against the probes of its last TTL.
+ * @param probes Round with the prefix's last TTL at probes[skip * queries]
+ * @param skip Number of TTLs before it
+ * @param queries Probes per TTL
+ * @param src Local source address (cache key)
+ * @return true if the TTLs before it can be copied from the cache,
+ *         false if they have to be probed after all
+ */
+static bool tracer_prefix_holds(const Probe *probes, size_t skip, int queries, struct in_addr src){
 
-        //Build ICMP Echo Request packet
-        unsigned char pkt[64];
-        size_t pktlen = 0;
+    size_t first = skip * (size_t)queries;
 
-        //build ICMP packet
-        if(icmp_build_echo(ICMP_ID, ttl, NULL, 0, pkt, &pktlen) < 0){
+    // Same router at the end of the prefix: the path up to it is the cached one
+    for(int q = 0; q < queries; q++){
 
-            fprintf(stderr, "Error: ICMP packet build failed\n");
+        const Probe *last = &probes[first + (size_t)q];
 
-            //clean up socket
-            close(sockfd);
-            return -1;
+        if(last->answered && !last->reached && hopcache_match(src, last->ttl, last->from.sin_addr)){
+            return true;
         }
+    }
 
-        // Record start time
-        long tstart = now_ms();
+    // Diverged (or lost)
+    return false;
+}
 
-        //Send ICMP Echo Request
-        if(sendto(sockfd, pkt, pktlen, 0, sa, target_len) < 0){
+/**
+ * Turn the probes of one TTL into a Hop.
+ * The hop's ip/RTT come from the probe that reached the destination if any,
+ * else from the first one answered; every probe is also kept in query_ip/query_rtt_us.
+ * @param group Probes of one TTL
+ * @param queries Number of probes in group
+ * @param paris true if the probes were flow-controlled
+ * @param h Hop to fill
+ */
+static void tracer_make_hop(const Probe *group, int queries, bool paris, Hop *h){
 
-            fprintf(stderr, "sendto failed:\n");
+    //clear Hop
+    memset(h, 0, sizeof(*h));
 
-            //clean up socket
-            close(sockfd);
-            return -1;
+    //set hop number
+    h->hop = group[0].ttl;
+
+    //flow identifier only means something for Paris probes
+    h->flow = paris ? (int)group[0].flow : -1;
+
+    h->queries = queries;
+
+    const Probe *p = NULL;
+
+    for(int q = 0; q < queries; q++){
+
+        const Probe *g = &group[q];
+
+        if(!g->answered){
+            strcpy(h->query_ip[q], "*");
+            h->query_rtt_us[q] = -1;
+            continue;
         }
 
-        // prepare buffer to receive response
-        char recvbuf[512];
+        inet_ntop(AF_INET, &g->from.sin_addr, h->query_ip[q], sizeof(h->query_ip[q]));
+        h->query_rtt_us[q] = g->rtt_us;
 
-        //prepare to receive from
-        struct sockaddr_in reply_addr;
-        socklen_t reply_len = sizeof(reply_addr);
+        //Destination wins over routers (the path ends here), else first answer
+        if(p == NULL || (g->reached && !p->reached)){
+            p = g;
+        }
+    }
 
-        //Set timeout (1 second)
-        struct timeval tv;
-        tv.tv_sec = 1;
-        tv.tv_usec = 0;
+    //Check probe result
+    if(p == NULL){
 
-        //Use select() to wait for response or timeout
-        fd_set fds;
-        FD_ZERO(&fds);
-        FD_SET(sockfd, &fds);
+        // timeout
+        h->timeout = true;
 
-        //getting result of select which is either 0 (timeout) or >0 (data available)
-        int sel = select(sockfd + 1, &fds, NULL, NULL, &tv);
+        //set unknown IP and host for timeout
+        strcpy(h->ip, "*");
 
-        //initialize Hop
-        Hop h;
+        //set unknown host for timeout
+        strcpy(h->host, "?");
 
-        //clear Hop
-        memset(&h, 0, sizeof(h));
+        //set RTT to -1 for timeout
+        h->rtt_us = -1;
 
-        //set hop number
-        h.hop = ttl;
+        //set icmp_type to -1 for timeout (marked as unknown)
+        h->icmp_type = -1;
+        return;
+    }
 
-        //Check select result
-        if(sel == 0){
+    //Extract IP of hop
+    inet_ntop(AF_INET, &p->from.sin_addr, h->ip, sizeof(h->ip));
 
-            // timeout
-            h.timeout = true;
+    //Fill Hop details
+    h->timeout = false;
+    h->rtt_us = p->rtt_us;
+    h->icmp_type = p->icmp_type;
+    h->reached = p->reached;
 
-            //set unknown IP and host for timeout
-            strcpy(h.ip, "*");
+    tracer_resolve_host(&p->from, h->host, sizeof(h->host), h->ip);
+}
 
-            //set unknown host for timeout
-            strcpy(h.host, "?");
+/**
+ * Start a trace: open its engine and send the first round without waiting.
+ * All TTLs are probed in one parallel round (cfg->queries probes each, all in
+ * flight together). With the hop cache on, a shared prefix seen on earlier
+ * traces from the same source is not probed: only its last TTL is, to check
+ * it still holds.
+ * @param cfg Pointer to CommandLine config
+ * @param job Job to fill (free with tracer_job_free)
+ * @return 0 on success, -1 on error (message already printed)
+ */
+int tracer_start(const CommandLine *cfg, TraceJob *job){
 
-            //set RTT to -1 for timeout
-            h.rtt_ms = -1;
+    memset(job, 0, sizeof(*job));
+    job->ttl_start = cfg->ttl_start;
+    job->queries = cfg->queries;
+    job->hop_cache = cfg->hop_cache;
 
-            //set icmp_type to -1 for timeout (marked as unknown)
-            h.icmp_type = -1;
+    if(tracer_open(cfg, &job->eng) != 0){
+        return -1;
+    }
+
+    //cfg->queries probes per TTL
+    size_t nttl = (size_t)(cfg->ttl_max - cfg->ttl_start + 1);
+    size_t q = (size_t)cfg->queries;
+    job->probes = calloc(nttl * q, sizeof(Probe));
+    if(job->probes == NULL){
+        fprintf(stderr, "Error: Memory allocation failed for probes\n");
+        tracer_job_free(job);
+        return -1;
+    }
+
+    job->n = tracer_fill_round(job->probes, cfg->ttl_start, cfg->ttl_max, cfg->queries);
+
+    //Near-side hops shared with earlier traces from this source
+    const struct sockaddr_in *dst = (const struct sockaddr_in *)&job->eng.dst;
+
+    if(cfg->hop_cache && job->eng.dst.ss_family == AF_INET && net_source_addr(dst, &job->src) == 0){
+
+        int last = hopcache_prefix(job->src, cfg->ttl_start, cfg->ttl_max);
+
+        if(last > 0){
+            job->skip = (size_t)(last - cfg->ttl_start);
+        }
+    }
+
+    //Send every TTL at once (from the prefix's last hop on)
+    if(probe_engine_send(&job->eng, job->probes + job->skip * q, job->n - job->skip * q, PROBE_TIMEOUT_MS) != 0){
+        tracer_job_free(job);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Continue a trace whose round has ended (job->eng.round is NULL).
+ * If the cached prefix did not hold, its TTLs are sent as one more round;
+ * otherwise the probes are turned into hops, cut at the first hop that
+ * answers from the destination.
+ * @param job Job from tracer_start
+ * @param out Pointer to TraceRoute to fill (always cleared; free with traceroute_free)
+ * @return 1 if the trace is complete, 0 if another round is in flight, -1 on error
+ */
+int tracer_resume(TraceJob *job, TraceRoute *out){
+
+    //clear TraceRoute to empty
+    memset(out, 0, sizeof(*out));
+    out->queries = job->queries;
+
+    size_t q = (size_t)job->queries;
+
+    //Prefix's last hop changed: probe the prefix after all
+    if(job->skip > 0 && !job->checking && !tracer_prefix_holds(job->probes, job->skip, job->queries, job->src)){
+
+        job->checking = true;
+
+        if(probe_engine_send(&job->eng, job->probes, job->skip * q, PROBE_TIMEOUT_MS) != 0){
+            return -1;
+        }
+        return 0;
+    }
+
+    bool copy_prefix = job->skip > 0 && !job->checking;
+    size_t nttl = job->n / q;
+
+    //Turn probe results into hops, in TTL order
+    for(size_t i = 0; i < nttl; i++){
+
+        const Probe *group = &job->probes[i * q];
 
-            //append hop to TraceRoute
+        //initialize Hop
+        Hop h;
+
+        //Shared prefix: copied from the cache, not probed
+        if(copy_prefix && i < job->skip){
+            hopcache_fill(job->src, group->ttl, &h);
             tracer_append(out, &h);
             continue;
         }
 
-        //recvfrom() for actual ICMP response
-        int n = recvfrom(sockfd, recvbuf, sizeof(recvbuf), 0, (struct sockaddr *)&reply_addr, &reply_len);
+        tracer_make_hop(group, job->queries, job->eng.paris, &h);
 
-        //Record end time
-        long tend = now_ms();
+        //Append Hop to TraceRoute
+        tracer_append(out, &h);
 
-        //Check recvfrom result
-        if(n < 0){
+        //If we reached destination, stop
+        if(h.reached){
+            break;
+        }
+    }
 
-            // treat as timeout
-            h.timeout = true;
+    //Remember the near side for the next trace from this source
+    if(job->hop_cache && job->src.s_addr != 0){
+        const struct sockaddr_in *dst = (const struct sockaddr_in *)&job->eng.dst;
+        hopcache_learn(job->src, dst->sin_addr, out);
+    }
 
-            //set unknown IP and host for timeout
-            strcpy(h.ip, "*");
+    return 1;
+}
 
-            //set unknown host for timeout
-            strcpy(h.host, "?");
+/**
+ * Release a job's probes and engine.
+ * @param job Job from tracer_start
+ */
+void tracer_job_free(TraceJob *job){
+
+    free(job->probes);
+    job->probes = NULL;
+    probe_engine_close(&job->eng);
+}
+
+/**
+ * Run traceroute using ICMP Echo requests: one job, waited on until it completes.
+ * @param cfg Pointer to CommandLine config
+ * @param out Pointer to TraceRoute to fill
+ * @return 0 on success, -1 on error
+ */
+int tracer_run(const CommandLine *cfg, TraceRoute *out){
+
+    //clear TraceRoute to empty
+    memset(out, 0, sizeof(*out));
+    out->queries = cfg->queries;
+
+    TraceJob job;
+    if(tracer_start(cfg, &job) != 0){
+        return -1;
+    }
+
+    ProbeEngine *eng = &job.eng;
+    int rc;
+
+    do{
+        probe_engine_wait(&eng, 1);
+        rc = tracer_resume(&job, out);
+    }while(rc == 0);
+
+    tracer_job_free(&job);
+    return rc < 0 ? -1 : 0;
+}
+
+/**
+ * Remember a responder for a TTL if it hasn't been seen yet.
+ * @param te Enumeration state of the TTL
+ * @param p Answered probe
+ * @return true if this was a new next hop
+ */
+static bool ttlenum_add(TtlEnum *te, const Probe *p){
+
+    for(int k = 0; k < te->nhops; k++){
+        if(te->seen[k].addr.sin_addr.s_addr == p->from.sin_addr.s_addr){
+            return false;
+        }
+    }
+
+    if(te->nhops == MAX_NEXTHOPS){
+        return false;
+    }
+
+    te->seen[te->nhops].addr = p->from;
+    te->seen[te->nhops].flow = p->flow;
+    te->seen[te->nhops].rtt_us = p->rtt_us;
+    te->seen[te->nhops].icmp_type = p->icmp_type;
+    te->seen[te->nhops].reached = p->reached;
+    te->nhops++;
+    return true;
+}
+
+/**
+ * Enumerate load-balanced (ECMP) paths.
+ * Each TTL is probed with distinct Paris flow identifiers until the MDA
+ * stopping rule says no further next hop is likely, or the per-TTL probe
+ * budget (cfg->flows) runs out. Every distinct responder becomes its own
+ * row, so a TTL with N next hops yields N rows with the same hop number.
+ * @param cfg Pointer to CommandLine config
+ * @param out Pointer to TraceRoute to fill
+ * @return 0 on success, -1 on error
+ */
+int tracer_enumerate(const CommandLine *cfg, TraceRoute *out){
+
+    //clear TraceRoute to empty
+    memset(out, 0, sizeof(*out));
+
+    ProbeEngine eng;
+    if(tracer_open(cfg, &eng) != 0){
+        return -1;
+    }
+
+    size_t nttl = (size_t)(cfg->ttl_max - cfg->ttl_start + 1);
+    TtlEnum *state = calloc(nttl, sizeof(TtlEnum));
+    Probe *probes = calloc(nttl * (size_t)cfg->flows, sizeof(Probe));
+
+    if(state == NULL || probes == NULL){
+        fprintf(stderr, "Error: Memory allocation failed for enumeration\n");
+        free(state);
+        free(probes);
+        probe_engine_close(&eng);
+        return -1;
+    }
+
+    int dest_ttl = 0;               // first TTL that answered with an Echo Reply
+    uint16_t next_flow = PARIS_DEFAULT_FLOW;
+    int result = 0;
+
+    while(1){
+
+        //Queue just enough new flows per TTL to reach its next stopping point
+        size_t n = 0;
+
+        for(size_t i = 0; i < nttl; i++){
 
-            //set RTT to -1 for timeout
-            h.rtt_ms = -1;
+            TtlEnum *te = &state[i];
+            int ttl = cfg->ttl_start + (int)i;
 
-            //set icmp_type to -1 for timeout (marked as unknown)
+            if(te->done || (dest_ttl > 0 && ttl > dest_ttl)){
+                te->done = true;
+                continue;
+            }
+
+            int target = (te->nhops == 0) ? ENUM_SILENT_PROBES : mda_stop[te->nhops - 1];
+            if(target > cfg->flows){
+                target = cfg->flows;
+            }
+
+            if(te->sent >= target){
+                te->done = true;
+                continue;
+            }
+
+            for(; te->sent < target; te->sent++){
+                memset(&probes[n], 0, sizeof(Probe));
+                probes[n].ttl = ttl;
+                probes[n].flow = next_flow++;
+                n++;
+            }
+        }
+
+        //Every TTL reached its stopping point
+        if(n == 0){
+            break;
+        }
+
+        if(probe_engine_round(&eng, probes, n, PROBE_TIMEOUT_MS) != 0){
+            result = -1;
+            break;
+        }
+
+        for(size_t k = 0; k < n; k++){
+
+            const Probe *p = &probes[k];
+            if(!p->answered){
+                continue;
+            }
+
+            ttlenum_add(&state[p->ttl - cfg->ttl_start], p);
+
+            if(p->reached && (dest_ttl == 0 || p->ttl < dest_ttl)){
+                dest_ttl = p->ttl;
+            }
+        }
+    }
+
+    //One row per (TTL, next hop), up to the destination
+    int last_ttl = (dest_ttl > 0) ? dest_ttl : cfg->ttl_max;
+
+    for(int ttl = cfg->ttl_start; result == 0 && ttl <= last_ttl; ttl++){
+
+        const TtlEnum *te = &state[ttl - cfg->ttl_start];
+
+        Hop h;
+        memset(&h, 0, sizeof(h));
+        h.hop = ttl;
+
+        if(te->nhops == 0){
+            h.timeout = true;
+            strcpy(h.ip, "*");
+            strcpy(h.host, "?");
+            h.rtt_us = -1;
+            h.icmp_type = -1;
+            h.flow = -1;
             tracer_append(out, &h);
             continue;
         }
 
-        //Extract IP of hop
-        inet_ntop(AF_INET, &reply_addr.sin_addr, h.ip, sizeof(h.ip));
+        for(int k = 0; k < te->nhops; k++){
+            inet_ntop(AF_INET, &te->seen[k].addr.sin_addr, h.ip, sizeof(h.ip));
+            tracer_resolve_host(&te->seen[k].addr, h.host, sizeof(h.host), h.ip);
+            h.timeout = false;
+            h.rtt_us = te->seen[k].rtt_us;
+            h.icmp_type = te->seen[k].icmp_type;
+            h.reached = te->seen[k].reached;
+            h.flow = te->seen[k].flow;
+            tracer_append(out, &h);
+        }
+    }
+
+    //Clean up
+    free(state);
+    free(probes);
+    probe_engine_close(&eng);
+    return result;
+}
+
+/**
+ * Signal handler used to request a stop of the continuous loop.
+ */
+static void signal_handler(int sig){
+    (void)sig;
+    running = 0;
+}
+
+/**
+ * Allows external code to stop continuous tracing.
+ */
+void tracer_stop(void){
+    running = 0;
+}
+
+/**
+ * Record one probe result into a hop's running statistics. O(1).
+ * @param hs Hop statistics to update
+ * @param rtt_us RTT in microseconds, or -1 if the probe was lost
+ */
+static void hopstats_record(HopStats *hs, long rtt_us){
+
+    hs->sent++;
+
+    // Ring of recent results: account for the entry being overwritten
+    if(hs->hist_len == HOP_HISTORY_LEN){
+        if(hs->history[hs->hist_head] < 0){
+            hs->hist_lost--;
+        }
+    }
+    else{
+        hs->hist_len++;
+    }
+
+    hs->history[hs->hist_head] = rtt_us;
+    hs->hist_head = (hs->hist_head + 1) % HOP_HISTORY_LEN;
+
+    if(rtt_us < 0){
+        hs->hist_lost++;
+        return;
+    }
+
+    // Jitter: smoothed absolute difference between consecutive replies (RFC 3550)
+    if(hs->received > 0){
+        double delta = (double)(rtt_us - hs->last_us);
+        if(delta < 0){
+            delta = -delta;
+        }
+        hs->jitter_us += (delta - hs->jitter_us) / JITTER_GAIN;
+    }
+
+    hs->received++;
+    hs->last_us = rtt_us;
+
+    if(hs->best_us < 0 || rtt_us < hs->best_us){
+        hs->best_us = rtt_us;
+    }
+
+    if(rtt_us > hs->worst_us){
+        hs->worst_us = rtt_us;
+    }
+
+    // Running mean, no sum to overflow over long runs
+    hs->avg_us += ((double)rtt_us - hs->avg_us) / (double)hs->received;
+}
+
+/**
+ * Run traceroute continuously, MTR-style.
+ * Every round probes all hops up to the destination in parallel and folds
+ * the results into per-hop running statistics. After each round the
+ * snapshot callback is invoked so the caller can render it.
+ * @param cfg Pointer to CommandLine config (cycles = 0 runs until stopped)
+ * @param out PathStats to fill (free with pathstats_free)
+ * @param on_snapshot Called after every round (may be NULL)
+ * @param ctx Passed through to on_snapshot
+ * @return 0 on success, -1 on error
+ */
+int tracer_continuous(const CommandLine *cfg, PathStats *out, TraceSnapshotFn on_snapshot, void *ctx){
+
+    //clear PathStats to empty
+    memset(out, 0, sizeof(*out));
+
+    ProbeEngine eng;
+    if(tracer_open(cfg, &eng) != 0){
+        return -1;
+    }
 
-        //Parse ICMP type
-        int icmp_type = 0;
-        icmp_parse_response(recvbuf, n, h.ip, &icmp_type);
+    //Everything is allocated once up front: memory stays flat for the whole run
+    size_t nttl = (size_t)(cfg->ttl_max - cfg->ttl_start + 1);
+    Probe *probes = calloc(nttl, sizeof(Probe));
+    out->hops = calloc(nttl, sizeof(HopStats));
 
-        //Fill Hop details
-        h.timeout = false;
+    if(probes == NULL || out->hops == NULL){
+        fprintf(stderr, "Error: Memory allocation failed for path statistics\n");
+        free(probes);
+        pathstats_free(out);
+        probe_engine_close(&eng);
+        return -1;
+    }
 
-        //Calculate RTT
-        h.rtt_ms = (int)(tend - tstart);
+    out->cap = nttl;
 
-        //set ICMP type
-        h.icmp_type = icmp_type;
+    for(size_t i = 0; i < nttl; i++){
+        HopStats *hs = &out->hops[i];
+        hs->hop = cfg->ttl_start + (int)i;
+        hs->last_us = -1;
+        hs->best_us = -1;
+        hs->worst_us = -1;
+        strcpy(hs->ip, "*");
+        strcpy(hs->host, "?");
+    }
 
-        //Resolve hostname (reverse DNS lookup)
-        char hostbuf[NI_MAXHOST];
+    /* Set up signal handlers for graceful shutdown */
+    running = 1;
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
 
-        //taking ip address from reply_addr and getting hostname
-        int gi = getnameinfo((struct sockaddr *)&reply_addr, reply_len, hostbuf, sizeof(hostbuf), NULL, 0, 0);
+    //Probe up to ttl_max until the destination shows up, then only up to it
+    int ttl_end = cfg->ttl_max;
+    int result = 0;
 
-        //check getnameinfo result
-        if(gi == 0){
+    while(running && (cfg->cycles == 0 || out->cycles < (unsigned long)cfg->cycles)){
 
-            // Successfully resolved a hostname
-            strncpy(h.host, hostbuf, sizeof(h.host) - 1);
-            h.host[sizeof(h.host) - 1] = '\0';
+        long round_start = ms_now();
+
+        size_t n = tracer_fill_round(probes, cfg->ttl_start, ttl_end, 1);
+
+        if(probe_engine_round(&eng, probes, n, PROBE_TIMEOUT_MS) != 0){
+            result = -1;
+            break;
         }
-        
-        else{
 
-            // Fallback: just use the IP string
-            strncpy(h.host, h.ip, sizeof(h.host) - 1);
-            h.host[sizeof(h.host) - 1] = '\0';
+        //Fold results into per-hop statistics
+        int dest_ttl = 0;
+
+        for(size_t i = 0; i < n; i++){
+
+            const Probe *p = &probes[i];
+            HopStats *hs = &out->hops[i];
+
+            if(!p->answered){
+                hopstats_record(hs, -1);
+                continue;
+            }
+
+            hopstats_record(hs, p->rtt_us);
+
+            //Resolve the name only when the responder changes
+            char ip[64];
+            inet_ntop(AF_INET, &p->from.sin_addr, ip, sizeof(ip));
+
+            if(strcmp(ip, hs->ip) != 0){
+                strcpy(hs->ip, ip);
+                tracer_resolve_host(&p->from, hs->host, sizeof(hs->host), hs->ip);
+            }
+
+            if(p->reached && dest_ttl == 0){
+                dest_ttl = p->ttl;
+            }
         }
 
-        //Append Hop to TraceRoute
-        tracer_append(out, &h);
+        //Path length is up to the destination if it answered, else everything probed
+        if(dest_ttl > 0){
+            ttl_end = dest_ttl;
+        }
 
-        //If we reached destination, stop
-        if(icmp_type == ICMP_ECHOREPLY){
+        out->len = (size_t)(ttl_end - cfg->ttl_start + 1);
+        out->cycles++;
+
+        if(on_snapshot != NULL){
+            on_snapshot(out, ctx);
+        }
+
+        //Pace rounds: sleep out whatever is left of the interval
+        if(!running || (cfg->cycles != 0 && out->cycles >= (unsigned long)cfg->cycles)){
             break;
         }
+
+        long elapsed = ms_diff(round_start, ms_now());
+        if(elapsed < cfg->interval_ms){
+            ms_sleep((int)(cfg->interval_ms - elapsed));
+        }
     }
 
-    //Clean up socket
-    close(sockfd);
-    return 0;
+    //Clean up
+    free(probes);
+    probe_engine_close(&eng);
+    return result;
+}
+
+/**
+ * Free resources in PathStats.
+ * @param stats Pointer to PathStats to free
+ */
+void pathstats_free(PathStats *stats){
+
+    //Check for NULL
+    if(stats == NULL){
+        return;
+    }
+
+    free(stats->hops);
+
+    //Reset PathStats
+    stats->hops = NULL;
+    stats->len = 0;
+    stats->cap = 0;
+    stats->cycles = 0;
 }
 
 /**
@@ -4,15 +4,27 @@
  *
  * Responsibilities:
  *  - Probe path to target by incrementing TTL
- *  - Capture per-hop RTT and IP/hostname (optional reverse DNS)
+ *  - Capture per-hop RTT (microseconds, kernel receive timestamps) and IP/hostname (optional reverse DNS)
+ *  - Continuous mode: keep probing and maintain per-hop loss/RTT/jitter statistics
+ *  - Paris (flow-stable) probing and ECMP next-hop enumeration
+ *  - Traces as resumable jobs, so many can be in flight at once (--graph)
  *
  * Data & Types:
- *  - typedef struct Hop { int hop; char host[256]; char ip[64]; int rtt_ms; bool timeout; }
+ *  - typedef struct Hop { int hop; char host[256]; char ip[64]; long rtt_us; bool timeout; }
  *  - typedef struct TraceRoute { Hop *rows; size_t len, cap; }
+ *  - typedef struct PathStats { HopStats *hops; size_t len, cap; unsigned long cycles; }
+ *  - typedef struct TraceJob { ProbeEngine eng; Probe *probes; size_t n, skip; bool checking; ... }
  *
  * Public API:
  *  - int  tracer_run(const Config *cfg, TraceRoute *out);
+ *  - int  tracer_start(const CommandLine *cmd, TraceJob *job);
+ *  - int  tracer_resume(TraceJob *job, TraceRoute *out);
+ *  - void tracer_job_free(TraceJob *job);
  *  - void traceroute_free(TraceRoute *t);
+ *  - int  tracer_enumerate(const CommandLine *cmd, TraceRoute *out);
+ *  - int  tracer_continuous(const CommandLine *cmd, PathStats *out, TraceSnapshotFn on_snapshot, void *ctx);
+ *  - void tracer_stop(void);
+ *  - void pathstats_free(PathStats *stats);
  *
  * Inputs:
  *  - cfg->target, cfg->ttl_start..ttl_max, per-probe timeout
@@ -23,7 +35,7 @@
  *  - 0 on success; <0 on error (permissions for raw sockets, resolve fail, etc.)
  *
  * Thread-safety: Stateless; each call owns its TraceRoute buffer.
- * Dependencies: icmp.h, net.h, timeutil.h, config.h
+ * Dependencies: probe.h, icmp.h, net.h, timeutil.h, config.h
  * 
  * Author: Shan Truong - 400576105 - truons8
  * Date: December 3, 2025
@@ -37,10 +49,50 @@
 #include <stdbool.h>
 #include "../cli/cli.h"
 #include "../model/model.h"
+#include "probe.h"
+
+// Called after every continuous-mode round with the updated statistics
+typedef void (*TraceSnapshotFn)(const PathStats *stats, void *ctx);
 
 int  tracer_run(const CommandLine *cmd, TraceRoute *out);
+
+/**
+ * One trace in progress: its probe round runs on its own engine, so the
+ * caller can wait on many with probe_engine_wait() and resume each one
+ * as its round ends.
+ * - eng: engine of the target (eng.round is NULL once the round has ended)
+ * - probes: every probe of the trace, queries per TTL, grouped by TTL
+ * - n: number of probes
+ * - skip: leading TTLs the hop cache can fill in (0 = probe them all)
+ * - checking: the cached prefix did not hold and is being probed
+ * - ttl_start, queries, hop_cache: options of the trace
+ * - src: local source address (hop cache key, 0 if unknown)
+ */
+typedef struct TraceJob{
+    ProbeEngine eng;
+    Probe *probes;
+    size_t n;
+    size_t skip;
+    bool checking;
+    int ttl_start;
+    int queries;
+    bool hop_cache;
+    struct in_addr src;
+} TraceJob;
+
+int  tracer_start(const CommandLine *cmd, TraceJob *job);
+int  tracer_resume(TraceJob *job, TraceRoute *out);
+void tracer_job_free(TraceJob *job);
 void traceroute_free(TraceRoute *route);
 void traceroute_free(TraceRoute *t);
 
+/* ECMP path enumeration (one row per TTL and next hop) */
+int  tracer_enumerate(const CommandLine *cmd, TraceRoute *out);
+
+/* Continuous (MTR-style) path monitoring */
+int  tracer_continuous(const CommandLine *cmd, PathStats *out, TraceSnapshotFn on_snapshot, void *ctx);
+void tracer_stop(void);
+void pathstats_free(PathStats *stats);
+
 #endif /* TRACER_H */
 